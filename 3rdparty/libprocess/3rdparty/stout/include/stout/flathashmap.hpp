@@ -0,0 +1,247 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __STOUT_FLATHASHMAP_HPP__
+#define __STOUT_FLATHASHMAP_HPP__
+
+#include <functional>
+#include <initializer_list>
+#include <list>
+#include <map>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#include "flathashtable.hpp"
+#include "foreach.hpp"
+#include "hashset.hpp"
+#include "none.hpp"
+#include "option.hpp"
+
+
+// Provides a hash map with the same interface as 'hashmap' which is
+// backed by an open addressing 'flathashtable' rather than by the
+// node based 'std::unordered_map'. Entries are stored inline, so
+// there is no allocation per entry and lookups do not chase
+// pointers. Prefer this for large maps on hot paths, but note that
+// inserting invalidates all iterators and references into the map
+// (see flathashtable.hpp), so do not hold on to a reference to a
+// value while inserting into the same map.
+
+namespace __flathashmap__ {
+
+template <typename Key, typename Value>
+struct Policy
+{
+  typedef std::pair<const Key, Value> Elem;
+
+  static const Key& key(const Elem& elem) { return elem.first; }
+
+  // NOTE: The element in 'from' is destroyed right after this, so it
+  // is safe to move its const key.
+  static void move(Elem* to, Elem* from)
+  {
+    new (to) Elem(
+        std::move(const_cast<Key&>(from->first)),
+        std::move(from->second));
+  }
+};
+
+} // namespace __flathashmap__ {
+
+
+template <typename Key,
+          typename Value,
+          typename Hash = std::hash<Key>,
+          typename Equal = std::equal_to<Key>>
+class flathashmap
+  : public flathashtable<
+        std::pair<const Key, Value>,
+        Key,
+        __flathashmap__::Policy<Key, Value>,
+        Hash,
+        Equal>
+{
+  typedef flathashtable<
+      std::pair<const Key, Value>,
+      Key,
+      __flathashmap__::Policy<Key, Value>,
+      Hash,
+      Equal> Table;
+
+public:
+  typedef Key key_type;
+  typedef Value mapped_type;
+
+  // An explicit default constructor is needed so
+  // 'const flathashmap<T> map;' is not an error.
+  flathashmap() {}
+
+  // An implicit constructor for converting from a std::map.
+  flathashmap(const std::map<Key, Value>& map)
+  {
+    Table::reserve(map.size());
+    Table::insert(map.begin(), map.end());
+  }
+
+  // An implicit constructor for converting from an r-value std::map.
+  flathashmap(std::map<Key, Value>&& map)
+  {
+    Table::reserve(map.size());
+
+    for (auto iterator = map.begin(); iterator != map.end(); ++iterator) {
+      Table::emplace_key(
+          iterator->first,
+          iterator->first,
+          std::move(iterator->second));
+    }
+  }
+
+  // Allow simple construction via initializer list.
+  flathashmap(std::initializer_list<std::pair<Key, Value>> list)
+  {
+    Table::reserve(list.size());
+
+    for (auto iterator = list.begin(); iterator != list.end(); ++iterator) {
+      Table::emplace_key(iterator->first, iterator->first, iterator->second);
+    }
+  }
+
+  Value& operator[](const Key& key)
+  {
+    return Table::emplace_key(
+        key,
+        std::piecewise_construct,
+        std::forward_as_tuple(key),
+        std::tuple<>()).first->second;
+  }
+
+  Value& at(const Key& key)
+  {
+    typename Table::iterator iterator = Table::find(key);
+    if (iterator == Table::end()) {
+      throw std::out_of_range("flathashmap::at");
+    }
+    return iterator->second;
+  }
+
+  const Value& at(const Key& key) const
+  {
+    typename Table::const_iterator iterator = Table::find(key);
+    if (iterator == Table::end()) {
+      throw std::out_of_range("flathashmap::at");
+    }
+    return iterator->second;
+  }
+
+  template <typename... Args>
+  std::pair<typename Table::iterator, bool> emplace(Args&&... args)
+  {
+    std::pair<Key, Value> pair(std::forward<Args>(args)...);
+
+    return Table::emplace_key(
+        pair.first,
+        std::move(pair.first),
+        std::move(pair.second));
+  }
+
+  // Checks whether this map contains a binding for a key.
+  bool contains(const Key& key) const
+  {
+    return Table::count(key) > 0;
+  }
+
+  // Checks whether there exists a bound value in this map.
+  bool containsValue(const Value& v) const
+  {
+    foreachvalue (const Value& value, *this) {
+      if (value == v) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Inserts a key, value pair into the map replacing an old value
+  // if the key is already present.
+  void put(const Key& key, const Value& value)
+  {
+    std::pair<typename Table::iterator, bool> result =
+      Table::emplace_key(key, key, value);
+
+    if (!result.second) {
+      result.first->second = value;
+    }
+  }
+
+  // Returns an Option for the binding to the key.
+  Option<Value> get(const Key& key) const
+  {
+    typename Table::const_iterator iterator = Table::find(key);
+    if (iterator == Table::end()) {
+      return None();
+    }
+    return iterator->second;
+  }
+
+  // Returns the set of keys in this map.
+  hashset<Key> keys() const
+  {
+    hashset<Key> result;
+    foreachkey (const Key& key, *this) {
+      result.insert(key);
+    }
+    return result;
+  }
+
+  // Returns the list of values in this map.
+  std::list<Value> values() const
+  {
+    std::list<Value> result;
+    foreachvalue (const Value& value, *this) {
+      result.push_back(value);
+    }
+    return result;
+  }
+};
+
+
+template <typename Key, typename Value, typename Hash, typename Equal>
+bool operator==(
+    const flathashmap<Key, Value, Hash, Equal>& left,
+    const flathashmap<Key, Value, Hash, Equal>& right)
+{
+  if (left.size() != right.size()) {
+    return false;
+  }
+
+  foreachpair (const Key& key, const Value& value, left) {
+    auto iterator = right.find(key);
+    if (iterator == right.end() || !(iterator->second == value)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+template <typename Key, typename Value, typename Hash, typename Equal>
+bool operator!=(
+    const flathashmap<Key, Value, Hash, Equal>& left,
+    const flathashmap<Key, Value, Hash, Equal>& right)
+{
+  return !(left == right);
+}
+
+#endif // __STOUT_FLATHASHMAP_HPP__
@@ -0,0 +1,511 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __STOUT_FLATHASHTABLE_HPP__
+#define __STOUT_FLATHASHTABLE_HPP__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// An open addressing hash table with linear probing which stores its
+// elements inline in a single contiguous array. This is the common
+// implementation behind 'flathashmap' and 'flathashset', see those
+// for the public interfaces.
+//
+// Next to the element array the table keeps one control byte per
+// slot which is either EMPTY, DELETED (a tombstone) or the low 7 bits
+// of the element's hash. Probing compares control bytes first so
+// that keys are only compared on a likely hit, and a lookup touches
+// at most a couple of cache lines in the common case.
+//
+// Unlike the node based 'std::unordered_map' this means:
+//   - Inserting may move elements and thus invalidates all iterators,
+//     pointers and references into the table.
+//   - Erasing only invalidates iterators, pointers and references to
+//     the erased element, so erasing while iterating is safe.
+//
+// The 'Policy' provides the key of an element and how to move an
+// element from one slot into another, which allows the map to move
+// its (const) keys rather than copying them when the table grows.
+
+template <typename Elem,
+          typename Key,
+          typename Policy,
+          typename Hash,
+          typename Equal>
+class flathashtable
+{
+  template <bool Const>
+  class Iterator;
+
+public:
+  typedef Elem value_type;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef Hash hasher;
+  typedef Equal key_equal;
+  typedef Elem& reference;
+  typedef const Elem& const_reference;
+  typedef Elem* pointer;
+  typedef const Elem* const_pointer;
+
+  typedef Iterator<false> iterator;
+  typedef Iterator<true> const_iterator;
+
+  flathashtable()
+    : control(NULL),
+      slots(NULL),
+      capacity(0),
+      size_(0),
+      deleted(0) {}
+
+  flathashtable(const flathashtable& that)
+    : control(NULL),
+      slots(NULL),
+      capacity(0),
+      size_(0),
+      deleted(0),
+      hash(that.hash),
+      equal(that.equal)
+  {
+    if (that.size_ == 0) {
+      return;
+    }
+
+    reserve(that.size_);
+    for (size_t i = 0; i < that.capacity; ++i) {
+      if (full(that.control[i])) {
+        const Elem& elem = that.slots[i];
+        const size_t h = mix(hash(Policy::key(elem)));
+        const size_t index = vacant(h);
+        new (&slots[index]) Elem(elem);
+        control[index] = fingerprint(h);
+        ++size_;
+      }
+    }
+  }
+
+  flathashtable(flathashtable&& that)
+    : control(that.control),
+      slots(that.slots),
+      capacity(that.capacity),
+      size_(that.size_),
+      deleted(that.deleted),
+      hash(std::move(that.hash)),
+      equal(std::move(that.equal))
+  {
+    that.control = NULL;
+    that.slots = NULL;
+    that.capacity = 0;
+    that.size_ = 0;
+    that.deleted = 0;
+  }
+
+  ~flathashtable()
+  {
+    destroy();
+  }
+
+  flathashtable& operator=(flathashtable that)
+  {
+    swap(that);
+    return *this;
+  }
+
+  void swap(flathashtable& that)
+  {
+    std::swap(control, that.control);
+    std::swap(slots, that.slots);
+    std::swap(capacity, that.capacity);
+    std::swap(size_, that.size_);
+    std::swap(deleted, that.deleted);
+    std::swap(hash, that.hash);
+    std::swap(equal, that.equal);
+  }
+
+  iterator begin() { return iterator(this, skip(0)); }
+  iterator end() { return iterator(this, capacity); }
+
+  const_iterator begin() const { return const_iterator(this, skip(0)); }
+  const_iterator end() const { return const_iterator(this, capacity); }
+
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  iterator find(const Key& key)
+  {
+    return iterator(this, lookup(key));
+  }
+
+  const_iterator find(const Key& key) const
+  {
+    return const_iterator(this, lookup(key));
+  }
+
+  size_t count(const Key& key) const
+  {
+    return lookup(key) != capacity ? 1 : 0;
+  }
+
+  // Inserts the element if no element with an equal key exists.
+  std::pair<iterator, bool> insert(const Elem& elem)
+  {
+    return emplace_key(Policy::key(elem), elem);
+  }
+
+  std::pair<iterator, bool> insert(Elem&& elem)
+  {
+    const Key& key = Policy::key(elem);
+    return emplace_key(key, std::move(elem));
+  }
+
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last)
+  {
+    for (; first != last; ++first) {
+      insert(*first);
+    }
+  }
+
+  // Constructs an element from 'args' in place if no element with
+  // an equal 'key' exists. The element constructed from 'args' must
+  // have a key equal to 'key'.
+  template <typename... Args>
+  std::pair<iterator, bool> emplace_key(const Key& key, Args&&... args)
+  {
+    const size_t h = mix(hash(key));
+
+    const size_t index = lookup(key, h);
+    if (index != capacity) {
+      return std::make_pair(iterator(this, index), false);
+    }
+
+    // NOTE: Only 'h' is used from here on since 'key' may refer into
+    // 'args' which are consumed by the constructor below.
+    grow();
+
+    const size_t slot = vacant(h);
+
+    new (&slots[slot]) Elem(std::forward<Args>(args)...);
+
+    if (control[slot] == DELETED) {
+      --deleted;
+    }
+
+    control[slot] = fingerprint(h);
+    ++size_;
+
+    return std::make_pair(iterator(this, slot), true);
+  }
+
+  size_t erase(const Key& key)
+  {
+    const size_t index = lookup(key);
+    if (index == capacity) {
+      return 0;
+    }
+
+    remove(index);
+    return 1;
+  }
+
+  iterator erase(const_iterator position)
+  {
+    const size_t index = position.index;
+    remove(index);
+    return iterator(this, skip(index + 1));
+  }
+
+  void clear()
+  {
+    for (size_t i = 0; i < capacity; ++i) {
+      if (full(control[i])) {
+        slots[i].~Elem();
+      }
+    }
+
+    if (capacity > 0) {
+      memset(control, EMPTY, capacity);
+    }
+
+    size_ = 0;
+    deleted = 0;
+  }
+
+  // Ensures that 'n' elements can be held without growing the table.
+  void reserve(size_t n)
+  {
+    size_t target = MIN_CAPACITY;
+    while (n > limit(target)) {
+      target *= 2;
+    }
+
+    if (target > capacity) {
+      rehash(target);
+    }
+  }
+
+  // Number of slots, for tests and benchmarks.
+  size_t bucket_count() const { return capacity; }
+
+  float load_factor() const
+  {
+    return capacity == 0 ? 0.0f : static_cast<float>(size_) / capacity;
+  }
+
+private:
+  template <bool Const>
+  class Iterator
+  {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Elem value_type;
+    typedef ptrdiff_t difference_type;
+    typedef typename std::conditional<Const, const Elem*, Elem*>::type pointer;
+    typedef typename std::conditional<Const, const Elem&, Elem&>::type
+      reference;
+
+    typedef typename std::conditional<
+        Const,
+        const flathashtable*,
+        flathashtable*>::type Table;
+
+    Iterator() : table(NULL), index(0) {}
+
+    // Allow conversion from 'iterator' to 'const_iterator'.
+    Iterator(const Iterator<false>& that)
+      : table(that.table), index(that.index) {}
+
+    reference operator*() const { return table->slots[index]; }
+    pointer operator->() const { return &table->slots[index]; }
+
+    Iterator& operator++()
+    {
+      index = table->skip(index + 1);
+      return *this;
+    }
+
+    Iterator operator++(int)
+    {
+      Iterator result = *this;
+      ++(*this);
+      return result;
+    }
+
+    bool operator==(const Iterator& that) const
+    {
+      return index == that.index;
+    }
+
+    bool operator!=(const Iterator& that) const
+    {
+      return index != that.index;
+    }
+
+  private:
+    friend class flathashtable;
+    friend class Iterator<true>;
+
+    Iterator(Table _table, size_t _index)
+      : table(_table), index(_index) {}
+
+    Table table;
+    size_t index;
+  };
+
+  static const uint8_t EMPTY = 0x80;
+  static const uint8_t DELETED = 0xfe;
+
+  static const size_t MIN_CAPACITY = 8;
+
+  static bool full(uint8_t c) { return (c & 0x80) == 0; }
+
+  static uint8_t fingerprint(size_t h) { return h & 0x7f; }
+
+  // The maximum number of occupied (full or deleted) slots for the
+  // given capacity, i.e., a maximum load factor of 7/8.
+  static size_t limit(size_t capacity) { return capacity - capacity / 8; }
+
+  // Many 'std::hash' implementations are the identity function for
+  // integral types; spread the bits so that linear probing with a
+  // power of two capacity does not cluster. This is the finalizer of
+  // MurmurHash3.
+  static size_t mix(size_t h)
+  {
+    uint64_t x = h;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return static_cast<size_t>(x);
+  }
+
+  size_t lookup(const Key& key) const
+  {
+    if (size_ == 0) {
+      return capacity;
+    }
+
+    return lookup(key, mix(hash(key)));
+  }
+
+  // Returns the slot holding 'key' or 'capacity' if there is none.
+  size_t lookup(const Key& key, size_t h) const
+  {
+    if (capacity == 0) {
+      return capacity;
+    }
+
+    const size_t mask = capacity - 1;
+    const uint8_t f = fingerprint(h);
+
+    for (size_t i = (h >> 7) & mask;; i = (i + 1) & mask) {
+      const uint8_t c = control[i];
+      if (c == EMPTY) {
+        return capacity;
+      } else if (c == f && equal(Policy::key(slots[i]), key)) {
+        return i;
+      }
+    }
+  }
+
+  // Returns the first EMPTY or DELETED slot on the probe sequence.
+  size_t vacant(size_t h) const
+  {
+    const size_t mask = capacity - 1;
+
+    for (size_t i = (h >> 7) & mask;; i = (i + 1) & mask) {
+      if (!full(control[i])) {
+        return i;
+      }
+    }
+  }
+
+  // Returns the first full slot at or after 'index'.
+  size_t skip(size_t index) const
+  {
+    while (index < capacity && !full(control[index])) {
+      ++index;
+    }
+    return index;
+  }
+
+  // Makes room for one more element, either by growing or, if the
+  // table is mostly tombstones, by rehashing in place.
+  void grow()
+  {
+    if (capacity == 0) {
+      rehash(MIN_CAPACITY);
+    } else if (size_ + deleted + 1 > limit(capacity)) {
+      rehash(size_ + 1 > limit(capacity) / 2 ? capacity * 2 : capacity);
+    }
+  }
+
+  void remove(size_t index)
+  {
+    slots[index].~Elem();
+    --size_;
+
+    // If the next slot is empty no probe sequence can continue past
+    // this slot, so it can be marked empty rather than deleted.
+    if (control[(index + 1) & (capacity - 1)] == EMPTY) {
+      control[index] = EMPTY;
+    } else {
+      control[index] = DELETED;
+      ++deleted;
+    }
+  }
+
+  void rehash(size_t target)
+  {
+    uint8_t* oldControl = control;
+    Elem* oldSlots = slots;
+    const size_t oldCapacity = capacity;
+
+    control = new uint8_t[target];
+    memset(control, EMPTY, target);
+    slots = static_cast<Elem*>(::operator new(target * sizeof(Elem)));
+    capacity = target;
+    deleted = 0;
+
+    for (size_t i = 0; i < oldCapacity; ++i) {
+      if (full(oldControl[i])) {
+        const size_t h = mix(hash(Policy::key(oldSlots[i])));
+        const size_t index = vacant(h);
+        Policy::move(&slots[index], &oldSlots[i]);
+        oldSlots[i].~Elem();
+        control[index] = fingerprint(h);
+      }
+    }
+
+    delete[] oldControl;
+    ::operator delete(oldSlots);
+  }
+
+  void destroy()
+  {
+    for (size_t i = 0; i < capacity; ++i) {
+      if (full(control[i])) {
+        slots[i].~Elem();
+      }
+    }
+
+    delete[] control;
+    ::operator delete(slots);
+  }
+
+  uint8_t* control;
+  Elem* slots;
+  size_t capacity; // Always zero or a power of two.
+  size_t size_;
+  size_t deleted;
+
+  Hash hash;
+  Equal equal;
+};
+
+
+template <typename Elem,
+          typename Key,
+          typename Policy,
+          typename Hash,
+          typename Equal>
+const uint8_t flathashtable<Elem, Key, Policy, Hash, Equal>::EMPTY;
+
+
+template <typename Elem,
+          typename Key,
+          typename Policy,
+          typename Hash,
+          typename Equal>
+const uint8_t flathashtable<Elem, Key, Policy, Hash, Equal>::DELETED;
+
+
+template <typename Elem,
+          typename Key,
+          typename Policy,
+          typename Hash,
+          typename Equal>
+const size_t flathashtable<Elem, Key, Policy, Hash, Equal>::MIN_CAPACITY;
+
+#endif // __STOUT_FLATHASHTABLE_HPP__
@@ -0,0 +1,583 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __STOUT_JSON_READER_HPP__
+#define __STOUT_JSON_READER_HPP__
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <stout/check.hpp>
+#include <stout/error.hpp>
+#include <stout/json.hpp>
+#include <stout/none.hpp>
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
+#include <stout/stringify.hpp>
+#include <stout/try.hpp>
+#include <stout/unreachable.hpp>
+
+namespace JSON {
+
+// An event driven ("pull") JSON parser which never materializes a
+// JSON::Value. Each call to 'next' consumes the next token of the
+// document and returns its type; the payload of KEY, STRING, NUMBER
+// and BOOLEAN tokens is available through the corresponding accessor
+// until the following call to 'next'. For example:
+//
+//   JSON::Reader reader(s);
+//   Try<JSON::Reader::Token> token = reader.next();
+//   while (token.isSome() && token.get() != JSON::Reader::END) {
+//     ...
+//     token = reader.next();
+//   }
+//
+// The grammar accepted is the same as 'JSON::parse': a single value
+// optionally surrounded by whitespace, where trailing non-whitespace
+// characters are an error. Unlike 'JSON::parse', numbers must follow
+// RFC 7159, e.g., '+1' and '007' are an error. Once an error has been
+// returned every subsequent call to 'next' returns the same error.
+//
+// NOTE: The reader does not copy the input, the caller must keep the
+// underlying buffer alive for the lifetime of the reader.
+class Reader
+{
+public:
+  enum Token
+  {
+    OBJECT_START,
+    OBJECT_END,
+    ARRAY_START,
+    ARRAY_END,
+    KEY,
+    STRING,
+    NUMBER,
+    BOOLEAN,
+    NULL_VALUE,
+    END,
+  };
+
+  explicit Reader(const std::string& s)
+    : cursor(s.data()),
+      begin(s.data()),
+      end(s.data() + s.size()),
+      state(VALUE) {}
+
+  Reader(const char* data, size_t size)
+    : cursor(data),
+      begin(data),
+      end(data + size),
+      state(VALUE) {}
+
+  Try<Token> next()
+  {
+    if (error.isSome()) {
+      return error.get();
+    }
+
+    Try<Token> token = _next();
+
+    if (token.isError()) {
+      error = Error(
+          token.error() + " at offset " + stringify(cursor - begin));
+      return error.get();
+    }
+
+    return token;
+  }
+
+  // Consumes the remainder of the value whose first token was the
+  // last one returned by 'next'. This is a no-op for scalar values,
+  // for OBJECT_START and ARRAY_START it consumes every token up to
+  // and including the matching OBJECT_END or ARRAY_END, and for KEY
+  // it consumes the value associated with the key.
+  Try<Nothing> skip()
+  {
+    size_t depth = stack.size();
+
+    // After a KEY we must first read the start of its value.
+    if (last == KEY) {
+      Try<Token> token = next();
+      if (token.isError()) {
+        return Error(token.error());
+      }
+
+      depth = stack.size();
+
+      if (token.get() != OBJECT_START && token.get() != ARRAY_START) {
+        return Nothing();
+      }
+    } else if (last != OBJECT_START && last != ARRAY_START) {
+      return Nothing();
+    }
+
+    while (stack.size() >= depth) {
+      Try<Token> token = next();
+      if (token.isError()) {
+        return Error(token.error());
+      } else if (token.get() == END) {
+        return Error("Unexpected end of input");
+      }
+    }
+
+    return Nothing();
+  }
+
+  // Number of currently open objects and arrays.
+  size_t depth() const { return stack.size(); }
+
+  // Whether 'next' has returned an error, i.e., whether the document
+  // is not valid JSON.
+  bool failed() const { return error.isSome(); }
+
+  // Valid after a KEY or STRING token.
+  const std::string& string() const { return buffer; }
+
+  // Valid after a NUMBER token.
+  const Number& number() const { return _number; }
+
+  // Valid after a BOOLEAN token.
+  bool boolean() const { return _boolean; }
+
+private:
+  // What the parser expects to see next.
+  enum State
+  {
+    VALUE,       // Any value.
+    FIRST_VALUE, // Any value or ']', directly after '['.
+    FIRST_KEY,   // A key or '}', directly after '{'.
+    KEY_,        // A key, after ','.
+    SEPARATOR,   // ',' or the end of the enclosing object/array.
+    DONE,        // Only whitespace until the end of the input.
+  };
+
+  enum Container
+  {
+    OBJECT,
+    ARRAY,
+  };
+
+  Try<Token> _next()
+  {
+    Try<Token> token = __next();
+    if (token.isSome()) {
+      last = token.get();
+    }
+    return token;
+  }
+
+  Try<Token> __next()
+  {
+    skipWhitespace();
+
+    switch (state) {
+      case DONE:
+        if (cursor != end) {
+          return Error("Parsed JSON included non-whitespace trailing"
+                       " characters");
+        }
+        return END;
+
+      case SEPARATOR:
+        if (stack.empty()) {
+          state = DONE;
+          return __next();
+        }
+
+        if (cursor == end) {
+          return Error("Unexpected end of input");
+        }
+
+        if (*cursor == ',') {
+          ++cursor;
+          state = stack.back() == OBJECT ? KEY_ : VALUE;
+          return __next();
+        }
+
+        return close();
+
+      case FIRST_KEY:
+        if (cursor != end && *cursor == '}') {
+          return close();
+        }
+        // Fall through.
+
+      case KEY_: {
+        if (cursor == end || *cursor != '"') {
+          return Error("Expecting an object key");
+        }
+
+        Try<Nothing> parse = parseString();
+        if (parse.isError()) {
+          return Error(parse.error());
+        }
+
+        skipWhitespace();
+
+        if (cursor == end || *cursor != ':') {
+          return Error("Expecting ':' after object key");
+        }
+
+        ++cursor;
+        state = VALUE;
+        return KEY;
+      }
+
+      case FIRST_VALUE:
+        if (cursor != end && *cursor == ']') {
+          return close();
+        }
+        // Fall through.
+
+      case VALUE:
+        return value();
+    }
+
+    UNREACHABLE();
+  }
+
+  Try<Token> value()
+  {
+    if (cursor == end) {
+      return Error("Unexpected end of input");
+    }
+
+    switch (*cursor) {
+      case '{':
+        ++cursor;
+        stack.push_back(OBJECT);
+        state = FIRST_KEY;
+        return OBJECT_START;
+
+      case '[':
+        ++cursor;
+        stack.push_back(ARRAY);
+        state = FIRST_VALUE;
+        return ARRAY_START;
+
+      case '"': {
+        Try<Nothing> parse = parseString();
+        if (parse.isError()) {
+          return Error(parse.error());
+        }
+        state = SEPARATOR;
+        return STRING;
+      }
+
+      case 't':
+        if (!literal("true")) {
+          return Error("Invalid literal");
+        }
+        _boolean = true;
+        state = SEPARATOR;
+        return BOOLEAN;
+
+      case 'f':
+        if (!literal("false")) {
+          return Error("Invalid literal");
+        }
+        _boolean = false;
+        state = SEPARATOR;
+        return BOOLEAN;
+
+      case 'n':
+        if (!literal("null")) {
+          return Error("Invalid literal");
+        }
+        state = SEPARATOR;
+        return NULL_VALUE;
+
+      default: {
+        Try<Nothing> parse = parseNumber();
+        if (parse.isError()) {
+          return Error(parse.error());
+        }
+        state = SEPARATOR;
+        return NUMBER;
+      }
+    }
+  }
+
+  // Consumes the '}' or ']' closing the innermost container.
+  Try<Token> close()
+  {
+    CHECK(!stack.empty());
+
+    const Container container = stack.back();
+
+    if (cursor == end ||
+        *cursor != (container == OBJECT ? '}' : ']')) {
+      return Error(container == OBJECT
+                   ? "Expecting ',' or '}'"
+                   : "Expecting ',' or ']'");
+    }
+
+    ++cursor;
+    stack.pop_back();
+    state = SEPARATOR;
+    return container == OBJECT ? OBJECT_END : ARRAY_END;
+  }
+
+  void skipWhitespace()
+  {
+    while (cursor != end &&
+           (*cursor == ' ' || *cursor == '\t' ||
+            *cursor == '\n' || *cursor == '\r')) {
+      ++cursor;
+    }
+  }
+
+  bool literal(const char* s)
+  {
+    const size_t length = strlen(s);
+    if (static_cast<size_t>(end - cursor) < length ||
+        strncmp(cursor, s, length) != 0) {
+      return false;
+    }
+    cursor += length;
+    return true;
+  }
+
+  static bool digit(char c)
+  {
+    return c >= '0' && c <= '9';
+  }
+
+  // Consumes the digits at the cursor and returns how many there are.
+  size_t skipDigits()
+  {
+    const char* start = cursor;
+    while (cursor != end && digit(*cursor)) {
+      ++cursor;
+    }
+    return cursor - start;
+  }
+
+  // Accepts the number grammar of RFC 7159, i.e., an optional '-',
+  // an integer without leading zeros and an optional fraction and
+  // exponent. Otherwise follows the same conventions as PicoJson
+  // (which backs 'JSON::parse') so that both parsers produce
+  // identical numbers:
+  // a value without a fraction or exponent that fits in an int64_t
+  // is a SIGNED_INTEGER, everything else is FLOATING.
+  Try<Nothing> parseNumber()
+  {
+    const char* start = cursor;
+    bool integral = true;
+
+    if (cursor != end && *cursor == '-') {
+      ++cursor;
+    }
+
+    if (cursor == end || !digit(*cursor)) {
+      return Error(cursor == end
+          ? "Unexpected end of input"
+          : "Unexpected character '" + std::string(1, *cursor) + "'");
+    }
+
+    // A zero can only be followed by a fraction or an exponent.
+    const bool zero = *cursor == '0';
+    const size_t count = skipDigits();
+    bool valid = !zero || count == 1;
+
+    if (cursor != end && *cursor == '.') {
+      integral = false;
+      ++cursor;
+      valid = skipDigits() > 0 && valid;
+    }
+
+    if (cursor != end && (*cursor == 'e' || *cursor == 'E')) {
+      integral = false;
+      ++cursor;
+      if (cursor != end && (*cursor == '+' || *cursor == '-')) {
+        ++cursor;
+      }
+      valid = skipDigits() > 0 && valid;
+    }
+
+    // 'strtoll' and 'strtod' require a NUL terminated string.
+    digits.assign(start, cursor - start);
+
+    if (!valid) {
+      return Error("Invalid number '" + digits + "'");
+    }
+
+    char* endptr = NULL;
+
+    if (integral) {
+      errno = 0;
+      const long long value = strtoll(digits.c_str(), &endptr, 10);
+      if (errno == 0 && endptr == digits.c_str() + digits.size()) {
+        _number = Number(static_cast<int64_t>(value));
+        return Nothing();
+      }
+    }
+
+    const double value = strtod(digits.c_str(), &endptr);
+    if (endptr != digits.c_str() + digits.size()) {
+      return Error("Invalid number '" + digits + "'");
+    }
+
+    _number = Number(value);
+    return Nothing();
+  }
+
+  // Reads four hexadecimal digits following a '\u' escape.
+  Option<uint32_t> hex4()
+  {
+    if (end - cursor < 4) {
+      return None();
+    }
+
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+      const char c = *cursor++;
+      value <<= 4;
+      if (c >= '0' && c <= '9') {
+        value |= c - '0';
+      } else if (c >= 'a' && c <= 'f') {
+        value |= c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'F') {
+        value |= c - 'A' + 10;
+      } else {
+        return None();
+      }
+    }
+
+    return value;
+  }
+
+  void utf8(uint32_t codepoint)
+  {
+    if (codepoint < 0x80) {
+      buffer.push_back(static_cast<char>(codepoint));
+    } else if (codepoint < 0x800) {
+      buffer.push_back(static_cast<char>(0xc0 | (codepoint >> 6)));
+      buffer.push_back(static_cast<char>(0x80 | (codepoint & 0x3f)));
+    } else if (codepoint < 0x10000) {
+      buffer.push_back(static_cast<char>(0xe0 | (codepoint >> 12)));
+      buffer.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3f)));
+      buffer.push_back(static_cast<char>(0x80 | (codepoint & 0x3f)));
+    } else {
+      buffer.push_back(static_cast<char>(0xf0 | (codepoint >> 18)));
+      buffer.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3f)));
+      buffer.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3f)));
+      buffer.push_back(static_cast<char>(0x80 | (codepoint & 0x3f)));
+    }
+  }
+
+  // Parses a string starting at the opening '"' into 'buffer'. Runs
+  // of unescaped characters are appended in bulk.
+  Try<Nothing> parseString()
+  {
+    CHECK(cursor != end && *cursor == '"');
+    ++cursor;
+
+    buffer.clear();
+
+    while (true) {
+      const char* run = cursor;
+      while (cursor != end &&
+             *cursor != '"' &&
+             *cursor != '\\' &&
+             static_cast<unsigned char>(*cursor) >= 0x20) {
+        ++cursor;
+      }
+
+      buffer.append(run, cursor - run);
+
+      if (cursor == end) {
+        return Error("Unterminated string");
+      } else if (*cursor == '"') {
+        ++cursor;
+        return Nothing();
+      } else if (*cursor != '\\') {
+        return Error("Unescaped control character in string");
+      }
+
+      // Escape sequence.
+      ++cursor;
+      if (cursor == end) {
+        return Error("Unterminated string");
+      }
+
+      switch (*cursor++) {
+        case '"':  buffer.push_back('"');  break;
+        case '\\': buffer.push_back('\\'); break;
+        case '/':  buffer.push_back('/');  break;
+        case 'b':  buffer.push_back('\b'); break;
+        case 'f':  buffer.push_back('\f'); break;
+        case 'n':  buffer.push_back('\n'); break;
+        case 'r':  buffer.push_back('\r'); break;
+        case 't':  buffer.push_back('\t'); break;
+        case 'u': {
+          Option<uint32_t> codepoint = hex4();
+          if (codepoint.isNone()) {
+            return Error("Invalid unicode escape");
+          }
+
+          // Combine UTF-16 surrogate pairs.
+          if (codepoint.get() >= 0xd800 && codepoint.get() <= 0xdfff) {
+            if (codepoint.get() > 0xdbff ||
+                end - cursor < 2 ||
+                cursor[0] != '\\' ||
+                cursor[1] != 'u') {
+              return Error("Invalid unicode surrogate pair");
+            }
+
+            cursor += 2;
+
+            Option<uint32_t> low = hex4();
+            if (low.isNone() || low.get() < 0xdc00 || low.get() > 0xdfff) {
+              return Error("Invalid unicode surrogate pair");
+            }
+
+            codepoint = 0x10000 +
+              (((codepoint.get() - 0xd800) << 10) | (low.get() - 0xdc00));
+          }
+
+          utf8(codepoint.get());
+          break;
+        }
+        default:
+          return Error("Invalid escape sequence");
+      }
+    }
+  }
+
+  const char* cursor;
+  const char* const begin;
+  const char* const end;
+
+  State state;
+  std::vector<Container> stack;
+
+  // The last token returned by 'next', used by 'skip'.
+  Option<Token> last;
+
+  Option<Error> error;
+
+  // Payloads of the last token.
+  std::string buffer;
+  std::string digits;
+  Number _number;
+  bool _boolean;
+};
+
+} // namespace JSON {
+
+#endif // __STOUT_JSON_READER_HPP__
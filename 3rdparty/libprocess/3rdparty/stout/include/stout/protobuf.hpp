@@ -42,6 +42,8 @@
 #include <stout/stringify.hpp>
 #include <stout/try.hpp>
 
+#include <stout/json/reader.hpp>
+
 #include <stout/os/close.hpp>
 #include <stout/os/open.hpp>
 #include <stout/os/read.hpp>
@@ -591,6 +593,196 @@ struct Parse<google::protobuf::RepeatedPtrField<T>>
   }
 };
 
+
+// Forward declaration.
+Try<Nothing> parse(
+    google::protobuf::Message* message,
+    JSON::Reader* reader);
+
+
+// Decodes the value starting with 'token' into 'field' of 'message'.
+// Scalars are handed to 'Parser' so that both the JSON::Value based
+// and the streaming decoders apply exactly the same conversions.
+inline Try<Nothing> parse(
+    google::protobuf::Message* message,
+    const google::protobuf::FieldDescriptor* field,
+    JSON::Reader* reader,
+    JSON::Reader::Token token)
+{
+  switch (token) {
+    case JSON::Reader::OBJECT_START: {
+      if (field->type() != google::protobuf::FieldDescriptor::TYPE_MESSAGE) {
+        return Error("Not expecting a JSON object for field '" +
+                     field->name() + "'");
+      }
+
+      const google::protobuf::Reflection* reflection =
+        message->GetReflection();
+
+      return parse(
+          field->is_repeated()
+            ? reflection->AddMessage(message, field)
+            : reflection->MutableMessage(message, field),
+          reader);
+    }
+    case JSON::Reader::ARRAY_START: {
+      if (!field->is_repeated()) {
+        return Error("Not expecting a JSON array for field '" +
+                     field->name() + "'");
+      }
+
+      while (true) {
+        Try<JSON::Reader::Token> next = reader->next();
+        if (next.isError()) {
+          return Error(next.error());
+        } else if (next.get() == JSON::Reader::ARRAY_END) {
+          return Nothing();
+        }
+
+        Try<Nothing> apply = parse(message, field, reader, next.get());
+        if (apply.isError()) {
+          return apply;
+        }
+      }
+    }
+    case JSON::Reader::STRING:
+      return Parser(message, field)(JSON::String(reader->string()));
+    case JSON::Reader::NUMBER:
+      return Parser(message, field)(reader->number());
+    case JSON::Reader::BOOLEAN:
+      return Parser(message, field)(JSON::Boolean(reader->boolean()));
+    case JSON::Reader::NULL_VALUE:
+      return Parser(message, field)(JSON::Null());
+    case JSON::Reader::OBJECT_END:
+    case JSON::Reader::ARRAY_END:
+    case JSON::Reader::KEY:
+    case JSON::Reader::END:
+      return Error("Unexpected JSON token");
+  }
+
+  UNREACHABLE();
+}
+
+
+// Decodes the members of a JSON object, whose OBJECT_START has
+// already been consumed, directly into 'message'. Like the
+// JSON::Object based parser, unknown fields are ignored.
+inline Try<Nothing> parse(
+    google::protobuf::Message* message,
+    JSON::Reader* reader)
+{
+  const google::protobuf::Descriptor* descriptor = message->GetDescriptor();
+
+  while (true) {
+    Try<JSON::Reader::Token> token = reader->next();
+    if (token.isError()) {
+      return Error(token.error());
+    } else if (token.get() == JSON::Reader::OBJECT_END) {
+      return Nothing();
+    }
+
+    CHECK_EQ(JSON::Reader::KEY, token.get());
+
+    const google::protobuf::FieldDescriptor* field =
+      descriptor->FindFieldByName(reader->string());
+
+    if (field == NULL) {
+      Try<Nothing> skip = reader->skip();
+      if (skip.isError()) {
+        return skip;
+      }
+      continue;
+    }
+
+    token = reader->next();
+    if (token.isError()) {
+      return Error(token.error());
+    }
+
+    Try<Nothing> apply = parse(message, field, reader, token.get());
+    if (apply.isError()) {
+      return apply;
+    }
+  }
+}
+
+
+// Streaming counterpart of 'Parse', used by the public
+// parse<T>(JSON::Reader*) below.
+template <typename T>
+struct StreamParse
+{
+  Try<T> operator()(JSON::Reader* reader)
+  {
+    static_assert(std::is_convertible<T*, google::protobuf::Message*>::value,
+                  "T must be a protobuf message");
+
+    Try<JSON::Reader::Token> token = reader->next();
+    if (token.isError()) {
+      return Error(token.error());
+    } else if (token.get() != JSON::Reader::OBJECT_START) {
+      return Error("Expecting a JSON object");
+    }
+
+    T message;
+
+    Try<Nothing> parse = internal::parse(&message, reader);
+    if (parse.isError()) {
+      return Error(parse.error());
+    }
+
+    if (!message.IsInitialized()) {
+      return Error("Missing required fields: " +
+                   message.InitializationErrorString());
+    }
+
+    return message;
+  }
+};
+
+
+template <typename T>
+struct StreamParse<google::protobuf::RepeatedPtrField<T>>
+{
+  Try<google::protobuf::RepeatedPtrField<T>> operator()(JSON::Reader* reader)
+  {
+    static_assert(std::is_convertible<T*, google::protobuf::Message*>::value,
+                  "T must be a protobuf message");
+
+    Try<JSON::Reader::Token> token = reader->next();
+    if (token.isError()) {
+      return Error(token.error());
+    } else if (token.get() != JSON::Reader::ARRAY_START) {
+      return Error("Expecting a JSON array");
+    }
+
+    google::protobuf::RepeatedPtrField<T> collection;
+
+    while (true) {
+      token = reader->next();
+      if (token.isError()) {
+        return Error(token.error());
+      } else if (token.get() == JSON::Reader::ARRAY_END) {
+        return collection;
+      } else if (token.get() != JSON::Reader::OBJECT_START) {
+        return Error("Expecting a JSON object");
+      }
+
+      T* message = collection.Add();
+
+      Try<Nothing> parse = internal::parse(message, reader);
+      if (parse.isError()) {
+        return Error(parse.error());
+      }
+
+      if (!message->IsInitialized()) {
+        return Error("Missing required fields: " +
+                     message->InitializationErrorString());
+      }
+    }
+  }
+};
+
 } // namespace internal {
 
 // A dispatch wrapper which parses protobuf messages(s) from a given JSON value.
@@ -607,6 +799,30 @@ Try<T> parse(const JSON::Value& value)
   return internal::Parse<T>()(value);
 }
 
+
+// Parses protobuf message(s) directly from the tokens of 'reader',
+// without building an intermediate JSON::Value. This produces the
+// same result as parse<T>(JSON::parse(s).get()) at a fraction of the
+// memory and time for large documents. The whole document must be
+// consumed, i.e., trailing non-whitespace characters are an error.
+template <typename T>
+Try<T> parse(JSON::Reader* reader)
+{
+  Try<T> result = internal::StreamParse<T>()(reader);
+  if (result.isError()) {
+    return result;
+  }
+
+  Try<JSON::Reader::Token> token = reader->next();
+  if (token.isError()) {
+    return Error(token.error());
+  }
+
+  CHECK_EQ(JSON::Reader::END, token.get());
+
+  return result;
+}
+
 } // namespace protobuf {
 
 namespace JSON {
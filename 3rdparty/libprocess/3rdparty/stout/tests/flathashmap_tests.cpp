@@ -0,0 +1,161 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <stout/flathashmap.hpp>
+#include <stout/foreach.hpp>
+#include <stout/gtest.hpp>
+#include <stout/stringify.hpp>
+
+using std::string;
+
+
+TEST(FlatHashMapTest, InitializerList)
+{
+  flathashmap<string, int> map{{"hello", 1}};
+  EXPECT_EQ(1u, map.size());
+
+  EXPECT_TRUE((flathashmap<int, int>{}.empty()));
+
+  flathashmap<int, int> map2{{1, 2}, {2, 3}, {3, 4}};
+  EXPECT_EQ(3u, map2.size());
+  EXPECT_SOME_EQ(2, map2.get(1));
+  EXPECT_SOME_EQ(3, map2.get(2));
+  EXPECT_SOME_EQ(4, map2.get(3));
+  EXPECT_NONE(map2.get(4));
+}
+
+
+TEST(FlatHashMapTest, FromStdMap)
+{
+  std::map<int, int> map1{{1, 2}, {2, 3}};
+
+  flathashmap<int, int> map2(map1);
+  EXPECT_EQ(2u, map2.size());
+  EXPECT_SOME_EQ(2, map2.get(1));
+  EXPECT_SOME_EQ(3, map2.get(2));
+
+  flathashmap<int, int> map3(std::move(map1));
+  EXPECT_EQ(map2, map3);
+}
+
+
+TEST(FlatHashMapTest, Insert)
+{
+  flathashmap<string, int> map;
+  map["abc"] = 1;
+  map.put("def", 2);
+
+  ASSERT_SOME_EQ(1, map.get("abc"));
+  ASSERT_SOME_EQ(2, map.get("def"));
+
+  map.put("def", 4);
+  ASSERT_SOME_EQ(4, map.get("def"));
+  ASSERT_EQ(2u, map.size());
+
+  EXPECT_FALSE(map.insert(std::make_pair("abc", 5)).second);
+  EXPECT_TRUE(map.emplace("ghi", 6).second);
+  EXPECT_SOME_EQ(1, map.get("abc"));
+  EXPECT_SOME_EQ(6, map.get("ghi"));
+  EXPECT_EQ(3u, map.size());
+
+  EXPECT_TRUE(map.contains("abc"));
+  EXPECT_TRUE(map.containsValue(6));
+  EXPECT_FALSE(map.contains("xyz"));
+  EXPECT_FALSE(map.containsValue(7));
+}
+
+
+// Grows the map well beyond its initial capacity while erasing, and
+// checks it against a std::map.
+TEST(FlatHashMapTest, GrowAndErase)
+{
+  flathashmap<int, string> map;
+  std::map<int, string> expected;
+
+  for (int i = 0; i < 10000; i++) {
+    map[i] = stringify(i);
+    expected[i] = stringify(i);
+
+    if (i % 3 == 0) {
+      EXPECT_EQ(1u, map.erase(i / 2));
+      expected.erase(i / 2);
+    }
+  }
+
+  EXPECT_EQ(expected.size(), map.size());
+  EXPECT_EQ(0u, map.erase(-1));
+
+  foreachpair (int key, const string& value, expected) {
+    EXPECT_SOME_EQ(value, map.get(key));
+  }
+
+  size_t count = 0;
+  foreachpair (int key, const string& value, map) {
+    EXPECT_EQ(expected[key], value);
+    count++;
+  }
+
+  EXPECT_EQ(expected.size(), count);
+
+  // Erasing while iterating visits every element exactly once.
+  count = 0;
+  for (auto iterator = map.begin(); iterator != map.end();) {
+    if (iterator->first % 2 == 0) {
+      iterator = map.erase(iterator);
+    } else {
+      ++iterator;
+    }
+    count++;
+  }
+
+  EXPECT_EQ(expected.size(), count);
+
+  foreachkey (int key, map) {
+    EXPECT_EQ(1, key % 2);
+  }
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.end(), map.begin());
+}
+
+
+TEST(FlatHashMapTest, CopyAndMove)
+{
+  flathashmap<string, std::shared_ptr<int>> map;
+  for (int i = 0; i < 100; i++) {
+    map[stringify(i)] = std::make_shared<int>(i);
+  }
+
+  flathashmap<string, std::shared_ptr<int>> copy = map;
+  EXPECT_EQ(100u, copy.size());
+  EXPECT_EQ(2, map["42"].use_count());
+
+  flathashmap<string, std::shared_ptr<int>> moved = std::move(copy);
+  EXPECT_EQ(100u, moved.size());
+  EXPECT_EQ(2, map["42"].use_count());
+
+  moved.clear();
+  EXPECT_EQ(1, map["42"].use_count());
+
+  // No values are leaked or destroyed twice when growing.
+  map.reserve(10000);
+  EXPECT_EQ(1, map["42"].use_count());
+  EXPECT_EQ(42, *map["42"]);
+}
@@ -0,0 +1,87 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <set>
+#include <string>
+
+#include <stout/flathashset.hpp>
+#include <stout/foreach.hpp>
+
+#include <gtest/gtest.h>
+
+#include <gmock/gmock.h>
+
+using std::string;
+
+
+TEST(FlatHashsetTest, InitializerList)
+{
+  flathashset<string> set{"hello"};
+  EXPECT_EQ(1u, set.size());
+
+  EXPECT_TRUE((flathashset<int>{}.empty()));
+
+  flathashset<int> set1{1, 3, 5, 7, 11};
+  EXPECT_EQ(5u, set1.size());
+  EXPECT_TRUE(set1.contains(1));
+  EXPECT_TRUE(set1.contains(3));
+  EXPECT_TRUE(set1.contains(5));
+  EXPECT_TRUE(set1.contains(7));
+  EXPECT_TRUE(set1.contains(11));
+
+  EXPECT_FALSE(set1.contains(2));
+}
+
+
+TEST(FlatHashsetTest, FromStdSet)
+{
+  std::set<int> set1{1, 3, 5, 7};
+
+  flathashset<int> set2(set1);
+
+  EXPECT_EQ(4u, set2.size());
+
+  foreach (int elem, set1) {
+    EXPECT_TRUE(set2.contains(elem));
+  }
+}
+
+
+TEST(FlatHashsetTest, InsertAndErase)
+{
+  flathashset<int> set;
+
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_TRUE(set.insert(i).second);
+  }
+
+  EXPECT_FALSE(set.insert(0).second);
+  EXPECT_EQ(1000u, set.size());
+
+  for (int i = 0; i < 1000; i += 2) {
+    EXPECT_EQ(1u, set.erase(i));
+  }
+
+  EXPECT_EQ(500u, set.size());
+
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_EQ(i % 2 == 1, set.contains(i));
+  }
+
+  flathashset<int> odd;
+  for (int i = 1; i < 1000; i += 2) {
+    odd.emplace(i);
+  }
+
+  EXPECT_EQ(odd, set);
+  EXPECT_EQ(odd, odd | set);
+}
@@ -20,8 +20,10 @@
 
 #include <gmock/gmock.h>
 
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
 #include <stout/json.hpp>
+#include <stout/json/reader.hpp>
 #include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 
@@ -273,6 +275,136 @@ TEST(JsonTest, ParseError)
 }
 
 
+TEST(JsonTest, Reader)
+{
+  string jsonString =
+    " {"
+    "  \"string\": \"a\\\"b\\u00e9\\ud83d\\ude00\","
+    "  \"integer\": -1,"
+    "  \"double\": 1.5e3,"
+    "  \"array\": [true, false, null, {}, []],"
+    "  \"nested\": {\"key\": \"value\"}"
+    "}\n";
+
+  JSON::Reader reader(jsonString);
+
+  EXPECT_SOME_EQ(JSON::Reader::OBJECT_START, reader.next());
+
+  EXPECT_SOME_EQ(JSON::Reader::KEY, reader.next());
+  EXPECT_EQ("string", reader.string());
+  EXPECT_SOME_EQ(JSON::Reader::STRING, reader.next());
+  EXPECT_EQ("a\"b\xc3\xa9\xf0\x9f\x98\x80", reader.string());
+
+  EXPECT_SOME_EQ(JSON::Reader::KEY, reader.next());
+  EXPECT_SOME_EQ(JSON::Reader::NUMBER, reader.next());
+  EXPECT_EQ(JSON::Number::SIGNED_INTEGER, reader.number().type);
+  EXPECT_EQ(-1, reader.number().as<int64_t>());
+
+  EXPECT_SOME_EQ(JSON::Reader::KEY, reader.next());
+  EXPECT_SOME_EQ(JSON::Reader::NUMBER, reader.next());
+  EXPECT_EQ(JSON::Number::FLOATING, reader.number().type);
+  EXPECT_EQ(1500.0, reader.number().as<double>());
+
+  EXPECT_SOME_EQ(JSON::Reader::KEY, reader.next());
+  EXPECT_SOME_EQ(JSON::Reader::ARRAY_START, reader.next());
+  EXPECT_EQ(2u, reader.depth());
+  EXPECT_SOME_EQ(JSON::Reader::BOOLEAN, reader.next());
+  EXPECT_TRUE(reader.boolean());
+  EXPECT_SOME_EQ(JSON::Reader::BOOLEAN, reader.next());
+  EXPECT_FALSE(reader.boolean());
+  EXPECT_SOME_EQ(JSON::Reader::NULL_VALUE, reader.next());
+  EXPECT_SOME_EQ(JSON::Reader::OBJECT_START, reader.next());
+  EXPECT_SOME_EQ(JSON::Reader::OBJECT_END, reader.next());
+  EXPECT_SOME_EQ(JSON::Reader::ARRAY_START, reader.next());
+  EXPECT_SOME_EQ(JSON::Reader::ARRAY_END, reader.next());
+  EXPECT_SOME_EQ(JSON::Reader::ARRAY_END, reader.next());
+
+  // Skipping a key consumes its entire value.
+  EXPECT_SOME_EQ(JSON::Reader::KEY, reader.next());
+  EXPECT_EQ("nested", reader.string());
+  EXPECT_SOME(reader.skip());
+
+  EXPECT_SOME_EQ(JSON::Reader::OBJECT_END, reader.next());
+  EXPECT_EQ(0u, reader.depth());
+  EXPECT_SOME_EQ(JSON::Reader::END, reader.next());
+}
+
+
+TEST(JsonTest, ReaderError)
+{
+  // Anything the reader accepts or rejects should match 'JSON::parse'.
+  const string invalid[] = {
+    "{\"key1\": \"value1\"}trailingcharacters",
+    "{\"key1\": \"value1\"},{\"key2\": \"value2\"}",
+    "{\"key1\": \"value1\" ",
+    "{\"key1\" \"value1\"}",
+    "{\"key1\": \"value1\",}",
+    "[1, 2",
+    "[1 2]",
+    "{key: 1}",
+    "\"unterminated",
+    "\"\\ud83d\"",
+    "nul",
+    "",
+  };
+
+  foreach (const string& s, invalid) {
+    EXPECT_ERROR(JSON::parse(s)) << s;
+
+    JSON::Reader reader(s);
+
+    Try<JSON::Reader::Token> token = reader.next();
+    while (token.isSome() && token.get() != JSON::Reader::END) {
+      token = reader.next();
+    }
+
+    EXPECT_ERROR(token) << s;
+
+    // Errors are sticky.
+    EXPECT_ERROR(reader.next()) << s;
+  }
+}
+
+
+// Numbers must follow RFC 7159, i.e., the reader rejects a leading
+// '+' and leading zeros that 'JSON::parse' accepts.
+TEST(JsonTest, ReaderNumber)
+{
+  const string valid[] = {"0", "-0", "0.5", "-0.5", "0e1", "10", "1e+5"};
+
+  foreach (const string& s, valid) {
+    JSON::Reader reader(s);
+
+    EXPECT_SOME_EQ(JSON::Reader::NUMBER, reader.next()) << s;
+    EXPECT_SOME_EQ(JSON::Reader::END, reader.next()) << s;
+    EXPECT_FALSE(reader.failed()) << s;
+  }
+
+  const string invalid[] = {
+    "+1",
+    "[+1]",
+    "{\"key\": +1.5}",
+    "007",
+    "-01",
+    "00",
+    "[0, 01]",
+    "{\"key\": 00.5}",
+  };
+
+  foreach (const string& s, invalid) {
+    JSON::Reader reader(s);
+
+    Try<JSON::Reader::Token> token = reader.next();
+    while (token.isSome() && token.get() != JSON::Reader::END) {
+      token = reader.next();
+    }
+
+    EXPECT_ERROR(token) << s;
+    EXPECT_TRUE(reader.failed()) << s;
+  }
+}
+
+
 TEST(JsonTest, Find)
 {
   JSON::Object object;
@@ -17,8 +17,10 @@
 #include <algorithm>
 #include <string>
 
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
 #include <stout/json.hpp>
+#include <stout/json/reader.hpp>
 #include <stout/protobuf.hpp>
 #include <stout/stringify.hpp>
 #include <stout/strings.hpp>
@@ -340,3 +342,82 @@ TEST(ProtobufTest, ParseJSONArray)
   EXPECT_EQ(message, repeated.Get(0));
   EXPECT_EQ(message, repeated.Get(1));
 }
+
+
+// Tests that decoding straight from a JSON string yields the same
+// messages as going through an intermediate JSON::Value.
+TEST(ProtobufTest, ParseJSONReader)
+{
+  tests::Message message;
+  message.set_b(true);
+  message.set_str("string");
+  message.set_bytes(UUID::random().toBytes());
+  message.set_int64(-9223372036854775807);
+  message.set_uint64(9223372036854775807);
+  message.set_f(1.5);
+  message.set_d(-2.25);
+  message.set_e(tests::TWO);
+  message.mutable_nested()->set_str("nested");
+  message.add_repeated_string("repeated_string");
+  message.add_repeated_double(1.0);
+  message.add_repeated_double(2.0);
+  message.add_repeated_enum(tests::ONE);
+  message.add_repeated_nested()->set_str("repeated_nested1");
+  message.add_repeated_nested()->set_str("repeated_nested2");
+
+  const string json = stringify(JSON::protobuf(message));
+
+  JSON::Reader reader(json);
+
+  Try<tests::Message> parse = protobuf::parse<tests::Message>(&reader);
+  ASSERT_SOME(parse);
+
+  EXPECT_EQ(JSON::protobuf(message), JSON::protobuf(parse.get()));
+
+  // Unknown fields, including nested ones, are skipped.
+  string unknown =
+    "{"
+    "  \"id\": \"message1\","
+    "  \"unknown\": {\"a\": [1, {\"b\": null}], \"c\": \"d\"},"
+    "  \"numbers\": [1, 2]"
+    "}";
+
+  JSON::Reader reader2(unknown);
+
+  Try<tests::SimpleMessage> simple =
+    protobuf::parse<tests::SimpleMessage>(&reader2);
+  ASSERT_SOME(simple);
+
+  tests::SimpleMessage expected;
+  expected.set_id("message1");
+  expected.add_numbers(1);
+  expected.add_numbers(2);
+
+  EXPECT_EQ(expected, simple.get());
+
+  // Arrays of messages.
+  string array = "[" + stringify(JSON::protobuf(expected)) + "]";
+
+  JSON::Reader reader3(array);
+
+  Try<RepeatedPtrField<tests::SimpleMessage>> repeated =
+    protobuf::parse<RepeatedPtrField<tests::SimpleMessage>>(&reader3);
+  ASSERT_SOME(repeated);
+  ASSERT_EQ(1, repeated.get().size());
+  EXPECT_EQ(expected, repeated.get().Get(0));
+
+  // Missing required fields, type mismatches and trailing
+  // characters are all errors.
+  const string invalid[] = {
+    "{\"numbers\": [1]}",
+    "{\"id\": 1}",
+    "{\"id\": \"message1\", \"numbers\": [\"1\"]}",
+    "{\"id\": null}",
+    "{\"id\": \"message1\"} {}",
+  };
+
+  foreach (const string& s, invalid) {
+    JSON::Reader reader(s);
+    EXPECT_ERROR(protobuf::parse<tests::SimpleMessage>(&reader)) << s;
+  }
+}
@@ -66,6 +66,75 @@ struct wrap;
 template <typename T>
 struct unwrap;
 
+
+// A list of callbacks which stores the first callback inline and only
+// allocates once more than one callback has been registered. Most
+// futures only ever have a single continuation (e.g., via 'then' or
+// 'onAny'), so this avoids an allocation for each link in a chain.
+template <typename C>
+class CallbackList
+{
+public:
+  CallbackList() : count(0) {}
+
+  CallbackList(CallbackList&& that)
+    : count(that.count),
+      first(std::move(that.first)),
+      rest(std::move(that.rest))
+  {
+    that.count = 0;
+  }
+
+  CallbackList& operator=(CallbackList&& that)
+  {
+    if (this != &that) {
+      count = that.count;
+      first = std::move(that.first);
+      rest = std::move(that.rest);
+      that.count = 0;
+    }
+    return *this;
+  }
+
+  void emplace_back(C&& callback)
+  {
+    if (count == 0) {
+      first = std::move(callback);
+    } else {
+      rest.emplace_back(std::move(callback));
+    }
+    ++count;
+  }
+
+  void push_back(const C& callback)
+  {
+    emplace_back(C(callback));
+  }
+
+  const C& operator[](size_t i) const
+  {
+    return i == 0 ? first : rest[i - 1];
+  }
+
+  size_t size() const { return count; }
+
+  bool empty() const { return count == 0; }
+
+  void clear()
+  {
+    // NOTE: We reset 'first' so that anything it has bound (e.g., a
+    // promise) is released right away rather than when the future is.
+    first = C();
+    rest.clear();
+    count = 0;
+  }
+
+private:
+  size_t count;
+  C first;
+  std::vector<C> rest;
+};
+
 } // namespace internal {
 
 
@@ -413,11 +482,11 @@ private:
     //   3. Error, the state is FAILED; 'error()' stores the message.
     Result<T> result;
 
-    std::vector<DiscardCallback> onDiscardCallbacks;
-    std::vector<ReadyCallback> onReadyCallbacks;
-    std::vector<FailedCallback> onFailedCallbacks;
-    std::vector<DiscardedCallback> onDiscardedCallbacks;
-    std::vector<AnyCallback> onAnyCallbacks;
+    internal::CallbackList<DiscardCallback> onDiscardCallbacks;
+    internal::CallbackList<ReadyCallback> onReadyCallbacks;
+    internal::CallbackList<FailedCallback> onFailedCallbacks;
+    internal::CallbackList<DiscardedCallback> onDiscardedCallbacks;
+    internal::CallbackList<AnyCallback> onAnyCallbacks;
   };
 
   // Sets the value for this future, unless the future is already set,
@@ -438,7 +507,7 @@ namespace internal {
 //
 // TODO(*): Invoke callbacks in another execution context.
 template <typename C, typename... Arguments>
-void run(const std::vector<C>& callbacks, Arguments&&... arguments)
+void run(const CallbackList<C>& callbacks, Arguments&&... arguments)
 {
   for (size_t i = 0; i < callbacks.size(); ++i) {
     callbacks[i](std::forward<Arguments>(arguments)...);
@@ -744,7 +813,8 @@ void select(
 template <typename T>
 Future<Future<T>> select(const std::set<Future<T>>& futures)
 {
-  std::shared_ptr<Promise<Future<T>>> promise(new Promise<Future<T>>());
+  std::shared_ptr<Promise<Future<T>>> promise =
+    std::make_shared<Promise<Future<T>>>();
 
   promise->future().onDiscard(
       lambda::bind(&internal::discarded<Future<T>>, promise->future()));
@@ -843,12 +913,12 @@ void Future<T>::Data::clearAllCallbacks()
 
 template <typename T>
 Future<T>::Future()
-  : data(new Data()) {}
+  : data(std::make_shared<Data>()) {}
 
 
 template <typename T>
 Future<T>::Future(const T& _t)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   set(_t);
 }
@@ -857,7 +927,7 @@ Future<T>::Future(const T& _t)
 template <typename T>
 template <typename U>
 Future<T>::Future(const U& u)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   set(u);
 }
@@ -865,7 +935,7 @@ Future<T>::Future(const U& u)
 
 template <typename T>
 Future<T>::Future(const Failure& failure)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   fail(failure.message);
 }
@@ -883,7 +953,7 @@ Future<T>::Future(Future<T>&& that)
 
 template <typename T>
 Future<T>::Future(const Try<T>& t)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   if (t.isSome()){
     set(t.get());
@@ -929,12 +999,12 @@ bool Future<T>::discard()
 {
   bool result = false;
 
-  std::vector<DiscardCallback> callbacks;
+  internal::CallbackList<DiscardCallback> callbacks;
   synchronized (data->lock) {
     if (!data->discard && data->state == PENDING) {
       result = data->discard = true;
 
-      // NOTE: We make a copy of the onDiscard callbacks here
+      // NOTE: We move the onDiscard callbacks out here
       // because it is possible that another thread completes this
       // future (ready, failed or discarded) when the current thread
       // is out of this critical section but *before* it executed the
@@ -942,8 +1012,7 @@ bool Future<T>::discard()
       // be clearing the onDiscard callbacks (via clearAllCallbacks())
       // while the current thread is executing or clearing the
       // onDiscard callbacks, causing thread safety issue.
-      callbacks = data->onDiscardCallbacks;
-      data->onDiscardCallbacks.clear();
+      callbacks = std::move(data->onDiscardCallbacks);
     }
   }
 
@@ -1284,12 +1353,12 @@ template <typename T>
 template <typename X>
 Future<X> Future<T>::then(const lambda::function<Future<X>(const T&)>& f) const
 {
-  std::shared_ptr<Promise<X>> promise(new Promise<X>());
+  std::shared_ptr<Promise<X>> promise = std::make_shared<Promise<X>>();
 
   lambda::function<void(const Future<T>&)> thenf =
     lambda::bind(&internal::thenf<T, X>, f, promise, lambda::_1);
 
-  onAny(thenf);
+  onAny(std::move(thenf));
 
   // Propagate discarding up the chain. To avoid cyclic dependencies,
   // we keep a weak future in the callback.
@@ -1304,12 +1373,12 @@ template <typename T>
 template <typename X>
 Future<X> Future<T>::then(const lambda::function<X(const T&)>& f) const
 {
-  std::shared_ptr<Promise<X>> promise(new Promise<X>());
+  std::shared_ptr<Promise<X>> promise = std::make_shared<Promise<X>>();
 
   lambda::function<void(const Future<T>&)> then =
     lambda::bind(&internal::then<T, X>, f, promise, lambda::_1);
 
-  onAny(then);
+  onAny(std::move(then));
 
   // Propagate discarding up the chain. To avoid cyclic dependencies,
   // we keep a weak future in the callback.
@@ -1324,7 +1393,7 @@ template <typename T>
 Future<T> Future<T>::repair(
     const lambda::function<Future<T>(const Future<T>&)>& f) const
 {
-  std::shared_ptr<Promise<T>> promise(new Promise<T>());
+  std::shared_ptr<Promise<T>> promise = std::make_shared<Promise<T>>();
 
   onAny(lambda::bind(&internal::repair<T>, f, promise, lambda::_1));
 
@@ -1346,7 +1415,7 @@ Future<T> Future<T>::after(
   // Unfortunately, Once depends on Future so we can't easily use it
   // from here.
   std::shared_ptr<Latch> latch(new Latch());
-  std::shared_ptr<Promise<T>> promise(new Promise<T>());
+  std::shared_ptr<Promise<T>> promise = std::make_shared<Promise<T>>();
 
   // Set up a timer to invoke the callback if this future has not
   // completed. Note that we do not pass a weak reference for this
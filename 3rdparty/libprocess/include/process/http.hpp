@@ -330,6 +330,11 @@ public:
     // was unable to continue reading!
     Future<Nothing> readerClosed() const;
 
+    // Returns the number of bytes written to the pipe that the
+    // reader has not read yet, so that a writer can notice that
+    // the reader does not keep up.
+    size_t size() const;
+
     // Comparison operators useful for checking connection equality.
     bool operator==(const Writer& other) const { return data == other.data; }
     bool operator!=(const Writer& other) const { return !(*this == other); }
@@ -361,7 +366,8 @@ private:
   {
     Data()
       : readEnd(Reader::OPEN),
-        writeEnd(Writer::OPEN) {}
+        writeEnd(Writer::OPEN),
+        size(0) {}
 
     // Rather than use a process to serialize access to the pipe's
     // internal data we use a 'std::atomic_flag'.
@@ -377,6 +383,9 @@ private:
     // empty strings as they serve as a signal for end-of-file.
     std::queue<std::string> writes;
 
+    // The number of bytes of the unread writes.
+    size_t size;
+
     // Signals when the read-end is closed before the write-end.
     Promise<Nothing> readerClosure;
 
@@ -87,6 +87,17 @@ public:
     return t;
   }
 
+  // Record the duration of an event timed by the caller, e.g., for
+  // overlapping events which cannot share 'start' and 'stop'.
+  void record(const T& t)
+  {
+    synchronized (data->lock) {
+      data->lastValue = t.value();
+    }
+
+    push(t.value());
+  }
+
   // Time an asynchronous event.
   template <typename U>
   Future<U> time(const Future<U>& future)
@@ -16,6 +16,7 @@
 #include <stdint.h>
 
 #include <map>
+#include <memory>
 #include <queue>
 #include <vector>
 
@@ -61,6 +62,51 @@ void install(std::vector<Owned<FirewallRule>>&& rules);
 
 } // namespace firewall {
 
+
+/**
+ * Describes where a process prefers to be run.
+ *
+ * Preferences are only honored when the processing threads have been
+ * pinned to CPUs via the `LIBPROCESS_WORKER_CPUS` environment
+ * variable, and when at least one processing thread matches the
+ * preference. Otherwise the process may be run on any thread.
+ *
+ * @see process::ProcessBase::prefer
+ */
+struct Affinity
+{
+  enum Type
+  {
+    NONE,
+    WORKER,
+    NODE
+  };
+
+  /**
+   * No preference, the process is run by any processing thread.
+   */
+  static Affinity none() { return Affinity(NONE, 0); }
+
+  /**
+   * The process is only run by the processing thread with the
+   * specified index.
+   */
+  static Affinity worker(size_t index) { return Affinity(WORKER, index); }
+
+  /**
+   * The process is only run by processing threads pinned to CPUs of
+   * the specified NUMA node.
+   */
+  static Affinity node(size_t index) { return Affinity(NODE, index); }
+
+  Type type;
+  size_t index;
+
+private:
+  Affinity(Type _type, size_t _index) : type(_type), index(_index) {}
+};
+
+
 class ProcessBase : public EventVisitor
 {
 public:
@@ -70,6 +116,38 @@ public:
 
   UPID self() const { return pid; }
 
+  /**
+   * Options for the HTTP requests of a route.
+   *
+   * @see process::ProcessBase::route
+   */
+  struct RouteOptions
+  {
+    /**
+     * The maximum number of requests of the route that are handled
+     * concurrently, i.e., whose responses are not yet ready. Requests
+     * beyond the limit are answered with `503 Service Unavailable`
+     * without invoking the handler.
+     */
+    Option<size_t> concurrency;
+
+    /**
+     * The prefix of the metrics that report the cost of the route:
+     *
+     *   `<prefix>/requests`: The number of requests.
+     *   `<prefix>/rejected`: The number of requests rejected due to
+     *       the `concurrency` limit.
+     *   `<prefix>/bytes_out`: The size of the response bodies.
+     *       Streamed (`PIPE`) and file (`PATH`) responses are not
+     *       counted.
+     *   `<prefix>/latency_ms`: The time until the responses are
+     *       ready, with percentiles over a window of 5 minutes.
+     *
+     * No metrics are reported if not set.
+     */
+    Option<std::string> metrics;
+  };
+
 protected:
   /**
    * Invoked when an event is serviced.
@@ -211,11 +289,13 @@ protected:
    *
    * @param name The endpoint or URL to route.
    *     Must begin with a `/`.
+   * @param options The limits and accounting of the requests.
    */
   void route(
       const std::string& name,
       const Option<std::string>& help,
-      const HttpRequestHandler& handler);
+      const HttpRequestHandler& handler,
+      const RouteOptions& options = RouteOptions());
 
   /**
    * @copydoc process::ProcessBase::route
@@ -224,14 +304,15 @@ protected:
   void route(
       const std::string& name,
       const Option<std::string>& help,
-      Future<http::Response> (T::*method)(const http::Request&))
+      Future<http::Response> (T::*method)(const http::Request&),
+      const RouteOptions& options = RouteOptions())
   {
     // Note that we use dynamic_cast here so a process can use
     // multiple inheritance if it sees so fit (e.g., to implement
     // multiple callback interfaces).
     HttpRequestHandler handler =
       lambda::bind(method, dynamic_cast<T*>(this), lambda::_1);
-    route(name, help, handler);
+    route(name, help, handler, options);
   }
 
   /**
@@ -261,6 +342,19 @@ protected:
     assets[name] = asset;
   }
 
+  /**
+   * Sets where this process prefers to be run, for example to keep
+   * processes that communicate frequently on the same NUMA node.
+   *
+   * **NOTE**: this must be called before the process is spawned.
+   *
+   * @see process::Affinity
+   */
+  void prefer(const Affinity& _affinity)
+  {
+    affinity = _affinity;
+  }
+
   /**
    * Returns the number of events of the given type currently on the event
    * queue.
@@ -316,6 +410,12 @@ private:
     std::map<std::string, HttpRequestHandler> http;
   } handlers;
 
+  // The limits and accounting of the routes with `RouteOptions`,
+  // defined in process.cpp. They are shared with the responses that
+  // are not yet ready, which may outlive the process.
+  struct Route;
+  std::map<std::string, std::shared_ptr<Route>> routes;
+
   // Definition of a static asset.
   struct Asset
   {
@@ -332,6 +432,25 @@ private:
   // Active references.
   std::atomic_long refs;
 
+  // Where this process prefers to be run (see 'prefer').
+  Affinity affinity;
+
+  // Statistics about which processing threads have run this process,
+  // only accessed by the processing thread currently running it.
+  struct
+  {
+    // Index of the processing thread that last ran this process or
+    // -1 if the process has not been run yet.
+    long worker;
+
+    uint64_t resumes;
+
+    // Number of times this process was resumed on a different
+    // processing thread (or NUMA node) than the previous time.
+    uint64_t migrations;
+    uint64_t nodeMigrations;
+  } locality;
+
   // Process PID.
   UPID pid;
 };
@@ -211,6 +211,10 @@ private:
  * but before exec'ing. If the return value of 'setup' is non-zero
  * then that gets returned in 'status()' and we will not exec.
  *
+ * If neither 'setup' nor 'clone' is specified the subprocess is
+ * spawned (via 'posix_spawnp') rather than forked, which avoids
+ * copying the address space of a (potentially large) parent.
+ *
  * @param path Relative or absolute path in the filesytem to the
  *     executable.
  * @param argv Argument vector to pass to exec.
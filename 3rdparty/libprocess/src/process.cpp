@@ -37,10 +37,12 @@
 #include <sys/uio.h>
 
 #include <algorithm>
+#include <atomic>
 #include <deque>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <list>
 #include <map>
 #include <memory> // TODO(benh): Replace shared_ptr with unique_ptr.
@@ -78,7 +80,9 @@
 #include <process/time.hpp>
 #include <process/timer.hpp>
 
+#include <process/metrics/counter.hpp>
 #include <process/metrics/metrics.hpp>
+#include <process/metrics/timer.hpp>
 
 #include <stout/duration.hpp>
 #include <stout/foreach.hpp>
@@ -163,6 +167,33 @@ map<string, string> types;
 } // namespace mime {
 
 
+// Encodes a chunk of a stream based response and invokes 'sent' once
+// the chunk is sent on the socket (or dropped because the socket was
+// closed), i.e., once the encoder is deleted.
+//
+// NOTE: Since 'sent' dispatches (which acquires the ProcessManager's
+// 'processes_mutex'), the SocketManager never deletes an encoder
+// while holding its 'mutex': 'ProcessManager::cleanup' acquires the
+// two in the opposite order.
+class ChunkEncoder : public DataEncoder
+{
+public:
+  ChunkEncoder(
+      const Socket& s,
+      const string& data,
+      const lambda::function<void()>& _sent)
+    : DataEncoder(s, data), sent(_sent) {}
+
+  virtual ~ChunkEncoder()
+  {
+    sent();
+  }
+
+private:
+  const lambda::function<void()> sent;
+};
+
+
 // Provides a process that manages sending HTTP responses so as to
 // satisfy HTTP/1.1 pipelining. Each request should either enqueue a
 // response, or ask the proxy to handle a future response. The process
@@ -200,6 +231,10 @@ private:
   // Handles stream based responses.
   void stream(const Request& request, const Future<string>& chunk);
 
+  // Invoked once a chunk of a stream based response is sent, in
+  // order to read the next chunk.
+  void streamed(const Request& request);
+
   Socket socket; // Wrap the socket to keep it from getting closed.
 
   // Describes a queue "item" that wraps the future to the response
@@ -420,10 +455,34 @@ private:
   // Gates for waiting threads (protected by processes_mutex).
   map<ProcessBase*, Gate*> gates;
 
+  // Returns the run queue that the process should be enqueued on
+  // given its affinity (see 'Affinity'). Must be called while
+  // holding 'runq_mutex'.
+  list<ProcessBase*>* runqOf(ProcessBase* process);
+
   // Queue of runnable processes (implemented using list).
   list<ProcessBase*> runq;
   std::recursive_mutex runq_mutex;
 
+  // The processing threads, the CPU they have been pinned to (via the
+  // LIBPROCESS_WORKER_CPUS environment variable) if any, and the run
+  // queues of the processes that prefer to be run by them (protected
+  // by 'runq_mutex'). Only the run queues change after the processing
+  // threads have been created.
+  struct Worker
+  {
+    Option<int> cpu;
+    Option<size_t> node;
+    list<ProcessBase*> runq;
+  };
+
+  vector<Worker> workers;
+
+  // Run queues of processes that prefer to be run on a NUMA node,
+  // keyed by node (protected by 'runq_mutex'). Only nodes with at
+  // least one pinned processing thread have a run queue.
+  map<size_t, list<ProcessBase*>> nodes;
+
   // Number of running processes, to support Clock::settle operation.
   std::atomic_long running;
 
@@ -457,6 +516,10 @@ static SocketManager* socket_manager = NULL;
 // Active ProcessManager (eventually will probably be thread-local).
 static ProcessManager* process_manager = NULL;
 
+// Index of the processing thread or -1 if this is not a processing
+// thread (e.g., the event loop or a thread waiting on a process).
+static THREAD_LOCAL long __worker__ = -1;
+
 // Scheduling gate that threads wait at when there is nothing to run.
 static Gate* gate = new Gate();
 
@@ -1171,20 +1234,28 @@ void HttpProxy::stream(
       // Finished reading.
       out << "0\r\n" << "\r\n";
       finished = true;
+
+      socket_manager->send(
+          new DataEncoder(socket, out.str()),
+          request.keepAlive);
     } else {
       out << std::hex << chunk.get().size() << "\r\n";
       out << chunk.get();
       out << "\r\n";
 
-      // Keep reading.
-      reader.read()
-        .onAny(defer(self(), &Self::stream, request, lambda::_1));
+      // Keep reading once the chunk is sent, so that the data a slow
+      // client has yet to receive stays in the pipe, where the writer
+      // can notice it (see 'Pipe::Writer::size').
+      //
+      // NOTE: Always persist the connection when streaming is not
+      // finished.
+      socket_manager->send(
+          new ChunkEncoder(
+              socket,
+              out.str(),
+              defer(self(), &Self::streamed, request)),
+          true);
     }
-
-    // Always persist the connection when streaming is not finished.
-    socket_manager->send(
-        new DataEncoder(socket, out.str()),
-        finished ? request.keepAlive : true);
   } else if (chunk.isFailed()) {
     VLOG(1) << "Failed to read from stream: " << chunk.failure();
     // TODO(bmahler): Have to close connection if headers were sent!
@@ -1205,6 +1276,17 @@ void HttpProxy::stream(
 }
 
 
+void HttpProxy::streamed(const Request& request)
+{
+  CHECK_SOME(pipe);
+
+  http::Pipe::Reader reader = pipe.get();
+
+  reader.read()
+    .onAny(defer(self(), &Self::stream, request, lambda::_1));
+}
+
+
 SocketManager::SocketManager() {}
 
 
@@ -1527,6 +1609,10 @@ void SocketManager::send(Encoder* encoder, bool persist)
 {
   CHECK(encoder != NULL);
 
+  // An encoder that can not be sent is deleted once we release the
+  // mutex (see 'ChunkEncoder').
+  Encoder* dropped = NULL;
+
   synchronized (mutex) {
     Socket socket = encoder->socket();
     if (sockets.count(socket) > 0) {
@@ -1545,11 +1631,13 @@ void SocketManager::send(Encoder* encoder, bool persist)
       }
     } else {
       VLOG(1) << "Attempting to send on a no longer valid socket!";
-      delete encoder;
+      dropped = encoder;
       encoder = NULL;
     }
   }
 
+  delete dropped;
+
   if (encoder != NULL) {
     internal::send(encoder, new Socket(encoder->socket()));
   }
@@ -1830,6 +1918,10 @@ void SocketManager::close(int s)
 {
   HttpProxy* proxy = NULL; // Non-null if needs to be terminated.
 
+  // The remaining encoders for the socket, which are deleted once we
+  // release the mutex (see 'ChunkEncoder').
+  queue<Encoder*> encoders;
+
   synchronized (mutex) {
     // This socket might not be active if it was already asked to get
     // closed (e.g., a write on the socket failed so we try and close
@@ -1839,12 +1931,7 @@ void SocketManager::close(int s)
     if (sockets.count(s) > 0) {
       // Clean up any remaining encoders for this socket.
       if (outgoing.count(s) > 0) {
-        while (!outgoing[s].empty()) {
-          Encoder* encoder = outgoing[s].front();
-          delete encoder;
-          outgoing[s].pop();
-        }
-
+        std::swap(encoders, outgoing[s]);
         outgoing.erase(s);
       }
 
@@ -1898,6 +1985,11 @@ void SocketManager::close(int s)
     }
   }
 
+  while (!encoders.empty()) {
+    delete encoders.front();
+    encoders.pop();
+  }
+
   // We terminate the proxy outside the synchronized block to avoid
   // possible deadlock between the ProcessManager and SocketManager.
   if (proxy != NULL) {
@@ -2112,6 +2204,98 @@ ProcessManager::~ProcessManager()
 }
 
 
+// Parses a list of CPUs in the format used by the kernel (e.g.,
+// '0-3,8,10-11'), see cpuset(7).
+static Try<vector<int>> parseCpus(const string& list)
+{
+  vector<int> cpus;
+
+  foreach (const string& range, strings::tokenize(list, ",")) {
+    vector<string> bounds = strings::split(strings::trim(range), "-");
+
+    if (bounds.size() > 2) {
+      return Error("Invalid CPU range '" + range + "'");
+    }
+
+    Try<int> first = numify<int>(bounds.front());
+    Try<int> last = numify<int>(bounds.back());
+
+    if (first.isError() || last.isError() || first.get() > last.get()) {
+      return Error("Invalid CPU range '" + range + "'");
+    }
+
+    for (int cpu = first.get(); cpu <= last.get(); cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+
+  return cpus;
+}
+
+
+// Returns the NUMA node of each CPU, or an empty map if the topology
+// can not be determined (e.g., on systems without NUMA support).
+static map<int, size_t> numaNodes()
+{
+  map<int, size_t> nodes;
+
+#ifdef __linux__
+  const string root = "/sys/devices/system/node";
+
+  Try<list<string>> entries = os::ls(root);
+  if (entries.isError()) {
+    return nodes;
+  }
+
+  foreach (const string& entry, entries.get()) {
+    if (!strings::startsWith(entry, "node")) {
+      continue;
+    }
+
+    Try<size_t> node = numify<size_t>(entry.substr(4));
+    Try<string> read = os::read(path::join(root, entry, "cpulist"));
+
+    if (node.isError() || read.isError()) {
+      continue;
+    }
+
+    Try<vector<int>> cpus = parseCpus(read.get());
+    if (cpus.isError()) {
+      continue;
+    }
+
+    foreach (int cpu, cpus.get()) {
+      nodes[cpu] = node.get();
+    }
+  }
+#endif // __linux__
+
+  return nodes;
+}
+
+
+// Pins the thread to the specified CPU.
+static Try<Nothing> pin(std::thread* thread, int cpu)
+{
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+
+  int error = pthread_setaffinity_np(
+      thread->native_handle(), sizeof(set), &set);
+
+  if (error != 0) {
+    return Error(os::strerror(error));
+  }
+
+  return Nothing();
+#else
+  return Error("Not supported on this platform");
+#endif // __linux__
+}
+
+
 long ProcessManager::init_threads()
 {
   joining_threads.store(false);
@@ -2128,13 +2312,50 @@ long ProcessManager::init_threads()
   long cpus = std::max(8L, sysconf(_SC_NPROCESSORS_ONLN));
   threads.reserve(cpus+1);
 
+  // Determine which CPUs (if any) the processing threads should be
+  // pinned to. The processing threads are assigned to the CPUs in a
+  // round-robin fashion.
+  vector<int> pinned;
+
+  Option<string> value = os::getenv("LIBPROCESS_WORKER_CPUS");
+  if (value.isSome()) {
+    Try<vector<int>> parse = parseCpus(value.get());
+    if (parse.isError() || parse.get().empty()) {
+      LOG(FATAL) << "Invalid LIBPROCESS_WORKER_CPUS=" << value.get()
+                 << (parse.isError() ? ": " + parse.error() : "");
+    }
+    pinned = parse.get();
+  }
+
+  const map<int, size_t> topology = numaNodes();
+
+  workers.resize(cpus);
+
+  // NOTE: We set up the workers before creating any processing
+  // thread so that they do not change while the threads are running.
+  if (!pinned.empty()) {
+    for (long i = 0; i < cpus; i++) {
+      const int cpu = pinned[i % pinned.size()];
+
+      workers[i].cpu = cpu;
+
+      if (topology.count(cpu) > 0) {
+        workers[i].node = topology.at(cpu);
+        nodes[topology.at(cpu)];
+      }
+    }
+  }
+
   // Create processing threads.
   for (long i = 0; i < cpus; i++) {
     // Retain the thread handles so that we can join when shutting down.
     threads.emplace_back(
         // We pass a constant reference to `joining` to make it clear that this
         // value is only being tested (read), and not manipulated.
-        new std::thread(std::bind([](const std::atomic_bool& joining) {
+        new std::thread(std::bind([](long index,
+                                     const std::atomic_bool& joining) {
+          __worker__ = index;
+
           do {
             ProcessBase* process = process_manager->dequeue();
             if (process == NULL) {
@@ -2153,7 +2374,17 @@ long ProcessManager::init_threads()
             process_manager->resume(process);
           } while (true);
         },
+        i,
         std::cref(joining_threads))));
+
+    if (workers[i].cpu.isSome()) {
+      Try<Nothing> pin = process::pin(threads.back(), workers[i].cpu.get());
+      if (pin.isError()) {
+        LOG(FATAL) << "Failed to pin processing thread " << i
+                   << " to CPU " << workers[i].cpu.get() << ": "
+                   << pin.error();
+      }
+    }
   }
 
   // Create a thread for the event loop.
@@ -2427,6 +2658,26 @@ void ProcessManager::resume(ProcessBase* process)
 
   VLOG(2) << "Resuming " << process->pid << " at " << Clock::now();
 
+  // Keep track of how often this process moves between processing
+  // threads (and NUMA nodes), see the '/__processes__' endpoint.
+  if (__worker__ >= 0) {
+    const long previous = process->locality.worker;
+
+    if (previous >= 0 && previous != __worker__) {
+      process->locality.migrations++;
+
+      const Option<size_t>& from = workers[previous].node;
+      const Option<size_t>& to = workers[__worker__].node;
+
+      if (from.isSome() && to.isSome() && from.get() != to.get()) {
+        process->locality.nodeMigrations++;
+      }
+    }
+
+    process->locality.worker = __worker__;
+    process->locality.resumes++;
+  }
+
   bool terminate = false;
   bool blocked = false;
 
@@ -2698,9 +2949,10 @@ bool ProcessManager::wait(const UPID& pid)
       if (process->state == ProcessBase::BOTTOM ||
           process->state == ProcessBase::READY) {
         synchronized (runq_mutex) {
+          list<ProcessBase*>* queue = runqOf(process);
           list<ProcessBase*>::iterator it =
-            find(runq.begin(), runq.end(), process);
-          if (it != runq.end()) {
+            find(queue->begin(), queue->end(), process);
+          if (it != queue->end()) {
             // Found it! Remove it from the run queue since we'll be
             // donating our thread and also increment 'running' before
             // leaving this 'runq' protected critical section so that
@@ -2708,7 +2960,7 @@ bool ProcessManager::wait(const UPID& pid)
             // continue to wait (otherwise they could see nothing in
             // 'runq' and 'running' equal to 0 between when we exit
             // this critical section and increment 'running').
-            runq.erase(it);
+            queue->erase(it);
             running.fetch_add(1);
           } else {
             // Another thread has resumed the process ...
@@ -2800,33 +3052,72 @@ void ProcessManager::enqueue(ProcessBase* process)
     return;
   }
 
-  // TODO(benh): Check and see if this process has it's own thread. If
-  // it does, push it on that threads runq, and wake up that thread if
-  // it's not running. Otherwise, check and see which thread this
-  // process was last running on, and put it on that threads runq.
+  // TODO(benh): Check and see which thread this process was last
+  // running on, and put it on that threads runq.
 
   synchronized (runq_mutex) {
-    CHECK(find(runq.begin(), runq.end(), process) == runq.end());
-    runq.push_back(process);
+    list<ProcessBase*>* queue = runqOf(process);
+    CHECK(find(queue->begin(), queue->end(), process) == queue->end());
+    queue->push_back(process);
   }
 
   // Wake up the processing thread if necessary.
+  //
+  // NOTE: This wakes up all waiting processing threads so that the
+  // thread the process prefers (if any) is woken up as well.
   gate->open();
 }
 
 
+list<ProcessBase*>* ProcessManager::runqOf(ProcessBase* process)
+{
+  const Affinity& affinity = process->affinity;
+
+  switch (affinity.type) {
+    case Affinity::WORKER:
+      if (affinity.index < workers.size() &&
+          workers[affinity.index].cpu.isSome()) {
+        return &workers[affinity.index].runq;
+      }
+      break;
+    case Affinity::NODE:
+      if (nodes.count(affinity.index) > 0) {
+        return &nodes[affinity.index];
+      }
+      break;
+    case Affinity::NONE:
+      break;
+  }
+
+  return &runq;
+}
+
+
 ProcessBase* ProcessManager::dequeue()
 {
-  // TODO(benh): Remove a process from this thread's runq. If there
-  // are no processes to run, and this is not a dedicated thread, then
-  // steal one from another threads runq.
+  // TODO(benh): If there are no processes to run, and this is not a
+  // dedicated thread, then steal one from another threads runq.
 
   ProcessBase* process = NULL;
 
   synchronized (runq_mutex) {
-    if (!runq.empty()) {
-      process = runq.front();
-      runq.pop_front();
+    // Prefer the processes that prefer this processing thread, then
+    // the ones that prefer its NUMA node and then everything else.
+    list<ProcessBase*>* queue = &runq;
+
+    if (__worker__ >= 0 && (size_t) __worker__ < workers.size()) {
+      Worker& worker = workers[__worker__];
+
+      if (!worker.runq.empty()) {
+        queue = &worker.runq;
+      } else if (worker.node.isSome() && !nodes[worker.node.get()].empty()) {
+        queue = &nodes[worker.node.get()];
+      }
+    }
+
+    if (!queue->empty()) {
+      process = queue->front();
+      queue->pop_front();
       // Increment the running count of processes in order to support
       // the Clock::settle() operation (this must be done atomically
       // with removing the process from the runq).
@@ -2864,6 +3155,21 @@ void ProcessManager::settle()
         continue;
       }
 
+      bool empty = true;
+
+      foreach (const Worker& worker, workers) {
+        empty = empty && worker.runq.empty();
+      }
+
+      foreachvalue (const list<ProcessBase*>& queue, nodes) {
+        empty = empty && queue.empty();
+      }
+
+      if (!empty) {
+        done = false;
+        continue;
+      }
+
       if (running.load() > 0) {
         done = false;
         continue;
@@ -2887,6 +3193,13 @@ Future<Response> ProcessManager::__processes__(const Request&)
       JSON::Object object;
       object.values["id"] = process->pid.id;
 
+      JSON::Object locality;
+      locality.values["resumes"] = process->locality.resumes;
+      locality.values["migrations"] = process->locality.migrations;
+      locality.values["node_migrations"] = process->locality.nodeMigrations;
+
+      object.values["locality"] = locality;
+
       JSON::Array events;
 
       struct JSONVisitor : EventVisitor
@@ -2961,6 +3274,7 @@ Future<Response> ProcessManager::__processes__(const Request&)
 
 
 ProcessBase::ProcessBase(const string& id)
+  : affinity(Affinity::none())
 {
   process::initialize();
 
@@ -2968,6 +3282,11 @@ ProcessBase::ProcessBase(const string& id)
 
   refs = 0;
 
+  locality.worker = -1;
+  locality.resumes = 0;
+  locality.migrations = 0;
+  locality.nodeMigrations = 0;
+
   pid.id = id != "" ? id : ID::generate();
   pid.address = __address__;
 
@@ -2983,6 +3302,107 @@ ProcessBase::ProcessBase(const string& id)
 ProcessBase::~ProcessBase() {}
 
 
+struct ProcessBase::Route
+{
+  explicit Route(const RouteOptions& _options)
+    : options(_options),
+      outstanding(0)
+  {
+    if (options.metrics.isSome()) {
+      metrics.reset(new Metrics(options.metrics.get()));
+    }
+  }
+
+  // Handles a request of the route, unless the concurrency limit of
+  // the route has been reached.
+  static Future<Response> handle(
+      const std::shared_ptr<Route>& route,
+      const HttpRequestHandler& handler,
+      const Request& request)
+  {
+    if (route->metrics) {
+      ++route->metrics->requests;
+    }
+
+    // NOTE: The requests are only admitted by the process, but the
+    // responses may become ready on any thread.
+    if (route->outstanding.fetch_add(1) >=
+          route->options.concurrency.getOrElse(
+              std::numeric_limits<size_t>::max())) {
+      --route->outstanding;
+
+      if (route->metrics) {
+        ++route->metrics->rejected;
+      }
+
+      VLOG(1) << "Returning '503 Service Unavailable' for"
+              << " '" << request.url.path << "' because of too many"
+              << " concurrent requests";
+
+      return ServiceUnavailable(
+          "Too many concurrent requests for '" + request.url.path + "'");
+    }
+
+    const Time start = Clock::now();
+
+    return handler(request)
+      .onAny(lambda::bind(&Route::handled, route, start, lambda::_1));
+  }
+
+  static void handled(
+      const std::shared_ptr<Route>& route,
+      const Time& start,
+      const Future<Response>& response)
+  {
+    --route->outstanding;
+
+    if (!route->metrics) {
+      return;
+    }
+
+    route->metrics->latency.record(Milliseconds(Clock::now() - start));
+
+    if (response.isReady() && response.get().type == Response::BODY) {
+      route->metrics->bytes_out += response.get().body.size();
+    }
+  }
+
+  struct Metrics
+  {
+    explicit Metrics(const string& prefix)
+      : requests(prefix + "/requests"),
+        rejected(prefix + "/rejected"),
+        bytes_out(prefix + "/bytes_out"),
+        latency(prefix + "/latency", Minutes(5))
+    {
+      process::metrics::add(requests);
+      process::metrics::add(rejected);
+      process::metrics::add(bytes_out);
+      process::metrics::add(latency);
+    }
+
+    ~Metrics()
+    {
+      process::metrics::remove(requests);
+      process::metrics::remove(rejected);
+      process::metrics::remove(bytes_out);
+      process::metrics::remove(latency);
+    }
+
+    process::metrics::Counter requests;
+    process::metrics::Counter rejected;
+    process::metrics::Counter bytes_out;
+    process::metrics::Timer<Milliseconds> latency;
+  };
+
+  const RouteOptions options;
+
+  std::atomic<size_t> outstanding;
+
+  std::unique_ptr<Metrics> metrics;
+};
+
+
 void ProcessBase::enqueue(Event* event, bool inject)
 {
   CHECK(event != NULL);
@@ -3086,7 +3506,12 @@ void ProcessBase::visit(const HttpEvent& event)
   while (Path(name).dirname() != name) {
     if (handlers.http.count(name) > 0) {
       // Now call the handler and associate the response with the promise.
-      event.response->associate(handlers.http[name](*event.request));
+      if (routes.count(name) > 0) {
+        event.response->associate(
+            Route::handle(routes[name], handlers.http[name], *event.request));
+      } else {
+        event.response->associate(handlers.http[name](*event.request));
+      }
 
       return;
     }
@@ -3160,11 +3585,19 @@ UPID ProcessBase::link(const UPID& to)
 void ProcessBase::route(
     const string& name,
     const Option<string>& help_,
-    const HttpRequestHandler& handler)
+    const HttpRequestHandler& handler,
+    const RouteOptions& options)
 {
   // Routes must start with '/'.
   CHECK(name.find('/') == 0);
   handlers.http[name.substr(1)] = handler;
+
+  if (options.concurrency.isSome() || options.metrics.isSome()) {
+    routes[name.substr(1)] = std::make_shared<Route>(options);
+  } else {
+    routes.erase(name.substr(1));
+  }
+
   dispatch(help, &Help::add, pid.id, name, help_);
 }
 
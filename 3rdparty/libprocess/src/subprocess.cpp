@@ -10,6 +10,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License
 
+#include <spawn.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/types.h>
@@ -96,6 +97,81 @@ static Try<Nothing> cloexec(int stdinFd[2], int stdoutFd[2], int stderrFd[2])
   return Nothing();
 }
 
+
+// Returns true if the child can be launched with 'posix_spawnp'
+// rather than with a fork. 'os::execvpe' searches for 'path' using
+// the PATH of the child's environment whereas 'posix_spawnp' uses the
+// PATH of the parent, so we only spawn when both would agree.
+static bool spawnable(
+    const string& path,
+    const Option<map<string, string>>& environment)
+{
+  if (strings::contains(path, "/") || environment.isNone()) {
+    return true;
+  }
+
+  Option<string> parent = os::getenv("PATH");
+  if (parent.isNone() || !environment.get().count("PATH")) {
+    return false;
+  }
+
+  return environment.get().at("PATH") == parent.get();
+}
+
+
+// Launches the child with 'posix_spawnp', which (unlike 'fork') does
+// not copy the page tables of the parent. With a large parent this
+// reduces the launch latency from milliseconds to microseconds. This
+// is equivalent to 'childMain' without a setup function: the parent's
+// ends of the pipes are close-on-exec already (see 'cloexec' above),
+// so only stdin/stdout/stderr need to be redirected.
+//
+// Returns -1 and sets errno on failure.
+static pid_t spawn(
+    const string& path,
+    char** argv,
+    char** envp,
+    int stdinFd[2],
+    int stdoutFd[2],
+    int stderrFd[2])
+{
+  posix_spawn_file_actions_t actions;
+
+  int error = ::posix_spawn_file_actions_init(&actions);
+  if (error != 0) {
+    errno = error;
+    return -1;
+  }
+
+  error = ::posix_spawn_file_actions_adddup2(
+      &actions, stdinFd[0], STDIN_FILENO);
+
+  if (error == 0) {
+    error = ::posix_spawn_file_actions_adddup2(
+        &actions, stdoutFd[1], STDOUT_FILENO);
+  }
+
+  if (error == 0) {
+    error = ::posix_spawn_file_actions_adddup2(
+        &actions, stderrFd[1], STDERR_FILENO);
+  }
+
+  pid_t pid = -1;
+
+  if (error == 0) {
+    error = ::posix_spawnp(&pid, path.c_str(), &actions, NULL, argv, envp);
+  }
+
+  ::posix_spawn_file_actions_destroy(&actions);
+
+  if (error != 0) {
+    errno = error;
+    return -1;
+  }
+
+  return pid;
+}
+
 }  // namespace internal {
 
 
@@ -355,24 +431,41 @@ Try<Subprocess> subprocess(
     envp[index] = NULL;
   }
 
-  // Determine the function to clone the child process. If the user
-  // does not specify the clone function, we will use the default.
-  lambda::function<pid_t(const lambda::function<int()>&)> clone =
-    (_clone.isSome() ? _clone.get() : defaultClone);
-
-  // Now, clone the child process.
-  pid_t pid = clone(lambda::bind(
-      &childMain,
-      path,
-      _argv,
-      in,
-      out,
-      err,
-      envp,
-      setup,
-      stdinFd,
-      stdoutFd,
-      stderrFd));
+  pid_t pid = -1;
+
+  // If neither a setup nor a clone function requires a full fork we
+  // spawn the child directly, which avoids copying the address space
+  // of the parent.
+  //
+  // NOTE: If spawning fails (e.g., because 'path' can not be found)
+  // we fall back to cloning below so that errors are reported the
+  // same way regardless of how the child was launched.
+  if (setup.isNone() &&
+      _clone.isNone() &&
+      internal::spawnable(path, environment)) {
+    pid = internal::spawn(path, _argv, envp, stdinFd, stdoutFd, stderrFd);
+  }
+
+  if (pid == -1) {
+    // Determine the function to clone the child process. If the user
+    // does not specify the clone function, we will use the default.
+    lambda::function<pid_t(const lambda::function<int()>&)> clone =
+      (_clone.isSome() ? _clone.get() : defaultClone);
+
+    // Now, clone the child process.
+    pid = clone(lambda::bind(
+        &childMain,
+        path,
+        _argv,
+        in,
+        out,
+        err,
+        envp,
+        setup,
+        stdinFd,
+        stdoutFd,
+        stderrFd));
+  }
 
   delete[] _argv;
 
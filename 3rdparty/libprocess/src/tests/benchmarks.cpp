@@ -24,24 +24,34 @@
 #include <vector>
 
 #include <process/collect.hpp>
+#include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
 #include <process/owned.hpp>
 #include <process/process.hpp>
+#include <process/subprocess.hpp>
 
 #include <stout/duration.hpp>
+#include <stout/flathashmap.hpp>
 #include <stout/gtest.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
+#include <stout/json.hpp>
+#include <stout/os.hpp>
 #include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
 
 namespace http = process::http;
 
+using process::Affinity;
 using process::Future;
 using process::Owned;
+using process::PID;
 using process::Process;
 using process::ProcessBase;
 using process::Promise;
+using process::Subprocess;
 using process::UPID;
 
 using std::cout;
@@ -374,3 +384,331 @@ TEST(ProcessTest, Process_BENCHMARK_LargeNumberOfLinks)
     delete process;
   }
 }
+
+
+// A process that bounces a message back and forth with its peer
+// until 'count' round trips have completed. Both peers must be
+// paired before either of them is started.
+class BouncerProcess : public Process<BouncerProcess>
+{
+public:
+  BouncerProcess(const Affinity& affinity)
+  {
+    prefer(affinity);
+  }
+
+  Nothing pair(const UPID& _peer)
+  {
+    peer = _peer;
+    return Nothing();
+  }
+
+  void start(size_t count)
+  {
+    bounce(count);
+  }
+
+  void bounce(size_t count)
+  {
+    if (count == 0) {
+      promise.set(Nothing());
+      return;
+    }
+
+    dispatch(peer, &BouncerProcess::bounce, count - 1);
+  }
+
+  Future<Nothing> done()
+  {
+    return promise.future();
+  }
+
+private:
+  PID<BouncerProcess> peer;
+  Promise<Nothing> promise;
+};
+
+
+// Measures how often two chatty processes are resumed on a different
+// processing thread (and NUMA node) than the previous time, with and
+// without declaring a preferred NUMA node. Preferences only take
+// effect when the processing threads are pinned, so run this with
+// e.g. 'LIBPROCESS_WORKER_CPUS=0-63' on a multi-socket machine.
+TEST(ProcessTest, Process_BENCHMARK_Locality)
+{
+  const size_t pairs = 8;
+  const size_t count = 100000;
+
+  vector<Affinity> affinities = {Affinity::none()};
+
+  // Only prefer the first NUMA node if the machine reports one.
+  if (os::exists("/sys/devices/system/node/node0")) {
+    affinities.push_back(Affinity::node(0));
+  }
+
+  foreach (const Affinity& affinity, affinities) {
+    vector<Owned<BouncerProcess>> processes;
+
+    for (size_t i = 0; i < pairs * 2; i++) {
+      processes.push_back(Owned<BouncerProcess>(new BouncerProcess(affinity)));
+      spawn(processes.back().get());
+    }
+
+    // Pair up the bouncers before starting any of them, since a
+    // bouncer may otherwise receive a bounce before it knows its peer.
+    list<Future<Nothing>> pairings;
+    for (size_t i = 0; i < pairs * 2; i += 2) {
+      const PID<BouncerProcess> first = processes[i]->self();
+      const PID<BouncerProcess> second = processes[i + 1]->self();
+
+      pairings.push_back(dispatch(first, &BouncerProcess::pair, second));
+      pairings.push_back(dispatch(second, &BouncerProcess::pair, first));
+    }
+
+    AWAIT_READY(process::collect(pairings));
+
+    Stopwatch watch;
+    watch.start();
+
+    list<Future<Nothing>> futures;
+    foreach (const Owned<BouncerProcess>& process, processes) {
+      futures.push_back(process->done());
+      dispatch(process.get(), &BouncerProcess::start, count);
+    }
+
+    AWAIT_READY_FOR(process::collect(futures), Minutes(5));
+
+    const Duration elapsed = watch.elapsed();
+
+    // Sum up the locality statistics of the bouncers.
+    hashset<string> ids;
+    foreach (const Owned<BouncerProcess>& process, processes) {
+      ids.insert(process->self().id);
+    }
+
+    Future<http::Response> response =
+      http::get(UPID("__processes__", process::address()));
+
+    AWAIT_READY(response);
+
+    Try<JSON::Array> array = JSON::parse<JSON::Array>(response.get().body);
+    ASSERT_SOME(array);
+
+    uint64_t resumes = 0;
+    uint64_t migrations = 0;
+    uint64_t nodeMigrations = 0;
+
+    foreach (const JSON::Value& value, array.get().values) {
+      const JSON::Object& object = value.as<JSON::Object>();
+
+      Result<JSON::String> id = object.find<JSON::String>("id");
+      if (!id.isSome() || !ids.contains(id.get().value)) {
+        continue;
+      }
+
+      Result<JSON::Number> number =
+        object.find<JSON::Number>("locality.resumes");
+      ASSERT_SOME(number);
+      resumes += number.get().as<uint64_t>();
+
+      number = object.find<JSON::Number>("locality.migrations");
+      ASSERT_SOME(number);
+      migrations += number.get().as<uint64_t>();
+
+      number = object.find<JSON::Number>("locality.node_migrations");
+      ASSERT_SOME(number);
+      nodeMigrations += number.get().as<uint64_t>();
+    }
+
+    cout << "Bounced " << count << " messages between " << pairs
+         << " pairs of processes "
+         << (affinity.type == Affinity::NONE ? "without" : "with")
+         << " a preferred NUMA node in " << elapsed << ": "
+         << resumes << " resumes, "
+         << migrations << " thread migrations, "
+         << nodeMigrations << " cross-node migrations" << endl;
+
+    foreach (const Owned<BouncerProcess>& process, processes) {
+      terminate(process.get());
+      wait(process.get());
+    }
+  }
+}
+
+
+// Measures insert, lookup and iteration for a map type 'Map' with
+// string keys (similar to the protobuf IDs used in the master) and
+// pointer values.
+template <typename Map>
+static void benchmarkMap(const string& name, const vector<string>& keys)
+{
+  Stopwatch watch;
+  watch.start();
+
+  Map map;
+  foreach (const string& key, keys) {
+    map[key] = &key;
+  }
+
+  const Duration insert = watch.elapsed();
+
+  watch.start();
+
+  size_t found = 0;
+  for (int i = 0; i < 10; i++) {
+    foreach (const string& key, keys) {
+      found += map.count(key);
+    }
+  }
+
+  const Duration lookup = watch.elapsed();
+
+  watch.start();
+
+  size_t length = 0;
+  for (int i = 0; i < 10; i++) {
+    foreachvalue (const string* value, map) {
+      length += value->size();
+    }
+  }
+
+  const Duration iterate = watch.elapsed();
+
+  EXPECT_EQ(keys.size() * 10, found);
+  EXPECT_LT(0u, length);
+
+  cout << name << " with " << keys.size() << " entries:"
+       << " insert " << insert
+       << ", 10x lookup " << lookup
+       << ", 10x iterate " << iterate << endl;
+}
+
+
+TEST(HashMapTest, HashMap_BENCHMARK_InsertLookupIterate)
+{
+  foreach (size_t count, vector<size_t>({100000u, 1000000u})) {
+    vector<string> keys;
+    keys.reserve(count);
+
+    for (size_t i = 0; i < count; i++) {
+      keys.push_back("20151206-001452-16842879-5050-1234-S" + stringify(i));
+    }
+
+    benchmarkMap<hashmap<string, const string*>>("hashmap", keys);
+    benchmarkMap<flathashmap<string, const string*>>("flathashmap", keys);
+  }
+}
+
+
+// Measures building and then satisfying chains of continuations. The
+// total number of links is kept constant while the chain depth grows.
+//
+// NOTE: Satisfying a chain recurses once per link, so the depth is
+// bounded to keep the stack from overflowing.
+TEST(FutureTest, Future_BENCHMARK_Chain)
+{
+  const size_t links = 1000000;
+
+  foreach (size_t depth, vector<size_t>({1u, 10u, 100u, 1000u})) {
+    Stopwatch watch;
+    watch.start();
+
+    for (size_t i = 0; i < links / depth; i++) {
+      Promise<size_t> promise;
+      Future<size_t> future = promise.future();
+
+      for (size_t j = 0; j < depth; j++) {
+        future = future.then([](size_t value) { return value + 1; });
+      }
+
+      promise.set(0);
+
+      ASSERT_TRUE(future.isReady());
+      ASSERT_EQ(depth, future.get());
+    }
+
+    cout << "Built and satisfied " << links / depth
+         << " chains of depth " << depth
+         << " in " << watch.elapsed() << endl;
+  }
+}
+
+
+// Measures 'collect' over a large number of futures which are
+// satisfied after the collect has been set up.
+TEST(FutureTest, Future_BENCHMARK_Collect)
+{
+  foreach (size_t count, vector<size_t>({1000u, 10000u, 100000u})) {
+    vector<Promise<size_t>> promises(count);
+
+    list<Future<size_t>> futures;
+    foreach (Promise<size_t>& promise, promises) {
+      futures.push_back(promise.future());
+    }
+
+    Stopwatch watch;
+    watch.start();
+
+    Future<list<size_t>> collect = process::collect(futures);
+
+    for (size_t i = 0; i < count; i++) {
+      promises[i].set(i);
+    }
+
+    AWAIT_READY(collect);
+
+    cout << "Collected " << count << " futures in "
+         << watch.elapsed() << endl;
+
+    EXPECT_EQ(count, collect.get().size());
+  }
+}
+
+
+// Measures the latency of launching short lived children from a
+// parent with a large resident set. Without a setup function the
+// child is spawned directly, with one it has to be forked.
+TEST(SubprocessTest, Subprocess_BENCHMARK_LaunchLatency)
+{
+  const size_t children = 100;
+
+  // Touch every page so that the parent has 1GB of resident memory
+  // whose page tables would need to be copied by a fork.
+  vector<char> memory(1024 * 1024 * 1024, 1);
+
+  foreach (bool fork, vector<bool>({false, true})) {
+    Option<lambda::function<int()>> setup = None();
+    if (fork) {
+      setup = lambda::function<int()>([]() { return 0; });
+    }
+
+    Duration launch;
+    for (size_t i = 0; i < children; i++) {
+      Stopwatch watch;
+      watch.start();
+
+      Try<Subprocess> s = process::subprocess(
+          "true",
+          {"true"},
+          Subprocess::FD(STDIN_FILENO),
+          Subprocess::FD(STDOUT_FILENO),
+          Subprocess::FD(STDERR_FILENO),
+          None(),
+          None(),
+          setup);
+
+      launch += watch.elapsed();
+
+      ASSERT_SOME(s);
+      AWAIT_READY(s.get().status());
+      EXPECT_SOME_EQ(0, s.get().status().get());
+    }
+
+    cout << "Launched " << children << " children "
+         << (fork ? "with" : "without") << " a setup function"
+         << " at 1GB RSS in " << launch
+         << " (" << launch / children << " per child)" << endl;
+  }
+
+  EXPECT_EQ(1, memory[memory.size() - 1]);
+}
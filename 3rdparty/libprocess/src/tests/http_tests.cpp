@@ -17,7 +17,10 @@
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 
+#include <atomic>
+#include <map>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <process/address.hpp>
@@ -31,6 +34,7 @@
 
 #include <stout/base64.hpp>
 #include <stout/gtest.hpp>
+#include <stout/json.hpp>
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
 #include <stout/os.hpp>
@@ -49,6 +53,7 @@ using process::http::URL;
 
 using process::network::Socket;
 
+using std::map;
 using std::string;
 using std::vector;
 
@@ -71,10 +76,15 @@ public:
   MOCK_METHOD1(requestDelete, Future<http::Response>(const http::Request&));
   MOCK_METHOD1(a, Future<http::Response>(const http::Request&));
   MOCK_METHOD1(abc, Future<http::Response>(const http::Request&));
+  MOCK_METHOD1(limited, Future<http::Response>(const http::Request&));
 
 protected:
   virtual void initialize()
   {
+    RouteOptions options;
+    options.concurrency = 1;
+    options.metrics = "http_test/limited";
+
     route("/auth", None(), &HttpProcess::auth);
     route("/body", None(), &HttpProcess::body);
     route("/pipe", None(), &HttpProcess::pipe);
@@ -83,6 +93,7 @@ protected:
     route("/delete", None(), &HttpProcess::requestDelete);
     route("/a", None(), &HttpProcess::a);
     route("/a/b/c", None(), &HttpProcess::abc);
+    route("/limited", None(), &HttpProcess::limited, options);
   }
 
   Future<http::Response> auth(const http::Request& request)
@@ -217,6 +228,62 @@ TEST(HTTPTest, Endpoints)
 }
 
 
+// Checks that the requests of a route beyond its concurrency limit
+// are rejected, and that the cost of the route is reported.
+TEST(HTTPTest, RouteOptions)
+{
+  Http http;
+
+  Promise<http::Response> promise;
+  Future<Nothing> limited;
+
+  EXPECT_CALL(*http.process, limited(_))
+    .WillOnce(DoAll(FutureSatisfy(&limited),
+                    Return(promise.future())));
+
+  Future<http::Response> first = http::get(http.process->self(), "limited");
+
+  AWAIT_READY(limited);
+
+  // The first request is still being handled.
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      http::ServiceUnavailable().status,
+      http::get(http.process->self(), "limited"));
+
+  promise.set(http::OK("body"));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, first);
+  EXPECT_EQ("body", first->body);
+
+  Future<http::Response> snapshot =
+    http::get(process::UPID("metrics", process::address()), "snapshot");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, snapshot);
+
+  Try<JSON::Object> object = JSON::parse<JSON::Object>(snapshot->body);
+  ASSERT_SOME(object);
+
+  map<string, JSON::Value> values = object.get().values;
+
+  ASSERT_EQ(1u, values.count("http_test/limited/requests"));
+  EXPECT_FLOAT_EQ(
+      2.0,
+      values["http_test/limited/requests"].as<JSON::Number>().as<double>());
+
+  ASSERT_EQ(1u, values.count("http_test/limited/rejected"));
+  EXPECT_FLOAT_EQ(
+      1.0,
+      values["http_test/limited/rejected"].as<JSON::Number>().as<double>());
+
+  ASSERT_EQ(1u, values.count("http_test/limited/bytes_out"));
+  EXPECT_FLOAT_EQ(
+      4.0,
+      values["http_test/limited/bytes_out"].as<JSON::Number>().as<double>());
+
+  EXPECT_EQ(1u, values.count("http_test/limited/latency_ms"));
+}
+
+
 TEST(HTTPTest, PipeEOF)
 {
   http::Pipe pipe;
@@ -238,10 +305,12 @@ TEST(HTTPTest, PipeEOF)
 
   // After a 'write' a call to 'read' should be completed immediately.
   ASSERT_TRUE(writer.write("world"));
+  EXPECT_EQ(5u, writer.size());
 
   read = reader.read();
   ASSERT_TRUE(read.isReady());
   EXPECT_EQ("world", read.get());
+  EXPECT_EQ(0u, writer.size());
 
   // Close the write end of the pipe and ensure the remaining
   // data can be read.
@@ -947,6 +1016,67 @@ TEST(HTTPConnectionTest, ClosingResponse)
 }
 
 
+// Tests that closing the connection of a slow streaming client,
+// while its chunks are queued, does not deadlock with processes
+// exiting. Deleting a queued chunk notifies its proxy (a dispatch),
+// while an exiting process notifies the socket manager.
+TEST(HTTPConnectionTest, ClosingStreamingResponse)
+{
+  Http http;
+
+  std::atomic<bool> done(false);
+
+  std::thread exiting([&done]() {
+    while (!done.load()) {
+      process::UPID pid = process::spawn(new process::ProcessBase(), true);
+      process::terminate(pid);
+      process::wait(pid);
+    }
+  });
+
+  http::URL url = http::URL(
+      "http",
+      http.process->self().address.ip,
+      http.process->self().address.port,
+      http.process->self().id + "/pipe");
+
+  for (int i = 0; i < 100; i++) {
+    http::Pipe pipe;
+    http::OK ok;
+    ok.type = http::Response::PIPE;
+    ok.reader = pipe.reader();
+
+    EXPECT_CALL(*http.process, pipe(_))
+      .WillOnce(Return(ok));
+
+    Future<http::Connection> connect = http::connect(url);
+    AWAIT_READY(connect);
+
+    http::Connection connection = connect.get();
+
+    http::Request request;
+    request.method = "GET";
+    request.url = url;
+    request.keepAlive = true;
+
+    Future<http::Response> response = connection.send(request, true);
+    AWAIT_READY(response);
+
+    // Queue more chunks than the client reads before it disconnects.
+    http::Pipe::Writer writer = pipe.writer();
+    for (int j = 0; j < 16; j++) {
+      writer.write(string(64 * 1024, 'x'));
+    }
+
+    AWAIT_READY(connection.disconnect());
+    AWAIT_READY(writer.readerClosed());
+  }
+
+  done.store(true);
+  exiting.join();
+}
+
+
 TEST(HTTPConnectionTest, ReferenceCounting)
 {
   Http http;
@@ -19,6 +19,7 @@
 
 #include <ostream>
 #include <string>
+#include <vector>
 
 // ONLY USEFUL AFTER RUNNING PROTOC.
 #include <mesos/authorizer/authorizer.pb.h>
@@ -108,6 +109,26 @@ public:
   virtual process::Future<bool> authorize(
       const ACL::RunTask& request) = 0;
 
+  /**
+   * Used to verify if principals are allowed to run tasks as the given UNIX
+   * users, e.g., for all the tasks launched by a single offer acceptance.
+   * Each request is decided as it would be by authorizing it on its own.
+   *
+   * The default implementation authorizes each request on its own, so that
+   * existing implementations keep working. Implementations are encouraged to
+   * override it to decide all the requests at once.
+   *
+   * @param requests The instances of ACL::RunTask protobuf messages to
+   *     authorize.
+   *
+   * @return Whether each request is authorized, in the order of the
+   *     requests. A failed future is neither true nor false for any of the
+   *     requests. It indicates a problem processing at least one of the
+   *     requests and the requests can be retried.
+   */
+  virtual process::Future<std::vector<bool>> authorize(
+      const std::vector<ACL::RunTask>& requests);
+
   /**
    * Used to verify if a principal is allowed to shut down a framework launched
    * by the given framework_principal. The principal and framework_principal
@@ -14,17 +14,30 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <list>
+#include <string>
+#include <vector>
+
 #include <mesos/authorizer/authorizer.hpp>
 
 #include <mesos/module/authorizer.hpp>
 
+#include <process/collect.hpp>
+#include <process/future.hpp>
+
+#include <stout/foreach.hpp>
+
 #include "authorizer/local/authorizer.hpp"
 
 #include "master/constants.hpp"
 
 #include "module/manager.hpp"
 
+using process::Future;
+
+using std::list;
 using std::string;
+using std::vector;
 
 using mesos::internal::LocalAuthorizer;
 
@@ -43,4 +56,19 @@ Try<Authorizer*> Authorizer::create(const string& name)
   return modules::ModuleManager::create<Authorizer>(name);
 }
 
+
+Future<vector<bool>> Authorizer::authorize(
+    const vector<ACL::RunTask>& requests)
+{
+  list<Future<bool>> futures;
+  foreach (const ACL::RunTask& request, requests) {
+    futures.push_back(authorize(request));
+  }
+
+  return process::collect(futures)
+    .then([](const list<bool>& authorizations) {
+      return vector<bool>(authorizations.begin(), authorizations.end());
+    });
+}
+
 } // namespace mesos {
@@ -16,26 +16,186 @@
 
 #include "authorizer/local/authorizer.hpp"
 
+#include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include <process/check.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/id.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 #include <process/protobuf.hpp>
 
+#include <stout/cache.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
 #include <stout/protobuf.hpp>
+#include <stout/stringify.hpp>
+#include <stout/synchronized.hpp>
 #include <stout/try.hpp>
 
 using process::Failure;
 using process::Future;
+using process::Owned;
 using process::dispatch;
 
+using std::pair;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
 
+// Maximum number of decisions cached for each kind of request.
+static const size_t MAX_CACHED_DECISIONS = 10000;
+
+
+// The ACLs of one kind (e.g., 'ACLs::run_tasks') compiled for
+// requests with a single subject and a single object (e.g., a
+// principal running a task as a user), which are the requests made
+// by the master for every framework and task.
+//
+// The ACLs matching a subject are looked up by its value, instead of
+// scanning all the ACLs, and the decisions are cached. The decision
+// is the same as scanning the ACLs in order (see
+// 'LocalAuthorizerProcess'): for such a request an ACL matches if both
+// of its entities are ANY, NONE or SOME including the request value,
+// and the first matching ACL allows the request unless one of its
+// entities is NONE.
+//
+// NOTE: The index is immutable once constructed, except for the
+// cache, so it can be used from any thread. The cache is dropped
+// along with the index when the ACLs are compiled again.
+class ACLIndex
+{
+public:
+  // The subject and object entities of the ACLs, in order.
+  typedef vector<pair<ACL::Entity, ACL::Entity>> ACLList;
+
+  ACLIndex(const ACLList& acls, bool _permissive)
+    : permissive(_permissive),
+      cache(MAX_CACHED_DECISIONS)
+  {
+    for (size_t i = 0; i < acls.size(); i++) {
+      const ACL::Entity& subject = acls[i].first;
+      const ACL::Entity& object = acls[i].second;
+
+      Entry entry;
+      entry.subject = subject.type();
+      entry.object = object.type();
+
+      foreach (const string& value, object.values()) {
+        entry.objects.insert(value);
+      }
+
+      entries.push_back(entry);
+
+      if (subject.type() == ACL::Entity::SOME) {
+        foreach (const string& value, subject.values()) {
+          vector<size_t>& indices = subjects[value];
+
+          // A value can be listed multiple times in an ACL.
+          if (indices.empty() || indices.back() != i) {
+            indices.push_back(i);
+          }
+        }
+      } else {
+        wildcards.push_back(i);
+      }
+    }
+  }
+
+  // Returns whether the request is a single subject and object that
+  // this index can decide on.
+  static bool indexable(const ACL::Entity& subject, const ACL::Entity& object)
+  {
+    return subject.type() == ACL::Entity::SOME &&
+           subject.values().size() == 1 &&
+           object.type() == ACL::Entity::SOME &&
+           object.values().size() == 1;
+  }
+
+  bool authorize(const string& subject, const string& object)
+  {
+    // NOTE: The subject is length prefixed to make the key unique.
+    const string key = stringify(subject.size()) + ":" + subject + object;
+
+    synchronized (mutex) {
+      const Option<bool> decision = cache.get(key);
+      if (decision.isSome()) {
+        return decision.get();
+      }
+    }
+
+    const bool decision = decide(subject, object);
+
+    synchronized (mutex) {
+      cache.put(key, decision);
+    }
+
+    return decision;
+  }
+
+private:
+  struct Entry
+  {
+    ACL::Entity::Type subject;
+    ACL::Entity::Type object;
+    hashset<string> objects;
+  };
+
+  bool decide(const string& subject, const string& object) const
+  {
+    static const vector<size_t> none;
+
+    hashmap<string, vector<size_t>>::const_iterator it =
+      subjects.find(subject);
+
+    const vector<size_t>& some = it != subjects.end() ? it->second : none;
+
+    // Visit the ACLs matching the subject in order, by merging the
+    // ACLs listing the subject with the ACLs matching any subject.
+    size_t i = 0;
+    size_t j = 0;
+    while (i < some.size() || j < wildcards.size()) {
+      size_t index;
+      if (j == wildcards.size() ||
+          (i < some.size() && some[i] < wildcards[j])) {
+        index = some[i++];
+      } else {
+        index = wildcards[j++];
+      }
+
+      const Entry& entry = entries[index];
+
+      if (entry.object != ACL::Entity::SOME ||
+          entry.objects.contains(object)) {
+        return entry.subject != ACL::Entity::NONE &&
+               entry.object != ACL::Entity::NONE;
+      }
+    }
+
+    return permissive; // None of the ACLs match.
+  }
+
+  const bool permissive;
+
+  vector<Entry> entries;
+
+  // The ACLs listing a subject value, in order.
+  hashmap<string, vector<size_t>> subjects;
+
+  // The ACLs matching any subject (ANY or NONE), in order.
+  vector<size_t> wildcards;
+
+  std::mutex mutex;
+  Cache<string, bool> cache;
+};
+
+
 class LocalAuthorizerProcess : public ProtobufProcess<LocalAuthorizerProcess>
 {
 public:
@@ -72,6 +232,21 @@ public:
     return acls.permissive(); // None of the ACLs match.
   }
 
+  Future<vector<bool>> authorize(const vector<ACL::RunTask>& requests)
+  {
+    vector<bool> authorizations;
+    authorizations.reserve(requests.size());
+
+    foreach (const ACL::RunTask& request, requests) {
+      const Future<bool> authorization = authorize(request);
+      CHECK_READY(authorization);
+
+      authorizations.push_back(authorization.get());
+    }
+
+    return authorizations;
+  }
+
   Future<bool> authorize(const ACL::ShutdownFramework& request)
   {
     foreach (const ACL::ShutdownFramework& acl, acls.shutdown_frameworks()) {
@@ -240,6 +415,33 @@ Try<Nothing> LocalAuthorizer::initialize(const Option<ACLs>& acls)
     process = new LocalAuthorizerProcess(acls.get());
     spawn(process);
 
+    const bool permissive = acls.get().permissive();
+
+    ACLIndex::ACLList registerFrameworks;
+    foreach (const ACL::RegisterFramework& acl,
+             acls.get().register_frameworks()) {
+      registerFrameworks.push_back(
+          std::make_pair(acl.principals(), acl.roles()));
+    }
+
+    ACLIndex::ACLList runTasks;
+    foreach (const ACL::RunTask& acl, acls.get().run_tasks()) {
+      runTasks.push_back(std::make_pair(acl.principals(), acl.users()));
+    }
+
+    ACLIndex::ACLList shutdownFrameworks;
+    foreach (const ACL::ShutdownFramework& acl,
+             acls.get().shutdown_frameworks()) {
+      shutdownFrameworks.push_back(
+          std::make_pair(acl.principals(), acl.framework_principals()));
+    }
+
+    indexes.registerFrameworks =
+      Owned<ACLIndex>(new ACLIndex(registerFrameworks, permissive));
+    indexes.runTasks = Owned<ACLIndex>(new ACLIndex(runTasks, permissive));
+    indexes.shutdownFrameworks =
+      Owned<ACLIndex>(new ACLIndex(shutdownFrameworks, permissive));
+
     initialized.done();
   }
 
@@ -253,6 +455,12 @@ Future<bool> LocalAuthorizer::authorize(const ACL::RegisterFramework& request)
     return Failure("Authorizer not initialized");
   }
 
+  if (ACLIndex::indexable(request.principals(), request.roles())) {
+    return indexes.registerFrameworks->authorize(
+        request.principals().values(0),
+        request.roles().values(0));
+  }
+
   // Necessary to disambiguate.
   typedef Future<bool>(LocalAuthorizerProcess::*F)(
       const ACL::RegisterFramework&);
@@ -268,6 +476,12 @@ Future<bool> LocalAuthorizer::authorize(const ACL::RunTask& request)
     return Failure("Authorizer not initialized");
   }
 
+  if (ACLIndex::indexable(request.principals(), request.users())) {
+    return indexes.runTasks->authorize(
+        request.principals().values(0),
+        request.users().values(0));
+  }
+
   // Necessary to disambiguate.
   typedef Future<bool>(LocalAuthorizerProcess::*F)(const ACL::RunTask&);
 
@@ -276,12 +490,53 @@ Future<bool> LocalAuthorizer::authorize(const ACL::RunTask& request)
 }
 
 
+Future<vector<bool>> LocalAuthorizer::authorize(
+    const vector<ACL::RunTask>& requests)
+{
+  if (process == NULL) {
+    return Failure("Authorizer not initialized");
+  }
+
+  // Decide all the requests right away if they can all be decided
+  // using the compiled ACLs, otherwise decide them all with a single
+  // dispatch to the process.
+  vector<bool> authorizations;
+  authorizations.reserve(requests.size());
+
+  foreach (const ACL::RunTask& request, requests) {
+    if (!ACLIndex::indexable(request.principals(), request.users())) {
+      // Necessary to disambiguate.
+      typedef Future<vector<bool>>(LocalAuthorizerProcess::*F)(
+          const vector<ACL::RunTask>&);
+
+      return dispatch(
+          process,
+          static_cast<F>(&LocalAuthorizerProcess::authorize),
+          requests);
+    }
+
+    authorizations.push_back(indexes.runTasks->authorize(
+        request.principals().values(0),
+        request.users().values(0)));
+  }
+
+  return authorizations;
+}
+
+
 Future<bool> LocalAuthorizer::authorize(const ACL::ShutdownFramework& request)
 {
   if (process == NULL) {
     return Failure("Authorizer not initialized");
   }
 
+  if (ACLIndex::indexable(
+          request.principals(), request.framework_principals())) {
+    return indexes.shutdownFrameworks->authorize(
+        request.principals().values(0),
+        request.framework_principals().values(0));
+  }
+
   // Necessary to disambiguate.
   typedef Future<bool>(LocalAuthorizerProcess::*F)(
       const ACL::ShutdownFramework&);
@@ -19,8 +19,11 @@
 
 #include <mesos/authorizer/authorizer.hpp>
 
+#include <vector>
+
 #include <process/future.hpp>
 #include <process/once.hpp>
+#include <process/owned.hpp>
 
 #include <stout/nothing.hpp>
 #include <stout/option.hpp>
@@ -29,7 +32,8 @@
 namespace mesos {
 namespace internal {
 
-// Forward declaration.
+// Forward declarations.
+class ACLIndex;
 class LocalAuthorizerProcess;
 
 // This Authorizer is constructed with all the required ACLs upfront.
@@ -51,10 +55,16 @@ public:
   virtual Try<Nothing> initialize(const Option<ACLs>& acls);
 
   // Implementation of Authorizer interface.
+  //
+  // Requests with a single subject and object (e.g., a principal
+  // running a task as a user) are decided synchronously using the
+  // compiled ACLs, the others are dispatched to the process.
   virtual process::Future<bool> authorize(
       const ACL::RegisterFramework& request);
   virtual process::Future<bool> authorize(
       const ACL::RunTask& request);
+  virtual process::Future<std::vector<bool>> authorize(
+      const std::vector<ACL::RunTask>& requests);
   virtual process::Future<bool> authorize(
       const ACL::ShutdownFramework& request);
 
@@ -63,6 +73,14 @@ private:
 
   LocalAuthorizerProcess* process;
 
+  // The ACLs compiled for each kind of request.
+  struct
+  {
+    process::Owned<ACLIndex> registerFrameworks;
+    process::Owned<ACLIndex> runTasks;
+    process::Owned<ACLIndex> shutdownFrameworks;
+  } indexes;
+
   process::Once initialized;
 };
 
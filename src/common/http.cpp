@@ -15,6 +15,7 @@
 // limitations under the License.
 
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <utility>
@@ -23,15 +24,39 @@
 #include <mesos/attributes.hpp>
 #include <mesos/resources.hpp>
 
+#include <process/async.hpp>
+#include <process/clock.hpp>
+#include <process/defer.hpp>
+
 #include <stout/foreach.hpp>
+#include <stout/numify.hpp>
 #include <stout/protobuf.hpp>
 #include <stout/stringify.hpp>
+#include <stout/strings.hpp>
 #include <stout/unreachable.hpp>
+#include <stout/uuid.hpp>
 
 #include "common/http.hpp"
 
 #include "messages/messages.hpp"
 
+using process::async;
+
+using process::Clock;
+using process::Future;
+using process::Owned;
+using process::ProcessBase;
+using process::Promise;
+using process::Time;
+using process::UPID;
+
+using process::http::BadRequest;
+using process::http::OK;
+using process::http::Request;
+using process::http::Response;
+using process::http::Status;
+
+using std::list;
 using std::map;
 using std::set;
 using std::string;
@@ -367,5 +392,349 @@ JSON::Object model(
 }
 
 
+ProcessBase::RouteOptions routeOptions(
+    const string& prefix,
+    const string& endpoint,
+    const Option<JSON::Object>& limits)
+{
+  CHECK(strings::startsWith(endpoint, "/"));
+
+  ProcessBase::RouteOptions options;
+  options.metrics = prefix + "/endpoints" + endpoint;
+
+  // NOTE: The limits are validated when the flags are loaded.
+  if (limits.isSome() && limits.get().values.count(endpoint) > 0) {
+    options.concurrency = static_cast<size_t>(
+        limits.get().values.at(endpoint).as<JSON::Number>().as<double>());
+  }
+
+  return options;
+}
+
+
+const Duration StateResponses::NOTIFY_INTERVAL = Milliseconds(100);
+const Duration StateResponses::DEFAULT_WATCH_TIMEOUT = Seconds(30);
+
+
+StateResponses::StateResponses(const UPID& _pid)
+  : pid(_pid),
+    incarnation(UUID::random().toString()),
+    stateVersion(0),
+    internal(false),
+    notifying(false) {}
+
+
+void StateResponses::notify()
+{
+  if (watchers.empty() || notifying) {
+    return;
+  }
+
+  // If we notified recently, we notify again once the interval has
+  // passed. The (deferred) timer is an event of the process, so we
+  // are invoked again after it.
+  const Time now = Clock::now();
+
+  if (notified.isSome() && now - notified.get() < NOTIFY_INTERVAL) {
+    notifying = true;
+
+    Clock::timer(
+        notified.get() + NOTIFY_INTERVAL - now,
+        defer(pid, [this]() {
+          internal = true;
+          notifying = false;
+        }));
+
+    return;
+  }
+
+  notified = now;
+
+  set<string> watched;
+
+  list<Owned<Watcher>>::iterator iterator = watchers.begin();
+  while (iterator != watchers.end()) {
+    // The long-poll timed out or the client went away.
+    if ((*iterator)->promise.future().hasDiscard()) {
+      iterator = watchers.erase(iterator);
+      continue;
+    }
+
+    watched.insert((*iterator)->endpoint);
+    ++iterator;
+  }
+
+  // If the snapshot of an endpoint is still being rendered, its
+  // watchers are woken once it is rendered (see 'rendered()').
+  foreach (const string& name, watched) {
+    if (update(name).isReady()) {
+      wake(name);
+    }
+  }
+}
+
+
+void StateResponses::wake(const string& name)
+{
+  CHECK(endpoints.contains(name));
+
+  const Endpoint& endpoint = endpoints[name];
+
+  list<Owned<Watcher>>::iterator iterator = watchers.begin();
+  while (iterator != watchers.end()) {
+    const Owned<Watcher> watcher = *iterator;
+
+    if (watcher->endpoint == name && endpoint.version > watcher->version) {
+      watcher->promise.set(response(endpoint, watcher->jsonp));
+      iterator = watchers.erase(iterator);
+    } else {
+      ++iterator;
+    }
+  }
+}
+
+
+Future<Response> StateResponses::respond(
+    const string& name,
+    const Request& request,
+    const lambda::function<JSON::Object()>& model)
+{
+  // The process models the state itself, so the published snapshot
+  // is the model.
+  const lambda::function<Model()> publish = [model]() -> Model {
+    std::shared_ptr<JSON::Object> object(new JSON::Object(model()));
+    return [object]() { return std::move(*object); };
+  };
+
+  return respond(name, request, publish);
+}
+
+
+Future<Response> StateResponses::respond(
+    const string& name,
+    const Request& request,
+    const lambda::function<Model()>& publish)
+{
+  if (!endpoints.contains(name)) {
+    endpoints[name].publish = publish;
+  }
+
+  return update(name)
+    .then(defer(pid, [this, name, request]() {
+      internal = true;
+      return _respond(name, request);
+    }));
+}
+
+
+Future<Response> StateResponses::_respond(
+    const string& name,
+    const Request& request)
+{
+  CHECK(endpoints.contains(name));
+
+  const Endpoint& endpoint = endpoints[name];
+  const Option<string> jsonp = request.url.query.get("jsonp");
+
+  Option<string> query = request.url.query.get("version");
+
+  if (query.isSome()) {
+    const size_t separator = query.get().rfind('-');
+    if (separator == string::npos) {
+      return BadRequest(
+          "Failed to parse 'version': Expecting '<incarnation>-<N>'\n");
+    }
+
+    Try<uint64_t> version = numify<uint64_t>(query.get().substr(separator + 1));
+    if (version.isError()) {
+      return BadRequest(
+          "Failed to parse 'version': " + version.error() + "\n");
+    }
+
+    // A version of another incarnation (e.g., of the master before a
+    // failover) says nothing about this one, so it is outdated.
+    const bool outdated = query.get().substr(0, separator) != incarnation;
+
+    Duration timeout = DEFAULT_WATCH_TIMEOUT;
+    query = request.url.query.get("timeout");
+
+    if (query.isSome()) {
+      Try<Duration> duration = Duration::parse(query.get());
+
+      if (duration.isError()) {
+        return BadRequest(
+            "Failed to parse 'timeout': " + duration.error() + "\n");
+      }
+
+      timeout = duration.get();
+    }
+
+    if (outdated || endpoint.version > version.get()) {
+      return response(endpoint, jsonp);
+    }
+
+    Owned<Watcher> watcher(new Watcher());
+    watcher->endpoint = name;
+    watcher->version = version.get();
+    watcher->jsonp = jsonp;
+
+    watchers.push_back(watcher);
+
+    // NOTE: The timeout is handled outside of the process, so it can
+    // not look at the endpoint. The watcher is removed (as discarded)
+    // by the next 'notify()'.
+    const string current = qualified(endpoint);
+
+    return watcher->promise.future()
+      .after(timeout, [current](const Future<Response>& future) {
+        Future<Response>(future).discard();
+        return Future<Response>(notModified(current));
+      });
+  }
+
+  Option<string> match = request.headers.get("If-None-Match");
+  if (match.isSome()) {
+    const string etag = "\"" + qualified(endpoint) + "\"";
+
+    foreach (string tag, strings::tokenize(match.get(), ",")) {
+      tag = strings::trim(tag);
+
+      // Weak and strong tags are compared the same way.
+      if (strings::startsWith(tag, "W/")) {
+        tag = tag.substr(2);
+      }
+
+      if (tag == "*" || tag == etag) {
+        return notModified(qualified(endpoint));
+      }
+    }
+  }
+
+  return response(endpoint, jsonp);
+}
+
+
+Future<Nothing> StateResponses::update(const string& name)
+{
+  CHECK(endpoints.contains(name));
+
+  Endpoint& endpoint = endpoints[name];
+
+  if (endpoint.stateVersion == stateVersion) {
+    if (endpoint.rendering.get() != NULL) {
+      return endpoint.rendering->future();
+    }
+
+    return Nothing();
+  }
+
+  if (endpoint.rendering.get() == NULL) {
+    return render(name);
+  }
+
+  // The snapshot being rendered is outdated, so the next snapshot is
+  // published once it is rendered.
+  if (endpoint.next.get() == NULL) {
+    endpoint.next.reset(new Promise<Nothing>());
+  }
+
+  return endpoint.next->future();
+}
+
+
+Future<Nothing> StateResponses::render(const string& name)
+{
+  Endpoint& endpoint = endpoints[name];
+
+  CHECK(endpoint.rendering.get() == NULL);
+
+  // Publishing the snapshot is the only work done within the process.
+  const Model model = endpoint.publish();
+
+  endpoint.stateVersion = stateVersion;
+  endpoint.rendering.reset(new Promise<Nothing>());
+
+  async([model]() { return stringify(model()); })
+    .onAny(defer(pid, [this, name](const Future<string>& json) {
+      internal = true;
+      rendered(name, json);
+    }));
+
+  return endpoint.rendering->future();
+}
+
+
+void StateResponses::rendered(const string& name, const Future<string>& json)
+{
+  CHECK(endpoints.contains(name));
+
+  Endpoint& endpoint = endpoints[name];
+
+  Owned<Promise<Nothing>> rendering = endpoint.rendering;
+  endpoint.rendering.reset();
+
+  if (json.isReady()) {
+    if (endpoint.version == 0 || json.get() != endpoint.json) {
+      endpoint.json = json.get();
+      ++endpoint.version;
+    }
+
+    rendering->set(Nothing());
+
+    wake(name);
+  } else {
+    // The snapshot is published again by the next request.
+    endpoint.stateVersion = None();
+
+    rendering->fail(
+        "Failed to render '" + name + "': " +
+        (json.isFailed() ? json.failure() : "discarded"));
+  }
+
+  Owned<Promise<Nothing>> next = endpoint.next;
+  endpoint.next.reset();
+
+  if (next.get() != NULL) {
+    next->associate(update(name));
+  }
+}
+
+
+string StateResponses::qualified(const Endpoint& endpoint) const
+{
+  return incarnation + "-" + stringify(endpoint.version);
+}
+
+
+Response StateResponses::response(
+    const Endpoint& endpoint,
+    const Option<string>& jsonp) const
+{
+  // We build the response as 'OK' does for a 'JSON::Value'.
+  OK response;
+  response.type = Response::BODY;
+
+  if (jsonp.isSome()) {
+    response.body = jsonp.get() + "(" + endpoint.json + ");";
+    response.headers["Content-Type"] = "text/javascript";
+  } else {
+    response.body = endpoint.json;
+    response.headers["Content-Type"] = "application/json";
+  }
+
+  response.headers["Content-Length"] = stringify(response.body.size());
+  response.headers["ETag"] = "\"" + qualified(endpoint) + "\"";
+
+  return response;
+}
+
+
+Response StateResponses::notModified(const string& version)
+{
+  Response response(Status::NOT_MODIFIED);
+  response.headers["ETag"] = "\"" + version + "\"";
+  return response;
+}
+
 }  // namespace internal {
 }  // namespace mesos {
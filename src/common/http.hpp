@@ -17,13 +17,27 @@
 #ifndef __COMMON_HTTP_HPP__
 #define __COMMON_HTTP_HPP__
 
+#include <list>
+#include <string>
 #include <vector>
 
 #include <mesos/http.hpp>
 #include <mesos/mesos.hpp>
 
+#include <process/future.hpp>
+#include <process/http.hpp>
+#include <process/owned.hpp>
+#include <process/pid.hpp>
+#include <process/process.hpp>
+#include <process/time.hpp>
+
+#include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/json.hpp>
+#include <stout/json/reader.hpp>
+#include <stout/lambda.hpp>
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
 #include <stout/protobuf.hpp>
 
 namespace mesos {
@@ -59,12 +73,14 @@ Try<Message> deserialize(
       return message;
     }
     case ContentType::JSON: {
-      Try<JSON::Value> value = JSON::parse(body);
-      if (value.isError()) {
-        return Error("Failed to parse body into JSON: " + value.error());
+      JSON::Reader reader(body);
+
+      Try<Message> message = ::protobuf::parse<Message>(&reader);
+      if (message.isError() && reader.failed()) {
+        return Error("Failed to parse body into JSON: " + message.error());
       }
 
-      return ::protobuf::parse<Message>(value.get());
+      return message;
     }
   }
 
@@ -89,6 +105,173 @@ JSON::Object model(
     const TaskState& state,
     const std::vector<TaskStatus>& statuses);
 
+
+// Returns how the requests of an endpoint of the master or the agent
+// are handled: their cost is reported by the metrics
+// '<prefix>/endpoints/<endpoint>/...' (see 'RouteOptions'), and their
+// concurrency is limited if the endpoint is in 'limits', as given by
+// the '--endpoint_concurrency_limits' flag.
+process::ProcessBase::RouteOptions routeOptions(
+    const std::string& prefix,
+    const std::string& endpoint,
+    const Option<JSON::Object>& limits);
+
+
+// Serves the endpoints of a process that only read its state (e.g.,
+// '/state') from their serialized JSON, which is only recomputed
+// after the state may have changed. The process calls 'changed()'
+// and then 'notify()' after handling any event that may have changed
+// its state.
+//
+// The JSON of an endpoint is rendered outside of the process: the
+// process only publishes a snapshot of the state of the endpoint,
+// which is then modeled (if it was not modeled by the process) and
+// serialized by a separate executor. Requests are answered once the
+// JSON is at least as recent as the state when they arrived. At most
+// one snapshot of an endpoint is rendered at a time; the requests
+// that arrive meanwhile share the next snapshot.
+//
+// Every endpoint has a version that is incremented whenever its JSON
+// changes. Versions are qualified by a random ID of the incarnation
+// of the 'StateResponses' (i.e., '<incarnation>-<N>'), since they
+// start over in every process (e.g., after a master failover).
+// Responses carry the version as their 'ETag', and requests with a
+// matching 'If-None-Match' header are answered with '304 Not
+// Modified'. A request with a 'version=<incarnation>-<N>' query
+// parameter is a long-poll: it is answered once the version of the
+// endpoint is greater than N, or with '304 Not Modified' after the
+// 'timeout' query parameter (30secs by default). A version of another
+// incarnation is outdated, so it is answered right away.
+//
+// NOTE: This must only be used from within the process, which must
+// call 'changed()' after handling any dispatch, since the rendered
+// snapshots are applied by dispatches to the process. These
+// dispatches mark themselves as internal, so that they do not
+// invalidate the snapshots.
+class StateResponses
+{
+public:
+  // Models the state of an endpoint from a snapshot that was
+  // published by the process. The model is invoked once, outside of
+  // the process, so the snapshot must not refer to any state of the
+  // process that may still change.
+  typedef lambda::function<JSON::Object()> Model;
+
+  explicit StateResponses(const process::UPID& pid);
+
+  // Invalidates the snapshots, unless the event that was handled is
+  // an internal dispatch (see 'internal').
+  void changed()
+  {
+    if (internal) {
+      internal = false;
+      return;
+    }
+
+    ++stateVersion;
+  }
+
+  void notify();
+
+  // Responds with the JSON of the endpoint as modeled by the process;
+  // only its serialization is done outside of the process.
+  process::Future<process::http::Response> respond(
+      const std::string& endpoint,
+      const process::http::Request& request,
+      const lambda::function<JSON::Object()>& model);
+
+  // Responds with the JSON of the endpoint as modeled (and serialized)
+  // outside of the process from the snapshots published by 'publish'.
+  process::Future<process::http::Response> respond(
+      const std::string& endpoint,
+      const process::http::Request& request,
+      const lambda::function<Model()>& publish);
+
+private:
+  struct Endpoint
+  {
+    Endpoint() : version(0) {}
+
+    lambda::function<Model()> publish;
+
+    // The state version the latest snapshot was published at.
+    Option<uint64_t> stateVersion;
+
+    // Satisfied once the latest snapshot is rendered, if it is still
+    // being rendered.
+    process::Owned<process::Promise<Nothing>> rendering;
+
+    // Satisfied once the snapshot that is published after the one
+    // being rendered is rendered, if any request waits for it.
+    process::Owned<process::Promise<Nothing>> next;
+
+    uint64_t version;
+    std::string json;
+  };
+
+  struct Watcher
+  {
+    std::string endpoint;
+    uint64_t version;
+    Option<std::string> jsonp;
+    process::Promise<process::http::Response> promise;
+  };
+
+  // Publishes a snapshot of the endpoint if the state may have changed
+  // since the latest one. The returned future is satisfied (within
+  // the process) once the JSON of the endpoint is at least as recent
+  // as the current state.
+  process::Future<Nothing> update(const std::string& endpoint);
+
+  // Publishes a snapshot of the endpoint and renders it outside of
+  // the process.
+  process::Future<Nothing> render(const std::string& endpoint);
+
+  // Applies the rendered JSON of the latest snapshot of the endpoint.
+  void rendered(
+      const std::string& endpoint,
+      const process::Future<std::string>& json);
+
+  process::Future<process::http::Response> _respond(
+      const std::string& endpoint,
+      const process::http::Request& request);
+
+  // Answers the watchers of the endpoint if its version has changed.
+  void wake(const std::string& endpoint);
+
+  // Returns the version of the endpoint, qualified by the
+  // incarnation.
+  std::string qualified(const Endpoint& endpoint) const;
+
+  process::http::Response response(
+      const Endpoint& endpoint,
+      const Option<std::string>& jsonp) const;
+
+  static process::http::Response notModified(const std::string& version);
+
+  // Recomputing the watched endpoints after every event would be as
+  // expensive as having the watchers poll, so it is done at most once
+  // per interval.
+  static const Duration NOTIFY_INTERVAL;
+  static const Duration DEFAULT_WATCH_TIMEOUT;
+
+  const process::UPID pid;
+  const std::string incarnation;
+
+  uint64_t stateVersion;
+
+  // Set by the continuations of 'StateResponses' itself, which run as
+  // dispatches to the process but do not change its state, so that
+  // the following 'changed()' is ignored.
+  bool internal;
+
+  hashmap<std::string, Endpoint> endpoints;
+  std::list<process::Owned<Watcher>> watchers;
+
+  Option<process::Time> notified;
+  bool notifying;
+};
+
 } // namespace internal {
 } // namespace mesos {
 
@@ -186,7 +186,7 @@ Option<bool> getTaskHealth(const Task& task)
     // each state, and appends later states at the end. Thus the last
     // status is either a terminal state (where health is
     // irrelevant), or the latest RUNNING status.
-    TaskStatus lastStatus = task.statuses(task.statuses_size() - 1);
+    const TaskStatus& lastStatus = task.statuses(task.statuses_size() - 1);
     if (lastStatus.has_healthy()) {
       healthy = lastStatus.healthy();
     }
@@ -0,0 +1,588 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A protoc plugin that generates the conversions between the internal
+// and the v1 protobufs used by 'evolve' and 'devolve'.
+//
+// The plugin is run once with all the protobuf files listed in
+// 'FILES' and generates 'internal/convert.pb.h' and
+// 'internal/convert.pb.cc' containing, for every pair of corresponding
+// messages, the following functions in 'mesos::internal::convert':
+//
+//   void evolve(const Internal& from, V1* to);
+//   void evolve(Internal&& from, V1* to);
+//   void devolve(const V1& from, Internal* to);
+//   void devolve(V1&& from, Internal* to);
+//
+// Messages are paired by name (e.g., 'mesos.Offer' and
+// 'mesos.v1.Offer'), and through the fields of paired messages
+// (e.g., 'mesos.SlaveID' and 'mesos.v1.AgentID').
+//
+// If the fields of 'from' have the same number, label and type in
+// 'to', the conversion copies the fields one by one, moving strings,
+// bytes and repeated fields out of an rvalue 'from'. Fields which
+// 'to' does not know about are kept as unknown fields, as long as
+// they are length delimited (messages, strings and bytes). Otherwise
+// the conversion falls back to serializing 'from' and parsing it into
+// 'to', as it does when 'from' has unknown fields itself (which 'to'
+// might know about).
+//
+// NOTE: 'to' is expected to be empty.
+
+#include <algorithm>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <google/protobuf/descriptor.h>
+
+#include <google/protobuf/compiler/code_generator.h>
+#include <google/protobuf/compiler/plugin.h>
+
+#include <google/protobuf/io/printer.h>
+#include <google/protobuf/io/zero_copy_stream.h>
+
+using google::protobuf::Descriptor;
+using google::protobuf::EnumDescriptor;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::FileDescriptor;
+
+using google::protobuf::compiler::CodeGenerator;
+using google::protobuf::compiler::GeneratorContext;
+
+using google::protobuf::io::Printer;
+using google::protobuf::io::ZeroCopyOutputStream;
+
+using std::ostringstream;
+using std::pair;
+using std::set;
+using std::string;
+using std::vector;
+
+// The internal protobuf files and their v1 counterparts.
+static const char* FILES[][2] = {
+  {"mesos/mesos.proto", "mesos/v1/mesos.proto"},
+  {"mesos/scheduler/scheduler.proto", "mesos/v1/scheduler/scheduler.proto"},
+  {"mesos/executor/executor.proto", "mesos/v1/executor/executor.proto"},
+};
+
+
+// Returns the fully qualified C++ name of a message or enum, e.g.,
+// '::mesos::v1::Offer_Operation' for 'mesos.v1.Offer.Operation'.
+template <typename T>
+static string cppName(const T* descriptor)
+{
+  const string& package = descriptor->file()->package();
+
+  // Nested types are named 'Outer_Inner' (see the C++ generator).
+  string name = descriptor->full_name().substr(package.size() + 1);
+  for (size_t i = 0; i < name.size(); i++) {
+    if (name[i] == '.') {
+      name[i] = '_';
+    }
+  }
+
+  string result = "::";
+  for (size_t i = 0; i < package.size(); i++) {
+    if (package[i] == '.') {
+      result += "::";
+    } else {
+      result += package[i];
+    }
+  }
+
+  return result + "::" + name;
+}
+
+
+// Returns the name of the C++ accessors of a field.
+static string fieldName(const FieldDescriptor* field)
+{
+  static const char* KEYWORDS[] = {
+    "and", "asm", "auto", "bool", "break", "case", "catch", "char",
+    "class", "const", "continue", "default", "delete", "do", "double",
+    "else", "enum", "explicit", "export", "extern", "false", "float",
+    "for", "friend", "goto", "if", "inline", "int", "long", "mutable",
+    "namespace", "new", "not", "operator", "or", "private", "protected",
+    "public", "register", "return", "short", "signed", "sizeof",
+    "static", "struct", "switch", "template", "this", "throw", "true",
+    "try", "typedef", "typename", "union", "unsigned", "using",
+    "virtual", "void", "volatile", "while", "xor",
+  };
+
+  const string& name = field->lowercase_name();
+
+  for (size_t i = 0; i < sizeof(KEYWORDS) / sizeof(KEYWORDS[0]); i++) {
+    if (name == KEYWORDS[i]) {
+      return name + "_";
+    }
+  }
+
+  return name;
+}
+
+
+static set<int> numbers(const EnumDescriptor* descriptor)
+{
+  set<int> result;
+  for (int i = 0; i < descriptor->value_count(); i++) {
+    result.insert(descriptor->value(i)->number());
+  }
+  return result;
+}
+
+
+class Generator : public CodeGenerator
+{
+public:
+  virtual bool Generate(
+      const FileDescriptor* file,
+      const string& parameter,
+      GeneratorContext* context,
+      string* error) const
+  {
+    // All the conversions are generated together, when invoked for
+    // the first of the files (the others are listed so that they are
+    // part of the descriptor pool).
+    if (file->name() != FILES[0][0]) {
+      return true;
+    }
+
+    Pairs pairs;
+
+    for (size_t i = 0; i < sizeof(FILES) / sizeof(FILES[0]); i++) {
+      const FileDescriptor* internal =
+        file->pool()->FindFileByName(FILES[i][0]);
+      const FileDescriptor* v1 = file->pool()->FindFileByName(FILES[i][1]);
+
+      if (internal == NULL || v1 == NULL) {
+        *error = string("Expecting both '") + FILES[i][0] + "' and '" +
+                 FILES[i][1] + "' to be generated together";
+        return false;
+      }
+
+      for (int j = 0; j < internal->message_type_count(); j++) {
+        pairByName(internal->message_type(j), v1, &pairs);
+      }
+    }
+
+    // Pair the types of the fields of the paired messages.
+    vector<Pair> pending(pairs.order);
+    while (!pending.empty()) {
+      const Pair pair = pending.back();
+      pending.pop_back();
+
+      for (int i = 0; i < pair.first->field_count(); i++) {
+        const FieldDescriptor* field = pair.first->field(i);
+        const FieldDescriptor* other =
+          pair.second->FindFieldByNumber(field->number());
+
+        if (other != NULL &&
+            field->type() == FieldDescriptor::TYPE_MESSAGE &&
+            other->type() == FieldDescriptor::TYPE_MESSAGE) {
+          const Pair nested(field->message_type(), other->message_type());
+          if (pairs.add(nested)) {
+            pending.push_back(nested);
+          }
+        }
+      }
+    }
+
+    write(context, "internal/convert.pb.h", header(pairs));
+    write(context, "internal/convert.pb.cc", source(pairs));
+
+    return true;
+  }
+
+private:
+  // An internal message and its v1 counterpart.
+  typedef pair<const Descriptor*, const Descriptor*> Pair;
+
+  // The paired messages, in the order they were paired to keep the
+  // generated code stable.
+  struct Pairs
+  {
+    bool add(const Pair& pair)
+    {
+      if (!added.insert(pair).second) {
+        return false;
+      }
+
+      order.push_back(pair);
+      return true;
+    }
+
+    set<Pair> added;
+    vector<Pair> order;
+  };
+
+  // Pairs the message (and its nested messages) with the message of
+  // the same name in the v1 file, if any.
+  static void pairByName(
+      const Descriptor* message,
+      const FileDescriptor* v1,
+      Pairs* pairs)
+  {
+    const string& package = message->file()->package();
+    const string name =
+      v1->package() + message->full_name().substr(package.size());
+
+    const Descriptor* other = v1->pool()->FindMessageTypeByName(name);
+    if (other == NULL) {
+      return;
+    }
+
+    pairs->add(Pair(message, other));
+
+    for (int i = 0; i < message->nested_type_count(); i++) {
+      pairByName(message->nested_type(i), v1, pairs);
+    }
+  }
+
+  // Returns whether 'from' can be converted to 'to' field by field.
+  static bool compatible(const Descriptor* from, const Descriptor* to)
+  {
+    if (from->extension_range_count() > 0 ||
+        to->extension_range_count() > 0) {
+      return false;
+    }
+
+    for (int i = 0; i < from->field_count(); i++) {
+      const FieldDescriptor* field = from->field(i);
+      const FieldDescriptor* other = to->FindFieldByNumber(field->number());
+
+      if (other == NULL) {
+        if (!delimited(field)) {
+          return false;
+        }
+
+        continue;
+      }
+
+      if (field->is_repeated() != other->is_repeated() ||
+          field->type() != other->type() ||
+          field->type() == FieldDescriptor::TYPE_GROUP) {
+        return false;
+      }
+
+      if (field->type() == FieldDescriptor::TYPE_ENUM) {
+        const set<int> values = numbers(field->enum_type());
+        const set<int> known = numbers(other->enum_type());
+
+        if (!std::includes(
+                known.begin(), known.end(), values.begin(), values.end())) {
+          return false;
+        }
+      }
+    }
+
+    return true;
+  }
+
+  // Returns whether the field is encoded as a length delimited value.
+  static bool delimited(const FieldDescriptor* field)
+  {
+    return field->type() == FieldDescriptor::TYPE_MESSAGE ||
+           field->type() == FieldDescriptor::TYPE_STRING ||
+           field->type() == FieldDescriptor::TYPE_BYTES;
+  }
+
+  static string header(const Pairs& pairs)
+  {
+    ostringstream out;
+
+    out << "// Generated by mesos-protoc-gen-convert. DO NOT EDIT!\n"
+        << "\n"
+        << "#ifndef __INTERNAL_CONVERT_PB_H__\n"
+        << "#define __INTERNAL_CONVERT_PB_H__\n"
+        << "\n";
+
+    includes(&out);
+
+    out << "\n"
+        << "namespace mesos {\n"
+        << "namespace internal {\n"
+        << "namespace convert {\n"
+        << "\n";
+
+    for (size_t i = 0; i < pairs.order.size(); i++) {
+      const string internal = cppName(pairs.order[i].first);
+      const string v1 = cppName(pairs.order[i].second);
+
+      out << "void evolve(const " << internal << "& from, "
+          << v1 << "* to);\n"
+          << "void evolve(" << internal << "&& from, " << v1 << "* to);\n"
+          << "void devolve(const " << v1 << "& from, "
+          << internal << "* to);\n"
+          << "void devolve(" << v1 << "&& from, " << internal << "* to);\n"
+          << "\n";
+    }
+
+    out << "} // namespace convert {\n"
+        << "} // namespace internal {\n"
+        << "} // namespace mesos {\n"
+        << "\n"
+        << "#endif // __INTERNAL_CONVERT_PB_H__\n";
+
+    return out.str();
+  }
+
+  static string source(const Pairs& pairs)
+  {
+    ostringstream out;
+
+    out << "// Generated by mesos-protoc-gen-convert. DO NOT EDIT!\n"
+        << "\n"
+        << "#include <string>\n"
+        << "#include <utility>\n"
+        << "\n"
+        << "#include <glog/logging.h>\n"
+        << "\n"
+        << "#include \"internal/convert.pb.h\"\n"
+        << "\n"
+        << "namespace mesos {\n"
+        << "namespace internal {\n"
+        << "namespace convert {\n"
+        << "\n"
+        << "// Converts messages which are not field-by-field compatible.\n"
+        << "template <typename From, typename To>\n"
+        << "static void reparse(const From& from, To* to)\n"
+        << "{\n"
+        << "  std::string data;\n"
+        << "\n"
+        << "  // NOTE: Some required fields might not be set.\n"
+        << "  CHECK(from.SerializePartialToString(&data))\n"
+        << "    << \"Failed to serialize \" << from.GetTypeName()\n"
+        << "    << \" while converting to \" << to->GetTypeName();\n"
+        << "\n"
+        << "  CHECK(to->ParsePartialFromString(data))\n"
+        << "    << \"Failed to parse \" << to->GetTypeName()\n"
+        << "    << \" while converting from \" << from.GetTypeName();\n"
+        << "}\n";
+
+    for (size_t i = 0; i < pairs.order.size(); i++) {
+      const Pair& pair = pairs.order[i];
+
+      generate(&out, "evolve", pair.first, pair.second);
+      generate(&out, "devolve", pair.second, pair.first);
+    }
+
+    out << "\n"
+        << "} // namespace convert {\n"
+        << "} // namespace internal {\n"
+        << "} // namespace mesos {\n";
+
+    return out.str();
+  }
+
+  static void includes(ostringstream* out)
+  {
+    for (size_t i = 0; i < sizeof(FILES) / sizeof(FILES[0]); i++) {
+      for (size_t j = 0; j < 2; j++) {
+        const string name(FILES[i][j]);
+        *out << "#include \"" << name.substr(0, name.size() - 6)
+             << ".pb.h\"\n";
+      }
+    }
+  }
+
+  static void generate(
+      ostringstream* out,
+      const string& function,
+      const Descriptor* from,
+      const Descriptor* to)
+  {
+    if (compatible(from, to)) {
+      convert(out, function, from, to, false);
+      convert(out, function, from, to, true);
+    } else {
+      reparse(out, function, from, to);
+    }
+  }
+
+  // Generates the field-by-field conversion from 'from' to 'to'. If
+  // 'move' is set, strings, bytes and repeated fields are swapped out
+  // of 'from' instead of being copied.
+  static void convert(
+      ostringstream* out,
+      const string& function,
+      const Descriptor* from,
+      const Descriptor* to,
+      bool move)
+  {
+    *out << "\n"
+         << "\n"
+         << "void " << function << "("
+         << (move ? "" : "const ") << cppName(from)
+         << (move ? "&& from, " : "& from, ") << cppName(to) << "* to)\n"
+         << "{\n"
+         << "  if (!from.unknown_fields().empty()) {\n"
+         << "    reparse(from, to);\n"
+         << "    return;\n"
+         << "  }\n";
+
+    for (int i = 0; i < from->field_count(); i++) {
+      const FieldDescriptor* field = from->field(i);
+      const FieldDescriptor* other = to->FindFieldByNumber(field->number());
+
+      const string source = fieldName(field);
+
+      *out << "\n";
+
+      if (other == NULL) {
+        unknown(out, field);
+        continue;
+      }
+
+      const string target = fieldName(other);
+
+      if (field->is_repeated()) {
+        if (field->type() == FieldDescriptor::TYPE_MESSAGE) {
+          *out << "  to->mutable_" << target << "()->Reserve(from."
+               << source << "_size());\n"
+               << "  for (int i = 0; i < from." << source
+               << "_size(); i++) {\n";
+
+          if (move) {
+            *out << "    " << function << "(std::move(*from.mutable_"
+                 << source << "(i)), to->add_" << target << "());\n";
+          } else {
+            *out << "    " << function << "(from." << source
+                 << "(i), to->add_" << target << "());\n";
+          }
+
+          *out << "  }\n";
+        } else if (move) {
+          // Repeated scalars, enums (stored as 'int') and strings have
+          // the same representation on both sides.
+          *out << "  to->mutable_" << target << "()->Swap(from.mutable_"
+               << source << "());\n";
+        } else {
+          *out << "  to->mutable_" << target << "()->CopyFrom(from."
+               << source << "());\n";
+        }
+
+        continue;
+      }
+
+      *out << "  if (from.has_" << source << "()) {\n";
+
+      switch (field->type()) {
+        case FieldDescriptor::TYPE_MESSAGE:
+          if (move) {
+            *out << "    " << function << "(std::move(*from.mutable_"
+                 << source << "()), to->mutable_" << target << "());\n";
+          } else {
+            *out << "    " << function << "(from." << source
+                 << "(), to->mutable_" << target << "());\n";
+          }
+          break;
+        case FieldDescriptor::TYPE_STRING:
+        case FieldDescriptor::TYPE_BYTES:
+          if (move) {
+            *out << "    to->mutable_" << target << "()->swap(*from.mutable_"
+                 << source << "());\n";
+          } else {
+            *out << "    to->set_" << target << "(from." << source
+                 << "());\n";
+          }
+          break;
+        case FieldDescriptor::TYPE_ENUM:
+          *out << "    to->set_" << target << "(static_cast<"
+               << cppName(other->enum_type()) << ">(from." << source
+               << "()));\n";
+          break;
+        default:
+          *out << "    to->set_" << target << "(from." << source
+               << "());\n";
+          break;
+      }
+
+      *out << "  }\n";
+    }
+
+    *out << "}\n";
+  }
+
+  // Generates keeping a (length delimited) field which the target
+  // does not know about as an unknown field.
+  static void unknown(ostringstream* out, const FieldDescriptor* field)
+  {
+    const string source = fieldName(field);
+    const bool message = field->type() == FieldDescriptor::TYPE_MESSAGE;
+
+    if (field->is_repeated()) {
+      *out << "  for (int i = 0; i < from." << source
+           << "_size(); i++) {\n"
+           << "    to->mutable_unknown_fields()->AddLengthDelimited(\n"
+           << "        " << field->number() << ", from." << source
+           << (message ? "(i).SerializePartialAsString());\n" : "(i));\n")
+           << "  }\n";
+    } else {
+      *out << "  if (from.has_" << source << "()) {\n"
+           << "    to->mutable_unknown_fields()->AddLengthDelimited(\n"
+           << "        " << field->number() << ", from." << source
+           << (message ? "().SerializePartialAsString());\n" : "());\n")
+           << "  }\n";
+    }
+  }
+
+  static void reparse(
+      ostringstream* out,
+      const string& function,
+      const Descriptor* from,
+      const Descriptor* to)
+  {
+    *out << "\n"
+         << "\n"
+         << "void " << function << "(const " << cppName(from)
+         << "& from, " << cppName(to) << "* to)\n"
+         << "{\n"
+         << "  reparse(from, to);\n"
+         << "}\n"
+         << "\n"
+         << "\n"
+         << "void " << function << "(" << cppName(from)
+         << "&& from, " << cppName(to) << "* to)\n"
+         << "{\n"
+         << "  reparse(from, to);\n"
+         << "}\n";
+  }
+
+  static void write(
+      GeneratorContext* context,
+      const string& name,
+      const string& content)
+  {
+    ZeroCopyOutputStream* stream = context->Open(name);
+
+    {
+      Printer printer(stream, '$');
+      printer.PrintRaw(content);
+    }
+
+    delete stream;
+  }
+};
+
+
+int main(int argc, char** argv)
+{
+  Generator generator;
+  return google::protobuf::compiler::PluginMain(argc, argv, &generator);
+}
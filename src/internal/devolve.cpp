@@ -14,36 +14,24 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <utility>
+
 #include <stout/check.hpp>
 
+#include "internal/convert.pb.h"
 #include "internal/devolve.hpp"
 
-using std::string;
-
 namespace mesos {
 namespace internal {
 
-template <typename T>
-static T devolve(const google::protobuf::Message& message)
+// Helper for devolving a type using the field-by-field conversions
+// generated from the protobuf definitions (see
+// 'internal/convert_generator.cpp').
+template <typename T, typename U>
+static T devolve(const U& u)
 {
   T t;
-
-  string data;
-
-  // NOTE: We need to use 'SerializePartialToString' instead of
-  // 'SerializeToString' because some required fields might not be set
-  // and we don't want an exception to get thrown.
-  CHECK(message.SerializePartialToString(&data))
-    << "Failed to serialize " << message.GetTypeName()
-    << " while devolving to " << t.GetTypeName();
-
-  // NOTE: We need to use 'ParsePartialFromString' instead of
-  // 'ParsePartialFromString' because some required fields might not
-  // be set and we don't want an exception to get thrown.
-  CHECK(t.ParsePartialFromString(data))
-    << "Failed to parse " << t.GetTypeName()
-    << " while devolving from " << message.GetTypeName();
-
+  convert::devolve(u, &t);
   return t;
 }
 
@@ -115,12 +103,28 @@ executor::Call devolve(const v1::executor::Call& call)
 }
 
 
+executor::Call devolve(v1::executor::Call&& call)
+{
+  executor::Call result;
+  convert::devolve(std::move(call), &result);
+  return result;
+}
+
+
 scheduler::Call devolve(const v1::scheduler::Call& call)
 {
   return devolve<scheduler::Call>(call);
 }
 
 
+scheduler::Call devolve(v1::scheduler::Call&& call)
+{
+  scheduler::Call result;
+  convert::devolve(std::move(call), &result);
+  return result;
+}
+
+
 scheduler::Event devolve(const v1::scheduler::Event& event)
 {
   return devolve<scheduler::Event>(event);
@@ -51,6 +51,11 @@ scheduler::Event devolve(const v1::scheduler::Event& event);
 
 executor::Call devolve(const v1::executor::Call& call);
 
+// Devolving an rvalue moves (rather than copies) its strings and
+// repeated fields, e.g., for calls that were just decoded.
+scheduler::Call devolve(v1::scheduler::Call&& call);
+executor::Call devolve(v1::executor::Call&& call);
+
 // Helper for repeated field devolving to 'T1' from 'T2'.
 template <typename T1, typename T2>
 google::protobuf::RepeatedPtrField<T1> devolve(
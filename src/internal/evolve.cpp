@@ -18,38 +18,22 @@
 
 #include <stout/check.hpp>
 
+#include "internal/convert.pb.h"
 #include "internal/evolve.hpp"
 
-using std::string;
-
 using process::UPID;
 
 namespace mesos {
 namespace internal {
 
-// Helper for evolving a type by serializing/parsing when the types
-// have not changed across versions.
-template <typename T>
-static T evolve(const google::protobuf::Message& message)
+// Helper for evolving a type using the field-by-field conversions
+// generated from the protobuf definitions (see
+// 'internal/convert_generator.cpp').
+template <typename T, typename U>
+static T evolve(const U& u)
 {
   T t;
-
-  string data;
-
-  // NOTE: We need to use 'SerializePartialToString' instead of
-  // 'SerializeToString' because some required fields might not be set
-  // and we don't want an exception to get thrown.
-  CHECK(message.SerializePartialToString(&data))
-    << "Failed to serialize " << message.GetTypeName()
-    << " while evolving to " << t.GetTypeName();
-
-  // NOTE: We need to use 'ParsePartialFromString' instead of
-  // 'ParsePartialFromString' because some required fields might not
-  // be set and we don't want an exception to get thrown.
-  CHECK(t.ParsePartialFromString(data))
-    << "Failed to parse " << t.GetTypeName()
-    << " while evolving from " << message.GetTypeName();
-
+  convert::evolve(u, &t);
   return t;
 }
 
@@ -174,9 +158,16 @@ v1::scheduler::Event evolve(const ResourceOffersMessage& message)
   event.set_type(v1::scheduler::Event::OFFERS);
 
   v1::scheduler::Event::Offers* offers = event.mutable_offers();
-  offers->mutable_offers()->CopyFrom(evolve<v1::Offer>(message.offers()));
-  offers->mutable_inverse_offers()->CopyFrom(evolve<v1::InverseOffer>(
-      message.inverse_offers()));
+
+  offers->mutable_offers()->Reserve(message.offers_size());
+  foreach (const Offer& offer, message.offers()) {
+    convert::evolve(offer, offers->add_offers());
+  }
+
+  offers->mutable_inverse_offers()->Reserve(message.inverse_offers_size());
+  foreach (const InverseOffer& inverseOffer, message.inverse_offers()) {
+    convert::evolve(inverseOffer, offers->add_inverse_offers());
+  }
 
   return event;
 }
@@ -201,7 +192,7 @@ v1::scheduler::Event evolve(const StatusUpdateMessage& message)
 
   v1::scheduler::Event::Update* update = event.mutable_update();
 
-  update->mutable_status()->CopyFrom(evolve(message.update().status()));
+  convert::evolve(message.update().status(), update->mutable_status());
 
   if (message.update().has_slave_id()) {
     update->mutable_status()->mutable_agent_id()->CopyFrom(
@@ -235,6 +226,21 @@ v1::scheduler::Event evolve(const StatusUpdateMessage& message)
 }
 
 
+v1::scheduler::Event evolve(const StatusUpdatesMessage& message)
+{
+  v1::scheduler::Event event;
+  event.set_type(v1::scheduler::Event::UPDATES);
+
+  v1::scheduler::Event::Updates* updates = event.mutable_updates();
+
+  foreach (const StatusUpdateMessage& update, message.updates()) {
+    updates->add_updates()->CopyFrom(evolve(update).update());
+  }
+
+  return event;
+}
+
+
 v1::scheduler::Event evolve(const LostSlaveMessage& message)
 {
   v1::scheduler::Event event;
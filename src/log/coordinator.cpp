@@ -17,14 +17,18 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <deque>
+#include <map>
 
 #include <mesos/type_utils.hpp>
 
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/id.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/none.hpp>
 
 #include "log/catchup.hpp"
@@ -35,12 +39,19 @@
 
 using namespace process;
 
+using std::deque;
+using std::map;
 using std::string;
 
 namespace mesos {
 namespace internal {
 namespace log {
 
+// The maximum number of positions that are written concurrently, see
+// 'CoordinatorProcess::enqueue'.
+static const size_t MAX_CONCURRENT_WRITES = 64;
+
+
 class CoordinatorProcess : public Process<CoordinatorProcess>
 {
 public:
@@ -54,7 +65,9 @@ public:
       network(_network),
       state(INITIAL),
       proposal(0),
-      index(0) {}
+      index(0),
+      demoting(false),
+      failed(false) {}
 
   virtual ~CoordinatorProcess() {}
 
@@ -68,7 +81,15 @@ protected:
   virtual void finalize()
   {
     electing.discard();
-    writing.discard();
+
+    foreachvalue (Write write, writing) {
+      write.future.discard();
+      write.promise->discard();
+    }
+
+    foreach (const Write& write, queued) {
+      write.promise->discard();
+    }
   }
 
 private:
@@ -92,6 +113,8 @@ private:
   // Writing related functions.  //
   /////////////////////////////////
 
+  Future<Option<uint64_t> > enqueue(const Action& action);
+  void flush();
   Future<Option<uint64_t> > write(const Action& action);
   Future<WriteResponse> runWritePhase(const Action& action);
   Future<Option<uint64_t> > checkWritePhase(
@@ -99,10 +122,11 @@ private:
       const WriteResponse& response);
   Future<Nothing> runLearnPhase(const Action& action);
   Future<bool> checkLearnPhase(const Action& action);
-  Future<Option<uint64_t> > updateIndexAfterWritten(bool missing);
-  void writingFinished();
-  void writingFailed();
-  void writingAborted();
+  Future<Option<uint64_t> > checkLearnedPosition(
+      const Action& action,
+      bool missing);
+  void written(const Future<Option<uint64_t> >& future);
+  void discard(uint64_t position);
 
   const size_t quorum;
   const Shared<Replica> replica;
@@ -115,7 +139,8 @@ private:
   // coordinator does not declare itself as elected until it wins the
   // election and has filled all existing positions. A coordinator is
   // put in electing state after it decides to go for an election and
-  // before it is elected.
+  // before it is elected. An elected coordinator is in writing state
+  // while it has writes queued or in flight.
   enum
   {
     INITIAL,
@@ -131,7 +156,30 @@ private:
   uint64_t index;
 
   Future<Option<uint64_t> > electing;
-  Future<Option<uint64_t> > writing;
+
+  // An append or truncate, and the write of its action once it has
+  // been assigned a position.
+  struct Write
+  {
+    Action action;
+    Owned<process::Promise<Option<uint64_t> > > promise;
+    Future<Option<uint64_t> > future;
+  };
+
+  // The writes waiting for a free slot in the window, and the writes
+  // that have not been answered yet keyed by position.
+  deque<Write> queued;
+  map<uint64_t, Write> writing;
+
+  // Whether a write in flight was rejected, failed or discarded. The
+  // coordinator will no longer accept writes and will be demoted once
+  // the writes in flight have finished.
+  bool demoting;
+
+  // Whether a write that has been answered was not successful, in
+  // which case all later writes are answered with none (see
+  // 'written').
+  bool failed;
 };
 
 
@@ -305,41 +353,84 @@ Future<uint64_t> CoordinatorProcess::demote()
 
 Future<Option<uint64_t> > CoordinatorProcess::append(const string& bytes)
 {
-  if (state == INITIAL || state == ELECTING) {
+  if (state == INITIAL || state == ELECTING || demoting) {
     return None();
-  } else if (state == WRITING) {
-    return Failure("Coordinator is currently writing");
   }
 
   Action action;
-  action.set_position(index);
-  action.set_promised(proposal);
-  action.set_performed(proposal);
   action.set_type(Action::APPEND);
   Action::Append* append = action.mutable_append();
   append->set_bytes(bytes);
 
-  return write(action);
+  return enqueue(action);
 }
 
 
 Future<Option<uint64_t> > CoordinatorProcess::truncate(uint64_t to)
 {
-  if (state == INITIAL || state == ELECTING) {
+  if (state == INITIAL || state == ELECTING || demoting) {
     return None();
-  } else if (state == WRITING) {
-    return Failure("Coordinator is currently writing");
   }
 
   Action action;
-  action.set_position(index);
-  action.set_promised(proposal);
-  action.set_performed(proposal);
   action.set_type(Action::TRUNCATE);
   Action::Truncate* truncate = action.mutable_truncate();
   truncate->set_to(to);
 
-  return write(action);
+  return enqueue(action);
+}
+
+
+Future<Option<uint64_t> > CoordinatorProcess::enqueue(const Action& action)
+{
+  CHECK(state == ELECTED || state == WRITING);
+
+  state = WRITING;
+
+  Write write;
+  write.action = action;
+  write.promise.reset(new process::Promise<Option<uint64_t> >());
+
+  queued.push_back(write);
+
+  flush();
+
+  return write.promise->future();
+}
+
+
+void CoordinatorProcess::flush()
+{
+  // Start writing the queued writes without waiting for the writes
+  // in flight to finish. Each position is an independent instance of
+  // Paxos for which we already hold the (implicit) promise from the
+  // election, so several positions can safely be written at the same
+  // time and the round trips to the replicas overlap.
+  while (!queued.empty() && writing.size() < MAX_CONCURRENT_WRITES) {
+    Write write = queued.front();
+    queued.pop_front();
+
+    if (write.promise->future().hasDiscard()) {
+      write.promise->discard();
+      continue;
+    }
+
+    if (demoting) {
+      write.promise->set(None());
+      continue;
+    }
+
+    write.action.set_position(index++);
+    write.action.set_promised(proposal);
+    write.action.set_performed(proposal);
+
+    write.future = this->write(write.action);
+
+    write.promise->future()
+      .onDiscard(defer(self(), &Self::discard, write.action.position()));
+
+    writing[write.action.position()] = write;
+  }
 }
 
 
@@ -348,18 +439,12 @@ Future<Option<uint64_t> > CoordinatorProcess::write(const Action& action)
   LOG(INFO) << "Coordinator attempting to write " << action.type()
             << " action at position " << action.position();
 
-  CHECK_EQ(state, ELECTED);
+  CHECK_EQ(state, WRITING);
   CHECK(action.has_performed() && action.has_type());
 
-  state = WRITING;
-
-  writing = runWritePhase(action)
+  return runWritePhase(action)
     .then(defer(self(), &Self::checkWritePhase, action, lambda::_1))
-    .onReady(defer(self(), &Self::writingFinished))
-    .onFailed(defer(self(), &Self::writingFailed))
-    .onDiscarded(defer(self(), &Self::writingAborted));
-
-  return writing;
+    .onAny(defer(self(), &Self::written, lambda::_1));
 }
 
 
@@ -374,16 +459,17 @@ Future<Option<uint64_t> > CoordinatorProcess::checkWritePhase(
     const WriteResponse& response)
 {
   if (!response.okay()) {
-    // Received a NACK. Save the proposal number.
-    CHECK_LE(proposal, response.proposal());
-    proposal = response.proposal();
+    // Received a NACK. Save the proposal number. Since several
+    // positions can be in flight, an earlier NACK might already have
+    // told us about a higher proposal number.
+    proposal = std::max(proposal, response.proposal());
 
     return None();
   }
 
   return runLearnPhase(action)
     .then(defer(self(), &Self::checkLearnPhase, action))
-    .then(defer(self(), &Self::updateIndexAfterWritten, lambda::_1));
+    .then(defer(self(), &Self::checkLearnedPosition, action, lambda::_1));
 }
 
 
@@ -402,39 +488,68 @@ Future<bool> CoordinatorProcess::checkLearnPhase(const Action& action)
 }
 
 
-Future<Option<uint64_t> > CoordinatorProcess::updateIndexAfterWritten(
+Future<Option<uint64_t> > CoordinatorProcess::checkLearnedPosition(
+    const Action& action,
     bool missing)
 {
   CHECK(!missing) << "Not expecting local replica to be missing position "
-                  << index << " after the writing is done";
+                  << action.position() << " after the writing is done";
 
-  return index++;
+  return action.position();
 }
 
 
-void CoordinatorProcess::writingFinished()
+void CoordinatorProcess::written(const Future<Option<uint64_t> >& future)
 {
   CHECK_EQ(state, WRITING);
-  state = ELECTED;
-}
 
+  // A NACK means that another coordinator has been elected. If a
+  // write operation is discarded we don't actually know whether the
+  // write was successful or not and we really need to "catch-up" that
+  // position before we try and do another write (see MESOS-1038 for
+  // more details). In either case, as well as on a failure, we stop
+  // writing and demote the coordinator.
+  if (!future.isReady() || future.get().isNone()) {
+    demoting = true;
+  }
 
-void CoordinatorProcess::writingFailed()
-{
-  CHECK_EQ(state, WRITING);
-  state = INITIAL;
+  // Answer the writes in the order of their positions, so that a
+  // write is never reported successful before all of the earlier
+  // writes are. Once a write is not successful, the later writes are
+  // answered with none, even if they were written (like for a
+  // discarded write, a later coordinator will "catch-up" the
+  // positions).
+  while (!writing.empty() && !writing.begin()->second.future.isPending()) {
+    const Write write = writing.begin()->second;
+    writing.erase(writing.begin());
+
+    if (failed) {
+      write.promise->set(None());
+    } else if (write.future.isReady() && write.future.get().isSome()) {
+      write.promise->set(write.future.get());
+    } else {
+      failed = true;
+      write.promise->associate(write.future);
+    }
+  }
+
+  // Write the writes that were waiting for a slot in the window (or
+  // answer them if we are being demoted).
+  flush();
+
+  if (writing.empty() && queued.empty()) {
+    state = demoting ? INITIAL : ELECTED;
+    demoting = false;
+    failed = false;
+  }
 }
 
 
-void CoordinatorProcess::writingAborted()
+void CoordinatorProcess::discard(uint64_t position)
 {
-  CHECK_EQ(state, WRITING);
-
-  // Demote the coordinator if a write operation is discarded since we
-  // don't actually know the write was successful or not and we really
-  // need to "catch-up" that position before we try and do another
-  // write (see MESOS-1038 for more details).
-  state = INITIAL;
+  if (writing.count(position) > 0) {
+    writing[position].future.discard();
+  }
 }
 
 
@@ -60,7 +60,13 @@ public:
 
   // Appends the specified bytes to the end of the log. Returns the
   // position of the appended entry if the operation succeeds or none
-  // if the coordinator was demoted.
+  // if the coordinator was demoted. Appends and truncates may be
+  // issued without waiting for earlier ones to finish; they are
+  // written concurrently at consecutive positions, in the order in
+  // which they were issued. They are also answered in that order: if
+  // one of them is not successful, all of the later ones that were
+  // already issued are answered with none (even though they might
+  // have been written, like any write that was not answered).
   process::Future<Option<uint64_t> > append(const std::string& bytes);
 
   // Removes all log entries preceding the log entry at the given
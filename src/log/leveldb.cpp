@@ -27,6 +27,7 @@
 #include <stout/error.hpp>
 #include <stout/numify.hpp>
 #include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 #include <stout/unreachable.hpp>
 
@@ -127,7 +128,7 @@ static string encode(uint64_t position, bool adjust = true)
 
 
 LevelDBStorage::LevelDBStorage()
-  : db(NULL), first(None())
+  : db(NULL), first(None()), batched(0), truncated(None())
 {
   // Nothing to see here.
 }
@@ -135,6 +136,14 @@ LevelDBStorage::LevelDBStorage()
 
 LevelDBStorage::~LevelDBStorage()
 {
+  if (db != NULL) {
+    Try<Nothing> synced = sync();
+
+    if (synced.isError()) {
+      LOG(ERROR) << "Failed to sync leveldb: " << synced.error();
+    }
+  }
+
   delete db; // Might be null if open failed in LevelDBStorage::restore.
 }
 
@@ -279,12 +288,6 @@ Try<Storage::State> LevelDBStorage::restore(const string& path)
 
 Try<Nothing> LevelDBStorage::persist(const Metadata& metadata)
 {
-  Stopwatch stopwatch;
-  stopwatch.start();
-
-  leveldb::WriteOptions options;
-  options.sync = true;
-
   Record record;
   record.set_type(Record::METADATA);
   record.mutable_metadata()->CopyFrom(metadata);
@@ -295,14 +298,8 @@ Try<Nothing> LevelDBStorage::persist(const Metadata& metadata)
     return Error("Failed to serialize record");
   }
 
-  leveldb::Status status = db->Put(options, encode(0, false), value);
-
-  if (!status.ok()) {
-    return Error(status.ToString());
-  }
-
-  LOG(INFO) << "Persisting metadata (" << value.size()
-            << " bytes) to leveldb took " << stopwatch.elapsed();
+  batch.Put(encode(0, false), value);
+  batched++;
 
   return Nothing();
 }
@@ -310,9 +307,6 @@ Try<Nothing> LevelDBStorage::persist(const Metadata& metadata)
 
 Try<Nothing> LevelDBStorage::persist(const Action& action)
 {
-  Stopwatch stopwatch;
-  stopwatch.start();
-
   Record record;
   record.set_type(Record::ACTION);
   record.mutable_action()->MergeFrom(action);
@@ -323,14 +317,10 @@ Try<Nothing> LevelDBStorage::persist(const Action& action)
     return Error("Failed to serialize record");
   }
 
-  leveldb::WriteOptions options;
-  options.sync = true;
+  batch.Put(encode(action.position()), value);
+  batched++;
 
-  leveldb::Status status = db->Put(options, encode(action.position()), value);
-
-  if (!status.ok()) {
-    return Error(status.ToString());
-  }
+  pending[action.position()] = value;
 
   // Updated the first position. Notice that we use 'min' here instead
   // of checking 'isNone()' because it's likely that log entries are
@@ -338,18 +328,12 @@ Try<Nothing> LevelDBStorage::persist(const Action& action)
   // catch-up policy is used).
   first = min(first, action.position());
 
-  LOG(INFO) << "Persisting action (" << value.size()
-            << " bytes) to leveldb took " << stopwatch.elapsed();
-
-  // Delete positions if a truncate action has been *learned*. Note
-  // that we do this in a best-effort fashion (i.e., we ignore any
-  // failures to the database since we can always try again).
+  // Delete positions if a truncate action has been *learned*. The
+  // deletions are synced along with the truncate action itself.
   if (action.has_type() && action.type() == Action::TRUNCATE &&
       action.has_learned() && action.learned()) {
     CHECK(action.has_truncate());
 
-    stopwatch.start(); // Restart the stopwatch.
-
     // To actually perform the truncation in leveldb we need to remove
     // all the keys that represent positions no longer in the log. We
     // do this by attempting to delete all keys that represent the
@@ -365,8 +349,6 @@ Try<Nothing> LevelDBStorage::persist(const Action& action)
     // cheaper than using an iterator to determine the first position
     // (which was, for posterity, the second implementation).
 
-    leveldb::WriteBatch batch;
-
     CHECK_SOME(first);
 
     // Add positions up to (but excluding) the truncate position to
@@ -380,25 +362,17 @@ Try<Nothing> LevelDBStorage::persist(const Action& action)
     uint64_t index = 0;
     while ((first.get() + index) < action.truncate().to()) {
       batch.Delete(encode(first.get() + index));
+      pending.erase(first.get() + index);
       index++;
     }
 
-    // If we added any positions, attempt to delete them!
+    // If we added any positions, save the new first position!
     if (index > 0) {
-      // We do this write asynchronously (e.g., using default options).
-      leveldb::Status status = db->Write(leveldb::WriteOptions(), &batch);
-
-      if (!status.ok()) {
-        LOG(WARNING) << "Ignoring leveldb batch delete failure: "
-                     << status.ToString();
-      } else {
-        // Save the new first position!
-        CHECK_LT(first.get(), action.truncate().to());
-        first = action.truncate().to();
-
-        LOG(INFO) << "Deleting ~" << index
-                  << " keys from leveldb took " << stopwatch.elapsed();
-      }
+      CHECK_LT(first.get(), action.truncate().to());
+      first = action.truncate().to();
+      truncated = max(truncated, action.truncate().to());
+
+      LOG(INFO) << "Deleting ~" << index << " keys from leveldb";
     }
   }
 
@@ -406,21 +380,57 @@ Try<Nothing> LevelDBStorage::persist(const Action& action)
 }
 
 
-Try<Action> LevelDBStorage::read(uint64_t position)
+Try<Nothing> LevelDBStorage::sync()
 {
+  if (batched == 0) {
+    return Nothing();
+  }
+
   Stopwatch stopwatch;
   stopwatch.start();
 
-  leveldb::ReadOptions options;
+  leveldb::WriteOptions options;
+  options.sync = true;
 
-  string value;
+  leveldb::Status status = db->Write(options, &batch);
+
+  LOG(INFO) << "Syncing " << batched << " records to leveldb took "
+            << stopwatch.elapsed();
 
-  leveldb::Status status = db->Get(options, encode(position), &value);
+  batch.Clear();
+  batched = 0;
+  pending.clear();
+  truncated = None();
 
   if (!status.ok()) {
     return Error(status.ToString());
   }
 
+  return Nothing();
+}
+
+
+Try<Action> LevelDBStorage::read(uint64_t position)
+{
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  string value;
+
+  if (pending.contains(position)) {
+    value = pending[position];
+  } else if (truncated.isSome() && position < truncated.get()) {
+    return Error("Position " + stringify(position) + " has been truncated");
+  } else {
+    leveldb::ReadOptions options;
+
+    leveldb::Status status = db->Get(options, encode(position), &value);
+
+    if (!status.ok()) {
+      return Error(status.ToString());
+    }
+  }
+
   google::protobuf::io::ArrayInputStream stream(value.data(), value.size());
 
   Record record;
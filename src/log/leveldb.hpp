@@ -18,9 +18,13 @@
 #define __LOG_LEVELDB_HPP__
 
 #include <leveldb/db.h>
+#include <leveldb/write_batch.h>
 
 #include <stdint.h>
 
+#include <string>
+
+#include <stout/hashmap.hpp>
 #include <stout/option.hpp>
 
 #include "log/storage.hpp"
@@ -39,6 +43,7 @@ public:
   virtual Try<State> restore(const std::string& path);
   virtual Try<Nothing> persist(const Metadata& metadata);
   virtual Try<Nothing> persist(const Action& action);
+  virtual Try<Nothing> sync();
   virtual Try<Action> read(uint64_t position);
 
 private:
@@ -46,6 +51,17 @@ private:
 
   // First position still in leveldb, used during truncation.
   Option<uint64_t> first;
+
+  // The records persisted since the last sync. They are written to
+  // leveldb in a single synced batch, i.e., with a single fsync.
+  leveldb::WriteBatch batch;
+  size_t batched;
+
+  // The actions in the batch by position, and the position up to
+  // which the batch truncates the log, so that reads observe the
+  // batch before it is synced.
+  hashmap<uint64_t, std::string> pending;
+  Option<uint64_t> truncated;
 };
 
 } // namespace log {
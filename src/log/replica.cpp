@@ -17,14 +17,22 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <utility>
+#include <vector>
 
 #include <mesos/type_utils.hpp>
 
 #include <process/dispatch.hpp>
 #include <process/id.hpp>
+#include <process/owned.hpp>
+
+#include <process/metrics/counter.hpp>
+#include <process/metrics/metrics.hpp>
+#include <process/metrics/timer.hpp>
 
 #include <stout/check.hpp>
 #include <stout/error.hpp>
+#include <stout/exit.hpp>
 #include <stout/foreach.hpp>
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
@@ -38,8 +46,13 @@
 
 using namespace process;
 
+using process::metrics::Counter;
+using process::metrics::Timer;
+
 using std::list;
+using std::pair;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -100,6 +113,14 @@ public:
   // to storage. Returns true on success and false otherwise.
   bool update(const Metadata::Status& status);
 
+protected:
+  virtual void finalize()
+  {
+    // Make sure the records persisted since the last sync are not
+    // lost when the replica is terminated.
+    sync();
+  }
+
 private:
   // Handles a request from a proposer to promise not to accept writes
   // from any other proposer with lower proposal number.
@@ -123,6 +144,21 @@ private:
   // otherwise.
   bool updatePromised(uint64_t promised);
 
+  // Sends the response to a request once the records persisted while
+  // handling the request have been synced.
+  void acknowledge(const UPID& to, const google::protobuf::Message& response);
+
+  // Dispatches a sync unless one is already pending. Since the sync
+  // is handled after the messages already queued for this replica,
+  // the records persisted for all of them are synced together (i.e.,
+  // group commit).
+  void scheduleSync();
+
+  // Syncs the records persisted since the last sync and then sends
+  // the pending acknowledgements. Exits if the sync fails (see the
+  // comment in the implementation).
+  void sync();
+
   // Helper routine to restore log (e.g., on restart).
   void restore(const string& path);
 
@@ -144,13 +180,49 @@ private:
 
   // Unlearned positions in the log.
   IntervalSet<uint64_t> unlearned;
+
+  // Whether a sync has been dispatched, the number of records
+  // persisted since the last sync and the responses waiting for them
+  // to be synced.
+  bool syncing;
+  size_t unsynced;
+  vector<pair<UPID, Owned<google::protobuf::Message>>> acknowledgements;
+
+  struct Metrics
+  {
+    Metrics()
+      : syncs("log/replica/syncs"),
+        synced_records("log/replica/synced_records"),
+        sync("log/replica/sync")
+    {
+      process::metrics::add(syncs);
+      process::metrics::add(synced_records);
+      process::metrics::add(sync);
+    }
+
+    ~Metrics()
+    {
+      process::metrics::remove(syncs);
+      process::metrics::remove(synced_records);
+      process::metrics::remove(sync);
+    }
+
+    // The number of syncs and the number of records they synced; the
+    // ratio of the two is the average size of a group commit.
+    Counter syncs;
+    Counter synced_records;
+
+    Timer<Milliseconds> sync;
+  } metrics;
 };
 
 
 ReplicaProcess::ReplicaProcess(const string& path)
   : ProcessBase(ID::generate("log-replica")),
     begin(0),
-    end(0)
+    end(0),
+    syncing(false),
+    unsynced(0)
 {
   // TODO(benh): Factor out and expose storage.
   storage = new LevelDBStorage();
@@ -318,6 +390,11 @@ bool ReplicaProcess::update(const Metadata::Status& status)
     return false;
   }
 
+  unsynced++;
+
+  // The caller expects the status to be durable once we return.
+  sync();
+
   LOG(INFO) << "Persisted replica status to " << status;
 
   // Update the cached metadata.
@@ -340,6 +417,9 @@ bool ReplicaProcess::updatePromised(uint64_t promised)
     return false;
   }
 
+  unsynced++;
+  scheduleSync();
+
   LOG(INFO) << "Persisted promised to " << promised;
 
   // Update the cached metadata.
@@ -462,7 +542,7 @@ void ReplicaProcess::promise(const UPID& from, const PromiseRequest& request)
           response.set_okay(true);
           response.set_proposal(request.proposal());
           response.set_position(request.position());
-          reply(response);
+          acknowledge(from, response);
         }
       }
     } else {
@@ -486,7 +566,7 @@ void ReplicaProcess::promise(const UPID& from, const PromiseRequest& request)
           response.set_okay(true);
           response.set_proposal(request.proposal());
           response.mutable_action()->MergeFrom(original);
-          reply(response);
+          acknowledge(from, response);
         }
       }
     }
@@ -511,7 +591,7 @@ void ReplicaProcess::promise(const UPID& from, const PromiseRequest& request)
         response.set_okay(true);
         response.set_proposal(request.proposal());
         response.set_position(end);
-        reply(response);
+        acknowledge(from, response);
       }
     }
   }
@@ -582,7 +662,7 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
         response.set_okay(true);
         response.set_proposal(request.proposal());
         response.set_position(request.position());
-        reply(response);
+        acknowledge(from, response);
       }
     }
   } else if (result.isSome()) {
@@ -661,7 +741,7 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
           response.set_okay(true);
           response.set_proposal(request.proposal());
           response.set_position(request.position());
-          reply(response);
+          acknowledge(from, response);
         }
       }
     }
@@ -710,6 +790,9 @@ bool ReplicaProcess::persist(const Action& action)
     return false;
   }
 
+  unsynced++;
+  scheduleSync();
+
   LOG(INFO) << "Persisted action at " << action.position();
 
   // No longer a hole here (if there even was one).
@@ -751,6 +834,73 @@ bool ReplicaProcess::persist(const Action& action)
 }
 
 
+void ReplicaProcess::acknowledge(
+    const UPID& to,
+    const google::protobuf::Message& response)
+{
+  if (unsynced == 0) {
+    send(to, response);
+    return;
+  }
+
+  Owned<google::protobuf::Message> message(response.New());
+  message->CopyFrom(response);
+
+  acknowledgements.push_back(std::make_pair(to, message));
+}
+
+
+void ReplicaProcess::scheduleSync()
+{
+  if (!syncing) {
+    syncing = true;
+    dispatch(self(), &ReplicaProcess::sync);
+  }
+}
+
+
+void ReplicaProcess::sync()
+{
+  syncing = false;
+
+  if (unsynced == 0) {
+    CHECK(acknowledgements.empty());
+    return;
+  }
+
+  metrics.sync.start();
+
+  Try<Nothing> synced = storage->sync();
+
+  Duration elapsed = metrics.sync.stop();
+
+  // The records have already been applied to the cached metadata and
+  // positions, and later requests (e.g., a promise or a learned
+  // position) may depend on them. Since we can neither roll them back
+  // nor guarantee that they are durable, we can't keep serving
+  // requests and exit instead (like a replica that is restarted it
+  // will recover from the last synced records).
+  if (synced.isError()) {
+    EXIT(EXIT_FAILURE) << "Failed to sync the log: " << synced.error();
+  }
+
+  LOG(INFO) << "Synced " << unsynced << " records and acknowledged "
+            << acknowledgements.size() << " requests in " << elapsed;
+
+  ++metrics.syncs;
+  metrics.synced_records += unsynced;
+
+  unsynced = 0;
+
+  typedef pair<UPID, Owned<google::protobuf::Message>> Acknowledgement;
+  foreach (const Acknowledgement& acknowledgement, acknowledgements) {
+    send(acknowledgement.first, *acknowledgement.second);
+  }
+
+  acknowledgements.clear();
+}
+
+
 void ReplicaProcess::restore(const string& path)
 {
   Try<Storage::State> state = storage->restore(path);
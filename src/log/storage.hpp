@@ -51,8 +51,14 @@ public:
   virtual ~Storage() {}
 
   virtual Try<State> restore(const std::string& path) = 0;
+
+  // Persisted records can be read right away but are only guaranteed
+  // to be durable once 'sync' returns, so that the records persisted
+  // for several concurrent requests can be synced together.
   virtual Try<Nothing> persist(const Metadata& metadata) = 0;
   virtual Try<Nothing> persist(const Action& action) = 0;
+  virtual Try<Nothing> sync() = 0;
+
   virtual Try<Action> read(uint64_t position) = 0;
 };
 
@@ -369,12 +369,15 @@ void HierarchicalAllocatorProcess::addSlave(
   slaves[slaveId].activated = true;
   slaves[slaveId].checkpoint = slaveInfo.checkpoint();
   slaves[slaveId].hostname = slaveInfo.hostname();
+  slaves[slaveId].whitelisted = isWhitelisted(slaveInfo.hostname());
 
   // NOTE: We currently implement maintenance in the allocator to be able to
   // leverage state and features such as the FrameworkSorter and OfferFilter.
   if (unavailability.isSome()) {
     slaves[slaveId].maintenance =
       typename Slave::Maintenance(unavailability.get());
+
+    unavailable.insert(slaveId);
   }
 
   LOG(INFO) << "Added slave " << slaveId << " (" << slaves[slaveId].hostname
@@ -401,6 +404,7 @@ void HierarchicalAllocatorProcess::removeSlave(
   quotaRoleSorter->remove(slaveId, slaves[slaveId].total.unreserved());
 
   slaves.erase(slaveId);
+  unavailable.erase(slaveId);
 
   // Note that we DO NOT actually delete any filters associated with
   // this slave, that will occur when the delayed
@@ -473,6 +477,10 @@ void HierarchicalAllocatorProcess::updateWhitelist(
 
   whitelist = _whitelist;
 
+  foreachvalue (Slave& slave, slaves) {
+    slave.whitelisted = isWhitelisted(slave.hostname);
+  }
+
   if (whitelist.isSome()) {
     LOG(INFO) << "Updated slave whitelist: " << stringify(whitelist.get());
 
@@ -622,11 +630,14 @@ void HierarchicalAllocatorProcess::updateUnavailability(
 
   // Remove any old unavailability.
   slaves[slaveId].maintenance = None();
+  unavailable.erase(slaveId);
 
   // If we have a new unavailability.
   if (unavailability.isSome()) {
     slaves[slaveId].maintenance =
       typename Slave::Maintenance(unavailability.get());
+
+    unavailable.insert(slaveId);
   }
 
   allocate(slaveId);
@@ -999,7 +1010,7 @@ void HierarchicalAllocatorProcess::allocate(
 
   foreach (const SlaveID& slaveId, slaveIds) {
     // Don't send offers for non-whitelisted and deactivated slaves.
-    if (!isWhitelisted(slaveId) || !slaves[slaveId].activated) {
+    if (!slaves[slaveId].whitelisted || !slaves[slaveId].activated) {
       continue;
     }
 
@@ -1099,8 +1110,27 @@ void HierarchicalAllocatorProcess::deallocate(
   // keep generating new inverse offers even though the framework had not
   // responded yet.
 
-  foreachvalue (Sorter* frameworkSorter, frameworkSorters) {
+  // Only the slaves with a scheduled unavailability need inverse
+  // offers. We intersect the specified slaves with them by walking
+  // the smaller of the two sets, which is usually `unavailable`.
+  vector<SlaveID> slaveIds;
+
+  if (unavailable.size() < slaveIds_.size()) {
+    foreach (const SlaveID& slaveId, unavailable) {
+      if (slaveIds_.contains(slaveId)) {
+        slaveIds.push_back(slaveId);
+      }
+    }
+  } else {
     foreach (const SlaveID& slaveId, slaveIds_) {
+      if (unavailable.contains(slaveId)) {
+        slaveIds.push_back(slaveId);
+      }
+    }
+  }
+
+  foreachvalue (Sorter* frameworkSorter, frameworkSorters) {
+    foreach (const SlaveID& slaveId, slaveIds) {
       CHECK(slaves.contains(slaveId));
 
       if (slaves[slaveId].maintenance.isSome()) {
@@ -1214,12 +1244,9 @@ void HierarchicalAllocatorProcess::expire(
 
 
 bool HierarchicalAllocatorProcess::isWhitelisted(
-    const SlaveID& slaveId)
+    const string& hostname) const
 {
-  CHECK(slaves.contains(slaveId));
-
-  return whitelist.isNone() ||
-         whitelist.get().contains(slaves[slaveId].hostname);
+  return whitelist.isNone() || whitelist.get().contains(hostname);
 }
 
 
@@ -27,6 +27,7 @@
 #include <process/metrics/metrics.hpp>
 
 #include <stout/duration.hpp>
+#include <stout/flathashmap.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
 #include <stout/option.hpp>
@@ -218,8 +219,8 @@ protected:
       const SlaveID& slaveId,
       InverseOfferFilter* inverseOfferFilter);
 
-  // Checks whether the slave is whitelisted.
-  bool isWhitelisted(const SlaveID& slaveId);
+  // Checks whether a slave with the given hostname is whitelisted.
+  bool isWhitelisted(const std::string& hostname) const;
 
   // Returns true if there is a resource offer filter for this framework
   // on this slave.
@@ -287,7 +288,7 @@ protected:
     return static_cast<double>(eventCount<process::DispatchEvent>());
   }
 
-  hashmap<FrameworkID, Framework> frameworks;
+  flathashmap<FrameworkID, Framework> frameworks;
 
   struct Slave
   {
@@ -313,6 +314,11 @@ protected:
     bool activated;  // Whether to offer resources.
     bool checkpoint; // Whether slave supports checkpointing.
 
+    // Whether the slave is in the whitelist. This is only recomputed
+    // when the slave is added or the whitelist is updated, so that
+    // allocations do not look up the hostname in the whitelist.
+    bool whitelisted;
+
     std::string hostname;
 
     // Represents a scheduled unavailability due to maintenance for a specific
@@ -350,7 +356,12 @@ protected:
     Option<Maintenance> maintenance;
   };
 
-  hashmap<SlaveID, Slave> slaves;
+  flathashmap<SlaveID, Slave> slaves;
+
+  // Slaves whose `maintenance` is set, i.e., the only slaves for
+  // which inverse offers are sent. This spares `deallocate` a walk
+  // over all the slaves on every allocation.
+  hashset<SlaveID> unavailable;
 
   // Represents a role and data associated with it.
   // NOTE: We currently associate quota with roles, but this may change in
@@ -22,6 +22,7 @@
 
 #include <mesos/resources.hpp>
 
+#include <stout/flathashmap.hpp>
 #include <stout/hashmap.hpp>
 
 #include "master/allocator/sorter/sorter.hpp"
@@ -145,7 +146,7 @@ private:
   };
 
   // Maps client names to the resources they have been allocated.
-  hashmap<std::string, Allocation> allocations;
+  flathashmap<std::string, Allocation> allocations;
 };
 
 } // namespace allocator {
@@ -0,0 +1,151 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MESOS_MASTER_COMPLETED_TASKS_HPP__
+#define __MESOS_MASTER_COMPLETED_TASKS_HPP__
+
+#include <deque>
+#include <memory>
+#include <string>
+
+#include <glog/logging.h>
+
+#include <mesos/mesos.hpp>
+
+#include <stout/bytes.hpp>
+#include <stout/option.hpp>
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// A completed task, kept in its serialized form. Completed tasks are
+// only read by the endpoints, so the 'Task' (with all its statuses,
+// labels, discovery info, etc.) is decoded lazily on access. Only the
+// fields needed for the bookkeeping of the master are kept decoded.
+//
+// The serialized task never changes and is shared by the copies of a
+// completed task, so that snapshots of the state of the master can
+// refer to it and decode it outside of the master.
+class CompletedTask
+{
+public:
+  explicit CompletedTask(const Task& task)
+    : slaveId_(task.slave_id()),
+      state_(task.state()),
+      data(new std::string(task.SerializeAsString()))
+  {
+    if (task.statuses().size() > 0) {
+      timestamp_ = task.statuses(0).timestamp();
+    }
+  }
+
+  // Decodes the task.
+  Task get() const
+  {
+    Task task;
+    CHECK(task.ParseFromString(*data)) << "Failed to decode completed task";
+    return task;
+  }
+
+  const SlaveID& slave_id() const { return slaveId_; }
+
+  const TaskState& state() const { return state_; }
+
+  // The timestamp of the earliest status of the task, if any.
+  const Option<double>& timestamp() const { return timestamp_; }
+
+  // The memory used by this completed task.
+  Bytes size() const
+  {
+    return Bytes(sizeof(CompletedTask) +
+                 slaveId_.SpaceUsed() - sizeof(SlaveID) +
+                 sizeof(std::string) + data->capacity());
+  }
+
+private:
+  SlaveID slaveId_;
+  TaskState state_;
+  Option<double> timestamp_;
+  std::shared_ptr<const std::string> data;
+};
+
+
+// A bounded buffer of the completed tasks of a framework. The buffer
+// holds at most 'capacity' tasks using at most 'budget' bytes, except
+// that the most recently added task is always kept.
+//
+// Eviction is left to the caller (see 'exceeded'), since the master
+// keeps other state (e.g., the task index) about the completed tasks.
+//
+// NOTE: We use a deque so that references to the completed tasks stay
+// valid as other tasks are added and evicted.
+class CompletedTasks
+{
+public:
+  // The completed tasks can not be modified once added.
+  typedef std::deque<CompletedTask>::const_iterator iterator;
+  typedef std::deque<CompletedTask>::const_iterator const_iterator;
+
+  CompletedTasks(size_t _capacity, const Bytes& _budget)
+    : capacity(_capacity), budget(_budget) {}
+
+  void push_back(const Task& task)
+  {
+    tasks.push_back(CompletedTask(task));
+    bytes += tasks.back().size();
+  }
+
+  void pop_front()
+  {
+    CHECK(!tasks.empty());
+
+    bytes -= tasks.front().size();
+    tasks.pop_front();
+  }
+
+  const CompletedTask& front() const { return tasks.front(); }
+  const CompletedTask& back() const { return tasks.back(); }
+
+  // Whether the oldest task has to be evicted to stay within the
+  // capacity and memory budget.
+  bool exceeded() const
+  {
+    return tasks.size() > 1 && (tasks.size() > capacity || bytes > budget);
+  }
+
+  size_t size() const { return tasks.size(); }
+  bool empty() const { return tasks.empty(); }
+
+  // The memory used by the completed tasks.
+  Bytes memory() const { return bytes; }
+
+  const_iterator begin() const { return tasks.begin(); }
+  const_iterator end() const { return tasks.end(); }
+
+private:
+  const size_t capacity;
+  const Bytes budget;
+
+  Bytes bytes;
+  std::deque<CompletedTask> tasks;
+};
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MESOS_MASTER_COMPLETED_TASKS_HPP__
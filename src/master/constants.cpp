@@ -37,7 +37,10 @@ const double RECOVERY_SLAVE_REMOVAL_PERCENT_LIMIT = 1.0; // 100%.
 const size_t MAX_REMOVED_SLAVES = 100000;
 const uint32_t MAX_COMPLETED_FRAMEWORKS = 50;
 const uint32_t MAX_COMPLETED_TASKS_PER_FRAMEWORK = 1000;
+const Bytes DEFAULT_MAX_COMPLETED_TASKS_MEMORY_PER_FRAMEWORK = Megabytes(4);
 const Duration WHITELIST_WATCH_INTERVAL = Seconds(5);
+const Duration OFFER_EXPIRY_INTERVAL = Seconds(1);
+const size_t MAX_RECONCILIATION_UPDATES_PER_MESSAGE = 1000;
 const uint32_t TASK_LIMIT = 100;
 const std::string MASTER_INFO_LABEL = "info";
 const std::string MASTER_INFO_JSON_LABEL = "json.info";
@@ -95,9 +95,21 @@ extern const uint32_t MAX_COMPLETED_FRAMEWORKS;
 // cache.  TODO(thomasm): Make configurable.
 extern const uint32_t MAX_COMPLETED_TASKS_PER_FRAMEWORK;
 
+// Default memory budget for the completed tasks of each framework.
+extern const Bytes DEFAULT_MAX_COMPLETED_TASKS_MEMORY_PER_FRAMEWORK;
+
 // Time interval to check for updated watchers list.
 extern const Duration WHITELIST_WATCH_INTERVAL;
 
+// Minimum time between two sweeps for expired offers (see
+// '--offer_timeout'). Offers expiring within this interval of each
+// other are rescinded by the same sweep.
+extern const Duration OFFER_EXPIRY_INTERVAL;
+
+// Maximum number of reconciliation updates sent to a framework with
+// the BATCHED_STATUS_UPDATES capability in a single message.
+extern const size_t MAX_RECONCILIATION_UPDATES_PER_MESSAGE;
+
 // Default number of tasks (limit) for /master/tasks endpoint.
 extern const uint32_t TASK_LIMIT;
 
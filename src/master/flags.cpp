@@ -14,7 +14,11 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <stout/error.hpp>
 #include <stout/flags.hpp>
+#include <stout/foreach.hpp>
+#include <stout/json.hpp>
+#include <stout/strings.hpp>
 
 #include <mesos/type_utils.hpp>
 
@@ -101,6 +105,15 @@ mesos::internal::master::Flags::Flags()
       "after which the operation is considered a failure.",
       Seconds(5));
 
+  add(&Flags::registry_deltas,
+      "registry_deltas",
+      "Whether the Registrar stores the changes made to the Registry as\n"
+      "deltas, compacting them into a new snapshot once they outgrow it,\n"
+      "rather than storing the whole Registry on every change.\n"
+      "NOTE: Masters that do not support deltas cannot recover a Registry\n"
+      "stored with deltas, see docs/upgrades.md before enabling this.",
+      false);
+
   add(&Flags::log_auto_initialize,
       "log_auto_initialize",
       "Whether to automatically initialize the replicated log used for the\n"
@@ -305,6 +318,39 @@ mesos::internal::master::Flags::Flags()
       "  \"aggregate_default_qps\": 33.3\n"
       "}");
 
+  add(&Flags::endpoint_concurrency_limits,
+      "endpoint_concurrency_limits",
+      "JSON object of the maximum number of requests of an endpoint\n"
+      "that are handled concurrently. Further requests are answered\n"
+      "with '503 Service Unavailable'. Long-polling requests (e.g.,\n"
+      "'/state?version=N') count against the limit until answered.\n"
+      "Example:\n"
+      "{\n"
+      "  \"/state\": 4,\n"
+      "  \"/tasks\": 8\n"
+      "}",
+      [](const Option<JSON::Object>& object) -> Option<Error> {
+        if (object.isSome()) {
+          foreachpair (const std::string& endpoint,
+                       const JSON::Value& value,
+                       object.get().values) {
+            if (!strings::startsWith(endpoint, "/")) {
+              return Error("'endpoint_concurrency_limits' must only "
+                           "contain endpoints starting with '/'");
+            }
+
+            if (!value.is<JSON::Number>() ||
+                value.as<JSON::Number>().as<double>() < 1 ||
+                value.as<JSON::Number>().as<double>() !=
+                  value.as<JSON::Number>().as<uint64_t>()) {
+              return Error("'endpoint_concurrency_limits' must only "
+                           "contain positive integer limits");
+            }
+          }
+        }
+        return None();
+      });
+
 #ifdef WITH_NETWORK_ISOLATOR
   add(&Flags::max_executors_per_slave,
       "max_executors_per_slave",
@@ -320,7 +366,17 @@ mesos::internal::master::Flags::Flags()
       "offer_timeout",
       "Duration of time before an offer is rescinded from a framework.\n"
       "This helps fairness when running frameworks that hold on to offers,\n"
-      "or frameworks that accidentally drop offers.");
+      "or frameworks that accidentally drop offers.\n"
+      "Expired offers are rescinded in periodic sweeps, so an offer may\n"
+      "be rescinded up to a second after this timeout.");
+
+  add(&Flags::numa_node,
+      "numa_node",
+      "NUMA node that the master and registrar prefer to be run on, so\n"
+      "that they share caches. This only takes effect when the libprocess\n"
+      "worker threads are pinned (LIBPROCESS_WORKER_CPUS) and some of\n"
+      "them are pinned to CPUs of the node, otherwise the preference is\n"
+      "ignored.");
 
   // This help message for --modules flag is the same for
   // {master,slave,tests}/flags.hpp and should always be kept in
@@ -419,6 +475,14 @@ mesos::internal::master::Flags::Flags()
         return None();
       });
 
+  add(&Flags::max_completed_tasks_memory_per_framework,
+      "max_completed_tasks_memory_per_framework",
+      "Maximum amount of memory used to keep the completed tasks of each\n"
+      "framework (e.g., '4MB'). The completed tasks are kept in a compact\n"
+      "serialized form; the oldest ones are dropped once either this budget\n"
+      "or the maximum number of completed tasks per framework is exceeded.",
+      DEFAULT_MAX_COMPLETED_TASKS_MEMORY_PER_FRAMEWORK);
+
 
   add(&Flags::authorizers,
       "authorizers",
@@ -19,7 +19,9 @@
 
 #include <string>
 
+#include <stout/bytes.hpp>
 #include <stout/duration.hpp>
+#include <stout/json.hpp>
 #include <stout/option.hpp>
 #include <stout/path.hpp>
 
@@ -52,6 +54,7 @@ public:
   bool registry_strict;
   Duration registry_fetch_timeout;
   Duration registry_store_timeout;
+  bool registry_deltas;
   bool log_auto_initialize;
   Duration slave_reregister_timeout;
   std::string recovery_slave_removal_limit;
@@ -70,13 +73,16 @@ public:
   Option<ACLs> acls;
   Option<Firewall> firewall_rules;
   Option<RateLimits> rate_limits;
+  Option<JSON::Object> endpoint_concurrency_limits;
   Option<Duration> offer_timeout;
+  Option<size_t> numa_node;
   Option<Modules> modules;
   std::string authenticators;
   std::string allocator;
   Option<std::string> hooks;
   Duration slave_ping_timeout;
   size_t max_slave_ping_timeouts;
+  Bytes max_completed_tasks_memory_per_framework;
   std::string authorizers;
 
 #ifdef WITH_NETWORK_ISOLATOR
@@ -41,6 +41,7 @@
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
 #include <stout/json.hpp>
+#include <stout/json/reader.hpp>
 #include <stout/lambda.hpp>
 #include <stout/net.hpp>
 #include <stout/nothing.hpp>
@@ -166,7 +167,8 @@ JSON::Object summarize(const Framework& framework)
 }
 
 
-// Returns a JSON object modeled on a Framework.
+// Returns a JSON object modeled on a Framework, except for its
+// completed tasks (see 'FrameworkSnapshot').
 JSON::Object model(const Framework& framework)
 {
   JSON::Object object = summarize(framework);
@@ -213,18 +215,6 @@ JSON::Object model(const Framework& framework)
     object.values["tasks"] = std::move(array);
   }
 
-  // Model all of the completed tasks of a framework.
-  {
-    JSON::Array array;
-    array.values.reserve(framework.completedTasks.size()); // MESOS-2353.
-
-    foreach (const std::shared_ptr<Task>& task, framework.completedTasks) {
-      array.values.push_back(model(*task));
-    }
-
-    object.values["completed_tasks"] = std::move(array);
-  }
-
   // Model all of the offers associated with a framework.
   {
     JSON::Array array;
@@ -269,6 +259,56 @@ JSON::Object model(const Framework& framework)
 }
 
 
+// A snapshot of a framework, as published by the master for the
+// endpoints that model frameworks. The completed tasks of a framework
+// never change and their serialized form is shared with the master
+// (see 'CompletedTask'), so the snapshot only refers to them, and they
+// are decoded and modeled outside of the master.
+class FrameworkSnapshot
+{
+public:
+  explicit FrameworkSnapshot(const Framework& framework)
+    : object(model(framework)),
+      completedTasks(
+          framework.completedTasks.begin(),
+          framework.completedTasks.end()) {}
+
+  // Completes the model of the framework with its completed tasks.
+  // This is invoked once, so the model is moved out of the snapshot.
+  JSON::Object get()
+  {
+    JSON::Array array;
+    array.values.reserve(completedTasks.size()); // MESOS-2353.
+
+    foreach (const CompletedTask& task, completedTasks) {
+      array.values.push_back(model(task.get()));
+    }
+
+    object.values["completed_tasks"] = std::move(array);
+
+    return std::move(object);
+  }
+
+private:
+  JSON::Object object;
+  vector<CompletedTask> completedTasks;
+};
+
+
+// Models the snapshots of frameworks (outside of the master).
+static JSON::Array render(vector<FrameworkSnapshot>* frameworks)
+{
+  JSON::Array array;
+  array.values.reserve(frameworks->size()); // MESOS-2353.
+
+  foreach (FrameworkSnapshot& framework, *frameworks) {
+    array.values.push_back(framework.get());
+  }
+
+  return array;
+}
+
+
 // Returns a JSON object summarizing some important fields in a Slave.
 JSON::Object summarize(const Slave& slave)
 {
@@ -284,7 +324,7 @@ JSON::Object summarize(const Slave& slave)
 
   const Resources& totalResources = slave.totalResources;
   object.values["resources"] = model(totalResources);
-  object.values["used_resources"] = model(Resources::sum(slave.usedResources));
+  object.values["used_resources"] = model(slave.totalUsedResources);
   object.values["offered_resources"] = model(slave.offeredResources);
   object.values["reserved_resources"] = model(totalResources.reserved());
   object.values["unreserved_resources"] = model(totalResources.unreserved());
@@ -399,16 +439,16 @@ Future<Response> Master::Http::scheduler(const Request& request) const
       return BadRequest("Failed to parse body into Call protobuf");
     }
   } else if (contentType.get() == APPLICATION_JSON) {
-    Try<JSON::Value> value = JSON::parse(request.body);
-
-    if (value.isError()) {
-      return BadRequest("Failed to parse body into JSON: " + value.error());
-    }
+    // Decode straight into the protobuf to avoid materializing an
+    // intermediate JSON::Value for large calls (e.g., ACCEPT).
+    JSON::Reader reader(request.body);
 
     Try<v1::scheduler::Call> parse =
-      ::protobuf::parse<v1::scheduler::Call>(value.get());
+      ::protobuf::parse<v1::scheduler::Call>(&reader);
 
-    if (parse.isError()) {
+    if (parse.isError() && reader.failed()) {
+      return BadRequest("Failed to parse body into JSON: " + parse.error());
+    } else if (parse.isError()) {
       return BadRequest("Failed to convert JSON into Call protobuf: " +
                         parse.error());
     }
@@ -420,7 +460,7 @@ Future<Response> Master::Http::scheduler(const Request& request) const
         APPLICATION_JSON + " or " + APPLICATION_PROTOBUF);
   }
 
-  scheduler::Call call = devolve(v1Call);
+  scheduler::Call call = devolve(std::move(v1Call));
 
   Option<Error> error = validation::scheduler::call::validate(call);
 
@@ -502,6 +542,10 @@ Future<Response> Master::Http::scheduler(const Request& request) const
       master->acknowledge(framework, call.acknowledge());
       return Accepted();
 
+    case scheduler::Call::ACKNOWLEDGE_UPDATES:
+      master->acknowledge(framework, call.acknowledge_updates());
+      return Accepted();
+
     case scheduler::Call::RECONCILE:
       master->reconcile(framework, call.reconcile());
       return Accepted();
@@ -709,39 +753,102 @@ Future<Response> Master::Http::destroyVolumes(const Request& request) const
 }
 
 
+string Master::Http::EVENTS_HELP()
+{
+  return HELP(
+    TLDR(
+        "Streams the changes of the agents, frameworks and tasks."),
+    DESCRIPTION(
+        "Returns a stream of 'StateEvent's in RecordIO format, encoded as",
+        "JSON or protobuf depending on the 'Accept' header.",
+        "",
+        "The first event is a snapshot of the agents, frameworks and",
+        "tasks. The following events describe the agents, frameworks and",
+        "tasks that were added, updated or removed since. Changes of the",
+        "same agent, framework or task that happen in between deliveries",
+        "are coalesced. A subscriber that falls too far behind is sent a",
+        "new snapshot instead of the changes it missed. A subscriber that",
+        "does not receive the events it is sent is disconnected (its",
+        "stream ends) and should subscribe again."));
+}
+
+
+Future<Response> Master::Http::events(const Request& request) const
+{
+  if (request.method != "GET") {
+    return MethodNotAllowed(
+        "Expecting a 'GET' request, received '" + request.method + "'");
+  }
+
+  // We default to JSON since an empty 'Accept' header
+  // results in all media types considered acceptable.
+  ContentType contentType;
+
+  if (request.acceptsMediaType(APPLICATION_JSON)) {
+    contentType = ContentType::JSON;
+  } else if (request.acceptsMediaType(APPLICATION_PROTOBUF)) {
+    contentType = ContentType::PROTOBUF;
+  } else {
+    return NotAcceptable(
+        string("Expecting 'Accept' to allow ") +
+        "'" + APPLICATION_PROTOBUF + "' or '" + APPLICATION_JSON + "'");
+  }
+
+  Pipe pipe;
+  OK ok;
+  ok.headers["Content-Type"] = stringify(contentType);
+
+  ok.type = Response::PIPE;
+  ok.reader = pipe.reader();
+
+  master->stateEvents.subscribe(pipe.writer(), contentType);
+
+  return ok;
+}
+
+
 string Master::Http::FRAMEWORKS()
 {
-  return HELP(TLDR("Exposes the frameworks info."));
+  return HELP(
+    TLDR("Exposes the frameworks info."),
+    DESCRIPTION(
+        "Supports the same 'If-None-Match' and 'version' queries as",
+        "'/state'."));
 }
 
 
 Future<Response> Master::Http::frameworks(const Request& request) const
 {
-  JSON::Object object;
+  const Http http = *this;
 
-  // Model all of the frameworks.
-  {
-    JSON::Array array;
-    array.values.reserve(master->frameworks.registered.size()); // MESOS-2353.
+  return master->stateResponses.respond(
+      "frameworks", request, [http]() { return http._frameworks(); });
+}
 
-    foreachvalue (Framework* framework, master->frameworks.registered) {
-      array.values.push_back(model(*framework));
-    }
 
-    object.values["frameworks"] = std::move(array);
+StateResponses::Model Master::Http::_frameworks() const
+{
+  std::shared_ptr<JSON::Object> object(new JSON::Object());
+
+  // Take snapshots of all of the frameworks.
+  std::shared_ptr<vector<FrameworkSnapshot>> frameworks(
+      new vector<FrameworkSnapshot>());
+
+  frameworks->reserve(master->frameworks.registered.size());
+
+  foreachvalue (Framework* framework, master->frameworks.registered) {
+    frameworks->push_back(FrameworkSnapshot(*framework));
   }
 
-  // Model all of the completed frameworks.
-  {
-    JSON::Array array;
-    array.values.reserve(master->frameworks.completed.size()); // MESOS-2353.
+  // Take snapshots of all of the completed frameworks.
+  std::shared_ptr<vector<FrameworkSnapshot>> completed(
+      new vector<FrameworkSnapshot>());
 
-    foreach (const std::shared_ptr<Framework>& framework,
-             master->frameworks.completed) {
-      array.values.push_back(model(*framework));
-    }
+  completed->reserve(master->frameworks.completed.size());
 
-    object.values["completed_frameworks"] = std::move(array);
+  foreach (const std::shared_ptr<Framework>& framework,
+           master->frameworks.completed) {
+    completed->push_back(FrameworkSnapshot(*framework));
   }
 
   // Model all currently unregistered frameworks.
@@ -759,10 +866,15 @@ Future<Response> Master::Http::frameworks(const Request& request) const
       }
     }
 
-    object.values["unregistered_frameworks"] = std::move(array);
+    object->values["unregistered_frameworks"] = std::move(array);
   }
 
-  return OK(object, request.url.query.get("jsonp"));
+  return [object, frameworks, completed]() {
+    object->values["frameworks"] = render(frameworks.get());
+    object->values["completed_frameworks"] = render(completed.get());
+
+    return std::move(*object);
+  };
 }
 
 
@@ -1049,11 +1161,23 @@ string Master::Http::SLAVES_HELP()
         "Information about registered slaves."),
     DESCRIPTION(
         "This endpoint shows information about the slaves registered in",
-        "this master formatted as a JSON object."));
+        "this master formatted as a JSON object.",
+        "",
+        "Supports the same 'If-None-Match' and 'version' queries as",
+        "'/state'."));
 }
 
 
 Future<Response> Master::Http::slaves(const Request& request) const
+{
+  const Http http = *this;
+
+  return master->stateResponses.respond(
+      "slaves", request, [http]() { return http._slaves(); });
+}
+
+
+JSON::Object Master::Http::_slaves() const
 {
   JSON::Object object;
 
@@ -1068,7 +1192,7 @@ Future<Response> Master::Http::slaves(const Request& request) const
     object.values["slaves"] = std::move(array);
   }
 
-  return OK(object, request.url.query.get("jsonp"));
+  return object;
 }
 
 
@@ -1113,56 +1237,78 @@ string Master::Http::STATE_HELP()
         "Information about state of master."),
     DESCRIPTION(
         "This endpoint shows information about the frameworks, tasks,",
-        "executors and slaves running in the cluster as a JSON object."));
+        "executors and slaves running in the cluster as a JSON object.",
+        "",
+        "The version of the response is returned as its 'ETag'. Requests",
+        "with a matching 'If-None-Match' header are answered with",
+        "'304 Not Modified'. Versions are only valid for the master that",
+        "returned them: after a failover, the versions of the previous",
+        "master never match.",
+        "",
+        "Query parameters:",
+        "",
+        ">        version=VALUE     Long-poll until the version is greater.",
+        ">        timeout=VALUE     How long to long-poll (defaults to 30secs)",
+        ">                          before answering '304 Not Modified'."));
 }
 
 
 Future<Response> Master::Http::state(const Request& request) const
 {
-  JSON::Object object;
-  object.values["version"] = MESOS_VERSION;
+  const Http http = *this;
+
+  return master->stateResponses.respond(
+      "state", request, [http]() { return http._state(); });
+}
+
+
+StateResponses::Model Master::Http::_state() const
+{
+  std::shared_ptr<JSON::Object> object(new JSON::Object());
+
+  object->values["version"] = MESOS_VERSION;
 
   if (build::GIT_SHA.isSome()) {
-    object.values["git_sha"] = build::GIT_SHA.get();
+    object->values["git_sha"] = build::GIT_SHA.get();
   }
 
   if (build::GIT_BRANCH.isSome()) {
-    object.values["git_branch"] = build::GIT_BRANCH.get();
+    object->values["git_branch"] = build::GIT_BRANCH.get();
   }
 
   if (build::GIT_TAG.isSome()) {
-    object.values["git_tag"] = build::GIT_TAG.get();
+    object->values["git_tag"] = build::GIT_TAG.get();
   }
 
-  object.values["build_date"] = build::DATE;
-  object.values["build_time"] = build::TIME;
-  object.values["build_user"] = build::USER;
-  object.values["start_time"] = master->startTime.secs();
+  object->values["build_date"] = build::DATE;
+  object->values["build_time"] = build::TIME;
+  object->values["build_user"] = build::USER;
+  object->values["start_time"] = master->startTime.secs();
 
   if (master->electedTime.isSome()) {
-    object.values["elected_time"] = master->electedTime.get().secs();
+    object->values["elected_time"] = master->electedTime.get().secs();
   }
 
-  object.values["id"] = master->info().id();
-  object.values["pid"] = string(master->self());
-  object.values["hostname"] = master->info().hostname();
-  object.values["activated_slaves"] = master->_slaves_active();
-  object.values["deactivated_slaves"] = master->_slaves_inactive();
+  object->values["id"] = master->info().id();
+  object->values["pid"] = string(master->self());
+  object->values["hostname"] = master->info().hostname();
+  object->values["activated_slaves"] = master->_slaves_active();
+  object->values["deactivated_slaves"] = master->_slaves_inactive();
 
   if (master->flags.cluster.isSome()) {
-    object.values["cluster"] = master->flags.cluster.get();
+    object->values["cluster"] = master->flags.cluster.get();
   }
 
   if (master->leader.isSome()) {
-    object.values["leader"] = master->leader.get().pid();
+    object->values["leader"] = master->leader.get().pid();
   }
 
   if (master->flags.log_dir.isSome()) {
-    object.values["log_dir"] = master->flags.log_dir.get();
+    object->values["log_dir"] = master->flags.log_dir.get();
   }
 
   if (master->flags.external_log_file.isSome()) {
-    object.values["external_log_file"] = master->flags.external_log_file.get();
+    object->values["external_log_file"] = master->flags.external_log_file.get();
   }
 
   {
@@ -1173,7 +1319,7 @@ Future<Response> Master::Http::state(const Request& request) const
         flags.values[name] = value.get();
       }
     }
-    object.values["flags"] = std::move(flags);
+    object->values["flags"] = std::move(flags);
   }
 
   // Model all of the slaves.
@@ -1185,32 +1331,28 @@ Future<Response> Master::Http::state(const Request& request) const
       array.values.push_back(model(*slave));
     }
 
-    object.values["slaves"] = std::move(array);
+    object->values["slaves"] = std::move(array);
   }
 
-  // Model all of the frameworks.
-  {
-    JSON::Array array;
-    array.values.reserve(master->frameworks.registered.size()); // MESOS-2353.
+  // Take snapshots of all of the frameworks.
+  std::shared_ptr<vector<FrameworkSnapshot>> frameworks(
+      new vector<FrameworkSnapshot>());
 
-    foreachvalue (Framework* framework, master->frameworks.registered) {
-      array.values.push_back(model(*framework));
-    }
+  frameworks->reserve(master->frameworks.registered.size());
 
-    object.values["frameworks"] = std::move(array);
+  foreachvalue (Framework* framework, master->frameworks.registered) {
+    frameworks->push_back(FrameworkSnapshot(*framework));
   }
 
-  // Model all of the completed frameworks.
-  {
-    JSON::Array array;
-    array.values.reserve(master->frameworks.completed.size()); // MESOS-2353.
+  // Take snapshots of all of the completed frameworks.
+  std::shared_ptr<vector<FrameworkSnapshot>> completed(
+      new vector<FrameworkSnapshot>());
 
-    foreach (const std::shared_ptr<Framework>& framework,
-             master->frameworks.completed) {
-      array.values.push_back(model(*framework));
-    }
+  completed->reserve(master->frameworks.completed.size());
 
-    object.values["completed_frameworks"] = std::move(array);
+  foreach (const std::shared_ptr<Framework>& framework,
+           master->frameworks.completed) {
+    completed->push_back(FrameworkSnapshot(*framework));
   }
 
   // Model all of the orphan tasks.
@@ -1219,7 +1361,7 @@ Future<Response> Master::Http::state(const Request& request) const
 
     // Find those orphan tasks.
     foreachvalue (const Slave* slave, master->slaves.registered) {
-      typedef hashmap<TaskID, Task*> TaskMap;
+      typedef flathashmap<TaskID, Task*> TaskMap;
       foreachvalue (const TaskMap& tasks, slave->tasks) {
         foreachvalue (const Task* task, tasks) {
           CHECK_NOTNULL(task);
@@ -1230,7 +1372,7 @@ Future<Response> Master::Http::state(const Request& request) const
       }
     }
 
-    object.values["orphan_tasks"] = std::move(array);
+    object->values["orphan_tasks"] = std::move(array);
   }
 
   // Model all currently unregistered frameworks.
@@ -1248,10 +1390,15 @@ Future<Response> Master::Http::state(const Request& request) const
       }
     }
 
-    object.values["unregistered_frameworks"] = std::move(array);
+    object->values["unregistered_frameworks"] = std::move(array);
   }
 
-  return OK(object, request.url.query.get("jsonp"));
+  return [object, frameworks, completed]() {
+    object->values["frameworks"] = render(frameworks.get());
+    object->values["completed_frameworks"] = render(completed.get());
+
+    return std::move(*object);
+  };
 }
 
 
@@ -1259,27 +1406,21 @@ Future<Response> Master::Http::state(const Request& request) const
 // mapping from 'slaves' to 'frameworks' to answer the questions 'what
 // frameworks are running on a given slave?' and 'what slaves are
 // running the given framework?'.
+//
+// NOTE: A framework has a 'TaskState' summary for exactly those
+// slaves it has pending, active or completed tasks on, so we derive
+// the mapping from these summaries rather than the tasks themselves.
 class SlaveFrameworkMapping
 {
 public:
-  SlaveFrameworkMapping(const hashmap<FrameworkID, Framework*>& frameworks)
+  SlaveFrameworkMapping(const flathashmap<FrameworkID, Framework*>& frameworks)
   {
     foreachpair (const FrameworkID& frameworkId,
                  const Framework* framework,
                  frameworks) {
-      foreachvalue (const TaskInfo& taskInfo, framework->pendingTasks) {
-        frameworksToSlaves[frameworkId].insert(taskInfo.slave_id());
-        slavesToFrameworks[taskInfo.slave_id()].insert(frameworkId);
-      }
-
-      foreachvalue (const Task* task, framework->tasks) {
-        frameworksToSlaves[frameworkId].insert(task->slave_id());
-        slavesToFrameworks[task->slave_id()].insert(frameworkId);
-      }
-
-      foreach (const std::shared_ptr<Task>& task, framework->completedTasks) {
-        frameworksToSlaves[frameworkId].insert(task->slave_id());
-        slavesToFrameworks[task->slave_id()].insert(frameworkId);
+      foreachkey (const SlaveID& slaveId, framework->taskStateSummaries) {
+        frameworksToSlaves[frameworkId].insert(slaveId);
+        slavesToFrameworks[slaveId].insert(frameworkId);
       }
     }
   }
@@ -1304,80 +1445,27 @@ private:
 };
 
 
-// This abstraction has no side-effects. It factors out the accounting
-// for a 'TaskState' summary. We use this to summarize 'TaskState's
-// for both frameworks as well as slaves.
-struct TaskStateSummary
-{
-  // TODO(jmlvanre): Possibly clean this up as per MESOS-2694.
-  const static TaskStateSummary EMPTY;
-
-  TaskStateSummary()
-    : staging(0),
-      starting(0),
-      running(0),
-      finished(0),
-      killed(0),
-      failed(0),
-      lost(0),
-      error(0) {}
-
-  // Account for the state of the given task.
-  void count(const Task& task)
-  {
-    switch (task.state()) {
-      case TASK_STAGING: { ++staging; break; }
-      case TASK_STARTING: { ++starting; break; }
-      case TASK_RUNNING: { ++running; break; }
-      case TASK_FINISHED: { ++finished; break; }
-      case TASK_KILLED: { ++killed; break; }
-      case TASK_FAILED: { ++failed; break; }
-      case TASK_LOST: { ++lost; break; }
-      case TASK_ERROR: { ++error; break; }
-      // No default case allows for a helpful compiler error if we
-      // introduce a new state.
-    }
-  }
-
-  size_t staging;
-  size_t starting;
-  size_t running;
-  size_t finished;
-  size_t killed;
-  size_t failed;
-  size_t lost;
-  size_t error;
-};
-
-
-const TaskStateSummary TaskStateSummary::EMPTY;
-
-
-// This abstraction has no side-effects. It factors out computing the
-// 'TaskState' summaries for frameworks and slaves. This answers the
-// questions 'How many tasks are in each state for a given framework?'
-// and 'How many tasks are in each state for a given slave?'.
+// This abstraction has no side-effects. It factors out combining the
+// per slave 'TaskState' summaries maintained by the frameworks. This
+// answers the questions 'How many tasks are in each state for a given
+// framework?' and 'How many tasks are in each state for a given
+// slave?'.
 class TaskStateSummaries
 {
 public:
-  TaskStateSummaries(const hashmap<FrameworkID, Framework*>& frameworks)
+  // TODO(jmlvanre): Possibly clean this up as per MESOS-2694.
+  static const TaskStateSummary EMPTY;
+
+  TaskStateSummaries(const flathashmap<FrameworkID, Framework*>& frameworks)
   {
     foreachpair (const FrameworkID& frameworkId,
                  const Framework* framework,
                  frameworks) {
-      foreachvalue (const TaskInfo& taskInfo, framework->pendingTasks) {
-        frameworkTaskSummaries[frameworkId].staging++;
-        slaveTaskSummaries[taskInfo.slave_id()].staging++;
-      }
-
-      foreachvalue (const Task* task, framework->tasks) {
-        frameworkTaskSummaries[frameworkId].count(*task);
-        slaveTaskSummaries[task->slave_id()].count(*task);
-      }
-
-      foreach (const std::shared_ptr<Task>& task, framework->completedTasks) {
-        frameworkTaskSummaries[frameworkId].count(*task);
-        slaveTaskSummaries[task->slave_id()].count(*task);
+      foreachpair (const SlaveID& slaveId,
+                   const TaskStateSummary& summary,
+                   framework->taskStateSummaries) {
+        frameworkTaskSummaries[frameworkId] += summary;
+        slaveTaskSummaries[slaveId] += summary;
       }
     }
   }
@@ -1386,14 +1474,14 @@ public:
   {
     const auto iterator = frameworkTaskSummaries.find(frameworkId);
     return iterator != frameworkTaskSummaries.end() ?
-      iterator->second : TaskStateSummary::EMPTY;
+      iterator->second : EMPTY;
   }
 
   const TaskStateSummary& slave(const SlaveID& slaveId) const
   {
     const auto iterator = slaveTaskSummaries.find(slaveId);
     return iterator != slaveTaskSummaries.end() ?
-      iterator->second : TaskStateSummary::EMPTY;
+      iterator->second : EMPTY;
   }
 private:
   hashmap<FrameworkID, TaskStateSummary> frameworkTaskSummaries;
@@ -1401,6 +1489,9 @@ private:
 };
 
 
+const TaskStateSummary TaskStateSummaries::EMPTY;
+
+
 string Master::Http::STATESUMMARY_HELP()
 {
   return HELP(
@@ -1408,11 +1499,23 @@ string Master::Http::STATESUMMARY_HELP()
         "Summary of state of all tasks and registered frameworks in cluster."),
     DESCRIPTION(
         "This endpoint gives a summary of the state of all tasks and",
-        "registered frameworks in the cluster as a JSON object."));
+        "registered frameworks in the cluster as a JSON object.",
+        "",
+        "Supports the same 'If-None-Match' and 'version' queries as",
+        "'/state'."));
 }
 
 
 Future<Response> Master::Http::stateSummary(const Request& request) const
+{
+  const Http http = *this;
+
+  return master->stateResponses.respond(
+      "state-summary", request, [http]() { return http._stateSummary(); });
+}
+
+
+JSON::Object Master::Http::_stateSummary() const
 {
   JSON::Object object;
 
@@ -1516,7 +1619,7 @@ Future<Response> Master::Http::stateSummary(const Request& request) const
     object.values["frameworks"] = std::move(array);
   }
 
-  return OK(object, request.url.query.get("jsonp"));
+  return object;
 }
 
 
@@ -1527,11 +1630,23 @@ string Master::Http::ROLES_HELP()
         "Information about roles that the master is configured with."),
     DESCRIPTION(
         "This endpoint gives information about the roles that are assigned",
-        "to frameworks and resources as a JSON object."));
+        "to frameworks and resources as a JSON object.",
+        "",
+        "Supports the same 'If-None-Match' and 'version' queries as",
+        "'/state'."));
 }
 
 
 Future<Response> Master::Http::roles(const Request& request) const
+{
+  const Http http = *this;
+
+  return master->stateResponses.respond(
+      "roles", request, [http]() { return http._roles(); });
+}
+
+
+JSON::Object Master::Http::_roles() const
 {
   JSON::Object object;
 
@@ -1545,7 +1660,7 @@ Future<Response> Master::Http::roles(const Request& request) const
     object.values["roles"] = std::move(array);
   }
 
-  return OK(object, request.url.query.get("jsonp"));
+  return object;
 }
 
 
@@ -1665,50 +1780,6 @@ string Master::Http::TASKS_HELP()
 }
 
 
-struct TaskComparator
-{
-  static bool ascending(const Task* lhs, const Task* rhs)
-  {
-    size_t lhsSize = lhs->statuses().size();
-    size_t rhsSize = rhs->statuses().size();
-
-    if ((lhsSize == 0) && (rhsSize == 0)) {
-      return false;
-    }
-
-    if (lhsSize == 0) {
-      return true;
-    }
-
-    if (rhsSize == 0) {
-      return false;
-    }
-
-    return (lhs->statuses(0).timestamp() < rhs->statuses(0).timestamp());
-  }
-
-  static bool descending(const Task* lhs, const Task* rhs)
-  {
-    size_t lhsSize = lhs->statuses().size();
-    size_t rhsSize = rhs->statuses().size();
-
-    if ((lhsSize == 0) && (rhsSize == 0)) {
-      return false;
-    }
-
-    if (rhsSize == 0) {
-      return true;
-    }
-
-    if (lhsSize == 0) {
-      return false;
-    }
-
-    return (lhs->statuses(0).timestamp() > rhs->statuses(0).timestamp());
-  }
-};
-
-
 Future<Response> Master::Http::tasks(const Request& request) const
 {
   // Get list options (limit and offset).
@@ -1721,45 +1792,25 @@ Future<Response> Master::Http::tasks(const Request& request) const
   // TODO(nnielsen): Currently, formatting errors in offset and/or limit
   // will silently be ignored. This could be reported to the user instead.
 
-  // Construct framework list with both active and completed frameworks.
-  vector<const Framework*> frameworks;
-  foreachvalue (Framework* framework, master->frameworks.registered) {
-    frameworks.push_back(framework);
-  }
-  foreach (const std::shared_ptr<Framework>& framework,
-           master->frameworks.completed) {
-    frameworks.push_back(framework.get());
-  }
-
-  // Construct task list with both running and finished tasks.
-  vector<const Task*> tasks;
-  foreach (const Framework* framework, frameworks) {
-    foreachvalue (Task* task, framework->tasks) {
-      CHECK_NOTNULL(task);
-      tasks.push_back(task);
-    }
-    foreach (const std::shared_ptr<Task>& task, framework->completedTasks) {
-      tasks.push_back(task.get());
-    }
-  }
-
-  // Sort tasks by task status timestamp. Default order is descending.
-  // The earliest timestamp is chosen for comparison when multiple are present.
+  // The tasks of the active and completed frameworks are indexed by
+  // task status timestamp, so we only need to look at the requested
+  // range. Default order is descending. The earliest timestamp is
+  // chosen for comparison when multiple are present.
   Option<string> order = request.url.query.get("order");
-  if (order.isSome() && (order.get() == "asc")) {
-    sort(tasks.begin(), tasks.end(), TaskComparator::ascending);
-  } else {
-    sort(tasks.begin(), tasks.end(), TaskComparator::descending);
-  }
+
+  const vector<Task> tasks = master->taskIndex.range(
+      offset,
+      limit,
+      order.isSome() && (order.get() == "asc"));
 
   JSON::Object object;
 
   {
     JSON::Array array;
-    size_t end = std::min(offset + limit, tasks.size());
-    for (size_t i = offset; i < end; i++) {
-      const Task* task = tasks[i];
-      array.values.push_back(model(*task));
+    array.values.reserve(tasks.size());
+
+    foreach (const Task& task, tasks) {
+      array.values.push_back(model(task));
     }
 
     object.values["tasks"] = std::move(array);
@@ -17,7 +17,9 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <deque>
 #include <fstream>
 #include <iomanip>
 #include <list>
@@ -34,6 +36,7 @@
 
 #include <mesos/module/authenticator.hpp>
 
+#include <process/async.hpp>
 #include <process/check.hpp>
 #include <process/collect.hpp>
 #include <process/defer.hpp>
@@ -88,12 +91,15 @@ using std::shared_ptr;
 using std::string;
 using std::vector;
 
+using process::async;
 using process::await;
 using process::wait; // Necessary on some OS's to disambiguate.
 using process::Clock;
+using process::DispatchEvent;
 using process::ExitedEvent;
 using process::Failure;
 using process::Future;
+using process::HttpEvent;
 using process::MessageEvent;
 using process::Owned;
 using process::PID;
@@ -285,12 +291,18 @@ Master::Master(
     contender(_contender),
     detector(_detector),
     authorizer(_authorizer),
+    stateResponses(self()),
+    stateEvents(self(), [this]() { return snapshot(); }),
     authenticator(None()),
     metrics(new Metrics(*this)),
     electedTime(None())
 {
   slaves.limiter = _slaveRemovalLimiter;
 
+  if (flags.numa_node.isSome()) {
+    prefer(process::Affinity::node(flags.numa_node.get()));
+  }
+
   // NOTE: We populate 'info_' here instead of inside 'initialize()'
   // because 'StandaloneMasterDetector' needs access to the info.
 
@@ -341,22 +353,227 @@ Master::Master(
 Master::~Master() {}
 
 
+// Throttles the messages (and exited events) of the frameworks of a
+// principal, or of all the frameworks throttled by the default
+// limit, as a token bucket.
+//
+// An event is admitted right away if a token is available, which
+// allows bursts of up to 'burst' events, otherwise it is queued on
+// the limiter until a token is available. Tokens become available
+// at 'qps'. The queued events are released in order by a single
+// timer (see 'FrameworkThrottler::throttled').
+//
+// The master takes the tokens of the events it admits right away
+// itself and only hands the other events over to the
+// 'FrameworkThrottler', which takes the tokens of the queued events.
+// The bucket is therefore the only state shared between the two,
+// the queue is only accessed by the throttler and 'forwarded' only
+// by the master.
+//
+// NOTE: The bucket is kept as the "theoretical arrival time" of the
+// next event (i.e., the generic cell rate algorithm), so that the
+// tokens are computed exactly from the (possibly paused) clock and
+// can be taken with a single compare-and-swap.
+//
 // TODO(vinod): Update this interface to return failed futures when
 // capacity is reached.
 struct BoundedRateLimiter
 {
-  BoundedRateLimiter(double qps, Option<uint64_t> _capacity)
-    : limiter(new process::RateLimiter(qps)),
-      capacity(_capacity),
-      messages(0) {}
+  BoundedRateLimiter(double qps, Option<uint64_t> _capacity, uint64_t burst)
+    : capacity(_capacity),
+      interval(Seconds(1) / qps),
+      tolerance(interval * (burst - 1)),
+      arrival(Clock::now().duration().ns()),
+      messages(0),
+      scheduled(false),
+      forwarded(0)
+  {
+    CHECK_GT(burst, 0u);
+  }
+
+  // Takes a token, unless no token is available or queued events
+  // are waiting for one.
+  bool acquire()
+  {
+    if (!queue.empty()) {
+      return false;
+    }
+
+    return take();
+  }
+
+  // Takes a token if one is available.
+  bool take()
+  {
+    const int64_t now = Clock::now().duration().ns();
+
+    int64_t current = arrival.load();
+    int64_t updated;
+
+    do {
+      if (now < current - tolerance.ns()) {
+        return false;
+      }
+
+      updated = std::max(current, now) + interval.ns();
+    } while (!arrival.compare_exchange_weak(current, updated));
+
+    return true;
+  }
+
+  // Returns how long until the next token is available.
+  Duration next() const
+  {
+    const int64_t now = Clock::now().duration().ns();
+    const Duration remaining =
+      Nanoseconds(arrival.load() - tolerance.ns() - now);
+
+    return std::max(Duration::zero(), remaining);
+  }
 
-  process::Owned<process::RateLimiter> limiter;
   const Option<uint64_t> capacity;
 
-  // Number of outstanding messages for this RateLimiter.
+  // The time between tokens and how many tokens (in time) can be
+  // accumulated on top of the next token.
+  const Duration interval;
+  const Duration tolerance;
+
+  // The time (in nanoseconds since the epoch) at which the next
+  // token is available, ignoring the tolerance.
+  std::atomic<int64_t> arrival;
+
+  // An event waiting for a token.
+  struct Throttled
+  {
+    Time queued;
+
+    // Whether the event is a message (or an exited event).
+    bool message;
+
+    // Invoked with how long the event waited once it is admitted.
+    lambda::function<void(const Duration&)> admit;
+  };
+
+  std::deque<Throttled> queue;
+
+  // Number of queued messages for this RateLimiter.
   // NOTE: ExitedEvents are throttled but not counted towards
   // the capacity here.
   uint64_t messages;
+
+  // Whether the queued events will be released by a pending timer.
+  bool scheduled;
+
+  // Number of events handed over to the throttler that the master
+  // has not processed (or dropped) yet. The master admits an event
+  // right away only if there are none, which keeps the events in
+  // order.
+  uint64_t forwarded;
+};
+
+
+// Admits the messages (and exited events) of the throttled frameworks
+// that exceed the rate of their 'BoundedRateLimiter' on behalf of the
+// master. The master hands such an event over as soon as it dequeues
+// it and the admitted events are dispatched back to it, in order. The
+// events waiting for a token and their timers are therefore kept off
+// the master actor.
+class FrameworkThrottler : public Process<FrameworkThrottler>
+{
+public:
+  FrameworkThrottler(
+      const hashmap<string, Owned<BoundedRateLimiter>>& _limiters,
+      const Option<Owned<BoundedRateLimiter>>& _defaultLimiter)
+    : ProcessBase(process::ID::generate("framework-throttler")),
+      limiters(_limiters),
+      defaultLimiter(_defaultLimiter) {}
+
+  // Admits a message throttled by the limiter. 'admit' is invoked
+  // with how long the message waited for a token. If the capacity of
+  // the limiter is exceeded the message is dropped and 'exceeded' is
+  // invoked with the capacity instead.
+  void message(
+      BoundedRateLimiter* limiter,
+      const lambda::function<void(const Duration&)>& admit,
+      const lambda::function<void(uint64_t)>& exceeded)
+  {
+    if (limiter->capacity.isSome() &&
+        limiter->messages >= limiter->capacity.get()) {
+      exceeded(limiter->capacity.get());
+    } else if (limiter->acquire()) {
+      admit(Duration::zero());
+    } else {
+      limiter->messages++;
+      throttle(limiter, true, admit);
+    }
+  }
+
+  // Admits an exited event like a message. Throttling exited events
+  // maintains the order between the messages and the exited events
+  // from the same PID. Exited events are not subject to the capacity.
+  void exited(
+      BoundedRateLimiter* limiter,
+      const lambda::function<void()>& admit)
+  {
+    if (limiter->acquire()) {
+      admit();
+    } else {
+      throttle(limiter, false, [=](const Duration&) { admit(); });
+    }
+  }
+
+private:
+  // Queues an event on the limiter until a token is available.
+  void throttle(
+      BoundedRateLimiter* limiter,
+      bool message,
+      const lambda::function<void(const Duration&)>& admit)
+  {
+    BoundedRateLimiter::Throttled throttled;
+    throttled.queued = Clock::now();
+    throttled.message = message;
+    throttled.admit = admit;
+
+    limiter->queue.push_back(throttled);
+
+    if (!limiter->scheduled) {
+      limiter->scheduled = true;
+      delay(limiter->next(), self(), &Self::throttled, limiter);
+    }
+  }
+
+  // Invoked when tokens may be available for the events queued on
+  // the limiter, in order to admit them.
+  void throttled(BoundedRateLimiter* limiter)
+  {
+    CHECK(limiter->scheduled);
+    limiter->scheduled = false;
+
+    // Release as many queued events as there are tokens available.
+    while (!limiter->queue.empty() && limiter->take()) {
+      const BoundedRateLimiter::Throttled throttled = limiter->queue.front();
+      limiter->queue.pop_front();
+
+      if (throttled.message) {
+        CHECK_GT(limiter->messages, 0u);
+        limiter->messages--;
+      }
+
+      throttled.admit(Clock::now() - throttled.queued);
+    }
+
+    if (!limiter->queue.empty()) {
+      limiter->scheduled = true;
+      delay(limiter->next(), self(), &Self::throttled, limiter);
+    }
+  }
+
+  // BoundedRateLimiters keyed by the framework principal.
+  const hashmap<string, Owned<BoundedRateLimiter>> limiters;
+
+  // The limiter of the frameworks not specified in
+  // 'flags.rate_limits'.
+  const Option<Owned<BoundedRateLimiter>> defaultLimiter;
 };
 
 
@@ -494,6 +711,9 @@ void Master::initialize()
   }
 
   if (flags.rate_limits.isSome()) {
+    hashmap<string, Owned<BoundedRateLimiter>> limiters;
+    Option<Owned<BoundedRateLimiter>> defaultLimiter;
+
     // Add framework rate limiters.
     foreach (const RateLimit& limit_, flags.rate_limits.get().limits()) {
       if (frameworks.limiters.contains(limit_.principal())) {
@@ -506,18 +726,27 @@ void Master::initialize()
                 << ". It must be a positive number";
       }
 
+      if (limit_.has_burst() && limit_.burst() == 0) {
+        EXIT(1) << "Invalid burst: " << limit_.burst()
+                << ". It must be a positive number";
+      }
+
+      BoundedRateLimiter* limiter = NULL;
+
       if (limit_.has_qps()) {
         Option<uint64_t> capacity;
         if (limit_.has_capacity()) {
           capacity = limit_.capacity();
         }
-        frameworks.limiters.put(
-            limit_.principal(),
-            Owned<BoundedRateLimiter>(
-                new BoundedRateLimiter(limit_.qps(), capacity)));
-      } else {
-        frameworks.limiters.put(limit_.principal(), None());
+        limiter = new BoundedRateLimiter(
+            limit_.qps(),
+            capacity,
+            limit_.has_burst() ? limit_.burst() : 1);
+
+        limiters.put(limit_.principal(), Owned<BoundedRateLimiter>(limiter));
       }
+
+      frameworks.limiters.put(limit_.principal(), limiter);
     }
 
     if (flags.rate_limits.get().has_aggregate_default_qps() &&
@@ -527,16 +756,32 @@ void Master::initialize()
               << ". It must be a positive number";
     }
 
+    if (flags.rate_limits.get().has_aggregate_default_burst() &&
+        flags.rate_limits.get().aggregate_default_burst() == 0) {
+      EXIT(1) << "Invalid aggregate_default_burst: "
+              << flags.rate_limits.get().aggregate_default_burst()
+              << ". It must be a positive number";
+    }
+
     if (flags.rate_limits.get().has_aggregate_default_qps()) {
       Option<uint64_t> capacity;
       if (flags.rate_limits.get().has_aggregate_default_capacity()) {
         capacity = flags.rate_limits.get().aggregate_default_capacity();
       }
-      frameworks.defaultLimiter = Owned<BoundedRateLimiter>(
+      defaultLimiter = Owned<BoundedRateLimiter>(
           new BoundedRateLimiter(
-              flags.rate_limits.get().aggregate_default_qps(), capacity));
+              flags.rate_limits.get().aggregate_default_qps(),
+              capacity,
+              flags.rate_limits.get().has_aggregate_default_burst()
+                ? flags.rate_limits.get().aggregate_default_burst()
+                : 1));
+
+      frameworks.defaultLimiter = defaultLimiter.get().get();
     }
 
+    frameworks.throttler = new FrameworkThrottler(limiters, defaultLimiter);
+    spawn(frameworks.throttler);
+
     LOG(INFO) << "Framework rate limiting enabled";
   }
 
@@ -691,16 +936,11 @@ void Master::initialize()
       &Master::registerSlave,
       &RegisterSlaveMessage::slave,
       &RegisterSlaveMessage::checkpointed_resources,
-      &RegisterSlaveMessage::version);
+      &RegisterSlaveMessage::version,
+      &RegisterSlaveMessage::capabilities);
 
   install<ReregisterSlaveMessage>(
-      &Master::reregisterSlave,
-      &ReregisterSlaveMessage::slave,
-      &ReregisterSlaveMessage::checkpointed_resources,
-      &ReregisterSlaveMessage::executor_infos,
-      &ReregisterSlaveMessage::tasks,
-      &ReregisterSlaveMessage::completed_frameworks,
-      &ReregisterSlaveMessage::version);
+      &Master::reregisterSlave);
 
   install<UnregisterSlaveMessage>(
       &Master::unregisterSlave,
@@ -711,6 +951,9 @@ void Master::initialize()
       &StatusUpdateMessage::update,
       &StatusUpdateMessage::pid);
 
+  install<StatusUpdatesMessage>(
+      &Master::statusUpdates);
+
   // Added in 0.24.0 to support HTTP schedulers. Since
   // these do not have a pid, the slave must forward
   // messages through the master.
@@ -745,58 +988,80 @@ void Master::initialize()
   // Setup HTTP routes.
   Http http = Http(this);
 
+  // The cost of every endpoint is reported as metrics, and endpoints
+  // may be limited with '--endpoint_concurrency_limits'.
+  auto options = [this](const string& endpoint) {
+    return routeOptions("master", endpoint, flags.endpoint_concurrency_limits);
+  };
+
   route("/api/v1/scheduler",
         Http::SCHEDULER_HELP(),
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.scheduler(request);
-        });
+        },
+        options("/api/v1/scheduler"));
     route("/create-volumes",
         Http::CREATE_VOLUMES_HELP(),
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.createVolumes(request);
-        });
+        },
+        options("/create-volumes"));
     route("/destroy-volumes",
         Http::DESTROY_VOLUMES_HELP(),
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.destroyVolumes(request);
-        });
+        },
+        options("/destroy-volumes"));
+  route("/events",
+        Http::EVENTS_HELP(),
+        [http](const process::http::Request& request) {
+          Http::log(request);
+          return http.events(request);
+        },
+        options("/events"));
   route("/frameworks",
         Http::FRAMEWORKS(),
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.frameworks(request);
-        });
+        },
+        options("/frameworks"));
   route("/flags",
         Http::FLAGS_HELP(),
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.flags(request);
-        });
+        },
+        options("/flags"));
   route("/health",
         Http::HEALTH_HELP(),
         [http](const process::http::Request& request) {
           return http.health(request);
-        });
+        },
+        options("/health"));
   route("/observe",
         Http::OBSERVE_HELP(),
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.observe(request);
-        });
+        },
+        options("/observe"));
   route("/redirect",
         Http::REDIRECT_HELP(),
         [http](const process::http::Request& request) {
           return http.redirect(request);
-        });
+        },
+        options("/redirect"));
   route("/reserve",
         Http::RESERVE_HELP(),
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.reserve(request);
-        });
+        },
+        options("/reserve"));
   // TODO(ijimenez): Remove this endpoint at the end of the
   // deprecation cycle on 0.26.
   route("/roles.json",
@@ -804,25 +1069,29 @@ void Master::initialize()
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.roles(request);
-        });
+        },
+        options("/roles.json"));
   route("/roles",
         Http::ROLES_HELP(),
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.roles(request);
-        });
+        },
+        options("/roles"));
   route("/teardown",
         Http::TEARDOWN_HELP(),
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.teardown(request);
-        });
+        },
+        options("/teardown"));
   route("/slaves",
         Http::SLAVES_HELP(),
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.slaves(request);
-        });
+        },
+        options("/slaves"));
   // TODO(ijimenez): Remove this endpoint at the end of the
   // deprecation cycle on 0.26.
   route("/state.json",
@@ -830,19 +1099,22 @@ void Master::initialize()
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.state(request);
-        });
+        },
+        options("/state.json"));
   route("/state",
         Http::STATE_HELP(),
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.state(request);
-        });
+        },
+        options("/state"));
   route("/state-summary",
         Http::STATESUMMARY_HELP(),
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.stateSummary(request);
-        });
+        },
+        options("/state-summary"));
   // TODO(ijimenez): Remove this endpoint at the end of the
   // deprecation cycle.
   route("/tasks.json",
@@ -850,49 +1122,57 @@ void Master::initialize()
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.tasks(request);
-        });
+        },
+        options("/tasks.json"));
   route("/tasks",
         Http::TASKS_HELP(),
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.tasks(request);
-        });
+        },
+        options("/tasks"));
   route("/maintenance/schedule",
         Http::MAINTENANCE_SCHEDULE_HELP(),
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.maintenanceSchedule(request);
-        });
+        },
+        options("/maintenance/schedule"));
   route("/maintenance/status",
         Http::MAINTENANCE_STATUS_HELP(),
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.maintenanceStatus(request);
-        });
+        },
+        options("/maintenance/status"));
   route("/machine/down",
         Http::MACHINE_DOWN_HELP(),
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.machineDown(request);
-        });
+        },
+        options("/machine/down"));
   route("/machine/up",
         Http::MACHINE_UP_HELP(),
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.machineUp(request);
-        });
+        },
+        options("/machine/up"));
   route("/unreserve",
         Http::UNRESERVE_HELP(),
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.unreserve(request);
-        });
+        },
+        options("/unreserve"));
   route("/quota",
         Http::QUOTA_HELP(),
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.quota(request);
-        });
+        },
+        options("/quota"));
 
   // Provide HTTP assets from a "webui" directory. This is either
   // specified via flags (which is necessary for running out of the
@@ -1042,6 +1322,12 @@ void Master::finalize()
   wait(whitelistWatcher);
   delete whitelistWatcher;
 
+  if (frameworks.throttler != NULL) {
+    terminate(frameworks.throttler);
+    wait(frameworks.throttler);
+    delete frameworks.throttler;
+  }
+
   if (authenticator.isSome()) {
     delete authenticator.get();
   }
@@ -1235,42 +1521,62 @@ void Master::visit(const MessageEvent& event)
   // 1) the default RateLimiter is not configured to handle case 2)
   //    above. (or)
   // 2) the principal exists in RateLimits but 'qps' is not set.
-  if (principal.isSome() &&
-      frameworks.limiters.contains(principal.get()) &&
-      frameworks.limiters[principal.get()].isSome()) {
-    const Owned<BoundedRateLimiter>& limiter =
-      frameworks.limiters[principal.get()].get();
-
-    if (limiter->capacity.isNone() ||
-        limiter->messages < limiter->capacity.get()) {
-      limiter->messages++;
-      limiter->limiter->acquire()
-        .onReady(defer(self(), &Self::throttled, event, principal));
-    } else {
-      exceededCapacity(
-          event,
-          principal,
-          limiter->capacity.get());
-    }
-  } else if ((principal.isNone() ||
-              !frameworks.limiters.contains(principal.get())) &&
-             isRegisteredFramework &&
-             frameworks.defaultLimiter.isSome()) {
-    if (frameworks.defaultLimiter.get()->capacity.isNone() ||
-        frameworks.defaultLimiter.get()->messages <
-          frameworks.defaultLimiter.get()->capacity.get()) {
-      frameworks.defaultLimiter.get()->messages++;
-      frameworks.defaultLimiter.get()->limiter->acquire()
-        .onReady(defer(self(), &Self::throttled, event, None()));
-    } else {
-      exceededCapacity(
-          event,
-          principal,
-          frameworks.defaultLimiter.get()->capacity.get());
-    }
-  } else {
+  //
+  // A throttled message is admitted right away if a token is
+  // available. Otherwise it is handed over to the
+  // 'FrameworkThrottler', which dispatches it back to 'released' once
+  // it is admitted.
+  BoundedRateLimiter* limiter = NULL;
+
+  if (principal.isSome() && frameworks.limiters.contains(principal.get())) {
+    limiter = frameworks.limiters[principal.get()];
+  } else if (isRegisteredFramework) {
+    limiter = frameworks.defaultLimiter;
+  }
+
+  if (limiter == NULL) {
     _visit(event);
+    return;
   }
+
+  // The message must not overtake the events of the limiter that
+  // were handed over earlier.
+  if (limiter->forwarded == 0 && limiter->take()) {
+    admitted(event, principal, Duration::zero());
+    return;
+  }
+
+  limiter->forwarded++;
+
+  // Necessary to disambiguate.
+  typedef void(Self::*F)(
+      BoundedRateLimiter*,
+      const MessageEvent&,
+      const Option<string>&,
+      const Duration&);
+
+  const lambda::function<void(const Duration&)> admit = defer(
+      self(),
+      static_cast<F>(&Self::released),
+      limiter,
+      event,
+      principal,
+      lambda::_1);
+
+  const lambda::function<void(uint64_t)> exceeded = defer(
+      self(),
+      &Self::exceededCapacity,
+      limiter,
+      event,
+      principal,
+      lambda::_1);
+
+  dispatch(
+      frameworks.throttler,
+      &FrameworkThrottler::message,
+      limiter,
+      admit,
+      exceeded);
 }
 
 
@@ -1287,44 +1593,99 @@ void Master::visit(const ExitedEvent& event)
     ? frameworks.principals[event.pid]
     : Option<string>::none();
 
-  // Necessary to disambiguate below.
-  typedef void(Self::*F)(const ExitedEvent&);
-
-  if (principal.isSome() &&
-      frameworks.limiters.contains(principal.get()) &&
-      frameworks.limiters[principal.get()].isSome()) {
-    frameworks.limiters[principal.get()].get()->limiter->acquire()
-      .onReady(defer(self(), static_cast<F>(&Self::_visit), event));
-  } else if ((principal.isNone() ||
-              !frameworks.limiters.contains(principal.get())) &&
-             isRegisteredFramework &&
-             frameworks.defaultLimiter.isSome()) {
-    frameworks.defaultLimiter.get()->limiter->acquire()
-      .onReady(defer(self(), static_cast<F>(&Self::_visit), event));
-  } else {
+  BoundedRateLimiter* limiter = NULL;
+
+  if (principal.isSome() && frameworks.limiters.contains(principal.get())) {
+    limiter = frameworks.limiters[principal.get()];
+  } else if (isRegisteredFramework) {
+    limiter = frameworks.defaultLimiter;
+  }
+
+  if (limiter == NULL) {
+    _visit(event);
+    return;
+  }
+
+  if (limiter->forwarded == 0 && limiter->take()) {
     _visit(event);
+    return;
   }
+
+  limiter->forwarded++;
+
+  // Necessary to disambiguate.
+  typedef void(Self::*F)(BoundedRateLimiter*, const ExitedEvent&);
+
+  const lambda::function<void()> admit =
+    defer(self(), static_cast<F>(&Self::released), limiter, event);
+
+  dispatch(frameworks.throttler, &FrameworkThrottler::exited, limiter, admit);
 }
 
 
-void Master::throttled(
+void Master::released(
+    BoundedRateLimiter* limiter,
     const MessageEvent& event,
-    const Option<std::string>& principal)
+    const Option<string>& principal,
+    const Duration& latency)
 {
-  // We already know a RateLimiter is used to throttle this event so
-  // here we only need to determine which.
-  if (principal.isSome()) {
-    CHECK_SOME(frameworks.limiters[principal.get()]);
-    frameworks.limiters[principal.get()].get()->messages--;
-  } else {
-    CHECK_SOME(frameworks.defaultLimiter);
-    frameworks.defaultLimiter.get()->messages--;
+  CHECK_GT(limiter->forwarded, 0u);
+  limiter->forwarded--;
+
+  admitted(event, principal, latency);
+}
+
+
+void Master::released(BoundedRateLimiter* limiter, const ExitedEvent& event)
+{
+  CHECK_GT(limiter->forwarded, 0u);
+  limiter->forwarded--;
+
+  _visit(event);
+}
+
+
+void Master::admitted(
+    const MessageEvent& event,
+    const Option<string>& principal,
+    const Duration& latency)
+{
+  if (principal.isSome() && metrics->frameworks.contains(principal.get())) {
+    metrics->frameworks.get(principal.get()).get()->message_admission.record(
+        latency);
   }
 
   _visit(event);
 }
 
 
+void Master::visit(const DispatchEvent& event)
+{
+  ProcessBase::visit(event);
+
+  stateResponses.changed();
+  stateResponses.notify();
+  stateEvents.flush();
+}
+
+
+void Master::visit(const HttpEvent& event)
+{
+  // Reading the state (e.g., '/state') must not invalidate the
+  // responses computed from it.
+  if (event.request->method == "GET") {
+    ProcessBase::visit(event);
+    return;
+  }
+
+  ProcessBase::visit(event);
+
+  stateResponses.changed();
+  stateResponses.notify();
+  stateEvents.flush();
+}
+
+
 void Master::_visit(const MessageEvent& event)
 {
   // Obtain the principal before processing the Message because the
@@ -1346,14 +1707,22 @@ void Master::_visit(const MessageEvent& event)
       metrics->frameworks.get(principal.get()).get()->messages_processed;
     ++messages_processed;
   }
+
+  stateResponses.changed();
+  stateResponses.notify();
+  stateEvents.flush();
 }
 
 
 void Master::exceededCapacity(
+    BoundedRateLimiter* limiter,
     const MessageEvent& event,
     const Option<string>& principal,
     uint64_t capacity)
 {
+  CHECK_GT(limiter->forwarded, 0u);
+  limiter->forwarded--;
+
   LOG(WARNING) << "Dropping message " << event.message->name << " from "
                << event.message->from
                << (principal.isSome() ? "(" + principal.get() + ")" : "")
@@ -1376,6 +1745,10 @@ void Master::exceededCapacity(
 void Master::_visit(const ExitedEvent& event)
 {
   Process<Master>::visit(event);
+
+  stateResponses.changed();
+  stateResponses.notify();
+  stateEvents.flush();
 }
 
 
@@ -1809,6 +2182,10 @@ void Master::receive(
       acknowledge(framework, call.acknowledge());
       break;
 
+    case scheduler::Call::ACKNOWLEDGE_UPDATES:
+      acknowledge(framework, call.acknowledge_updates());
+      break;
+
     case scheduler::Call::RECONCILE:
       reconcile(framework, call.reconcile());
       break;
@@ -2723,36 +3100,48 @@ void Master::launchTasks(
 }
 
 
-Future<bool> Master::authorizeTask(
-    const TaskInfo& task,
+Future<vector<bool>> Master::authorizeTasks(
+    const vector<TaskInfo>& tasks,
     Framework* framework)
 {
   if (authorizer.isNone()) {
-    return true; // Authorization is disabled.
-  }
-
-  // Authorize the task.
-  string user = framework->info.user(); // Default user.
-  if (task.has_command() && task.command().has_user()) {
-    user = task.command().user();
-  } else if (task.has_executor() && task.executor().command().has_user()) {
-    user = task.executor().command().user();
+    // Authorization is disabled.
+    return vector<bool>(tasks.size(), true);
   }
 
   LOG(INFO)
     << "Authorizing framework principal '" << framework->info.principal()
-    << "' to launch task " << task.task_id() << " as user '" << user << "'";
+    << "' to launch " << tasks.size() << " tasks";
+
+  vector<mesos::ACL::RunTask> requests;
+  requests.reserve(tasks.size());
+
+  foreach (const TaskInfo& task, tasks) {
+    // Authorize the task.
+    string user = framework->info.user(); // Default user.
+    if (task.has_command() && task.command().has_user()) {
+      user = task.command().user();
+    } else if (task.has_executor() && task.executor().command().has_user()) {
+      user = task.executor().command().user();
+    }
 
-  mesos::ACL::RunTask request;
-  if (framework->info.has_principal()) {
-    request.mutable_principals()->add_values(framework->info.principal());
-  } else {
-    // Framework doesn't have a principal set.
-    request.mutable_principals()->set_type(mesos::ACL::Entity::ANY);
+    VLOG(1)
+      << "Authorizing framework principal '" << framework->info.principal()
+      << "' to launch task " << task.task_id() << " as user '" << user << "'";
+
+    mesos::ACL::RunTask request;
+    if (framework->info.has_principal()) {
+      request.mutable_principals()->add_values(framework->info.principal());
+    } else {
+      // Framework doesn't have a principal set.
+      request.mutable_principals()->set_type(mesos::ACL::Entity::ANY);
+    }
+    request.mutable_users()->add_values(user);
+
+    requests.push_back(request);
   }
-  request.mutable_users()->add_values(user);
 
-  return authorizer.get()->authorize(request);
+  return authorizer.get()->authorize(requests);
 }
 
 
@@ -2955,14 +3344,14 @@ void Master::accept(
   //
   // TODO(mpark): Add authorization logic for RESERVE and UNRESERVE
   // when "reserve" and "unreserve" ACLs are being introduced.
-  list<Future<bool>> futures;
+  vector<TaskInfo> tasks;
   foreach (const Offer::Operation& operation, accept.operations()) {
     if (operation.type() != Offer::Operation::LAUNCH) {
       continue;
     }
 
     foreach (const TaskInfo& task, operation.launch().task_infos()) {
-      futures.push_back(authorizeTask(task, framework));
+      tasks.push_back(task);
 
       // Add to pending tasks.
       //
@@ -2972,13 +3361,13 @@ void Master::accept(
       // one will not be put into 'framework->pendingTasks', therefore
       // will not be launched.
       if (!framework->pendingTasks.contains(task.task_id())) {
-        framework->pendingTasks[task.task_id()] = task;
+        framework->addPendingTask(task);
       }
     }
   }
 
   // Wait for all the tasks to be authorized.
-  await(futures)
+  authorizeTasks(tasks, framework)
     .onAny(defer(self(),
                  &Master::_accept,
                  framework->id(),
@@ -2994,7 +3383,7 @@ void Master::_accept(
     const SlaveID& slaveId,
     const Resources& offeredResources,
     const scheduler::Call::Accept& accept,
-    const Future<list<Future<bool>>>& _authorizations)
+    const Future<vector<bool>>& authorizations)
 {
   Framework* framework = getFramework(frameworkId);
 
@@ -3063,8 +3452,39 @@ void Master::_accept(
   // launched, we remove its resource from offered resources.
   Resources _offeredResources = offeredResources;
 
-  CHECK_READY(_authorizations);
-  list<Future<bool>> authorizations = _authorizations.get();
+  // Check authorization result.
+  CHECK(!authorizations.isDiscarded());
+
+  // The authorizer must return exactly one result per task. If it
+  // returns a different number we cannot tell which result belongs
+  // to which task, so every task in the batch is unauthorized.
+  Option<string> authorizationError;
+  if (authorizations.isFailed()) {
+    authorizationError = "Authorization failure: " + authorizations.failure();
+  } else {
+    size_t launches = 0;
+    foreach (const Offer::Operation& operation, accept.operations()) {
+      if (operation.type() == Offer::Operation::LAUNCH) {
+        launches += operation.launch().task_infos().size();
+      }
+    }
+
+    if (authorizations.get().size() != launches) {
+      authorizationError =
+        "Authorization failure: authorizer returned " +
+        stringify(authorizations.get().size()) + " results for " +
+        stringify(launches) + " tasks";
+
+      LOG(WARNING) << authorizationError.get() << " of framework "
+                   << *framework;
+    }
+  }
+
+  // The authorization of the next task to launch.
+  size_t authorization = 0;
+
+  // The tasks are validated incrementally, as they are launched.
+  const validation::task::Validator validator(framework, slave);
 
   foreach (const Offer::Operation& operation, accept.operations()) {
     switch (operation.type()) {
@@ -3176,8 +3596,11 @@ void Master::_accept(
 
       case Offer::Operation::LAUNCH: {
         foreach (const TaskInfo& task, operation.launch().task_infos()) {
-          Future<bool> authorization = authorizations.front();
-          authorizations.pop_front();
+          const bool authorized =
+            authorizationError.isNone() &&
+            authorizations.get()[authorization];
+
+          authorization++;
 
           // NOTE: The task will not be in 'pendingTasks' if
           // 'killTask()' for the task was called before we are here.
@@ -3188,12 +3611,11 @@ void Master::_accept(
           bool pending = framework->pendingTasks.contains(task.task_id());
 
           // Remove from pending tasks.
-          framework->pendingTasks.erase(task.task_id());
-
-          // Check authorization result.
-          CHECK(!authorization.isDiscarded());
+          if (pending) {
+            framework->removePendingTask(task.task_id());
+          }
 
-          if (authorization.isFailed() || !authorization.get()) {
+          if (!authorized) {
             string user = framework->info.user(); // Default user.
             if (task.has_command() && task.command().has_user()) {
               user = task.command().user();
@@ -3209,8 +3631,8 @@ void Master::_accept(
                 TASK_ERROR,
                 TaskStatus::SOURCE_MASTER,
                 None(),
-                authorization.isFailed() ?
-                    "Authorization failure: " + authorization.failure() :
+                authorizationError.isSome() ?
+                    authorizationError.get() :
                     "Not authorized to launch as user '" + user + "'",
                 TaskStatus::REASON_TASK_UNAUTHORIZED);
 
@@ -3238,11 +3660,8 @@ void Master::_accept(
                 ->mutable_framework_id()->CopyFrom(framework->id());
           }
 
-          const Option<Error>& validationError = validation::task::validate(
-              task_,
-              framework,
-              slave,
-              _offeredResources);
+          const Option<Error>& validationError =
+            validator.validate(task_, _offeredResources);
 
           if (validationError.isSome()) {
             const StatusUpdate& update = protobuf::createStatusUpdate(
@@ -3455,7 +3874,7 @@ void Master::kill(Framework* framework, const scheduler::Call::Kill& kill)
 
   if (framework->pendingTasks.contains(taskId)) {
     // Remove from pending tasks.
-    framework->pendingTasks.erase(taskId);
+    framework->removePendingTask(taskId);
 
     const StatusUpdate& update = protobuf::createStatusUpdate(
         framework->id(),
@@ -3640,12 +4059,34 @@ void Master::acknowledge(
   message.mutable_task_id()->CopyFrom(taskId);
   message.set_uuid(uuid.toBytes());
 
-  send(slave->pid, message);
+  if (slave->hasCapability(SlaveCapability::BATCHED_STATUS_UPDATES)) {
+    if (batched.updates.empty() && batched.acknowledgements.empty()) {
+      dispatch(self(), &Self::sendStatusUpdates);
+    }
+
+    batched.acknowledgements[slaveId].add_acknowledgements()->CopyFrom(
+        message);
+  } else {
+    send(slave->pid, message);
+  }
 
   metrics->valid_status_update_acknowledgements++;
 }
 
 
+void Master::acknowledge(
+    Framework* framework,
+    const scheduler::Call::AcknowledgeUpdates& acknowledgeUpdates)
+{
+  CHECK_NOTNULL(framework);
+
+  foreach (const scheduler::Call::Acknowledge& acknowledge,
+           acknowledgeUpdates.acknowledgements()) {
+    Master::acknowledge(framework, acknowledge);
+  }
+}
+
+
 void Master::schedulerMessage(
     const UPID& from,
     const SlaveID& slaveId,
@@ -3786,11 +4227,53 @@ void Master::message(
 }
 
 
+// Returns the capabilities of a (re-)registering slave that the
+// master supports as well.
+static vector<SlaveCapability> supportedCapabilities(
+    const vector<SlaveCapability>& capabilities)
+{
+  vector<SlaveCapability> supported;
+
+  foreach (const SlaveCapability& capability, capabilities) {
+    switch (capability.type()) {
+      case SlaveCapability::BATCHED_STATUS_UPDATES:
+        supported.push_back(capability);
+        break;
+      default:
+        break;
+    }
+  }
+
+  return supported;
+}
+
+
+// Returns whether the framework receives its status updates in
+// batches, which is only supported for HTTP frameworks.
+static bool batchesStatusUpdates(const Framework* framework)
+{
+  if (framework->http.isNone()) {
+    return false;
+  }
+
+  foreach (const FrameworkInfo::Capability& capability,
+           framework->info.capabilities()) {
+    if (capability.type() ==
+          FrameworkInfo::Capability::BATCHED_STATUS_UPDATES) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
 void Master::registerSlave(
     const UPID& from,
     const SlaveInfo& slaveInfo,
     const vector<Resource>& checkpointedResources,
-    const string& version)
+    const string& version,
+    const vector<SlaveCapability>& capabilities)
 {
   ++metrics->messages_register_slave;
 
@@ -3804,7 +4287,8 @@ void Master::registerSlave(
                      from,
                      slaveInfo,
                      checkpointedResources,
-                     version));
+                     version,
+                     capabilities));
     return;
   }
 
@@ -3860,14 +4344,9 @@ void Master::registerSlave(
       LOG(INFO) << "Slave " << *slave << " already registered,"
                 << " resending acknowledgement";
 
-      Duration pingTimeout =
-        flags.slave_ping_timeout * flags.max_slave_ping_timeouts;
-      MasterSlaveConnection connection;
-      connection.set_total_ping_timeout_seconds(pingTimeout.secs());
-
       SlaveRegisteredMessage message;
       message.mutable_slave_id()->CopyFrom(slave->id);
-      message.mutable_connection()->CopyFrom(connection);
+      message.mutable_connection()->CopyFrom(connection(slave));
       send(from, message);
       return;
     }
@@ -3897,6 +4376,7 @@ void Master::registerSlave(
                  from,
                  checkpointedResources,
                  version,
+                 capabilities,
                  lambda::_1));
 }
 
@@ -3906,6 +4386,7 @@ void Master::_registerSlave(
     const UPID& pid,
     const vector<Resource>& checkpointedResources,
     const string& version,
+    const vector<SlaveCapability>& capabilities,
     const Future<bool>& admit)
 {
   slaves.registering.erase(pid);
@@ -3941,18 +4422,15 @@ void Master::_registerSlave(
         Clock::now(),
         checkpointedResources);
 
+    slave->capabilities = supportedCapabilities(capabilities);
+
     ++metrics->slave_registrations;
 
     addSlave(slave);
 
-    Duration pingTimeout =
-      flags.slave_ping_timeout * flags.max_slave_ping_timeouts;
-    MasterSlaveConnection connection;
-    connection.set_total_ping_timeout_seconds(pingTimeout.secs());
-
     SlaveRegisteredMessage message;
     message.mutable_slave_id()->CopyFrom(slave->id);
-    message.mutable_connection()->CopyFrom(connection);
+    message.mutable_connection()->CopyFrom(connection(slave));
     send(slave->pid, message);
 
     LOG(INFO) << "Registered slave " << *slave
@@ -3963,12 +4441,7 @@ void Master::_registerSlave(
 
 void Master::reregisterSlave(
     const UPID& from,
-    const SlaveInfo& slaveInfo,
-    const vector<Resource>& checkpointedResources,
-    const vector<ExecutorInfo>& executorInfos,
-    const vector<Task>& tasks,
-    const vector<Archive::Framework>& completedFrameworks,
-    const string& version)
+    const ReregisterSlaveMessage& message)
 {
   ++metrics->messages_reregister_slave;
 
@@ -3977,18 +4450,15 @@ void Master::reregisterSlave(
               << " because authentication is still in progress";
 
     authenticating[from]
-      .onReady(defer(self(),
-                     &Self::reregisterSlave,
-                     from,
-                     slaveInfo,
-                     checkpointedResources,
-                     executorInfos,
-                     tasks,
-                     completedFrameworks,
-                     version));
+      .onReady(defer(self(), &Self::reregisterSlave, from, message));
     return;
   }
 
+  const SlaveInfo& slaveInfo = message.slave();
+  const vector<ExecutorInfo> executorInfos =
+    google::protobuf::convert(message.executor_infos());
+  const vector<Task> tasks = google::protobuf::convert(message.tasks());
+
   if (flags.authenticate_slaves && !authenticated.contains(from)) {
     // This could happen if another authentication request came
     // through before we are here or if a slave tried to
@@ -4069,6 +4539,10 @@ void Master::reregisterSlave(
       return;
     }
 
+    // The slave might have been upgraded or downgraded in the meantime.
+    slave->capabilities = supportedCapabilities(
+        google::protobuf::convert(message.capabilities()));
+
     // Update the slave pid and relink to it.
     // NOTE: Re-linking the slave here always rather than only when
     // the slave is disconnected can lead to multiple exited events
@@ -4125,18 +4599,133 @@ void Master::reregisterSlave(
 
   // This handles the case when the slave tries to re-register with
   // a failed over master, in which case we must consult the
-  // registrar.
-  registrar->apply(Owned<Operation>(new ReadmitSlave(slaveInfo)))
-    .onAny(defer(self(),
-                 &Self::_reregisterSlave,
-                 slaveInfo,
-                 from,
-                 checkpointedResources,
-                 executorInfos,
-                 tasks,
-                 completedFrameworks,
-                 version,
-                 lambda::_1));
+  // registrar. After a failover all the slaves re-register at about
+  // the same time, so rather than doing a registrar operation per
+  // slave we readmit the slaves in batches (see 'readmitSlaves').
+  Reregistration reregistration;
+  reregistration.slaveInfo = slaveInfo;
+  reregistration.pid = from;
+  reregistration.checkpointedResources =
+    google::protobuf::convert(message.checkpointed_resources());
+  reregistration.executorInfos = executorInfos;
+  reregistration.tasks = tasks;
+  reregistration.completedFrameworks =
+    google::protobuf::convert(message.completed_frameworks());
+  reregistration.version = message.version();
+  reregistration.capabilities =
+    google::protobuf::convert(message.capabilities());
+
+  slaves.readmissions.push_back(reregistration);
+
+  if (!slaves.readmitting) {
+    slaves.readmitting = true;
+    dispatch(self(), &Self::readmitSlaves);
+  }
+}
+
+
+void Master::readmitSlaves()
+{
+  CHECK(slaves.readmitting);
+  slaves.readmitting = false;
+
+  Owned<vector<Reregistration>> reregistrations(new vector<Reregistration>());
+  std::swap(*reregistrations, slaves.readmissions);
+
+  LOG(INFO) << "Validating the re-registration of "
+            << reregistrations->size() << " slaves";
+
+  // The executors and tasks of the slaves make up most of the
+  // re-registration payloads, so we validate them without blocking
+  // the master.
+  async([reregistrations]() {
+    vector<Option<Error>> validations;
+
+    foreach (const Reregistration& reregistration, *reregistrations) {
+      validations.push_back(validation::slave::reregistration::validate(
+          reregistration.slaveInfo,
+          reregistration.checkpointedResources,
+          reregistration.executorInfos,
+          reregistration.tasks));
+    }
+
+    return validations;
+  })
+  .onAny(defer(self(), &Self::_readmitSlaves, reregistrations, lambda::_1));
+}
+
+
+void Master::_readmitSlaves(
+    const Owned<vector<Reregistration>>& reregistrations,
+    const Future<vector<Option<Error>>>& validations)
+{
+  CHECK(validations.isReady())
+    << "Failed to validate the re-registration of slaves: "
+    << (validations.isFailed() ? validations.failure() : "discarded");
+
+  CHECK_EQ(reregistrations->size(), validations.get().size());
+
+  vector<SlaveInfo> slaveInfos;
+
+  for (size_t i = 0; i < reregistrations->size(); i++) {
+    const Reregistration& reregistration = reregistrations->at(i);
+    const Option<Error>& error = validations.get()[i];
+
+    if (error.isSome()) {
+      LOG(WARNING) << "Refusing re-registration of slave "
+                   << reregistration.slaveInfo.id() << " at "
+                   << reregistration.pid << " ("
+                   << reregistration.slaveInfo.hostname() << "): "
+                   << error.get().message;
+
+      slaves.reregistering.erase(reregistration.slaveInfo.id());
+
+      ShutdownMessage message;
+      message.set_message("Invalid re-registration: " + error.get().message);
+      send(reregistration.pid, message);
+      continue;
+    }
+
+    slaveInfos.push_back(reregistration.slaveInfo);
+  }
+
+  if (slaveInfos.empty()) {
+    return;
+  }
+
+  LOG(INFO) << "Readmitting " << slaveInfos.size() << " slaves";
+
+  ReadmitSlaves* readmit = new ReadmitSlaves(slaveInfos);
+  Owned<Operation> operation(readmit);
+
+  Future<bool> applied = registrar->apply(operation);
+
+  for (size_t i = 0; i < reregistrations->size(); i++) {
+    if (validations.get()[i].isSome()) {
+      continue;
+    }
+
+    const Reregistration& reregistration = reregistrations->at(i);
+    const SlaveID slaveId = reregistration.slaveInfo.id();
+
+    // NOTE: We hold on to 'operation' so that 'readmit' outlives the
+    // registrar's copy of it.
+    applied
+      .then([operation, readmit, slaveId](bool success) {
+        return success && readmit->readmitted(slaveId);
+      })
+      .onAny(defer(self(),
+                   &Self::_reregisterSlave,
+                   reregistration.slaveInfo,
+                   reregistration.pid,
+                   reregistration.checkpointedResources,
+                   reregistration.executorInfos,
+                   reregistration.tasks,
+                   reregistration.completedFrameworks,
+                   reregistration.version,
+                   reregistration.capabilities,
+                   lambda::_1));
+  }
 }
 
 
@@ -4148,6 +4737,7 @@ void Master::_reregisterSlave(
     const vector<Task>& tasks,
     const vector<Archive::Framework>& completedFrameworks,
     const string& version,
+    const vector<SlaveCapability>& capabilities,
     const Future<bool>& readmit)
 {
   slaves.reregistering.erase(slaveInfo.id());
@@ -4185,19 +4775,15 @@ void Master::_reregisterSlave(
         tasks);
 
     slave->reregisteredTime = Clock::now();
+    slave->capabilities = supportedCapabilities(capabilities);
 
     ++metrics->slave_reregistrations;
 
     addSlave(slave, completedFrameworks);
 
-    Duration pingTimeout =
-      flags.slave_ping_timeout * flags.max_slave_ping_timeouts;
-    MasterSlaveConnection connection;
-    connection.set_total_ping_timeout_seconds(pingTimeout.secs());
-
     SlaveReregisteredMessage message;
     message.mutable_slave_id()->CopyFrom(slave->id);
-    message.mutable_connection()->CopyFrom(connection);
+    message.mutable_connection()->CopyFrom(connection(slave));
     send(slave->pid, message);
 
     LOG(INFO) << "Re-registered slave " << *slave
@@ -4246,6 +4832,24 @@ void Master::__reregisterSlave(Slave* slave, const vector<Task>& tasks)
 }
 
 
+MasterSlaveConnection Master::connection(const Slave* slave) const
+{
+  CHECK_NOTNULL(slave);
+
+  Duration pingTimeout =
+    flags.slave_ping_timeout * flags.max_slave_ping_timeouts;
+
+  MasterSlaveConnection connection;
+  connection.set_total_ping_timeout_seconds(pingTimeout.secs());
+
+  foreach (const SlaveCapability& capability, slave->capabilities) {
+    connection.add_capabilities()->CopyFrom(capability);
+  }
+
+  return connection;
+}
+
+
 void Master::unregisterSlave(const UPID& from, const SlaveID& slaveId)
 {
   ++metrics->messages_unregister_slave;
@@ -4477,6 +5081,19 @@ void Master::statusUpdate(StatusUpdate update, const UPID& pid)
 }
 
 
+void Master::statusUpdates(
+    const UPID& from,
+    const StatusUpdatesMessage& message)
+{
+  VLOG(1) << "Received " << message.updates().size()
+          << " status updates from " << from;
+
+  foreach (const StatusUpdateMessage& update, message.updates()) {
+    statusUpdate(update.update(), update.pid());
+  }
+}
+
+
 void Master::forward(
     const StatusUpdate& update,
     const UPID& acknowledgee,
@@ -4496,7 +5113,63 @@ void Master::forward(
   StatusUpdateMessage message;
   message.mutable_update()->MergeFrom(update);
   message.set_pid(acknowledgee);
-  framework->send(message);
+
+  if (!batchesStatusUpdates(framework)) {
+    framework->send(message);
+    return;
+  }
+
+  if (batched.updates.empty() && batched.acknowledgements.empty()) {
+    dispatch(self(), &Self::sendStatusUpdates);
+  }
+
+  batched.updates[framework->id()].add_updates()->CopyFrom(message);
+}
+
+
+void Master::sendStatusUpdates()
+{
+  // NOTE: The batches are dropped if the framework or slave went
+  // away in the meantime. This is safe because the slave retries
+  // status updates until they are acknowledged.
+  foreachpair (const FrameworkID& frameworkId,
+               const StatusUpdatesMessage& message,
+               batched.updates) {
+    Framework* framework = getFramework(frameworkId);
+
+    if (framework == NULL || !batchesStatusUpdates(framework)) {
+      LOG(WARNING) << "Dropping " << message.updates().size()
+                   << " status updates for framework " << frameworkId
+                   << " because it is no longer subscribed";
+      continue;
+    }
+
+    VLOG(1) << "Sending " << message.updates().size()
+            << " status updates to framework " << *framework;
+
+    framework->send(message);
+  }
+
+  foreachpair (const SlaveID& slaveId,
+               const StatusUpdateAcknowledgementsMessage& message,
+               batched.acknowledgements) {
+    Slave* slave = slaves.registered.get(slaveId);
+
+    if (slave == NULL || !slave->connected) {
+      LOG(WARNING) << "Dropping " << message.acknowledgements().size()
+                   << " status update acknowledgements for slave " << slaveId
+                   << " because it is no longer connected";
+      continue;
+    }
+
+    VLOG(1) << "Sending " << message.acknowledgements().size()
+            << " status update acknowledgements to slave " << *slave;
+
+    send(slave->pid, message);
+  }
+
+  batched.updates.clear();
+  batched.acknowledgements.clear();
 }
 
 
@@ -4666,6 +5339,105 @@ void Master::reconcileTasks(
 }
 
 
+// Returns the reconciliation update of a task that is pending
+// authorization.
+static StatusUpdate reconciliationUpdate(
+    const FrameworkID& frameworkId,
+    const TaskInfo& task)
+{
+  return protobuf::createStatusUpdate(
+      frameworkId,
+      task.slave_id(),
+      task.task_id(),
+      TASK_STAGING,
+      TaskStatus::SOURCE_MASTER,
+      None(),
+      "Reconciliation: Latest task state",
+      TaskStatus::REASON_RECONCILIATION);
+}
+
+
+// Returns the reconciliation update of a known task, carrying the
+// latest status update state of the task.
+static StatusUpdate reconciliationUpdate(
+    const FrameworkID& frameworkId,
+    const Task& task)
+{
+  const TaskState& state = task.has_status_update_state()
+      ? task.status_update_state()
+      : task.state();
+
+  const Option<ExecutorID> executorId = task.has_executor_id()
+      ? Option<ExecutorID>(task.executor_id())
+      : None();
+
+  return protobuf::createStatusUpdate(
+      frameworkId,
+      task.slave_id(),
+      task.task_id(),
+      state,
+      TaskStatus::SOURCE_MASTER,
+      None(),
+      "Reconciliation: Latest task state",
+      TaskStatus::REASON_RECONCILIATION,
+      executorId,
+      protobuf::getTaskHealth(task),
+      None(),
+      protobuf::getTaskContainerStatus(task));
+}
+
+
+// Sends the reconciliation updates of a framework. Frameworks with
+// the BATCHED_STATUS_UPDATES capability receive the updates in chunks
+// of at most MAX_RECONCILIATION_UPDATES_PER_MESSAGE, which are sent
+// as soon as they fill up, instead of one message per task.
+class ReconciliationStream
+{
+public:
+  explicit ReconciliationStream(Framework* _framework)
+    : framework(CHECK_NOTNULL(_framework)),
+      batched(batchesStatusUpdates(_framework)) {}
+
+  ~ReconciliationStream()
+  {
+    flush();
+  }
+
+  void send(const StatusUpdate& update)
+  {
+    // TODO(bmahler): Consider using forward(); might lead to too
+    // much logging.
+    if (!batched) {
+      StatusUpdateMessage message;
+      message.mutable_update()->CopyFrom(update);
+      framework->send(message);
+      return;
+    }
+
+    chunk.add_updates()->mutable_update()->CopyFrom(update);
+
+    if (chunk.updates_size() >=
+          static_cast<int>(MAX_RECONCILIATION_UPDATES_PER_MESSAGE)) {
+      flush();
+    }
+  }
+
+private:
+  void flush()
+  {
+    if (chunk.updates_size() > 0) {
+      framework->send(chunk);
+      chunk.Clear();
+    }
+  }
+
+  Framework* const framework;
+  const bool batched;
+
+  StatusUpdatesMessage chunk;
+};
+
+
 void Master::_reconcileTasks(
     Framework* framework,
     const vector<TaskStatus>& statuses)
@@ -4674,67 +5446,35 @@ void Master::_reconcileTasks(
 
   ++metrics->messages_reconcile_tasks;
 
+  ReconciliationStream stream(framework);
+
   if (statuses.empty()) {
     // Implicit reconciliation.
     LOG(INFO) << "Performing implicit task state reconciliation"
                  " for framework " << *framework;
 
     foreachvalue (const TaskInfo& task, framework->pendingTasks) {
-      const StatusUpdate& update = protobuf::createStatusUpdate(
-          framework->id(),
-          task.slave_id(),
-          task.task_id(),
-          TASK_STAGING,
-          TaskStatus::SOURCE_MASTER,
-          None(),
-          "Reconciliation: Latest task state",
-          TaskStatus::REASON_RECONCILIATION);
+      const StatusUpdate& update =
+        reconciliationUpdate(framework->id(), task);
 
       VLOG(1) << "Sending implicit reconciliation state "
               << update.status().state()
               << " for task " << update.status().task_id()
               << " of framework " << *framework;
 
-      // TODO(bmahler): Consider using forward(); might lead to too
-      // much logging.
-      StatusUpdateMessage message;
-      message.mutable_update()->CopyFrom(update);
-      framework->send(message);
+      stream.send(update);
     }
 
     foreachvalue (Task* task, framework->tasks) {
-      const TaskState& state = task->has_status_update_state()
-          ? task->status_update_state()
-          : task->state();
-
-      const Option<ExecutorID>& executorId = task->has_executor_id()
-          ? Option<ExecutorID>(task->executor_id())
-          : None();
-
-      const StatusUpdate& update = protobuf::createStatusUpdate(
-          framework->id(),
-          task->slave_id(),
-          task->task_id(),
-          state,
-          TaskStatus::SOURCE_MASTER,
-          None(),
-          "Reconciliation: Latest task state",
-          TaskStatus::REASON_RECONCILIATION,
-          executorId,
-          protobuf::getTaskHealth(*task),
-          None(),
-          protobuf::getTaskContainerStatus(*task));
+      const StatusUpdate& update =
+        reconciliationUpdate(framework->id(), *task);
 
       VLOG(1) << "Sending implicit reconciliation state "
               << update.status().state()
               << " for task " << update.status().task_id()
               << " of framework " << *framework;
 
-      // TODO(bmahler): Consider using forward(); might lead to too
-      // much logging.
-      StatusUpdateMessage message;
-      message.mutable_update()->CopyFrom(update);
-      framework->send(message);
+      stream.send(update);
     }
 
     return;
@@ -4764,43 +5504,22 @@ void Master::_reconcileTasks(
     }
 
     Option<StatusUpdate> update = None();
-    Task* task = framework->getTask(status.task_id());
 
-    if (framework->pendingTasks.contains(status.task_id())) {
+    // Each task is looked up once in the pending and the known tasks
+    // of the framework.
+    hashmap<TaskID, TaskInfo>::const_iterator pending =
+      framework->pendingTasks.find(status.task_id());
+
+    Task* task = pending == framework->pendingTasks.end()
+      ? framework->getTask(status.task_id())
+      : NULL;
+
+    if (pending != framework->pendingTasks.end()) {
       // (1) Task is known, but pending: TASK_STAGING.
-      const TaskInfo& task_ = framework->pendingTasks[status.task_id()];
-      update = protobuf::createStatusUpdate(
-          framework->id(),
-          task_.slave_id(),
-          task_.task_id(),
-          TASK_STAGING,
-          TaskStatus::SOURCE_MASTER,
-          None(),
-          "Reconciliation: Latest task state",
-          TaskStatus::REASON_RECONCILIATION);
+      update = reconciliationUpdate(framework->id(), pending->second);
     } else if (task != NULL) {
       // (2) Task is known: send the latest status update state.
-      const TaskState& state = task->has_status_update_state()
-          ? task->status_update_state()
-          : task->state();
-
-      const Option<ExecutorID> executorId = task->has_executor_id()
-          ? Option<ExecutorID>(task->executor_id())
-          : None();
-
-      update = protobuf::createStatusUpdate(
-          framework->id(),
-          task->slave_id(),
-          task->task_id(),
-          state,
-          TaskStatus::SOURCE_MASTER,
-          None(),
-          "Reconciliation: Latest task state",
-          TaskStatus::REASON_RECONCILIATION,
-          executorId,
-          protobuf::getTaskHealth(*task),
-          None(),
-          protobuf::getTaskContainerStatus(*task));
+      update = reconciliationUpdate(framework->id(), *task);
     } else if (slaveId.isSome() && slaves.registered.contains(slaveId.get())) {
       // (3) Task is unknown, slave is registered: TASK_LOST.
       update = protobuf::createStatusUpdate(
@@ -4836,11 +5555,7 @@ void Master::_reconcileTasks(
               << " for task " << update.get().status().task_id()
               << " of framework " << *framework;
 
-      // TODO(bmahler): Consider using forward(); might lead to too
-      // much logging.
-      StatusUpdateMessage message;
-      message.mutable_update()->CopyFrom(update.get());
-      framework->send(message);
+      stream.send(update.get());
     }
   }
 }
@@ -4979,11 +5694,10 @@ void Master::offer(const FrameworkID& frameworkId,
 
     if (flags.offer_timeout.isSome()) {
       // Rescind the offer after the timeout elapses.
-      offerTimers[offer->id()] =
-        delay(flags.offer_timeout.get(),
-              self(),
-              &Self::offerTimeout,
-              offer->id());
+      expiry.offers.add(
+          offer->id(), Clock::now() + flags.offer_timeout.get());
+
+      scheduleExpiry();
     }
 
     // TODO(jieyu): For now, we strip 'ephemeral_ports' resource from
@@ -5081,11 +5795,10 @@ void Master::inverseOffer(
     // timeout?
     if (flags.offer_timeout.isSome()) {
       // Rescind the inverse offer after the timeout elapses.
-      inverseOfferTimers[inverseOffer->id()] =
-        delay(flags.offer_timeout.get(),
-              self(),
-              &Self::inverseOfferTimeout,
-              inverseOffer->id());
+      expiry.inverseOffers.add(
+          inverseOffer->id(), Clock::now() + flags.offer_timeout.get());
+
+      scheduleExpiry();
     }
 
     // Add the inverse offer *AND* the corresponding slave's PID.
@@ -5259,14 +5972,9 @@ void Master::reconcile(
   // To resolve both cases correctly, we must reconcile through the
   // slave. For slaves that do not support reconciliation, we keep
   // the old semantics and cover only case (1) via TASK_LOST.
-  Duration pingTimeout =
-    flags.slave_ping_timeout * flags.max_slave_ping_timeouts;
-  MasterSlaveConnection connection;
-  connection.set_total_ping_timeout_seconds(pingTimeout.secs());
-
   SlaveReregisteredMessage reregistered;
   reregistered.mutable_slave_id()->CopyFrom(slave->id);
-  reregistered.mutable_connection()->CopyFrom(connection);
+  reregistered.mutable_connection()->CopyFrom(connection(slave));
 
   // NOTE: copies are needed because removeTask modified slave->tasks.
   foreachkey (const FrameworkID& frameworkId, utils::copy(slave->tasks)) {
@@ -5391,6 +6099,8 @@ void Master::addFramework(Framework* framework)
 
   frameworks.registered[framework->id()] = framework;
 
+  stateEvents.frameworkAdded(framework->info);
+
   if (framework->pid.isSome()) {
     link(framework->pid.get());
   } else {
@@ -5603,8 +6313,11 @@ void Master::removeFramework(Framework* framework)
     send(slave->pid, message);
   }
 
-  // Remove the pending tasks from the framework.
-  framework->pendingTasks.clear();
+  // Remove the pending tasks from the framework (which also removes
+  // them from the task state summaries).
+  foreach (const TaskID& taskId, framework->pendingTasks.keys()) {
+    framework->removePendingTask(taskId);
+  }
 
   // Remove pointers to the framework's tasks in slaves.
   foreachvalue (Task* task, utils::copy(framework->tasks)) {
@@ -5717,6 +6430,7 @@ void Master::removeFramework(Framework* framework)
 
   // Remove the framework.
   frameworks.registered.erase(framework->id());
+  stateEvents.frameworkRemoved(framework->info);
   allocator->removeFramework(framework->id());
 }
 
@@ -5776,6 +6490,8 @@ void Master::addSlave(
   slaves.removed.erase(slave->id);
   slaves.registered.put(slave);
 
+  stateEvents.agentAdded(slave->info);
+
   link(slave->pid);
 
   // Map the slave to the machine it is running on.
@@ -5942,6 +6658,7 @@ void Master::removeSlave(
   slaves.removing.insert(slave->id);
   slaves.registered.remove(slave);
   slaves.removed.put(slave->id, Nothing());
+  stateEvents.agentRemoved(slave->info);
   authenticated.erase(slave->pid);
 
   // Remove the slave from the `machines` mapping.
@@ -6047,9 +6764,13 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
     latestState = update.latest_state();
   }
 
+  // The framework (if any) accounts for the states of its tasks.
+  Framework* framework = getFramework(task->framework_id());
+
   // Set 'terminated' to true if this is the first time the task
   // transitioned to terminal state. Also set the latest state.
   bool terminated;
+  Option<TaskState> state;
   if (latestState.isSome()) {
     terminated = !protobuf::isTerminalState(task->state()) &&
                  protobuf::isTerminalState(latestState.get());
@@ -6057,7 +6778,7 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
     // If the task has already transitioned to a terminal state,
     // do not update its state.
     if (!protobuf::isTerminalState(task->state())) {
-      task->set_state(latestState.get());
+      state = latestState.get();
     }
   } else {
     terminated = !protobuf::isTerminalState(task->state()) &&
@@ -6067,7 +6788,15 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
     // its state. Note that we are being defensive here because this should not
     // happen unless there is a bug in the master code.
     if (!protobuf::isTerminalState(task->state())) {
-      task->set_state(status.state());
+      state = status.state();
+    }
+  }
+
+  if (state.isSome()) {
+    if (framework != NULL) {
+      framework->updateTaskState(task, state.get());
+    } else {
+      task->set_state(state.get());
     }
   }
 
@@ -6094,6 +6823,15 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
   // MESOS-1746.
   task->mutable_statuses(task->statuses_size() - 1)->clear_data();
 
+  // Re-index the task since its earliest status may have changed.
+  if (taskIndex.contains(task)) {
+    taskIndex.add(task);
+  }
+
+  if (framework != NULL) {
+    stateEvents.taskUpdated(*task);
+  }
+
   LOG(INFO) << "Updating the state of task " << task->task_id()
             << " of framework " << task->framework_id()
             << " (latest state: " << task->state()
@@ -6113,7 +6851,6 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
 
     slave->taskTerminated(task);
 
-    Framework* framework = getFramework(task->framework_id());
     if (framework != NULL) {
       framework->taskTerminated(task);
     }
@@ -6244,14 +6981,101 @@ void Master::_apply(Slave* slave, const Offer::Operation& operation) {
 }
 
 
-void Master::offerTimeout(const OfferID& offerId)
+void Master::scheduleExpiry()
 {
-  Offer* offer = getOffer(offerId);
-  if (offer != NULL) {
-    allocator->recoverResources(
-        offer->framework_id(), offer->slave_id(), offer->resources(), None());
-    removeOffer(offer, true);
+  if (expiry.timer.isSome()) {
+    return;
+  }
+
+  Option<Time> next = expiry.offers.next();
+
+  if (next.isNone() ||
+      (expiry.inverseOffers.next().isSome() &&
+       expiry.inverseOffers.next().get() < next.get())) {
+    next = expiry.inverseOffers.next();
+  }
+
+  if (next.isNone()) {
+    return;
+  }
+
+  // Offers that expire shortly after the previous sweep are left for
+  // the next one, so that a steady stream of offers is rescinded in
+  // batches rather than one sweep per offer.
+  if (expiry.swept.isSome() &&
+      next.get() < expiry.swept.get() + OFFER_EXPIRY_INTERVAL) {
+    next = expiry.swept.get() + OFFER_EXPIRY_INTERVAL;
   }
+
+  const Time now = Clock::now();
+
+  expiry.timer = delay(
+      next.get() > now ? next.get() - now : Duration::zero(),
+      self(),
+      &Self::expire);
+}
+
+
+void Master::expire()
+{
+  const Time now = Clock::now();
+
+  expiry.timer = None();
+  expiry.swept = now;
+
+  // NOTE: The offers are removed from 'expiry' by 'removeOffer' and
+  // 'removeInverseOffer', so all the expired offers are outstanding.
+  hashmap<FrameworkID, vector<Offer*>> offers_;
+  foreach (const OfferID& offerId, expiry.offers.expire(now)) {
+    Offer* offer = CHECK_NOTNULL(getOffer(offerId));
+    offers_[offer->framework_id()].push_back(offer);
+  }
+
+  hashmap<FrameworkID, vector<InverseOffer*>> inverseOffers_;
+  foreach (const OfferID& inverseOfferId, expiry.inverseOffers.expire(now)) {
+    InverseOffer* inverseOffer =
+      CHECK_NOTNULL(getInverseOffer(inverseOfferId));
+
+    inverseOffers_[inverseOffer->framework_id()].push_back(inverseOffer);
+  }
+
+  foreachpair (const FrameworkID& frameworkId,
+               const vector<Offer*>& expired,
+               offers_) {
+    LOG(INFO) << "Rescinding " << expired.size() << " expired offers"
+              << " of framework " << frameworkId;
+
+    foreach (Offer* offer, expired) {
+      allocator->recoverResources(
+          offer->framework_id(),
+          offer->slave_id(),
+          offer->resources(),
+          None());
+
+      removeOffer(offer, true);
+    }
+  }
+
+  foreachpair (const FrameworkID& frameworkId,
+               const vector<InverseOffer*>& expired,
+               inverseOffers_) {
+    LOG(INFO) << "Rescinding " << expired.size() << " expired inverse offers"
+              << " of framework " << frameworkId;
+
+    foreach (InverseOffer* inverseOffer, expired) {
+      allocator->updateInverseOffer(
+          inverseOffer->slave_id(),
+          inverseOffer->framework_id(),
+          UnavailableResources{
+              inverseOffer->resources(),
+              inverseOffer->unavailability()},
+          None());
+
+      removeInverseOffer(inverseOffer, true);
+    }
+  }
+
+  scheduleExpiry();
 }
 
 
@@ -6282,12 +7106,7 @@ void Master::removeOffer(Offer* offer, bool rescind)
     framework->send(message);
   }
 
-  // Remove and cancel offer removal timers. Canceling the Timers is
-  // only done to avoid having too many active Timers in libprocess.
-  if (offerTimers.contains(offer->id())) {
-    Clock::cancel(offerTimers[offer->id()]);
-    offerTimers.erase(offer->id());
-  }
+  expiry.offers.remove(offer->id());
 
   // Delete it.
   offers.erase(offer->id());
@@ -6295,23 +7114,6 @@ void Master::removeOffer(Offer* offer, bool rescind)
 }
 
 
-void Master::inverseOfferTimeout(const OfferID& inverseOfferId)
-{
-  InverseOffer* inverseOffer = getInverseOffer(inverseOfferId);
-  if (inverseOffer != NULL) {
-    allocator->updateInverseOffer(
-        inverseOffer->slave_id(),
-        inverseOffer->framework_id(),
-        UnavailableResources{
-            inverseOffer->resources(),
-            inverseOffer->unavailability()},
-        None());
-
-    removeInverseOffer(inverseOffer, true);
-  }
-}
-
-
 void Master::removeInverseOffer(InverseOffer* inverseOffer, bool rescind)
 {
   // Remove from framework.
@@ -6337,12 +7139,7 @@ void Master::removeInverseOffer(InverseOffer* inverseOffer, bool rescind)
     framework->send(message);
   }
 
-  // Remove and cancel inverse offer removal timers. Canceling the Timers is
-  // only done to avoid having too many active Timers in libprocess.
-  if (inverseOfferTimers.contains(inverseOffer->id())) {
-    Clock::cancel(inverseOfferTimers[inverseOffer->id()]);
-    inverseOfferTimers.erase(inverseOffer->id());
-  }
+  expiry.inverseOffers.remove(inverseOffer->id());
 
   // Delete it.
   inverseOffers.erase(inverseOffer->id());
@@ -6359,6 +7156,29 @@ Framework* Master::getFramework(const FrameworkID& frameworkId)
 }
 
 
+StateEvent Master::snapshot() const
+{
+  StateEvent event;
+  event.set_type(StateEvent::SNAPSHOT);
+
+  StateEvent::Snapshot* snapshot = event.mutable_snapshot();
+
+  foreachvalue (const Slave* slave, slaves.registered) {
+    snapshot->add_agents()->CopyFrom(slave->info);
+  }
+
+  foreachvalue (const Framework* framework, frameworks.registered) {
+    snapshot->add_frameworks()->CopyFrom(framework->info);
+
+    foreachvalue (const Task* task, framework->tasks) {
+      snapshot->add_tasks()->CopyFrom(*task);
+    }
+  }
+
+  return event;
+}
+
+
 // TODO(bmahler): Consider killing this.
 Offer* Master::getOffer(const OfferID& offerId)
 {
@@ -6513,7 +7333,7 @@ double Master::_tasks_staging()
   }
 
   foreachvalue (Slave* slave, slaves.registered) {
-    typedef hashmap<TaskID, Task*> TaskMap;
+    typedef flathashmap<TaskID, Task*> TaskMap;
     foreachvalue (const TaskMap& tasks, slave->tasks) {
       foreachvalue (const Task* task, tasks) {
         if (task->state() == TASK_STAGING) {
@@ -6532,7 +7352,7 @@ double Master::_tasks_starting()
   double count = 0.0;
 
   foreachvalue (Slave* slave, slaves.registered) {
-    typedef hashmap<TaskID, Task*> TaskMap;
+    typedef flathashmap<TaskID, Task*> TaskMap;
     foreachvalue (const TaskMap& tasks, slave->tasks) {
       foreachvalue (const Task* task, tasks) {
         if (task->state() == TASK_STARTING) {
@@ -6551,7 +7371,7 @@ double Master::_tasks_running()
   double count = 0.0;
 
   foreachvalue (Slave* slave, slaves.registered) {
-    typedef hashmap<TaskID, Task*> TaskMap;
+    typedef flathashmap<TaskID, Task*> TaskMap;
     foreachvalue (const TaskMap& tasks, slave->tasks) {
       foreachvalue (const Task* task, tasks) {
         if (task->state() == TASK_RUNNING) {
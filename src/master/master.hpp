@@ -50,12 +50,16 @@
 #include <process/metrics/counter.hpp>
 
 #include <stout/cache.hpp>
+#include <stout/duration.hpp>
+#include <stout/flathashmap.hpp>
 #include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
+#include <stout/lambda.hpp>
 #include <stout/multihashmap.hpp>
 #include <stout/option.hpp>
 #include <stout/recordio.hpp>
+#include <stout/unreachable.hpp>
 
 #include "common/http.hpp"
 #include "common/protobuf_utils.hpp"
@@ -66,13 +70,17 @@
 #include "internal/devolve.hpp"
 #include "internal/evolve.hpp"
 
+#include "master/completed_tasks.hpp"
 #include "master/constants.hpp"
 #include "master/contender.hpp"
 #include "master/detector.hpp"
 #include "master/flags.hpp"
 #include "master/machine.hpp"
 #include "master/metrics.hpp"
+#include "master/offer_expiry.hpp"
 #include "master/registrar.hpp"
+#include "master/state_events.hpp"
+#include "master/task_index.hpp"
 #include "master/validation.hpp"
 
 #include "messages/messages.hpp"
@@ -97,6 +105,7 @@ class WhitelistWatcher;
 
 namespace master {
 
+class FrameworkThrottler;
 class Repairer;
 class SlaveObserver;
 
@@ -106,6 +115,83 @@ struct HttpConnection;
 struct Role;
 
 
+// The number of tasks in each 'TaskState'. Frameworks maintain these
+// per slave so that the '/state-summary' endpoint does not need to
+// look at every task.
+struct TaskStateSummary
+{
+  TaskStateSummary()
+    : staging(0),
+      starting(0),
+      running(0),
+      finished(0),
+      killed(0),
+      failed(0),
+      lost(0),
+      error(0) {}
+
+  // Accounts for a task in the given state.
+  void add(const TaskState& state)
+  {
+    ++count(state);
+  }
+
+  void remove(const TaskState& state)
+  {
+    CHECK_GT(count(state), 0u) << "No tasks in state " << state;
+    --count(state);
+  }
+
+  TaskStateSummary& operator+=(const TaskStateSummary& that)
+  {
+    staging += that.staging;
+    starting += that.starting;
+    running += that.running;
+    finished += that.finished;
+    killed += that.killed;
+    failed += that.failed;
+    lost += that.lost;
+    error += that.error;
+    return *this;
+  }
+
+  bool empty() const
+  {
+    return staging == 0 && starting == 0 && running == 0 &&
+      finished == 0 && killed == 0 && failed == 0 && lost == 0 &&
+      error == 0;
+  }
+
+  size_t staging;
+  size_t starting;
+  size_t running;
+  size_t finished;
+  size_t killed;
+  size_t failed;
+  size_t lost;
+  size_t error;
+
+private:
+  size_t& count(const TaskState& state)
+  {
+    switch (state) {
+      case TASK_STAGING: return staging;
+      case TASK_STARTING: return starting;
+      case TASK_RUNNING: return running;
+      case TASK_FINISHED: return finished;
+      case TASK_KILLED: return killed;
+      case TASK_FAILED: return failed;
+      case TASK_LOST: return lost;
+      case TASK_ERROR: return error;
+      // No default case allows for a helpful compiler error if we
+      // introduce a new state.
+    }
+
+    UNREACHABLE();
+  }
+};
+
+
 struct Slave
 {
   Slave(const SlaveInfo& _info,
@@ -151,6 +237,16 @@ struct Slave
 
   ~Slave() {}
 
+  bool hasCapability(const SlaveCapability::Type& type) const
+  {
+    foreach (const SlaveCapability& capability, capabilities) {
+      if (capability.type() == type) {
+        return true;
+      }
+    }
+    return false;
+  }
+
   Task* getTask(const FrameworkID& frameworkId, const TaskID& taskId)
   {
     if (tasks.contains(frameworkId) && tasks[frameworkId].contains(taskId)) {
@@ -170,6 +266,7 @@ struct Slave
     tasks[frameworkId][taskId] = task;
 
     if (!protobuf::isTerminalState(task->state())) {
+      totalUsedResources += task->resources();
       usedResources[frameworkId] += task->resources();
     }
 
@@ -191,6 +288,7 @@ struct Slave
     CHECK(tasks[frameworkId].contains(taskId))
       << "Unknown task " << taskId << " of framework " << frameworkId;
 
+    totalUsedResources -= task->resources();
     usedResources[frameworkId] -= task->resources();
     if (!tasks.contains(frameworkId) && !executors.contains(frameworkId)) {
       usedResources.erase(frameworkId);
@@ -206,6 +304,7 @@ struct Slave
       << "Unknown task " << taskId << " of framework " << frameworkId;
 
     if (!protobuf::isTerminalState(task->state())) {
+      totalUsedResources -= task->resources();
       usedResources[frameworkId] -= task->resources();
       if (!tasks.contains(frameworkId) && !executors.contains(frameworkId)) {
         usedResources.erase(frameworkId);
@@ -267,6 +366,7 @@ struct Slave
       << "' of framework " << frameworkId;
 
     executors[frameworkId][executorInfo.executor_id()] = executorInfo;
+    totalUsedResources += executorInfo.resources();
     usedResources[frameworkId] += executorInfo.resources();
   }
 
@@ -276,6 +376,7 @@ struct Slave
     CHECK(hasExecutor(frameworkId, executorId))
       << "Unknown executor '" << executorId << "' of framework " << frameworkId;
 
+    totalUsedResources -= executors[frameworkId][executorId].resources();
     usedResources[frameworkId] -=
       executors[frameworkId][executorId].resources();
 
@@ -317,6 +418,10 @@ struct Slave
   // No offers will be made for a deactivated slave.
   bool active;
 
+  // The capabilities of the slave that the master supports as well
+  // (see 'SlaveCapability'), updated when the slave (re-)registers.
+  std::vector<SlaveCapability> capabilities;
+
   // Executors running on this slave.
   hashmap<FrameworkID, hashmap<ExecutorID, ExecutorInfo>> executors;
 
@@ -324,7 +429,7 @@ struct Slave
   // TODO(bmahler): The task pointer ownership complexity arises from the fact
   // that we own the pointer here, but it's shared with the Framework struct.
   // We should find a way to eliminate this.
-  hashmap<FrameworkID, hashmap<TaskID, Task*>> tasks;
+  hashmap<FrameworkID, flathashmap<TaskID, Task*>> tasks;
 
   // Tasks that were asked to kill by frameworks.
   // This is used for reconciliation when the slave re-registers.
@@ -336,7 +441,11 @@ struct Slave
   // Active inverse offers on this slave.
   hashset<InverseOffer*> inverseOffers;
 
-  hashmap<FrameworkID, Resources> usedResources;  // Active task / executors.
+  // Active task / executors. We keep a running total since summing
+  // the resources of all frameworks is expensive (see 'Framework').
+  Resources totalUsedResources;
+  hashmap<FrameworkID, Resources> usedResources;
+
   Resources offeredResources; // Offers.
 
   // Resources that should be checkpointed by the slave (e.g.,
@@ -450,16 +559,14 @@ public:
       const process::UPID& from,
       const SlaveInfo& slaveInfo,
       const std::vector<Resource>& checkpointedResources,
-      const std::string& version);
+      const std::string& version,
+      const std::vector<SlaveCapability>& capabilities);
 
+  // NOTE: This takes the whole message since it has more fields
+  // than 'ProtobufProcess::install' can pass as arguments.
   void reregisterSlave(
       const process::UPID& from,
-      const SlaveInfo& slaveInfo,
-      const std::vector<Resource>& checkpointedResources,
-      const std::vector<ExecutorInfo>& executorInfos,
-      const std::vector<Task>& tasks,
-      const std::vector<Archive::Framework>& completedFrameworks,
-      const std::string& version);
+      const ReregisterSlaveMessage& message);
 
   void unregisterSlave(
       const process::UPID& from,
@@ -469,6 +576,12 @@ public:
       StatusUpdate update,
       const process::UPID& pid);
 
+  // Handles the batched status updates of a slave with the
+  // BATCHED_STATUS_UPDATES capability.
+  void statusUpdates(
+      const process::UPID& from,
+      const StatusUpdatesMessage& message);
+
   void reconcileTasks(
       const process::UPID& from,
       const FrameworkID& frameworkId,
@@ -537,6 +650,7 @@ public:
       const std::vector<Task>& tasks,
       const std::vector<Archive::Framework>& completedFrameworks,
       const std::string& version,
+      const std::vector<SlaveCapability>& capabilities,
       const process::Future<bool>& readmit);
 
   MasterInfo info() const
@@ -550,18 +664,31 @@ protected:
 
   virtual void visit(const process::MessageEvent& event);
   virtual void visit(const process::ExitedEvent& event);
+  virtual void visit(const process::DispatchEvent& event);
+  virtual void visit(const process::HttpEvent& event);
 
   virtual void exited(const process::UPID& pid);
   void exited(const FrameworkID& frameworkId, const HttpConnection& http);
   void _exited(Framework* framework);
 
-  // Invoked when the message is ready to be executed after
-  // being throttled.
-  // 'principal' being None indicates it is throttled by
-  // 'defaultLimiter'.
-  void throttled(
+  // Invoked when a throttled message from a framework of the given
+  // principal is admitted, after waiting for 'latency' (see
+  // 'FrameworkThrottler'), in order to process it.
+  void admitted(
       const process::MessageEvent& event,
-      const Option<std::string>& principal);
+      const Option<std::string>& principal,
+      const Duration& latency);
+
+  // Invoked when the 'FrameworkThrottler' admits an event that was
+  // handed over to it by the limiter.
+  void released(
+      BoundedRateLimiter* limiter,
+      const process::MessageEvent& event,
+      const Option<std::string>& principal,
+      const Duration& latency);
+  void released(
+      BoundedRateLimiter* limiter,
+      const process::ExitedEvent& event);
 
   // Continuations of visit().
   void _visit(const process::MessageEvent& event);
@@ -570,6 +697,7 @@ protected:
   // Helper method invoked when the capacity for a framework
   // principal is exceeded.
   void exceededCapacity(
+      BoundedRateLimiter* limiter,
       const process::MessageEvent& event,
       const Option<std::string>& principal,
       uint64_t capacity);
@@ -583,12 +711,41 @@ protected:
       const process::UPID& pid,
       const std::vector<Resource>& checkpointedResources,
       const std::string& version,
+      const std::vector<SlaveCapability>& capabilities,
       const process::Future<bool>& admit);
 
   void __reregisterSlave(
       Slave* slave,
       const std::vector<Task>& tasks);
 
+  // Returns the connection parameters (including the negotiated
+  // capabilities) that are sent to a (re-)registered slave.
+  MasterSlaveConnection connection(const Slave* slave) const;
+
+  // A re-registration of a slave with a failed over master that is
+  // waiting to be validated and readmitted.
+  struct Reregistration
+  {
+    SlaveInfo slaveInfo;
+    process::UPID pid;
+    std::vector<Resource> checkpointedResources;
+    std::vector<ExecutorInfo> executorInfos;
+    std::vector<Task> tasks;
+    std::vector<Archive::Framework> completedFrameworks;
+    std::string version;
+    std::vector<SlaveCapability> capabilities;
+  };
+
+  // Validates the pending re-registrations (without blocking the
+  // master) and readmits the valid ones with a single registrar
+  // operation. Every re-registration in the batch then continues
+  // with '_reregisterSlave'.
+  void readmitSlaves();
+
+  void _readmitSlaves(
+      const process::Owned<std::vector<Reregistration>>& reregistrations,
+      const process::Future<std::vector<Option<Error>>>& validations);
+
   // 'authenticate' is the future returned by the authenticator.
   void _authenticate(
       const process::UPID& pid,
@@ -677,10 +834,11 @@ protected:
   process::Future<bool> authorizeFramework(
       const FrameworkInfo& frameworkInfo);
 
-  // Returns whether the task is authorized.
+  // Returns whether each task is authorized, using a single request
+  // to the authorizer for all the tasks.
   // Returns failure for transient authorization failures.
-  process::Future<bool> authorizeTask(
-      const TaskInfo& task,
+  process::Future<std::vector<bool>> authorizeTasks(
+      const std::vector<TaskInfo>& tasks,
       Framework* framework);
 
   // Add the task and its executor (if not already running) to the
@@ -726,19 +884,30 @@ protected:
       const process::UPID& acknowledgee,
       Framework* framework);
 
-  // Remove an offer after specified timeout
-  void offerTimeout(const OfferID& offerId);
+  // Sends the status updates and acknowledgements that were batched
+  // for frameworks and slaves with the BATCHED_STATUS_UPDATES
+  // capability (see 'forward' and 'acknowledge').
+  void sendStatusUpdates();
+
+  // Arms the timer for the next sweep of the expired offers and
+  // inverse offers, unless one is already pending.
+  void scheduleExpiry();
+
+  // Rescinds all the offers and inverse offers whose timeout has
+  // elapsed, grouped by framework.
+  void expire();
 
   // Remove an offer and optionally rescind the offer as well.
   void removeOffer(Offer* offer, bool rescind = false);
 
-  // Remove an inverse offer after specified timeout
-  void inverseOfferTimeout(const OfferID& inverseOfferId);
-
   // Remove an inverse offer and optionally rescind it as well.
   void removeInverseOffer(InverseOffer* inverseOffer, bool rescind = false);
 
   Framework* getFramework(const FrameworkID& frameworkId);
+
+  // Returns a snapshot of the agents, frameworks and tasks for the
+  // subscribers of '/events'.
+  StateEvent snapshot() const;
   Offer* getOffer(const OfferID& offerId);
   InverseOffer* getInverseOffer(const OfferID& inverseOfferId);
 
@@ -795,7 +964,7 @@ private:
     const SlaveID& slaveId,
     const Resources& offeredResources,
     const scheduler::Call::Accept& accept,
-    const process::Future<std::list<process::Future<bool>>>& authorizations);
+    const process::Future<std::vector<bool>>& authorizations);
 
   void decline(
       Framework* framework,
@@ -815,6 +984,10 @@ private:
       Framework* framework,
       const scheduler::Call::Acknowledge& acknowledge);
 
+  void acknowledge(
+      Framework* framework,
+      const scheduler::Call::AcknowledgeUpdates& acknowledgeUpdates);
+
   void reconcile(
       Framework* framework,
       const scheduler::Call::Reconcile& reconcile);
@@ -937,6 +1110,10 @@ private:
     process::Future<process::http::Response> destroyVolumes(
         const process::http::Request& request) const;
 
+    // /master/events
+    process::Future<process::http::Response> events(
+        const process::http::Request& request) const;
+
     // /master/flags
     process::Future<process::http::Response> flags(
         const process::http::Request& request) const;
@@ -1010,6 +1187,7 @@ private:
         const process::http::Request& request) const;
 
     static std::string SCHEDULER_HELP();
+    static std::string EVENTS_HELP();
     static std::string FLAGS_HELP();
     static std::string FRAMEWORKS();
     static std::string HEALTH_HELP();
@@ -1038,6 +1216,16 @@ private:
     Result<Credential> authenticate(
         const process::http::Request& request) const;
 
+    // Model the current state for the endpoints served from the
+    // 'stateResponses' of the master. The endpoints that model the
+    // frameworks publish snapshots of the state instead, which are
+    // modeled outside of the master.
+    StateResponses::Model _frameworks() const;
+    JSON::Object _roles() const;
+    JSON::Object _slaves() const;
+    StateResponses::Model _state() const;
+    JSON::Object _stateSummary() const;
+
     // Continuations.
     process::Future<process::http::Response> _teardown(
         const FrameworkID& id,
@@ -1120,9 +1308,20 @@ private:
   // master is elected as a leader.
   Option<process::Future<Nothing>> recovered;
 
+  // The status updates and acknowledgements that are batched for
+  // frameworks and slaves with the BATCHED_STATUS_UPDATES capability.
+  // 'sendStatusUpdates' is dispatched when the first of them is
+  // batched, so a batch covers everything the master handles before
+  // the dispatch runs.
+  struct
+  {
+    hashmap<FrameworkID, StatusUpdatesMessage> updates;
+    hashmap<SlaveID, StatusUpdateAcknowledgementsMessage> acknowledgements;
+  } batched;
+
   struct Slaves
   {
-    Slaves() : removed(MAX_REMOVED_SLAVES) {}
+    Slaves() : readmitting(false), removed(MAX_REMOVED_SLAVES) {}
 
     // Imposes a time limit for slaves that we recover from the
     // registry to re-register with the master.
@@ -1141,9 +1340,17 @@ private:
     // these slaves until the registrar determines their fate.
     hashset<SlaveID> reregistering;
 
+    // The re-registrations that have not been handed to
+    // 'readmitSlaves' yet, and whether it has been dispatched. Since
+    // it is dispatched after the first such re-registration, all the
+    // re-registrations queued for the master by then are readmitted
+    // together.
+    std::vector<Reregistration> readmissions;
+    bool readmitting;
+
     // Registered slaves are indexed by SlaveID and UPID. Note that
     // iteration is supported but is exposed as iteration over a
-    // hashmap<SlaveID, Slave*> since it is tedious to convert
+    // flathashmap<SlaveID, Slave*> since it is tedious to convert
     // the map's key/value iterator into a value iterator.
     //
     // TODO(bmahler): Consider pulling in boost's multi_index,
@@ -1192,8 +1399,8 @@ private:
 
       size_t size() const { return ids.size(); }
 
-      typedef hashmap<SlaveID, Slave*>::iterator iterator;
-      typedef hashmap<SlaveID, Slave*>::const_iterator const_iterator;
+      typedef flathashmap<SlaveID, Slave*>::iterator iterator;
+      typedef flathashmap<SlaveID, Slave*>::const_iterator const_iterator;
 
       iterator begin() { return ids.begin(); }
       iterator end()   { return ids.end();   }
@@ -1202,8 +1409,8 @@ private:
       const_iterator end()   const { return ids.end();   }
 
     private:
-      hashmap<SlaveID, Slave*> ids;
-      hashmap<process::UPID, Slave*> pids;
+      flathashmap<SlaveID, Slave*> ids;
+      flathashmap<process::UPID, Slave*> pids;
     } registered;
 
     // Slaves that are in the process of being removed from the
@@ -1241,11 +1448,30 @@ private:
     }
   } slaves;
 
+  // Running and completed tasks of the registered and completed
+  // frameworks, ordered for the '/tasks' endpoint. This is maintained
+  // by 'Framework' and declared before 'frameworks' so that it
+  // outlives the completed frameworks.
+  TaskIndex taskIndex;
+
+  // The responses of '/frameworks', '/roles', '/slaves', '/state'
+  // and '/state-summary'. The state may change with every handled
+  // message, exit and dispatch as well as HTTP requests other than
+  // GETs (see 'visit').
+  StateResponses stateResponses;
+
+  // The subscribers of '/events', which are sent the changes of the
+  // agents, frameworks and tasks after every handled event.
+  StateEvents stateEvents;
+
   struct Frameworks
   {
-    Frameworks() : completed(MAX_COMPLETED_FRAMEWORKS) {}
+    Frameworks()
+      : completed(MAX_COMPLETED_FRAMEWORKS),
+        defaultLimiter(NULL),
+        throttler(NULL) {}
 
-    hashmap<FrameworkID, Framework*> registered;
+    flathashmap<FrameworkID, Framework*> registered;
     boost::circular_buffer<std::shared_ptr<Framework>> completed;
 
     // Principals of frameworks keyed by PID.
@@ -1259,21 +1485,37 @@ private:
     //    FrameworkInfo.
     hashmap<process::UPID, Option<std::string>> principals;
 
-    // BoundedRateLimiters keyed by the framework principal.
-    // Like Metrics::Frameworks, all frameworks of the same principal
-    // are throttled together at a common rate limit.
-    hashmap<std::string, Option<process::Owned<BoundedRateLimiter>>> limiters;
-
-    // The default limiter is for frameworks not specified in
-    // 'flags.rate_limits'.
-    Option<process::Owned<BoundedRateLimiter>> defaultLimiter;
+    // The limiters of the principals specified in
+    // 'flags.rate_limits', NULL if their frameworks are not throttled
+    // (i.e., if 'qps' is not set). Like Metrics::Frameworks, all
+    // frameworks of the same principal are throttled together at a
+    // common rate limit.
+    hashmap<std::string, BoundedRateLimiter*> limiters;
+
+    // The limiter of the frameworks not specified in
+    // 'flags.rate_limits', NULL if they are not throttled.
+    BoundedRateLimiter* defaultLimiter;
+
+    // Admits the messages and exited events of the throttled
+    // frameworks that exceed the rate of their limiter, which it
+    // owns. NULL if 'flags.rate_limits' is not set.
+    FrameworkThrottler* throttler;
   } frameworks;
 
   hashmap<OfferID, Offer*> offers;
-  hashmap<OfferID, process::Timer> offerTimers;
-
   hashmap<OfferID, InverseOffer*> inverseOffers;
-  hashmap<OfferID, process::Timer> inverseOfferTimers;
+
+  // The deadlines of the offers and inverse offers when
+  // '--offer_timeout' is set. A single timer is armed for the next
+  // sweep, which happens at most once per 'OFFER_EXPIRY_INTERVAL'.
+  struct
+  {
+    OfferExpiry offers;
+    OfferExpiry inverseOffers;
+
+    Option<process::Timer> timer;
+    Option<process::Time> swept;
+  } expiry;
 
   hashmap<std::string, Role*> roles;
 
@@ -1440,6 +1682,55 @@ private:
 };
 
 
+// Implementation of the readmission of many slaves as a single
+// Registrar operation. Unlike 'ReadmitSlave' an unknown slave does
+// not fail the whole operation; the slaves that were readmitted can
+// be queried once the operation has completed.
+class ReadmitSlaves : public Operation
+{
+public:
+  explicit ReadmitSlaves(const std::vector<SlaveInfo>& _infos)
+    : infos(_infos)
+  {
+    foreach (const SlaveInfo& info, infos) {
+      CHECK(info.has_id()) << "SlaveInfo is missing the 'id' field";
+    }
+  }
+
+  bool readmitted(const SlaveID& slaveId) const
+  {
+    return readmitted_.contains(slaveId);
+  }
+
+protected:
+  virtual Try<bool> perform(
+      Registry* registry,
+      hashset<SlaveID>* slaveIDs,
+      bool strict)
+  {
+    bool mutation = false;
+
+    foreach (const SlaveInfo& info, infos) {
+      if (slaveIDs->contains(info.id())) {
+        readmitted_.insert(info.id());
+      } else if (!strict) {
+        Registry::Slave* slave = registry->mutable_slaves()->add_slaves();
+        slave->mutable_info()->CopyFrom(info);
+        slaveIDs->insert(info.id());
+        readmitted_.insert(info.id());
+        mutation = true;
+      }
+    }
+
+    return mutation;
+  }
+
+private:
+  const std::vector<SlaveInfo> infos;
+  hashset<SlaveID> readmitted_;
+};
+
+
 // Implementation of slave removal Registrar operation.
 class RemoveSlave : public Operation
 {
@@ -1572,7 +1863,9 @@ struct Framework
       active(true),
       registeredTime(time),
       reregisteredTime(time),
-      completedTasks(MAX_COMPLETED_TASKS_PER_FRAMEWORK) {}
+      completedTasks(
+          MAX_COMPLETED_TASKS_PER_FRAMEWORK,
+          master->flags.max_completed_tasks_memory_per_framework) {}
 
   Framework(Master* const _master,
             const FrameworkInfo& _info,
@@ -1585,22 +1878,30 @@ struct Framework
       active(true),
       registeredTime(time),
       reregisteredTime(time),
-      completedTasks(MAX_COMPLETED_TASKS_PER_FRAMEWORK) {}
+      completedTasks(
+          MAX_COMPLETED_TASKS_PER_FRAMEWORK,
+          master->flags.max_completed_tasks_memory_per_framework) {}
 
   ~Framework()
   {
     if (http.isSome()) {
       closeHttpConnection();
     }
+
+    foreachvalue (Task* task, tasks) {
+      master->taskIndex.remove(task);
+    }
+
+    foreach (const CompletedTask& task, completedTasks) {
+      master->taskIndex.remove(&task);
+    }
   }
 
   Task* getTask(const TaskID& taskId)
   {
-    if (tasks.count(taskId) > 0) {
-      return tasks[taskId];
-    }
+    auto task = tasks.find(taskId);
 
-    return NULL;
+    return task != tasks.end() ? task->second : NULL;
   }
 
   void addTask(Task* task)
@@ -1611,6 +1912,11 @@ struct Framework
 
     tasks[task->task_id()] = task;
 
+    master->taskIndex.add(task);
+    master->stateEvents.taskAdded(*task);
+
+    taskStateSummaries[task->slave_id()].add(task->state());
+
     if (!protobuf::isTerminalState(task->state())) {
       totalUsedResources += task->resources();
       usedResources[task->slave_id()] += task->resources();
@@ -1658,7 +1964,51 @@ struct Framework
   void addCompletedTask(const Task& task)
   {
     // TODO(adam-mesos): Check if completed task already exists.
-    completedTasks.push_back(std::shared_ptr<Task>(new Task(task)));
+    completedTasks.push_back(task);
+
+    master->taskIndex.add(&completedTasks.back());
+
+    taskStateSummaries[task.slave_id()].add(task.state());
+
+    while (completedTasks.exceeded()) {
+      const CompletedTask& evicted = completedTasks.front();
+
+      master->taskIndex.remove(&evicted);
+      removeTaskState(evicted.slave_id(), evicted.state());
+
+      completedTasks.pop_front();
+    }
+  }
+
+  // Updates the state of one of the (active) tasks of this framework.
+  void updateTaskState(Task* task, const TaskState& state)
+  {
+    CHECK(tasks.contains(task->task_id()))
+      << "Unknown task " << task->task_id()
+      << " of framework " << task->framework_id();
+
+    removeTaskState(task->slave_id(), task->state());
+    task->set_state(state);
+    taskStateSummaries[task->slave_id()].add(task->state());
+  }
+
+  void addPendingTask(const TaskInfo& task)
+  {
+    CHECK(!pendingTasks.contains(task.task_id()))
+      << "Duplicate pending task " << task.task_id()
+      << " of framework " << id();
+
+    pendingTasks[task.task_id()] = task;
+    taskStateSummaries[task.slave_id()].add(TASK_STAGING);
+  }
+
+  void removePendingTask(const TaskID& taskId)
+  {
+    CHECK(pendingTasks.contains(taskId))
+      << "Unknown pending task " << taskId << " of framework " << id();
+
+    removeTaskState(pendingTasks[taskId].slave_id(), TASK_STAGING);
+    pendingTasks.erase(taskId);
   }
 
   void removeTask(Task* task)
@@ -1675,6 +2025,11 @@ struct Framework
       }
     }
 
+    master->taskIndex.remove(task);
+    master->stateEvents.taskRemoved(*task);
+
+    removeTaskState(task->slave_id(), task->state());
+
     addCompletedTask(*task);
 
     tasks.erase(task->task_id());
@@ -1823,6 +2178,8 @@ struct Framework
     } else {
       info.clear_labels();
     }
+
+    master->stateEvents.frameworkUpdated(info);
   }
 
   void updateConnection(const process::UPID& newPid)
@@ -1918,12 +2275,10 @@ struct Framework
   // being authorized.
   hashmap<TaskID, TaskInfo> pendingTasks;
 
-  hashmap<TaskID, Task*> tasks;
+  flathashmap<TaskID, Task*> tasks;
 
-  // NOTE: We use a shared pointer for Task because clang doesn't like
-  // Boost's implementation of circular_buffer with Task (Boost
-  // attempts to do some memset's which are unsafe).
-  boost::circular_buffer<std::shared_ptr<Task>> completedTasks;
+  // The completed tasks are kept serialized, see 'CompletedTasks'.
+  CompletedTasks completedTasks;
 
   hashset<Offer*> offers; // Active offers for framework.
 
@@ -1961,10 +2316,26 @@ struct Framework
   Resources totalOfferedResources;
   hashmap<SlaveID, Resources> offeredResources;
 
+  // The states of the pending, active and completed tasks, by slave.
+  // A slave is only present if the framework has such tasks on it.
+  hashmap<SlaveID, TaskStateSummary> taskStateSummaries;
+
   // This is only set for HTTP frameworks.
   Option<process::Owned<Heartbeater>> heartbeater;
 
 private:
+  void removeTaskState(const SlaveID& slaveId, const TaskState& state)
+  {
+    CHECK(taskStateSummaries.contains(slaveId))
+      << "No tasks on slave " << slaveId << " for framework " << id();
+
+    taskStateSummaries[slaveId].remove(state);
+
+    if (taskStateSummaries[slaveId].empty()) {
+      taskStateSummaries.erase(slaveId);
+    }
+  }
+
   Framework(const Framework&);              // No copying.
   Framework& operator=(const Framework&); // No assigning.
 };
@@ -23,7 +23,9 @@
 #include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
 #include <process/metrics/metrics.hpp>
+#include <process/metrics/timer.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
 
 #include "mesos/mesos.hpp"
@@ -98,18 +100,27 @@ struct Metrics
     // requested by this message has finished.
     process::metrics::Counter messages_processed;
 
+    // Time framework messages wait for the RateLimiter (if one is
+    // configured for this principal) before they are processed.
+    process::metrics::Timer<Milliseconds> message_admission;
+
     explicit Frameworks(const std::string& principal)
       : messages_received("frameworks/" + principal + "/messages_received"),
-        messages_processed("frameworks/" + principal + "/messages_processed")
+        messages_processed("frameworks/" + principal + "/messages_processed"),
+        message_admission(
+            "frameworks/" + principal + "/message_admission",
+            Minutes(5))
     {
       process::metrics::add(messages_received);
       process::metrics::add(messages_processed);
+      process::metrics::add(message_admission);
     }
 
     ~Frameworks()
     {
       process::metrics::remove(messages_received);
       process::metrics::remove(messages_processed);
+      process::metrics::remove(message_admission);
     }
   };
 
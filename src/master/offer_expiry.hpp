@@ -0,0 +1,107 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MESOS_MASTER_OFFER_EXPIRY_HPP__
+#define __MESOS_MASTER_OFFER_EXPIRY_HPP__
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <mesos/mesos.hpp>
+#include <mesos/type_utils.hpp>
+
+#include <process/time.hpp>
+
+#include <stout/hashmap.hpp>
+#include <stout/none.hpp>
+#include <stout/option.hpp>
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// The deadlines of the outstanding offers (or inverse offers). The
+// master expires the offers in bulk, by periodically sweeping the
+// offers whose deadline has passed, instead of arming a timer for
+// every offer.
+//
+// The deadlines are kept ordered rather than assumed to be added in
+// order: they are derived from 'Clock::now()', which can go backwards
+// (e.g., when the system clock is stepped, or a paused clock is
+// resumed in tests). Each outstanding offer maps to its entry so that
+// removing an offer before its deadline is cheap.
+class OfferExpiry
+{
+public:
+  void add(const OfferID& offerId, const process::Time& deadline)
+  {
+    remove(offerId);
+
+    outstanding[offerId] = deadlines.insert(std::make_pair(deadline, offerId));
+  }
+
+  void remove(const OfferID& offerId)
+  {
+    if (outstanding.contains(offerId)) {
+      deadlines.erase(outstanding[offerId]);
+      outstanding.erase(offerId);
+    }
+  }
+
+  // Removes and returns the offers whose deadline is at or before
+  // 'now', in the order of their deadlines.
+  std::vector<OfferID> expire(const process::Time& now)
+  {
+    std::vector<OfferID> expired;
+
+    while (!deadlines.empty() && deadlines.begin()->first <= now) {
+      const OfferID offerId = deadlines.begin()->second;
+
+      outstanding.erase(offerId);
+      deadlines.erase(deadlines.begin());
+
+      expired.push_back(offerId);
+    }
+
+    return expired;
+  }
+
+  // The earliest deadline of the outstanding offers, if any.
+  Option<process::Time> next() const
+  {
+    if (deadlines.empty()) {
+      return None();
+    }
+
+    return deadlines.begin()->first;
+  }
+
+  size_t size() const { return outstanding.size(); }
+  bool empty() const { return outstanding.empty(); }
+
+private:
+  typedef std::multimap<process::Time, OfferID> Deadlines;
+
+  Deadlines deadlines;
+  hashmap<OfferID, Deadlines::iterator> outstanding;
+};
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MESOS_MASTER_OFFER_EXPIRY_HPP__
@@ -0,0 +1,209 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MESOS_MASTER_RANKED_SET_HPP__
+#define __MESOS_MASTER_RANKED_SET_HPP__
+
+#include <stdint.h>
+
+#include <functional>
+#include <random>
+
+#include <glog/logging.h>
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// A set of distinct elements ordered by 'Compare' whose elements can
+// also be looked up by their rank (i.e., their position in the
+// order), also known as an order statistic tree.
+//
+// The set is kept as a treap (a binary search tree that is balanced
+// by random priorities) whose nodes are augmented with the size of
+// their subtree, so inserting, erasing and looking up an element by
+// rank take (expected) logarithmic time.
+template <typename T, typename Compare = std::less<T>>
+class RankedSet
+{
+public:
+  RankedSet() : root(NULL) {}
+
+  ~RankedSet()
+  {
+    destroy(root);
+  }
+
+  size_t size() const
+  {
+    return size(root);
+  }
+
+  // Inserts the element, which must not be in the set yet.
+  void insert(const T& t)
+  {
+    Node* less;
+    Node* greater;
+    split(root, t, &less, &greater);
+
+    root = merge(merge(less, new Node(t, random())), greater);
+  }
+
+  // Erases the element if it is in the set.
+  void erase(const T& t)
+  {
+    root = erase(root, t);
+  }
+
+  // Returns the element of the given rank, which must be less than
+  // the size of the set.
+  const T& at(size_t rank) const
+  {
+    CHECK_LT(rank, size());
+
+    const Node* node = root;
+
+    while (true) {
+      const size_t left = size(node->left);
+
+      if (rank < left) {
+        node = node->left;
+      } else if (rank > left) {
+        rank -= left + 1;
+        node = node->right;
+      } else {
+        return node->value;
+      }
+    }
+  }
+
+private:
+  struct Node
+  {
+    Node(const T& _value, uint32_t _priority)
+      : value(_value),
+        priority(_priority),
+        size(1),
+        left(NULL),
+        right(NULL) {}
+
+    const T value;
+    const uint32_t priority;
+
+    // The number of elements in the subtree of the node.
+    size_t size;
+
+    Node* left;
+    Node* right;
+  };
+
+  static size_t size(const Node* node)
+  {
+    return node == NULL ? 0 : node->size;
+  }
+
+  static void resize(Node* node)
+  {
+    node->size = 1 + size(node->left) + size(node->right);
+  }
+
+  // Splits the tree into the elements that are less than 't' and the
+  // others.
+  static void split(Node* node, const T& t, Node** less, Node** greater)
+  {
+    if (node == NULL) {
+      *less = NULL;
+      *greater = NULL;
+      return;
+    }
+
+    if (Compare()(node->value, t)) {
+      split(node->right, t, &node->right, greater);
+      *less = node;
+    } else {
+      split(node->left, t, less, &node->left);
+      *greater = node;
+    }
+
+    resize(node);
+  }
+
+  // Merges two trees, all elements of 'left' must be less than those
+  // of 'right'.
+  static Node* merge(Node* left, Node* right)
+  {
+    if (left == NULL) {
+      return right;
+    }
+
+    if (right == NULL) {
+      return left;
+    }
+
+    if (left->priority > right->priority) {
+      left->right = merge(left->right, right);
+      resize(left);
+      return left;
+    }
+
+    right->left = merge(left, right->left);
+    resize(right);
+    return right;
+  }
+
+  static Node* erase(Node* node, const T& t)
+  {
+    if (node == NULL) {
+      return NULL;
+    }
+
+    if (Compare()(t, node->value)) {
+      node->left = erase(node->left, t);
+    } else if (Compare()(node->value, t)) {
+      node->right = erase(node->right, t);
+    } else {
+      Node* merged = merge(node->left, node->right);
+      delete node;
+      return merged;
+    }
+
+    resize(node);
+    return node;
+  }
+
+  static void destroy(Node* node)
+  {
+    if (node != NULL) {
+      destroy(node->left);
+      destroy(node->right);
+      delete node;
+    }
+  }
+
+  RankedSet(const RankedSet&); // Not copyable.
+  RankedSet& operator=(const RankedSet&); // Not assignable.
+
+  Node* root;
+
+  // Generates the priorities of the nodes.
+  std::minstd_rand random;
+};
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MESOS_MASTER_RANKED_SET_HPP__
@@ -14,11 +14,15 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <deque>
+#include <list>
+#include <set>
 #include <string>
 
 #include <mesos/type_utils.hpp>
 
+#include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
@@ -32,12 +36,15 @@
 #include <process/metrics/metrics.hpp>
 #include <process/metrics/timer.hpp>
 
+#include <stout/hashmap.hpp>
 #include <stout/lambda.hpp>
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
+#include <stout/numify.hpp>
 #include <stout/option.hpp>
 #include <stout/protobuf.hpp>
 #include <stout/stopwatch.hpp>
+#include <stout/strings.hpp>
 
 #include "master/registrar.hpp"
 #include "master/registry.hpp"
@@ -68,6 +75,8 @@ using process::metrics::Gauge;
 using process::metrics::Timer;
 
 using std::deque;
+using std::list;
+using std::set;
 using std::string;
 
 namespace mesos {
@@ -84,8 +93,16 @@ public:
     : ProcessBase(process::ID::generate("registrar")),
       metrics(*this),
       updating(false),
+      deltaBytes(0),
+      nextDelta(0),
+      expunging(true),
       flags(_flags),
-      state(_state) {}
+      state(_state)
+  {
+    if (flags.numa_node.isSome()) {
+      prefer(process::Affinity::node(flags.numa_node.get()));
+    }
+  }
 
   virtual ~RegistrarProcess() {}
 
@@ -169,8 +186,8 @@ private:
 
   Future<double> _registry_size_bytes()
   {
-    if (variable.isSome()) {
-      return variable.get().get().ByteSize();
+    if (current.isSome()) {
+      return current.get().ByteSize();
     }
 
     return Failure("Not recovered yet");
@@ -180,22 +197,59 @@ private:
   void _recover(
       const MasterInfo& info,
       const Future<Variable<Registry> >& recovery);
-  void __recover(const Future<bool>& recover);
+  void __recover(
+      const MasterInfo& info,
+      const Future<list<Variable<RegistryDelta> > >& recovery);
+  void ___recover(const Future<bool>& recover);
   Future<bool> _apply(Owned<Operation> operation);
 
+  // Fetches the deltas stored since the last snapshot, in order.
+  Future<list<Variable<RegistryDelta> > > fetch(const set<string>& names);
+
   // Helper for updating state (performing store).
   void update();
   void _update(
-      const Future<Option<Variable<Registry> > >& store,
+      const Future<bool>& store,
+      const Registry& registry,
       deque<Owned<Operation> > operations);
 
+  // Continuations of 'update' for storing a delta or a new snapshot,
+  // returning false on a version mismatch.
+  bool _append(const Option<Variable<RegistryDelta> >& store);
+  bool compact(const Option<Variable<Registry> >& store);
+
+  // Expunges the delta with the given sequence number once it has
+  // been compacted into a snapshot, fetching it first if it is not
+  // given (see 'fetch'). A failure is logged rather than propagated,
+  // so that it does not keep the following deltas from being expunged.
+  Future<bool> expunge(
+      uint64_t sequence,
+      const Option<Variable<RegistryDelta> >& delta);
+  Future<bool> _expunge(uint64_t sequence, const Future<bool>& expunged);
+
   // Fails all pending operations and transitions the Registrar
   // into an error state in which all subsequent operations will fail.
   // This ensures we don't attempt to re-acquire log leadership by
   // performing more State storage operations.
   void abort(const string& message);
 
-  Option<Variable<Registry> > variable;
+  // The latest registry, i.e., the snapshot with all deltas applied.
+  Option<Registry> current;
+
+  // The last stored snapshot of the registry.
+  Option<Variable<Registry> > snapshot;
+
+  // The deltas stored since the last snapshot, their total size and
+  // the sequence number of the next delta.
+  deque<Variable<RegistryDelta> > deltas;
+  size_t deltaBytes;
+  uint64_t nextDelta;
+
+  // Expunges the deltas that have been compacted into a snapshot, in
+  // order (see 'compact'). This only reclaims space, the deltas are
+  // ignored on recovery regardless (see 'Registry.next_delta').
+  Future<bool> expunging;
+
   deque<Owned<Operation> > operations;
   bool updating; // Used to signify fetching (recovering) or storing.
 
@@ -235,12 +289,147 @@ void fail(deque<Owned<Operation>>* operations, const string& message)
 }
 
 
+// Prefix of the names of the variables that hold the deltas, the
+// sequence number of the delta is appended.
+static const string DELTA_PREFIX = "registry_delta_";
+
+
+// Helper for comparing protobuf messages by their serialization.
+static bool equals(
+    const google::protobuf::Message& left,
+    const google::protobuf::Message& right)
+{
+  return left.SerializeAsString() == right.SerializeAsString();
+}
+
+
+// Returns the changes that turn the 'from' registry into 'to'.
+static RegistryDelta diff(const Registry& from, const Registry& to)
+{
+  RegistryDelta delta;
+
+  hashmap<SlaveID, const Registry::Slave*> slaves;
+  foreach (const Registry::Slave& slave, from.slaves().slaves()) {
+    slaves[slave.info().id()] = &slave;
+  }
+
+  foreach (const Registry::Slave& slave, to.slaves().slaves()) {
+    const Option<const Registry::Slave*> existing =
+      slaves.get(slave.info().id());
+
+    if (existing.isNone() || !(existing.get()->info() == slave.info())) {
+      delta.add_added_slaves()->CopyFrom(slave);
+    }
+
+    slaves.erase(slave.info().id());
+  }
+
+  foreachkey (const SlaveID& slaveId, slaves) {
+    delta.add_removed_slaves()->CopyFrom(slaveId);
+  }
+
+  if (!equals(from.master(), to.master())) {
+    delta.mutable_master()->CopyFrom(to.master());
+  }
+
+  if (!equals(from.machines(), to.machines())) {
+    delta.mutable_machines()->CopyFrom(to.machines());
+  }
+
+  RegistryDelta::Schedules schedules;
+  schedules.mutable_schedules()->CopyFrom(to.schedules());
+
+  RegistryDelta::Quotas quotas;
+  quotas.mutable_quotas()->CopyFrom(to.quotas());
+
+  {
+    RegistryDelta::Schedules previous;
+    previous.mutable_schedules()->CopyFrom(from.schedules());
+
+    if (!equals(previous, schedules)) {
+      delta.mutable_schedules()->CopyFrom(schedules);
+    }
+  }
+
+  {
+    RegistryDelta::Quotas previous;
+    previous.mutable_quotas()->CopyFrom(from.quotas());
+
+    if (!equals(previous, quotas)) {
+      delta.mutable_quotas()->CopyFrom(quotas);
+    }
+  }
+
+  return delta;
+}
+
+
+// Applies the deltas (in order) to the registry.
+//
+// NOTE: Every delta only sets slaves and fields to their new value,
+// so replaying deltas that are already part of the registry does not
+// change it, as long as all of the subsequent deltas are replayed as
+// well.
+static void replay(Registry* registry, const list<RegistryDelta>& deltas)
+{
+  // The latest value of every slave changed by the deltas, or none if
+  // the slave was removed.
+  hashmap<SlaveID, Option<Registry::Slave>> slaves;
+
+  foreach (const RegistryDelta& delta, deltas) {
+    foreach (const SlaveID& slaveId, delta.removed_slaves()) {
+      slaves[slaveId] = None();
+    }
+
+    foreach (const Registry::Slave& slave, delta.added_slaves()) {
+      slaves[slave.info().id()] = slave;
+    }
+
+    if (delta.has_master()) {
+      registry->mutable_master()->CopyFrom(delta.master());
+    }
+
+    if (delta.has_machines()) {
+      registry->mutable_machines()->CopyFrom(delta.machines());
+    }
+
+    if (delta.has_schedules()) {
+      registry->mutable_schedules()->CopyFrom(delta.schedules().schedules());
+    }
+
+    if (delta.has_quotas()) {
+      registry->mutable_quotas()->CopyFrom(delta.quotas().quotas());
+    }
+  }
+
+  if (slaves.empty()) {
+    return;
+  }
+
+  Registry::Slaves result;
+
+  foreach (const Registry::Slave& slave, registry->slaves().slaves()) {
+    if (!slaves.contains(slave.info().id())) {
+      result.add_slaves()->CopyFrom(slave);
+    }
+  }
+
+  foreachvalue (const Option<Registry::Slave>& slave, slaves) {
+    if (slave.isSome()) {
+      result.add_slaves()->CopyFrom(slave.get());
+    }
+  }
+
+  registry->mutable_slaves()->Swap(&result);
+}
+
+
 Future<Response> RegistrarProcess::registry(const Request& request)
 {
   JSON::Object result;
 
-  if (variable.isSome()) {
-    result = JSON::protobuf(variable.get().get());
+  if (current.isSome()) {
+    result = JSON::protobuf(current.get());
   }
 
   return OK(result, request.url.query.get("jsonp"));
@@ -326,6 +515,84 @@ Future<Registry> RegistrarProcess::recover(const MasterInfo& info)
 void RegistrarProcess::_recover(
     const MasterInfo& info,
     const Future<Variable<Registry> >& recovery)
+{
+  CHECK(!recovery.isPending());
+
+  if (!recovery.isReady()) {
+    updating = false;
+
+    recovered.get()->fail("Failed to recover registrar: " +
+        (recovery.isFailed() ? recovery.failure() : "discarded"));
+    return;
+  }
+
+  snapshot = recovery.get();
+
+  // Fetch the deltas that were stored since the snapshot.
+  state->names()
+    .then(defer(self(), &Self::fetch, lambda::_1))
+    .after(flags.registry_fetch_timeout,
+           lambda::bind(
+               &timeout<list<Variable<RegistryDelta> > >,
+               "fetch",
+               flags.registry_fetch_timeout,
+               lambda::_1))
+    .onAny(defer(self(), &Self::__recover, info, lambda::_1));
+}
+
+
+Future<list<Variable<RegistryDelta> > > RegistrarProcess::fetch(
+    const set<string>& names)
+{
+  // NOTE: 'set' orders the sequence numbers.
+  set<uint64_t> sequences;
+
+  foreach (const string& name, names) {
+    if (strings::startsWith(name, DELTA_PREFIX)) {
+      Try<uint64_t> sequence =
+        numify<uint64_t>(name.substr(DELTA_PREFIX.size()));
+
+      if (sequence.isError()) {
+        return Failure(
+            "Failed to parse the sequence number of '" + name + "': " +
+            sequence.error());
+      }
+
+      sequences.insert(sequence.get());
+    }
+  }
+
+  CHECK_SOME(snapshot);
+
+  // The deltas below 'next_delta' are already part of the snapshot,
+  // but were not expunged before a failover (see 'compact').
+  nextDelta = snapshot.get().get().next_delta();
+
+  list<Future<Variable<RegistryDelta> > > futures;
+  foreach (uint64_t sequence, sequences) {
+    const string name = DELTA_PREFIX + stringify(sequence);
+
+    if (sequence < nextDelta) {
+      expunging = expunging
+        .then(defer(self(), &Self::expunge, sequence, None()));
+
+      continue;
+    }
+
+    futures.push_back(state->fetch<RegistryDelta>(name));
+  }
+
+  if (!sequences.empty()) {
+    nextDelta = std::max(nextDelta, *sequences.rbegin() + 1);
+  }
+
+  return process::collect(futures);
+}
+
+
+void RegistrarProcess::__recover(
+    const MasterInfo& info,
+    const Future<list<Variable<RegistryDelta> > >& recovery)
 {
   updating = false;
 
@@ -337,25 +604,40 @@ void RegistrarProcess::_recover(
   } else {
     Duration elapsed = metrics.state_fetch.stop();
 
+    // Replay the deltas on top of the snapshot.
+    Registry registry = snapshot.get().get();
+    registry.clear_next_delta();
+
+    list<RegistryDelta> replayed;
+    foreach (const Variable<RegistryDelta>& delta, recovery.get()) {
+      deltas.push_back(delta);
+      deltaBytes += delta.get().ByteSize();
+      replayed.push_back(delta.get());
+    }
+
+    replay(&registry, replayed);
+
     LOG(INFO) << "Successfully fetched the registry"
-              << " (" << Bytes(recovery.get().get().ByteSize()) << ")"
+              << " (" << Bytes(snapshot.get().get().ByteSize()) << ")"
+              << " and " << deltas.size() << " deltas"
+              << " (" << Bytes(deltaBytes) << ")"
               << " in " << elapsed;
 
     // Save the registry.
-    variable = recovery.get();
+    current = registry;
 
     // Perform the Recover operation to add the new MasterInfo.
     Owned<Operation> operation(new Recover(info));
     operations.push_back(operation);
     operation->future()
-      .onAny(defer(self(), &Self::__recover, lambda::_1));
+      .onAny(defer(self(), &Self::___recover, lambda::_1));
 
     update();
   }
 }
 
 
-void RegistrarProcess::__recover(const Future<bool>& recover)
+void RegistrarProcess::___recover(const Future<bool>& recover)
 {
   CHECK(!recover.isPending());
 
@@ -369,11 +651,11 @@ void RegistrarProcess::__recover(const Future<bool>& recover)
   } else {
     LOG(INFO) << "Successfully recovered registrar";
 
-    // At this point _update() has updated 'variable' to contain
+    // At this point _update() has updated 'current' to contain
     // the Registry with the latest MasterInfo.
     // Set the promise and un-gate any pending operations.
-    CHECK_SOME(variable);
-    recovered.get()->set(variable.get().get());
+    CHECK_SOME(current);
+    recovered.get()->set(current.get());
   }
 }
 
@@ -395,7 +677,7 @@ Future<bool> RegistrarProcess::_apply(Owned<Operation> operation)
     return Failure(error.get());
   }
 
-  CHECK_SOME(variable);
+  CHECK_SOME(current);
 
   operations.push_back(operation);
   Future<bool> future = operation->future();
@@ -414,7 +696,8 @@ void RegistrarProcess::update()
 
   CHECK(!updating);
   CHECK_NONE(error);
-  CHECK_SOME(variable);
+  CHECK_SOME(current);
+  CHECK_SOME(snapshot);
 
   // Time how long it takes to apply the operations.
   Stopwatch stopwatch;
@@ -423,7 +706,7 @@ void RegistrarProcess::update()
   updating = true;
 
   // Create a snapshot of the current registry.
-  Registry registry = variable.get().get();
+  Registry registry = current.get();
 
   // Create the 'slaveIDs' accumulator.
   hashset<SlaveID> slaveIDs;
@@ -436,33 +719,143 @@ void RegistrarProcess::update()
     (*operation)(&registry, &slaveIDs, flags.registry_strict);
   }
 
+  const RegistryDelta delta = diff(current.get(), registry);
+
   LOG(INFO) << "Applied " << operations.size() << " operations in "
             << stopwatch.elapsed() << "; attempting to update the 'registry'";
 
   // Perform the store, and time the operation.
   metrics.state_store.start();
-  state->store(variable.get().mutate(registry))
+
+  // With '--registry_deltas', rather than storing the whole registry
+  // we store the changes made by the operations as a delta. Once the
+  // deltas would outgrow the registry we store a new snapshot instead,
+  // which bounds both the amount of data written per operation and
+  // the number of deltas that need to be replayed on recovery.
+  // Without it we always store the whole registry, which masters that
+  // do not know about deltas can read (see docs/upgrades.md).
+  Future<bool> store;
+
+  const size_t bytes = deltaBytes + delta.ByteSize();
+
+  if (!flags.registry_deltas ||
+      bytes > static_cast<size_t>(registry.ByteSize())) {
+    // The snapshot records which deltas it contains, so that the
+    // deltas that are not yet expunged on a failover are not replayed
+    // on top of it. If no delta was ever stored it is left unset.
+    Registry compacted = registry;
+    if (nextDelta > 0) {
+      compacted.set_next_delta(nextDelta);
+    }
+
+    store = state->store(snapshot.get().mutate(compacted))
+      .then(defer(self(), &Self::compact, lambda::_1));
+  } else {
+    // Every delta is stored under a new name. Rather than fetching the
+    // variable we create it, which can only be stored if no other
+    // master stored a delta with the same name in the meantime.
+    store = state->store(
+        state->create<RegistryDelta>(DELTA_PREFIX + stringify(nextDelta))
+          .mutate(delta))
+      .then(defer(self(), &Self::_append, lambda::_1));
+  }
+
+  store
     .after(flags.registry_store_timeout,
            lambda::bind(
-               &timeout<Option<Variable<Registry> > >,
+               &timeout<bool>,
                "store",
                flags.registry_store_timeout,
                lambda::_1))
-    .onAny(defer(self(), &Self::_update, lambda::_1, operations));
+    .onAny(defer(self(), &Self::_update, lambda::_1, registry, operations));
 
   // Clear the operations, _update will transition the Promises!
   operations.clear();
 }
 
 
+bool RegistrarProcess::_append(const Option<Variable<RegistryDelta> >& store)
+{
+  if (store.isNone()) {
+    return false;
+  }
+
+  deltas.push_back(store.get());
+  deltaBytes += store.get().get().ByteSize();
+  nextDelta++;
+
+  return true;
+}
+
+
+bool RegistrarProcess::compact(const Option<Variable<Registry> >& store)
+{
+  if (store.isNone()) {
+    return false;
+  }
+
+  snapshot = store.get();
+
+  // The deltas are now part of the snapshot. Since the snapshot
+  // records the sequence number of the next delta, the deltas left
+  // behind by a failure (or a failover) before they are expunged are
+  // ignored on recovery (and expunged then, see 'fetch'). The deltas
+  // are stored with consecutive sequence numbers up to 'nextDelta'.
+  uint64_t sequence = nextDelta - deltas.size();
+
+  while (!deltas.empty()) {
+    const Variable<RegistryDelta> delta = deltas.front();
+    deltas.pop_front();
+
+    expunging = expunging
+      .then(defer(self(), &Self::expunge, sequence++, delta));
+  }
+
+  deltaBytes = 0;
+
+  return true;
+}
+
+
+Future<bool> RegistrarProcess::expunge(
+    uint64_t sequence,
+    const Option<Variable<RegistryDelta> >& delta)
+{
+  Future<bool> expunged;
+
+  if (delta.isSome()) {
+    expunged = state->expunge(delta.get());
+  } else {
+    expunged = state->fetch<RegistryDelta>(DELTA_PREFIX + stringify(sequence))
+      .then(defer(self(), &Self::expunge, sequence, lambda::_1));
+  }
+
+  return expunged
+    .repair(defer(self(), &Self::_expunge, sequence, lambda::_1));
+}
+
+
+Future<bool> RegistrarProcess::_expunge(
+    uint64_t sequence,
+    const Future<bool>& expunged)
+{
+  LOG(WARNING) << "Failed to expunge registry delta "
+               << DELTA_PREFIX + stringify(sequence) << ": "
+               << expunged.failure();
+
+  return false;
+}
+
+
 void RegistrarProcess::_update(
-    const Future<Option<Variable<Registry> > >& store,
+    const Future<bool>& store,
+    const Registry& registry,
     deque<Owned<Operation> > applied)
 {
   updating = false;
 
   // Abort if the storage operation did not succeed.
-  if (!store.isReady() || store.get().isNone()) {
+  if (!store.isReady() || !store.get()) {
     string message = "Failed to update 'registry': ";
 
     if (store.isFailed()) {
@@ -483,7 +876,7 @@ void RegistrarProcess::_update(
 
   LOG(INFO) << "Successfully updated the 'registry' in " << elapsed;
 
-  variable = store.get().get();
+  current = registry;
 
   // Remove the operations.
   while (!applied.empty()) {
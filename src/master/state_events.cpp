@@ -0,0 +1,353 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <glog/logging.h>
+
+#include <process/clock.hpp>
+#include <process/defer.hpp>
+
+#include <stout/foreach.hpp>
+
+#include "common/http.hpp"
+
+#include "master/state_events.hpp"
+
+using process::Clock;
+using process::Future;
+using process::Owned;
+using process::Time;
+using process::UPID;
+
+using process::http::Pipe;
+
+using std::list;
+using std::shared_ptr;
+using std::string;
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+const size_t StateEvents::DEFAULT_CAPACITY = 10000;
+const Bytes StateEvents::DEFAULT_LIMIT = Megabytes(64);
+const Duration StateEvents::FLUSH_INTERVAL = Milliseconds(100);
+
+
+StateEvents::Subscriber::Subscriber(
+    const Pipe::Writer& _writer,
+    ContentType contentType)
+  : writer(_writer),
+    encoder(lambda::bind(serialize, contentType, lambda::_1)),
+    overflowed(false) {}
+
+
+StateEvents::StateEvents(
+    const UPID& _pid,
+    const lambda::function<StateEvent()>& _snapshot,
+    size_t _capacity,
+    const Bytes& _limit)
+  : pid(_pid),
+    snapshot(_snapshot),
+    capacity(_capacity),
+    limit(_limit),
+    flushing(false) {}
+
+
+StateEvents::~StateEvents()
+{
+  foreach (const Owned<Subscriber>& subscriber, subscribers) {
+    subscriber->writer.close();
+  }
+}
+
+
+void StateEvents::subscribe(
+    const Pipe::Writer& writer,
+    ContentType contentType)
+{
+  Owned<Subscriber> subscriber(new Subscriber(writer, contentType));
+
+  subscriber->writer.write(subscriber->encoder.encode(snapshot()));
+
+  subscribers.push_back(subscriber);
+
+  writer.readerClosed()
+    .onAny(defer(pid, [=](const Future<Nothing>&) { unsubscribe(writer); }));
+}
+
+
+void StateEvents::unsubscribe(const Pipe::Writer& writer)
+{
+  list<Owned<Subscriber>>::iterator iterator = subscribers.begin();
+  while (iterator != subscribers.end()) {
+    if ((*iterator)->writer == writer) {
+      iterator = subscribers.erase(iterator);
+    } else {
+      ++iterator;
+    }
+  }
+}
+
+
+void StateEvents::agentAdded(const SlaveInfo& agent)
+{
+  if (!subscribers.empty()) {
+    StateEvent event;
+    event.mutable_agent()->CopyFrom(agent);
+
+    add("agent/" + agent.id().value(), ADDED, event);
+  }
+}
+
+
+void StateEvents::agentRemoved(const SlaveInfo& agent)
+{
+  if (!subscribers.empty()) {
+    StateEvent event;
+    event.mutable_agent()->CopyFrom(agent);
+
+    add("agent/" + agent.id().value(), REMOVED, event);
+  }
+}
+
+
+void StateEvents::frameworkAdded(const FrameworkInfo& framework)
+{
+  if (!subscribers.empty()) {
+    StateEvent event;
+    event.mutable_framework()->CopyFrom(framework);
+
+    add("framework/" + framework.id().value(), ADDED, event);
+  }
+}
+
+
+void StateEvents::frameworkUpdated(const FrameworkInfo& framework)
+{
+  if (!subscribers.empty()) {
+    StateEvent event;
+    event.mutable_framework()->CopyFrom(framework);
+
+    add("framework/" + framework.id().value(), UPDATED, event);
+  }
+}
+
+
+void StateEvents::frameworkRemoved(const FrameworkInfo& framework)
+{
+  if (!subscribers.empty()) {
+    StateEvent event;
+    event.mutable_framework()->CopyFrom(framework);
+
+    add("framework/" + framework.id().value(), REMOVED, event);
+  }
+}
+
+
+void StateEvents::taskAdded(const Task& task)
+{
+  if (!subscribers.empty()) {
+    StateEvent event;
+    event.mutable_task()->CopyFrom(task);
+
+    add("task/" + task.framework_id().value() + "/" + task.task_id().value(),
+        ADDED,
+        event);
+  }
+}
+
+
+void StateEvents::taskUpdated(const Task& task)
+{
+  if (!subscribers.empty()) {
+    StateEvent event;
+    event.mutable_task()->CopyFrom(task);
+
+    add("task/" + task.framework_id().value() + "/" + task.task_id().value(),
+        UPDATED,
+        event);
+  }
+}
+
+
+void StateEvents::taskRemoved(const Task& task)
+{
+  if (!subscribers.empty()) {
+    StateEvent event;
+    event.mutable_task()->CopyFrom(task);
+
+    add("task/" + task.framework_id().value() + "/" + task.task_id().value(),
+        REMOVED,
+        event);
+  }
+}
+
+
+void StateEvents::add(
+    const string& key,
+    Change change,
+    const StateEvent& event)
+{
+  // The events for the different kinds of changes are shared by the
+  // subscribers and only created when needed.
+  shared_ptr<const StateEvent> events[3];
+
+  foreach (const Owned<Subscriber>& subscriber, subscribers) {
+    // The subscriber is sent a new snapshot instead.
+    if (subscriber->overflowed) {
+      continue;
+    }
+
+    Change coalesced = change;
+
+    Option<Pending> previous = subscriber->pending.get(key);
+    if (previous.isSome()) {
+      switch (previous.get().change) {
+        case ADDED:
+          // The subscriber does not need to know about objects that
+          // were added and removed in between flushes.
+          if (change == REMOVED) {
+            subscriber->pending.erase(key);
+            continue;
+          }
+          coalesced = ADDED;
+          break;
+        case UPDATED:
+          coalesced = change == REMOVED ? REMOVED : UPDATED;
+          break;
+        case REMOVED:
+          coalesced = change == REMOVED ? REMOVED : UPDATED;
+          break;
+      }
+    } else if (subscriber->pending.size() >= capacity) {
+      subscriber->pending.clear();
+      subscriber->overflowed = true;
+      continue;
+    }
+
+    if (events[coalesced].get() == NULL) {
+      StateEvent* event_ = new StateEvent(event);
+
+      if (event.has_agent()) {
+        event_->set_type(
+            coalesced == ADDED ? StateEvent::AGENT_ADDED :
+            coalesced == UPDATED ? StateEvent::AGENT_UPDATED :
+            StateEvent::AGENT_REMOVED);
+      } else if (event.has_framework()) {
+        event_->set_type(
+            coalesced == ADDED ? StateEvent::FRAMEWORK_ADDED :
+            coalesced == UPDATED ? StateEvent::FRAMEWORK_UPDATED :
+            StateEvent::FRAMEWORK_REMOVED);
+      } else {
+        CHECK(event.has_task());
+
+        event_->set_type(
+            coalesced == ADDED ? StateEvent::TASK_ADDED :
+            coalesced == UPDATED ? StateEvent::TASK_UPDATED :
+            StateEvent::TASK_REMOVED);
+      }
+
+      events[coalesced].reset(event_);
+    }
+
+    // NOTE: A coalesced change keeps the position of the first change
+    // of the key, so that, e.g., a framework is still added before its
+    // tasks when it is updated afterwards.
+    subscriber->pending[key] = Pending {coalesced, events[coalesced]};
+  }
+}
+
+
+void StateEvents::flush()
+{
+  if (flushing) {
+    return;
+  }
+
+  bool buffered = false;
+  foreach (const Owned<Subscriber>& subscriber, subscribers) {
+    if (subscriber->overflowed || !subscriber->pending.empty()) {
+      buffered = true;
+      break;
+    }
+  }
+
+  if (!buffered) {
+    return;
+  }
+
+  // If we flushed recently, we flush again once the interval has
+  // passed. The (deferred) timer is an event of the master, so we
+  // are invoked again after it.
+  const Time now = Clock::now();
+
+  if (flushed.isSome() && now - flushed.get() < FLUSH_INTERVAL) {
+    flushing = true;
+
+    Clock::timer(
+        flushed.get() + FLUSH_INTERVAL - now,
+        defer(pid, [this]() { flushing = false; }));
+
+    return;
+  }
+
+  flushed = now;
+
+  // The snapshot for the subscribers that missed events.
+  Option<StateEvent> snapshot_;
+
+  list<Owned<Subscriber>>::iterator iterator = subscribers.begin();
+  while (iterator != subscribers.end()) {
+    Owned<Subscriber> subscriber = *iterator;
+
+    // Rather than buffering ever more data for a subscriber that does
+    // not keep up, we end its stream.
+    const Bytes unsent = Bytes(subscriber->writer.size());
+    if (unsent > limit) {
+      LOG(WARNING) << "Disconnecting a subscriber of '/events' which has "
+                   << unsent << " of events yet to receive";
+
+      subscriber->writer.close();
+      iterator = subscribers.erase(iterator);
+      continue;
+    }
+
+    ++iterator;
+
+    if (subscriber->overflowed) {
+      if (snapshot_.isNone()) {
+        snapshot_ = snapshot();
+      }
+
+      subscriber->writer.write(subscriber->encoder.encode(snapshot_.get()));
+      subscriber->overflowed = false;
+      continue;
+    }
+
+    string data;
+    foreach (const Pending& pending, subscriber->pending.values()) {
+      data += subscriber->encoder.encode(*pending.event);
+    }
+
+    subscriber->pending.clear();
+    subscriber->writer.write(data);
+  }
+}
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
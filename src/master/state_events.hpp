@@ -0,0 +1,154 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef __MESOS_MASTER_STATE_EVENTS_HPP__
+#define __MESOS_MASTER_STATE_EVENTS_HPP__
+
+#include <list>
+#include <memory>
+#include <string>
+
+#include <mesos/http.hpp>
+#include <mesos/mesos.hpp>
+
+#include <process/http.hpp>
+#include <process/owned.hpp>
+#include <process/pid.hpp>
+#include <process/time.hpp>
+
+#include <stout/bytes.hpp>
+#include <stout/duration.hpp>
+#include <stout/lambda.hpp>
+#include <stout/linkedhashmap.hpp>
+#include <stout/option.hpp>
+#include <stout/recordio.hpp>
+
+#include "messages/messages.hpp"
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// Streams the changes of the state of the master (i.e., its agents,
+// frameworks and tasks) to the subscribers of the '/events' endpoint
+// as 'StateEvent's, starting with a snapshot of the state.
+//
+// Every subscriber has a buffer of the events that were not sent yet,
+// in which the events about the same agent, framework or task are
+// coalesced. The buffers are flushed at most once per interval. If
+// the buffer of a subscriber overflows, its events are dropped and it
+// is sent a new snapshot instead.
+//
+// The HTTP layer only reads the pipe of a subscriber once the data
+// it read before is sent, so the data that a subscriber has yet to
+// receive stays in its pipe. A subscriber that does not keep up,
+// i.e., whose pipe holds more than 'limit' bytes when it is flushed,
+// is disconnected (its stream ends) and is expected to subscribe
+// again, which sends it a new snapshot.
+class StateEvents
+{
+public:
+  StateEvents(
+      const process::UPID& pid,
+      const lambda::function<StateEvent()>& snapshot,
+      size_t capacity = DEFAULT_CAPACITY,
+      const Bytes& limit = DEFAULT_LIMIT);
+
+  ~StateEvents();
+
+  bool empty() const
+  {
+    return subscribers.empty();
+  }
+
+  // Adds a subscriber and sends it a snapshot of the state.
+  void subscribe(
+      const process::http::Pipe::Writer& writer,
+      ContentType contentType);
+
+  void agentAdded(const SlaveInfo& agent);
+  void agentRemoved(const SlaveInfo& agent);
+
+  void frameworkAdded(const FrameworkInfo& framework);
+  void frameworkUpdated(const FrameworkInfo& framework);
+  void frameworkRemoved(const FrameworkInfo& framework);
+
+  void taskAdded(const Task& task);
+  void taskUpdated(const Task& task);
+  void taskRemoved(const Task& task);
+
+  // Sends the buffered events to the subscribers. This is invoked by
+  // the master after handling any event (see 'Master::visit').
+  void flush();
+
+  static const size_t DEFAULT_CAPACITY;
+  static const Bytes DEFAULT_LIMIT;
+  static const Duration FLUSH_INTERVAL;
+
+private:
+  enum Change
+  {
+    ADDED,
+    UPDATED,
+    REMOVED,
+  };
+
+  struct Pending
+  {
+    Change change;
+    std::shared_ptr<const StateEvent> event;
+  };
+
+  struct Subscriber
+  {
+    Subscriber(
+        const process::http::Pipe::Writer& _writer,
+        ContentType contentType);
+
+    process::http::Pipe::Writer writer;
+    ::recordio::Encoder<StateEvent> encoder;
+
+    // The events that were not sent yet, by the agent, framework or
+    // task they are about.
+    LinkedHashMap<std::string, Pending> pending;
+
+    // Whether the subscriber missed events and needs a new snapshot.
+    bool overflowed;
+  };
+
+  void unsubscribe(const process::http::Pipe::Writer& writer);
+
+  // Buffers the change of an agent, framework or task for all of the
+  // subscribers, coalescing it with a pending change of the same key.
+  void add(const std::string& key, Change change, const StateEvent& event);
+
+  const process::UPID pid;
+  const lambda::function<StateEvent()> snapshot;
+  const size_t capacity;
+  const Bytes limit;
+
+  std::list<process::Owned<Subscriber>> subscribers;
+
+  Option<process::Time> flushed;
+  bool flushing;
+};
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MESOS_MASTER_STATE_EVENTS_HPP__
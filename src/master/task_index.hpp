@@ -0,0 +1,161 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MESOS_MASTER_TASK_INDEX_HPP__
+#define __MESOS_MASTER_TASK_INDEX_HPP__
+
+#include <utility>
+#include <vector>
+
+#include <mesos/mesos.hpp>
+
+#include <stout/hashmap.hpp>
+
+#include "master/completed_tasks.hpp"
+#include "master/ranked_set.hpp"
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// An index of the (running and completed) tasks known to the master,
+// ordered by the timestamp of their earliest status, as used by the
+// '/tasks' endpoint. Tasks without a status are ordered before all
+// other tasks.
+//
+// The index keeps the key each task was indexed with, so tasks can be
+// removed without being dereferenced. Whenever the statuses of an
+// indexed task change, the task must be re-added to update its key.
+//
+// Completed tasks are indexed in their serialized form and are only
+// decoded when they are returned by a query. The tasks are kept in a
+// 'RankedSet', so that a query seeks to its offset in logarithmic
+// time.
+class TaskIndex
+{
+public:
+  // Adds the task to the index, or updates its position if the task
+  // is already indexed.
+  void add(const Task* task)
+  {
+    add(Handle(task, NULL), key(*task));
+  }
+
+  void add(const CompletedTask* task)
+  {
+    add(Handle(NULL, task), key(*task));
+  }
+
+  void remove(const Task* task)
+  {
+    remove(Handle(task, NULL));
+  }
+
+  void remove(const CompletedTask* task)
+  {
+    remove(Handle(NULL, task));
+  }
+
+  bool contains(const Task* task) const
+  {
+    return keys.contains(task);
+  }
+
+  size_t size() const
+  {
+    return ordered.size();
+  }
+
+  // Returns at most 'limit' tasks starting at 'offset', in ascending
+  // or descending order.
+  std::vector<Task> range(
+      size_t offset,
+      size_t limit,
+      bool ascending) const
+  {
+    std::vector<Task> tasks;
+
+    for (size_t i = offset; i < ordered.size() && tasks.size() < limit; i++) {
+      const Handle& handle =
+        ordered.at(ascending ? i : ordered.size() - 1 - i).second;
+
+      tasks.push_back(
+          handle.first != NULL ? *handle.first : handle.second->get());
+    }
+
+    return tasks;
+  }
+
+private:
+  // Whether the task has a status and the timestamp of its earliest
+  // status.
+  typedef std::pair<bool, double> Key;
+
+  // Either an active or a completed task.
+  typedef std::pair<const Task*, const CompletedTask*> Handle;
+
+  static const void* address(const Handle& handle)
+  {
+    return handle.first != NULL
+      ? static_cast<const void*>(handle.first)
+      : static_cast<const void*>(handle.second);
+  }
+
+  static Key key(const Task& task)
+  {
+    if (task.statuses().size() == 0) {
+      return Key(false, 0.0);
+    }
+
+    return Key(true, task.statuses(0).timestamp());
+  }
+
+  static Key key(const CompletedTask& task)
+  {
+    if (task.timestamp().isNone()) {
+      return Key(false, 0.0);
+    }
+
+    return Key(true, task.timestamp().get());
+  }
+
+  void add(const Handle& handle, const Key& key)
+  {
+    remove(handle);
+
+    keys[address(handle)] = key;
+    ordered.insert(std::make_pair(key, handle));
+  }
+
+  void remove(const Handle& handle)
+  {
+    const void* task = address(handle);
+
+    if (keys.contains(task)) {
+      ordered.erase(std::make_pair(keys[task], handle));
+      keys.erase(task);
+    }
+  }
+
+  RankedSet<std::pair<Key, Handle>> ordered;
+  hashmap<const void*, Key> keys;
+};
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MESOS_MASTER_TASK_INDEX_HPP__
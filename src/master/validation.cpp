@@ -116,6 +116,12 @@ Option<Error> validate(const mesos::scheduler::Call& call)
       }
       return None();
 
+    case mesos::scheduler::Call::ACKNOWLEDGE_UPDATES:
+      if (!call.has_acknowledge_updates()) {
+        return Error("Expecting 'acknowledge_updates' to be present");
+      }
+      return None();
+
     case mesos::scheduler::Call::RECONCILE:
       if (!call.has_reconcile()) {
         return Error("Expecting 'reconcile' to be present");
@@ -393,23 +399,18 @@ Option<Error> validateCheckpoint(Framework* framework, Slave* slave)
 // Validates that the task and the executor are using proper amount of
 // resources. For instance, the used resources by a task on a slave
 // should not exceed the total resources offered on that slave.
-Option<Error> validateResourceUsage(
+static Option<Error> validateResourceUsage(
     const TaskInfo& task,
+    const Resources& taskResources,
+    const Resources& executorResources,
     Framework* framework,
     Slave* slave,
     const Resources& offered)
 {
-  Resources taskResources = task.resources();
-
   if (taskResources.empty()) {
     return Error("Task uses no resources");
   }
 
-  Resources executorResources;
-  if (task.has_executor()) {
-    executorResources = task.executor().resources();
-  }
-
   // Validate minimal cpus and memory resources of executor and log
   // warnings if not set.
   if (task.has_executor()) {
@@ -457,15 +458,19 @@ Option<Error> validateResourceUsage(
 }
 
 
-// Validates that the resources specified by the task are valid.
-Option<Error> validateResources(const TaskInfo& task)
+// Validates that the resources specified by the task (and the given
+// resources of the task and its executor) are valid.
+static Option<Error> validateResources(
+    const TaskInfo& task,
+    const Resources& taskResources,
+    const Resources& executorResources)
 {
   Option<Error> error = resource::validate(task.resources());
   if (error.isSome()) {
     return Error("Task uses invalid resources: " + error.get().message);
   }
 
-  Resources total = task.resources();
+  Resources total = taskResources;
 
   if (task.has_executor()) {
     error = resource::validate(task.executor().resources());
@@ -473,17 +478,20 @@ Option<Error> validateResources(const TaskInfo& task)
       return Error("Executor uses invalid resources: " + error.get().message);
     }
 
-    total += task.executor().resources();
+    total += executorResources;
   }
 
   // A task and its executor can either use non-revocable resources
   // or revocable resources of a given name but not both.
-  foreach (const string& name, total.names()) {
-    Resources resources = total.get(name);
-    if (!resources.revocable().empty() &&
-        resources != resources.revocable()) {
-      return Error("Task (and its executor, if exists) uses both revocable and"
-                   " non-revocable " + name);
+  Resources revocable = total.revocable();
+  if (!revocable.empty()) {
+    foreach (const string& name, total.names()) {
+      Resources resources = total.get(name);
+      if (!resources.revocable().empty() &&
+          resources != resources.revocable()) {
+        return Error("Task (and its executor, if exists) uses both revocable"
+                     " and non-revocable " + name);
+      }
     }
   }
 
@@ -495,47 +503,95 @@ Option<Error> validateResources(const TaskInfo& task)
   return None();
 }
 
+
+// Validates that the resources specified by the task are valid.
+Option<Error> validateResources(const TaskInfo& task)
+{
+  Resources executorResources;
+  if (task.has_executor()) {
+    executorResources = task.executor().resources();
+  }
+
+  return validateResources(task, task.resources(), executorResources);
+}
+
 } // namespace internal {
 
 
-Option<Error> validate(
+Validator::Validator(Framework* _framework, Slave* _slave)
+  : framework(CHECK_NOTNULL(_framework)),
+    slave(CHECK_NOTNULL(_slave)),
+    checkpoint(internal::validateCheckpoint(_framework, _slave)) {}
+
+
+Option<Error> Validator::validate(
     const TaskInfo& task,
-    Framework* framework,
-    Slave* slave,
-    const Resources& offered)
+    const Resources& offered) const
 {
-  CHECK_NOTNULL(framework);
-  CHECK_NOTNULL(slave);
+  // NOTE: The order in which the following validations are done does
+  // matter! For example, 'validateResourceUsage' assumes that
+  // ExecutorInfo is valid which is verified by 'validateExecutorInfo'.
+  Option<Error> error = internal::validateTaskID(task);
+  if (error.isSome()) {
+    return error;
+  }
 
-  // NOTE: The order in which the following validate functions are
-  // executed does matter! For example, 'validateResourceUsage'
-  // assumes that ExecutorInfo is valid which is verified by
-  // 'validateExecutorInfo'.
-  vector<lambda::function<Option<Error>(void)>> validators = {
-    lambda::bind(internal::validateTaskID, task),
-    lambda::bind(internal::validateUniqueTaskID, task, framework),
-    lambda::bind(internal::validateSlaveID, task, slave),
-    lambda::bind(internal::validateExecutorInfo, task, framework, slave),
-    lambda::bind(internal::validateCheckpoint, framework, slave),
-    lambda::bind(internal::validateResources, task),
-    lambda::bind(
-        internal::validateResourceUsage, task, framework, slave, offered)
-  };
+  error = internal::validateUniqueTaskID(task, framework);
+  if (error.isSome()) {
+    return error;
+  }
 
-  // TODO(benh): Add a validateHealthCheck function.
+  error = internal::validateSlaveID(task, slave);
+  if (error.isSome()) {
+    return error;
+  }
 
-  // TODO(jieyu): Add a validateCommandInfo function.
+  error = internal::validateExecutorInfo(task, framework, slave);
+  if (error.isSome()) {
+    return error;
+  }
 
-  foreach (const lambda::function<Option<Error>(void)>& validator, validators) {
-    Option<Error> error = validator();
-    if (error.isSome()) {
-      return error;
-    }
+  if (checkpoint.isSome()) {
+    return checkpoint;
   }
 
+  // The resources of the task and its executor are converted once
+  // for all the resource validations.
+  const Resources taskResources = task.resources();
+
+  Resources executorResources;
+  if (task.has_executor()) {
+    executorResources = task.executor().resources();
+  }
+
+  error = internal::validateResources(task, taskResources, executorResources);
+  if (error.isSome()) {
+    return error;
+  }
+
+  error = internal::validateResourceUsage(
+      task, taskResources, executorResources, framework, slave, offered);
+  if (error.isSome()) {
+    return error;
+  }
+
+  // TODO(benh): Add a validateHealthCheck function.
+
+  // TODO(jieyu): Add a validateCommandInfo function.
+
   return None();
 }
 
+
+Option<Error> validate(
+    const TaskInfo& task,
+    Framework* framework,
+    Slave* slave,
+    const Resources& offered)
+{
+  return Validator(framework, slave).validate(task, offered);
+}
+
 } // namespace task {
 
 
@@ -801,6 +857,63 @@ Option<Error> validate(
 
 } // namespace operation {
 
+
+namespace slave {
+namespace reregistration {
+
+Option<Error> validate(
+    const SlaveInfo& slaveInfo,
+    const vector<Resource>& checkpointedResources,
+    const vector<ExecutorInfo>& executorInfos,
+    const vector<Task>& tasks)
+{
+  if (!slaveInfo.has_id()) {
+    return Error("Slave is missing the 'id' field");
+  }
+
+  Try<Resources> resources = applyCheckpointedResources(
+      slaveInfo.resources(),
+      checkpointedResources);
+
+  if (resources.isError()) {
+    return Error(
+        "Failed to apply checkpointed resources " +
+        stringify(checkpointedResources) + " to slave resources " +
+        stringify(slaveInfo.resources()) + ": " + resources.error());
+  }
+
+  foreach (const ExecutorInfo& executorInfo, executorInfos) {
+    if (!executorInfo.has_framework_id()) {
+      return Error(
+          "Executor " + stringify(executorInfo.executor_id()) +
+          " is missing the 'framework_id' field");
+    }
+  }
+
+  hashmap<FrameworkID, hashset<TaskID>> taskIds;
+
+  foreach (const Task& task, tasks) {
+    if (task.slave_id() != slaveInfo.id()) {
+      return Error(
+          "Task " + stringify(task.task_id()) + " belongs to slave " +
+          stringify(task.slave_id()));
+    }
+
+    if (taskIds[task.framework_id()].contains(task.task_id())) {
+      return Error(
+          "Duplicate task " + stringify(task.task_id()) +
+          " of framework " + stringify(task.framework_id()));
+    }
+
+    taskIds[task.framework_id()].insert(task.task_id());
+  }
+
+  return None();
+}
+
+} // namespace reregistration {
+} // namespace slave {
+
 } // namespace validation {
 } // namespace master {
 } // namespace internal {
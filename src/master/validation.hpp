@@ -17,6 +17,8 @@
 #ifndef __MASTER_VALIDATION_HPP__
 #define __MASTER_VALIDATION_HPP__
 
+#include <vector>
+
 #include <google/protobuf/repeated_field.h>
 
 #include <mesos/mesos.hpp>
@@ -60,6 +62,33 @@ Option<Error> validate(
 
 namespace task {
 
+// Validates the tasks that a framework attempts to launch on a slave
+// within the offered resources, e.g., all the tasks of an ACCEPT
+// call. The validations that only depend on the framework and the
+// slave are done once, rather than for every task.
+// NOTE: 'validate' must be called sequentially for each task, and
+// each task needs to be launched before the next can be validated.
+class Validator
+{
+public:
+  Validator(Framework* framework, Slave* slave);
+
+  // Returns an optional error which will cause the master to send a
+  // failed status update back to the framework.
+  Option<Error> validate(
+      const TaskInfo& task,
+      const Resources& offered) const;
+
+private:
+  Framework* const framework;
+  Slave* const slave;
+
+  // Whether the slave can run the (checkpointed) tasks of the
+  // framework.
+  const Option<Error> checkpoint;
+};
+
+
 // Validates a task that a framework attempts to launch within the
 // offered resources. Returns an optional error which will cause the
 // master to send a failed status update back to the framework.
@@ -130,6 +159,25 @@ Option<Error> validate(
 
 } // namespace operation {
 
+
+namespace slave {
+namespace reregistration {
+
+// Validates the executors and tasks reported by a slave that
+// re-registers with a failed over master. These are otherwise
+// assumed to be valid when the slave is added (see 'Slave').
+//
+// NOTE: This does not depend on any master state so that it can be
+// done without blocking the master (see 'Master::readmitSlaves').
+Option<Error> validate(
+    const SlaveInfo& slaveInfo,
+    const std::vector<Resource>& checkpointedResources,
+    const std::vector<ExecutorInfo>& executorInfos,
+    const std::vector<Task>& tasks);
+
+} // namespace reregistration {
+} // namespace slave {
+
 } // namespace validation {
 } // namespace master {
 } // namespace internal {
@@ -18,8 +18,10 @@
 
 #include <stout/error.hpp>
 #include <stout/flags.hpp>
+#include <stout/foreach.hpp>
 #include <stout/json.hpp>
 #include <stout/option.hpp>
+#include <stout/strings.hpp>
 
 #include <mesos/type_utils.hpp>
 
@@ -260,6 +262,39 @@ mesos::internal::slave::Flags::Flags()
         return None();
       });
 
+  add(&Flags::endpoint_concurrency_limits,
+      "endpoint_concurrency_limits",
+      "JSON object of the maximum number of requests of an endpoint\n"
+      "that are handled concurrently. Further requests are answered\n"
+      "with '503 Service Unavailable'. Long-polling requests (e.g.,\n"
+      "'/state?version=N') count against the limit until answered.\n"
+      "Example:\n"
+      "{\n"
+      "  \"/state\": 4,\n"
+      "  \"/flags\": 1\n"
+      "}",
+      [](const Option<JSON::Object>& object) -> Option<Error> {
+        if (object.isSome()) {
+          foreachpair (const std::string& endpoint,
+                       const JSON::Value& value,
+                       object.get().values) {
+            if (!strings::startsWith(endpoint, "/")) {
+              return Error("'endpoint_concurrency_limits' must only "
+                           "contain endpoints starting with '/'");
+            }
+
+            if (!value.is<JSON::Number>() ||
+                value.as<JSON::Number>().as<double>() < 1 ||
+                value.as<JSON::Number>().as<double>() !=
+                  value.as<JSON::Number>().as<uint64_t>()) {
+              return Error("'endpoint_concurrency_limits' must only "
+                           "contain positive integer limits");
+            }
+          }
+        }
+        return None();
+      });
+
   add(&Flags::executor_registration_timeout,
       "executor_registration_timeout",
       "Amount of time to wait for an executor\n"
@@ -273,6 +308,14 @@ mesos::internal::slave::Flags::Flags()
       "to shut down (e.g., 60secs, 3mins, etc)",
       EXECUTOR_SHUTDOWN_GRACE_PERIOD);
 
+  add(&Flags::batch_status_updates,
+      "batch_status_updates",
+      "Whether to exchange status updates and their acknowledgements\n"
+      "with the master in batches, if the master supports it. Reduces\n"
+      "the number of messages when many tasks change their state at\n"
+      "about the same time.",
+      false);
+
   add(&Flags::gc_delay,
       "gc_delay",
       "Maximum amount of time to wait before cleaning up\n"
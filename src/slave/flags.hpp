@@ -71,8 +71,10 @@ public:
   std::string frameworks_home;  // TODO(benh): Make an Option.
   Duration registration_backoff_factor;
   Option<JSON::Object> executor_environment_variables;
+  Option<JSON::Object> endpoint_concurrency_limits;
   Duration executor_registration_timeout;
   Duration executor_shutdown_grace_period;
+  bool batch_status_updates;
   Duration gc_delay;
   double gc_disk_headroom;
   Duration disk_watch_interval;
@@ -18,6 +18,7 @@
 #include <memory>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <mesos/executor/executor.hpp>
@@ -34,6 +35,7 @@
 
 #include <stout/foreach.hpp>
 #include <stout/json.hpp>
+#include <stout/json/reader.hpp>
 #include <stout/lambda.hpp>
 #include <stout/net.hpp>
 #include <stout/numify.hpp>
@@ -236,15 +238,14 @@ Future<Response> Slave::Http::executor(const Request& request) const
       return BadRequest("Failed to parse body into Call protobuf");
     }
   } else if (contentType.get() == APPLICATION_JSON) {
-    Try<JSON::Value> value = JSON::parse(request.body);
-    if (value.isError()) {
-      return BadRequest("Failed to parse body into JSON: " + value.error());
-    }
+    JSON::Reader reader(request.body);
 
     Try<v1::executor::Call> parse =
-      ::protobuf::parse<v1::executor::Call>(value.get());
+      ::protobuf::parse<v1::executor::Call>(&reader);
 
-    if (parse.isError()) {
+    if (parse.isError() && reader.failed()) {
+      return BadRequest("Failed to parse body into JSON: " + parse.error());
+    } else if (parse.isError()) {
       return BadRequest("Failed to convert JSON into Call protobuf: " +
                         parse.error());
     }
@@ -256,7 +257,7 @@ Future<Response> Slave::Http::executor(const Request& request) const
         APPLICATION_JSON + " or " + APPLICATION_PROTOBUF);
   }
 
-  const executor::Call call = devolve(v1Call);
+  const executor::Call call = devolve(std::move(v1Call));
 
 
   Option<Error> error = validation::executor::call::validate(call);
@@ -388,11 +389,30 @@ string Slave::Http::STATE_HELP() {
         "Information about state of the Slave."),
     DESCRIPTION(
         "This endpoint shows information about the frameworks, executors",
-        "and the slave's master as a JSON object."));
+        "and the slave's master as a JSON object.",
+        "",
+        "The version of the response is returned as its 'ETag'. Requests",
+        "with a matching 'If-None-Match' header are answered with",
+        "'304 Not Modified'.",
+        "",
+        "Query parameters:",
+        "",
+        ">        version=VALUE     Long-poll until the version is greater.",
+        ">        timeout=VALUE     How long to long-poll (defaults to 30secs)",
+        ">                          before answering '304 Not Modified'."));
 }
 
 
 Future<Response> Slave::Http::state(const Request& request) const
+{
+  const Http http = *this;
+
+  return slave->stateResponses.respond(
+      "state", request, [http]() { return http._state(); });
+}
+
+
+JSON::Object Slave::Http::_state() const
 {
   JSON::Object object;
   object.values["version"] = MESOS_VERSION;
@@ -455,7 +475,7 @@ Future<Response> Slave::Http::state(const Request& request) const
   }
   object.values["flags"] = flags;
 
-  return OK(object, request.url.query.get("jsonp"));
+  return object;
 }
 
 } // namespace slave {
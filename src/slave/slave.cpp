@@ -100,8 +100,12 @@ using std::vector;
 using process::async;
 using process::wait; // Necessary on some OS's to disambiguate.
 using process::Clock;
+using process::DispatchEvent;
+using process::ExitedEvent;
 using process::Failure;
 using process::Future;
+using process::HttpEvent;
+using process::MessageEvent;
 using process::Owned;
 using process::Time;
 using process::UPID;
@@ -133,6 +137,7 @@ Slave::Slave(const slave::Flags& _flags,
     monitor(defer(self(), &Self::usage)),
     statusUpdateManager(_statusUpdateManager),
     masterPingTimeout(DEFAULT_MASTER_PING_TIMEOUT()),
+    batchStatusUpdates(false),
     metaDir(paths::getMetaRootDir(flags.work_dir)),
     recoveryErrors(0),
     credential(None()),
@@ -142,7 +147,8 @@ Slave::Slave(const slave::Flags& _flags,
     reauthenticate(false),
     executorDirectoryMaxAllowedAge(age(0)),
     resourceEstimator(_resourceEstimator),
-    qosController(_qosController) {}
+    qosController(_qosController),
+    stateResponses(self()) {}
 
 
 Slave::~Slave()
@@ -473,6 +479,9 @@ void Slave::initialize()
       &StatusUpdateAcknowledgementMessage::task_id,
       &StatusUpdateAcknowledgementMessage::uuid);
 
+  install<StatusUpdateAcknowledgementsMessage>(
+      &Slave::statusUpdateAcknowledgements);
+
   install<RegisterExecutorMessage>(
       &Slave::registerExecutor,
       &RegisterExecutorMessage::framework_id,
@@ -508,12 +517,19 @@ void Slave::initialize()
   // Setup HTTP routes.
   Http http = Http(this);
 
+  // The cost of every endpoint is reported as metrics, and endpoints
+  // may be limited with '--endpoint_concurrency_limits'.
+  auto options = [this](const string& endpoint) {
+    return routeOptions("slave", endpoint, flags.endpoint_concurrency_limits);
+  };
+
   route("/api/v1/executor",
         Http::EXECUTOR_HELP(),
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.executor(request);
-        });
+        },
+        options("/api/v1/executor"));
 
   // TODO(ijimenez): Remove this endpoint at the end of the
   // deprecation cycle on 0.26.
@@ -522,24 +538,28 @@ void Slave::initialize()
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.state(request);
-        });
+        },
+        options("/state.json"));
   route("/state",
         Http::STATE_HELP(),
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.state(request);
-        });
+        },
+        options("/state"));
   route("/flags",
         Http::FLAGS_HELP(),
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.flags(request);
-        });
+        },
+        options("/flags"));
   route("/health",
         Http::HEALTH_HELP(),
         [http](const process::http::Request& request) {
           return http.health(request);
-        });
+        },
+        options("/health"));
 
   // Expose the log file for the webui. Fall back to 'log_dir' if
   // an explicit file was not specified.
@@ -628,6 +648,49 @@ void Slave::finalize()
 }
 
 
+void Slave::visit(const MessageEvent& event)
+{
+  ProtobufProcess<Slave>::visit(event);
+
+  stateResponses.changed();
+  stateResponses.notify();
+}
+
+
+void Slave::visit(const DispatchEvent& event)
+{
+  ProcessBase::visit(event);
+
+  stateResponses.changed();
+  stateResponses.notify();
+}
+
+
+void Slave::visit(const HttpEvent& event)
+{
+  // Reading the state (i.e., '/state') must not invalidate the
+  // responses computed from it.
+  if (event.request->method == "GET") {
+    ProcessBase::visit(event);
+    return;
+  }
+
+  ProcessBase::visit(event);
+
+  stateResponses.changed();
+  stateResponses.notify();
+}
+
+
+void Slave::visit(const ExitedEvent& event)
+{
+  ProcessBase::visit(event);
+
+  stateResponses.changed();
+  stateResponses.notify();
+}
+
+
 void Slave::shutdown(const UPID& from, const string& message)
 {
   if (from && master != from) {
@@ -897,6 +960,13 @@ void Slave::registered(
     masterPingTimeout = DEFAULT_MASTER_PING_TIMEOUT();
   }
 
+  batchStatusUpdates = false;
+  foreach (const SlaveCapability& capability, connection.capabilities()) {
+    if (capability.type() == SlaveCapability::BATCHED_STATUS_UPDATES) {
+      batchStatusUpdates = true;
+    }
+  }
+
   switch (state) {
     case DISCONNECTED: {
       LOG(INFO) << "Registered with master " << master.get()
@@ -997,6 +1067,13 @@ void Slave::reregistered(
     masterPingTimeout = DEFAULT_MASTER_PING_TIMEOUT();
   }
 
+  batchStatusUpdates = false;
+  foreach (const SlaveCapability& capability, connection.capabilities()) {
+    if (capability.type() == SlaveCapability::BATCHED_STATUS_UPDATES) {
+      batchStatusUpdates = true;
+    }
+  }
+
   switch (state) {
     case DISCONNECTED:
       LOG(INFO) << "Re-registered with master " << master.get();
@@ -1134,6 +1211,11 @@ void Slave::doReliableRegistration(Duration maxBackoff)
     message.set_version(MESOS_VERSION);
     message.mutable_slave()->CopyFrom(info);
 
+    if (flags.batch_status_updates) {
+      message.add_capabilities()->set_type(
+          SlaveCapability::BATCHED_STATUS_UPDATES);
+    }
+
     // Include checkpointed resources.
     message.mutable_checkpointed_resources()->CopyFrom(checkpointedResources);
 
@@ -1143,6 +1225,11 @@ void Slave::doReliableRegistration(Duration maxBackoff)
     ReregisterSlaveMessage message;
     message.set_version(MESOS_VERSION);
 
+    if (flags.batch_status_updates) {
+      message.add_capabilities()->set_type(
+          SlaveCapability::BATCHED_STATUS_UPDATES);
+    }
+
     // Include checkpointed resources.
     message.mutable_checkpointed_resources()->CopyFrom(checkpointedResources);
 
@@ -2328,6 +2415,22 @@ void Slave::statusUpdateAcknowledgement(
 }
 
 
+void Slave::statusUpdateAcknowledgements(
+    const UPID& from,
+    const StatusUpdateAcknowledgementsMessage& message)
+{
+  foreach (const StatusUpdateAcknowledgementMessage& acknowledgement,
+           message.acknowledgements()) {
+    statusUpdateAcknowledgement(
+        from,
+        acknowledgement.slave_id(),
+        acknowledgement.framework_id(),
+        acknowledgement.task_id(),
+        acknowledgement.uuid());
+  }
+}
+
+
 void Slave::_statusUpdateAcknowledgement(
     const Future<bool>& future,
     const TaskID& taskId,
@@ -3128,6 +3231,53 @@ void Slave::forward(StatusUpdate update)
   message.mutable_update()->MergeFrom(update);
   message.set_pid(self()); // The ACK will be first received by the slave.
 
+  if (!batchStatusUpdates) {
+    send(master.get(), message);
+    return;
+  }
+
+  // The updates that the status update manager forwards until the
+  // dispatch below runs are sent to the master in a single message.
+  if (statusUpdates.updates().empty()) {
+    dispatch(self(), &Self::forwardStatusUpdates);
+  }
+
+  statusUpdates.add_updates()->CopyFrom(message);
+}
+
+
+void Slave::forwardStatusUpdates()
+{
+  if (statusUpdates.updates().empty()) {
+    return;
+  }
+
+  StatusUpdatesMessage message;
+  message.Swap(&statusUpdates);
+
+  // NOTE: The status update manager retries the updates that are
+  // dropped here until they are acknowledged.
+  if (state != RUNNING) {
+    LOG(WARNING) << "Dropping " << message.updates().size()
+                 << " status updates because the slave is in "
+                 << state << " state";
+    return;
+  }
+
+  CHECK_SOME(master);
+
+  // The slave might have re-registered with a master that does not
+  // accept batched status updates in the meantime.
+  if (!batchStatusUpdates) {
+    foreach (const StatusUpdateMessage& update, message.updates()) {
+      send(master.get(), update);
+    }
+    return;
+  }
+
+  VLOG(1) << "Forwarding " << message.updates().size()
+          << " status updates to " << master.get();
+
   send(master.get(), message);
 }
 
@@ -224,6 +224,10 @@ public:
   // added to the update before forwarding.
   void forward(StatusUpdate update);
 
+  // Sends the status updates that were batched by 'forward' to a
+  // master that accepted the BATCHED_STATUS_UPDATES capability.
+  void forwardStatusUpdates();
+
   void statusUpdateAcknowledgement(
       const process::UPID& from,
       const SlaveID& slaveId,
@@ -231,6 +235,10 @@ public:
       const TaskID& taskId,
       const std::string& uuid);
 
+  void statusUpdateAcknowledgements(
+      const process::UPID& from,
+      const StatusUpdateAcknowledgementsMessage& message);
+
   void _statusUpdateAcknowledgement(
       const process::Future<bool>& future,
       const TaskID& taskId,
@@ -277,6 +285,11 @@ public:
   virtual void finalize();
   virtual void exited(const process::UPID& pid);
 
+  virtual void visit(const process::MessageEvent& event);
+  virtual void visit(const process::DispatchEvent& event);
+  virtual void visit(const process::HttpEvent& event);
+  virtual void visit(const process::ExitedEvent& event);
+
   // This is called when the resource limits of the container have
   // been updated for the given tasks. If the update is successful, we
   // flush the given tasks to the executor by sending RunTaskMessages.
@@ -426,6 +439,9 @@ private:
     static std::string STATE_HELP();
 
   private:
+    // Models the current state for '/state'.
+    JSON::Object _state() const;
+
     Slave* slave;
   };
 
@@ -516,6 +532,13 @@ private:
   // Master's ping timeout value, updated on reregistration.
   Duration masterPingTimeout;
 
+  // Whether the master accepted the BATCHED_STATUS_UPDATES capability,
+  // updated on reregistration. If so, 'forward' batches the status
+  // updates until 'forwardStatusUpdates' runs, which is dispatched
+  // when the first update of a batch is added.
+  bool batchStatusUpdates;
+  StatusUpdatesMessage statusUpdates;
+
   // Timer for triggering re-detection when no ping is received from
   // the master.
   process::Timer pingTimer;
@@ -557,6 +580,10 @@ private:
   // The most recent estimate of the total amount of oversubscribed
   // (allocated and oversubscribable) resources.
   Option<Resources> oversubscribedResources;
+
+  // The responses of '/state'. The state may change with every
+  // handled event other than HTTP GETs (see 'visit').
+  StateResponses stateResponses;
 };
 
 
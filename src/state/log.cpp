@@ -65,10 +65,16 @@ namespace state {
 // Log::Writer has been started and all positions in the log have been
 // read and cached in memory. All reads are performed by this cache
 // (for now). If the Log::Writer gets demoted (i.e., because another
-// writer started) then the current operation will return false
-// implying the operation was not atomic and subsequent operations
-// will re-'start()' which will again read all positions to make sure
-// operations are consistent.
+// writer started) then the current operation (and all the operations
+// still in flight) will return false implying the operation was not
+// atomic and subsequent operations will re-'start()' which will again
+// read all positions to make sure operations are consistent.
+//
+// Sets and expunges are appended to the log without waiting for the
+// earlier ones to finish (the Log::Writer writes them concurrently,
+// in order). Their versions are checked against the latest entries,
+// including the writes in flight, while the cache is only updated
+// once a write has finished.
 // TODO(benh): Log demotion does not necessarily imply a non-atomic
 // read/modify/write. An alternative strategy might be to retry after
 // restarting via 'start' (and holding on to the mutex so no other
@@ -106,20 +112,32 @@ private:
       const Log::Position& minimum,
       const Option<Log::Position>& position);
 
+  // Helpers for appending the operations of sets and expunges and
+  // keeping track of the writes in flight.
+  Future<Option<Log::Position> > write(
+      const string& name,
+      const Option<state::Entry>& entry,
+      size_t diffs,
+      const string& value);
+  void written(
+      const string& name,
+      uint64_t generation,
+      const Future<Option<Log::Position> >& future);
+
   // Continuations.
   Future<Option<state::Entry> > _get(const string& name);
 
   Future<bool> _set(const state::Entry& entry, const UUID& uuid);
-  Future<bool> __set(const state::Entry& entry, const UUID& uuid);
-  Future<bool> ___set(
+  Future<bool> __set(
       const state::Entry& entry,
       size_t diff,
+      uint64_t generation,
       Option<Log::Position> position);
 
   Future<bool> _expunge(const state::Entry& entry);
-  Future<bool> __expunge(const state::Entry& entry);
-  Future<bool> ___expunge(
+  Future<bool> __expunge(
       const state::Entry& entry,
+      uint64_t generation,
       const Option<Log::Position>& position);
 
   Future<std::set<string> > _names();
@@ -129,7 +147,7 @@ private:
 
   const size_t diffsBetweenSnapshots;
 
-  // Used to serialize Log::Writer::append/truncate operations.
+  // Used to serialize Log::Writer::truncate operations.
   Mutex mutex;
 
   // Whether or not we've started the ability to append to log.
@@ -196,6 +214,24 @@ private:
   // a default/empty constructor.
   hashmap<string, Snapshot> snapshots;
 
+  // The latest entry (none if it is expunged) and the number of diffs
+  // for the names with writes in flight, as well as the number of
+  // these writes.
+  struct Pending
+  {
+    Pending() : diffs(0), writes(0) {}
+
+    Option<state::Entry> entry;
+    size_t diffs;
+    size_t writes;
+  };
+
+  hashmap<string, Pending> pending;
+
+  // Incremented whenever the writes in flight are abandoned because
+  // the Log::Writer was demoted (see 'written').
+  uint64_t generation;
+
   struct Metrics
   {
     Metrics()
@@ -217,7 +253,8 @@ private:
 LogStorageProcess::LogStorageProcess(Log* log, size_t diffsBetweenSnapshots)
   : reader(log),
     writer(log),
-    diffsBetweenSnapshots(diffsBetweenSnapshots) {}
+    diffsBetweenSnapshots(diffsBetweenSnapshots),
+    generation(0) {}
 
 
 LogStorageProcess::~LogStorageProcess() {}
@@ -373,9 +410,11 @@ Future<Nothing> LogStorageProcess::apply(const list<Log::Entry>& entries)
 // very big.
 void LogStorageProcess::truncate()
 {
-  // We lock the truncation since it includes a call to
-  // Log::Writer::truncate which must be serialized with calls to
-  // Log::Writer::append.
+  // We lock the truncation so that we only compute the minimum
+  // position once the previous Log::Writer::truncate has finished.
+  // NOTE: It is safe to truncate while appends are in flight since
+  // the minimum position is only determined by the snapshots whose
+  // writes have finished (i.e., that precede the writes in flight).
   mutex.lock()
     .then(defer(self(), &Self::_truncate))
     .onAny(lambda::bind(&Mutex::unlock, mutex));
@@ -450,46 +489,92 @@ Future<Option<state::Entry> > LogStorageProcess::_get(const string& name)
 }
 
 
-Future<bool> LogStorageProcess::set(
-    const state::Entry& entry,
-    const UUID& uuid)
+Future<Option<Log::Position> > LogStorageProcess::write(
+    const string& name,
+    const Option<state::Entry>& entry,
+    size_t diffs,
+    const string& value)
 {
-  return mutex.lock()
-    .then(defer(self(), &Self::_set, entry, uuid))
-    .onAny(lambda::bind(&Mutex::unlock, mutex));
+  Future<Option<Log::Position> > future = writer.append(value);
+
+  Pending& latest = pending[name];
+  latest.entry = entry;
+  latest.diffs = diffs;
+  latest.writes++;
+
+  // NOTE: This is invoked before the continuations of the callers
+  // (i.e., '__set' and '__expunge').
+  future.onAny(defer(self(), &Self::written, name, generation, lambda::_1));
+
+  return future;
 }
 
 
-Future<bool> LogStorageProcess::_set(
+void LogStorageProcess::written(
+    const string& name,
+    uint64_t generation,
+    const Future<Option<Log::Position> >& future)
+{
+  if (generation != this->generation) {
+    return; // The write has already been abandoned.
+  }
+
+  if (!future.isReady() || future.get().isNone()) {
+    // The writes still in flight won't succeed either (the
+    // Log::Writer answers them in order), so we abandon them and
+    // reset 'starting' so we try again.
+    starting = None();
+    pending.clear();
+    this->generation++;
+    return;
+  }
+
+  CHECK(pending.contains(name));
+
+  if (--pending[name].writes == 0) {
+    pending.erase(name);
+  }
+}
+
+
+Future<bool> LogStorageProcess::set(
     const state::Entry& entry,
     const UUID& uuid)
 {
   return start()
-    .then(defer(self(), &Self::__set, entry, uuid));
+    .then(defer(self(), &Self::_set, entry, uuid));
 }
 
 
-Future<bool> LogStorageProcess::__set(
+Future<bool> LogStorageProcess::_set(
     const state::Entry& entry,
     const UUID& uuid)
 {
-  Option<Snapshot> snapshot = snapshots.get(entry.name());
+  // Determine the latest version of the entry, including the writes
+  // in flight.
+  Option<state::Entry> latest = None();
+  size_t diffs = 0;
+
+  if (pending.contains(entry.name())) {
+    latest = pending[entry.name()].entry;
+    diffs = pending[entry.name()].diffs;
+  } else if (snapshots.contains(entry.name())) {
+    latest = snapshots.get(entry.name()).get().entry;
+    diffs = snapshots.get(entry.name()).get().diffs;
+  }
 
-  // Check the version first (if we've already got a snapshot).
-  if (snapshot.isSome() &&
-      UUID::fromBytes(snapshot.get().entry.uuid()) != uuid) {
+  // Check the version first (if we've already got an entry).
+  if (latest.isSome() && UUID::fromBytes(latest.get().uuid()) != uuid) {
     return false;
   }
 
   // Check if we should try to compute a diff.
-  if (snapshot.isSome() && snapshot.get().diffs < diffsBetweenSnapshots) {
+  if (latest.isSome() && diffs < diffsBetweenSnapshots) {
     // Keep metrics for the time to calculate diffs.
     metrics.diff.start();
 
-    // Construct the diff of the last snapshot.
-    Try<svn::Diff> diff = svn::diff(
-        snapshot.get().entry.value(),
-        entry.value());
+    // Construct the diff of the latest entry.
+    Try<svn::Diff> diff = svn::diff(latest.get().value(), entry.value());
 
     Duration elapsed = metrics.diff.stop();
 
@@ -516,11 +601,12 @@ Future<bool> LogStorageProcess::__set(
         return Failure("Failed to serialize DIFF Operation");
       }
 
-      return writer.append(value)
+      return write(entry.name(), entry, diffs + 1, value)
         .then(defer(self(),
-                    &Self::___set,
+                    &Self::__set,
                     entry,
-                    snapshot.get().diffs + 1,
+                    diffs + 1,
+                    generation,
                     lambda::_1));
     }
   }
@@ -535,19 +621,25 @@ Future<bool> LogStorageProcess::__set(
     return Failure("Failed to serialize SNAPSHOT Operation");
   }
 
-  return writer.append(value)
-    .then(defer(self(), &Self::___set, entry, 0, lambda::_1));
+  return write(entry.name(), entry, 0, value)
+    .then(defer(self(), &Self::__set, entry, 0, generation, lambda::_1));
 }
 
 
-Future<bool> LogStorageProcess::___set(
+Future<bool> LogStorageProcess::__set(
     const state::Entry& entry,
     size_t diffs,
+    uint64_t generation,
     Option<Log::Position> position)
 {
   if (position.isNone()) {
-    starting = None(); // Reset 'starting' so we try again.
-    return false;
+    return false; // See 'written'.
+  }
+
+  // If the writes in flight have been abandoned the entry is still
+  // in the log, and is read when we 'start()' again.
+  if (generation != this->generation) {
+    return true;
   }
 
   // Update index so we don't bother reading anything before this
@@ -557,7 +649,9 @@ Future<bool> LogStorageProcess::___set(
   // Determine the position that represents the snapshot: if we just
   // wrote a diff then we want to use the existing position of the
   // snapshot, otherwise we just overwrote the snapshot so we should
-  // use the returned position (i.e., do nothing).
+  // use the returned position (i.e., do nothing). Since the writes
+  // finish in order, the existing snapshot is the one the diff was
+  // computed against.
   if (diffs > 0) {
     CHECK(snapshots.contains(entry.name()));
     position = snapshots.get(entry.name()).get().position;
@@ -574,31 +668,30 @@ Future<bool> LogStorageProcess::___set(
 
 
 Future<bool> LogStorageProcess::expunge(const state::Entry& entry)
-{
-  return mutex.lock()
-    .then(defer(self(), &Self::_expunge, entry))
-    .onAny(lambda::bind(&Mutex::unlock, mutex));
-}
-
-
-Future<bool> LogStorageProcess::_expunge(const state::Entry& entry)
 {
   return start()
-    .then(defer(self(), &Self::__expunge, entry));
+    .then(defer(self(), &Self::_expunge, entry));
 }
 
 
-Future<bool> LogStorageProcess::__expunge(const state::Entry& entry)
+Future<bool> LogStorageProcess::_expunge(const state::Entry& entry)
 {
-  Option<Snapshot> snapshot = snapshots.get(entry.name());
+  // Determine the latest version of the entry, including the writes
+  // in flight.
+  Option<state::Entry> latest = None();
+
+  if (pending.contains(entry.name())) {
+    latest = pending[entry.name()].entry;
+  } else if (snapshots.contains(entry.name())) {
+    latest = snapshots.get(entry.name()).get().entry;
+  }
 
-  if (snapshot.isNone()) {
+  if (latest.isNone()) {
     return false;
   }
 
   // Check the version first.
-  if (UUID::fromBytes(snapshot.get().entry.uuid()) !=
-      UUID::fromBytes(entry.uuid())) {
+  if (UUID::fromBytes(latest.get().uuid()) != UUID::fromBytes(entry.uuid())) {
     return false;
   }
 
@@ -612,18 +705,22 @@ Future<bool> LogStorageProcess::__expunge(const state::Entry& entry)
     return Failure("Failed to serialize Operation");
   }
 
-  return writer.append(value)
-    .then(defer(self(), &Self::___expunge, entry, lambda::_1));
+  return write(entry.name(), None(), 0, value)
+    .then(defer(self(), &Self::__expunge, entry, generation, lambda::_1));
 }
 
 
-Future<bool> LogStorageProcess::___expunge(
+Future<bool> LogStorageProcess::__expunge(
     const state::Entry& entry,
+    uint64_t generation,
     const Option<Log::Position>& position)
 {
   if (position.isNone()) {
-    starting = None(); // Reset 'starting' so we try again.
-    return false;
+    return false; // See 'written'.
+  }
+
+  if (generation != this->generation) {
+    return true;
   }
 
   // Remove from snapshots and truncate the log if possible.
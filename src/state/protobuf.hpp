@@ -80,6 +80,11 @@ public:
   template <typename T>
   process::Future<Variable<T> > fetch(const std::string& name);
 
+  // Returns a new variable (without fetching it) that can only be
+  // stored if no variable with the same name exists in the state.
+  template <typename T>
+  Variable<T> create(const std::string& name);
+
   // Returns the variable specified if it was successfully stored in
   // the state, otherwise returns none if the version of the variable
   // was no longer valid, or an error if one occurs.
@@ -126,6 +131,13 @@ process::Future<Variable<T> > State::_fetch(
 }
 
 
+template <typename T>
+Variable<T> State::create(const std::string& name)
+{
+  return Variable<T>(state::State::create(name), T());
+}
+
+
 template <typename T>
 process::Future<Option<Variable<T> > > State::store(
     const Variable<T>& variable)
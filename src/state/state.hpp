@@ -100,6 +100,10 @@ public:
   // previously did not exist (or an error if one occurs).
   process::Future<Variable> fetch(const std::string& name);
 
+  // Returns a new variable (without fetching it) that can only be
+  // stored if no variable with the same name exists in the state.
+  Variable create(const std::string& name);
+
   // Returns the variable specified if it was successfully stored in
   // the state, otherwise returns none if the version of the variable
   // was no longer valid, or an error if one occurs.
@@ -152,6 +156,18 @@ inline process::Future<Variable> State::_fetch(
 }
 
 
+inline Variable State::create(const std::string& name)
+{
+  // Like a variable that did not exist when fetched, the new entry
+  // has a random UUID and no value to start.
+  Entry entry;
+  entry.set_name(name);
+  entry.set_uuid(UUID::random().toBytes());
+
+  return Variable(entry);
+}
+
+
 inline process::Future<Option<Variable> > State::store(const Variable& variable)
 {
   // Note that we try and swap an entry even if the value didn't change!
@@ -14,12 +14,19 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <iostream>
+#include <string>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include <mesos/authorizer/authorizer.hpp>
 
 #include <mesos/module/authorizer.hpp>
 
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
+
 #include "authorizer/local/authorizer.hpp"
 
 #include "tests/mesos.hpp"
@@ -27,6 +34,11 @@
 
 using namespace process;
 
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
 namespace mesos {
 namespace internal {
 namespace tests {
@@ -405,6 +417,230 @@ TYPED_TEST(AuthorizationTest, PrincipalNotOfferedAnyRoleRestrictive)
   AWAIT_EXPECT_EQ(false, authorizer.get()->authorize(request3));
 }
 
+
+// Checks that the first matching ACL decides, whether it lists the
+// principal or matches any principal, including for repeated
+// (possibly cached) requests.
+TYPED_TEST(AuthorizationTest, FirstMatchingAclDecides)
+{
+  ACLs acls;
+  acls.set_permissive(false);
+
+  {
+    // Principal "foo" can run as "alice".
+    mesos::ACL::RunTask* acl = acls.add_run_tasks();
+    acl->mutable_principals()->add_values("foo");
+    acl->mutable_users()->add_values("alice");
+  }
+
+  {
+    // Any principal can run as "bob".
+    mesos::ACL::RunTask* acl = acls.add_run_tasks();
+    acl->mutable_principals()->set_type(mesos::ACL::Entity::ANY);
+    acl->mutable_users()->add_values("bob");
+  }
+
+  {
+    // Principals "foo" and "bar" cannot run as any other user.
+    mesos::ACL::RunTask* acl = acls.add_run_tasks();
+    acl->mutable_principals()->add_values("foo");
+    acl->mutable_principals()->add_values("bar");
+    acl->mutable_users()->set_type(mesos::ACL::Entity::NONE);
+  }
+
+  {
+    // Any other principal can run as any user.
+    mesos::ACL::RunTask* acl = acls.add_run_tasks();
+    acl->mutable_principals()->set_type(mesos::ACL::Entity::ANY);
+    acl->mutable_users()->set_type(mesos::ACL::Entity::ANY);
+  }
+
+  // Create an Authorizer with the ACLs.
+  Try<Authorizer*> create = TypeParam::create();
+  ASSERT_SOME(create);
+  Owned<Authorizer> authorizer(create.get());
+
+  Try<Nothing> initialized = authorizer.get()->initialize(acls);
+  ASSERT_SOME(initialized);
+
+  const bool expected[][3] = {
+    // "alice", "bob",  "carol"
+    {true,      true,   false},  // "foo"
+    {false,     true,   false},  // "bar"
+    {true,      true,   true},   // "baz"
+  };
+
+  const string principals[] = {"foo", "bar", "baz"};
+  const string users[] = {"alice", "bob", "carol"};
+
+  // Authorize every request twice.
+  for (int round = 0; round < 2; round++) {
+    for (int i = 0; i < 3; i++) {
+      for (int j = 0; j < 3; j++) {
+        mesos::ACL::RunTask request;
+        request.mutable_principals()->add_values(principals[i]);
+        request.mutable_users()->add_values(users[j]);
+
+        AWAIT_EXPECT_EQ(expected[i][j], authorizer.get()->authorize(request))
+          << principals[i] << " as " << users[j];
+      }
+    }
+  }
+}
+
+
+// Checks that authorizing tasks in a batch decides each request as
+// it would be decided on its own, including requests which are not
+// for a single principal and user.
+TYPED_TEST(AuthorizationTest, BatchedRunTasks)
+{
+  ACLs acls;
+  acls.set_permissive(false);
+
+  {
+    // Principal "foo" can run as "alice" and "bob".
+    mesos::ACL::RunTask* acl = acls.add_run_tasks();
+    acl->mutable_principals()->add_values("foo");
+    acl->mutable_users()->add_values("alice");
+    acl->mutable_users()->add_values("bob");
+  }
+
+  {
+    // Any principal can run as "guest".
+    mesos::ACL::RunTask* acl = acls.add_run_tasks();
+    acl->mutable_principals()->set_type(mesos::ACL::Entity::ANY);
+    acl->mutable_users()->add_values("guest");
+  }
+
+  // Create an Authorizer with the ACLs.
+  Try<Authorizer*> create = TypeParam::create();
+  ASSERT_SOME(create);
+  Owned<Authorizer> authorizer(create.get());
+
+  Try<Nothing> initialized = authorizer.get()->initialize(acls);
+  ASSERT_SOME(initialized);
+
+  vector<mesos::ACL::RunTask> requests;
+
+  // Principal "foo" can run as "alice".
+  mesos::ACL::RunTask request1;
+  request1.mutable_principals()->add_values("foo");
+  request1.mutable_users()->add_values("alice");
+  requests.push_back(request1);
+
+  // Principal "bar" cannot run as "alice".
+  mesos::ACL::RunTask request2;
+  request2.mutable_principals()->add_values("bar");
+  request2.mutable_users()->add_values("alice");
+  requests.push_back(request2);
+
+  // Principal "bar" can run as "guest".
+  mesos::ACL::RunTask request3;
+  request3.mutable_principals()->add_values("bar");
+  request3.mutable_users()->add_values("guest");
+  requests.push_back(request3);
+
+  Future<vector<bool>> authorizations = authorizer.get()->authorize(requests);
+  AWAIT_READY(authorizations);
+
+  EXPECT_EQ(vector<bool>({true, false, true}), authorizations.get());
+
+  // A principal without a value (i.e., a framework without a
+  // principal) can run as "guest", but not as "alice".
+  mesos::ACL::RunTask request4;
+  request4.mutable_principals()->set_type(mesos::ACL::Entity::ANY);
+  request4.mutable_users()->add_values("guest");
+  requests.push_back(request4);
+
+  mesos::ACL::RunTask request5;
+  request5.mutable_principals()->set_type(mesos::ACL::Entity::ANY);
+  request5.mutable_users()->add_values("alice");
+  requests.push_back(request5);
+
+  authorizations = authorizer.get()->authorize(requests);
+  AWAIT_READY(authorizations);
+
+  EXPECT_EQ(vector<bool>({true, false, true, true, false}),
+            authorizations.get());
+
+  // Each request is decided as it would be on its own.
+  for (size_t i = 0; i < requests.size(); i++) {
+    AWAIT_EXPECT_EQ(
+        authorizations.get()[i], authorizer.get()->authorize(requests[i]));
+  }
+}
+
+class LocalAuthorizer_BENCHMARK_Test
+  : public ::testing::Test,
+    public ::testing::WithParamInterface<size_t> {};
+
+
+// The local authorizer benchmark is parameterized by the number of
+// ACLs.
+INSTANTIATE_TEST_CASE_P(
+    AclCount,
+    LocalAuthorizer_BENCHMARK_Test,
+    ::testing::Values(10U, 100U, 1000U));
+
+
+// Measures authorizing tasks against ACLs allowing each principal to
+// run as its own user. The requests are spread over all principals
+// (and a few unknown ones), both the first time (when the decision
+// is computed) and afterwards (when it is cached).
+TEST_P(LocalAuthorizer_BENCHMARK_Test, RunTask)
+{
+  const size_t aclCount = GetParam();
+  const size_t requestCount = 100000;
+
+  ACLs acls;
+  acls.set_permissive(false);
+
+  for (size_t i = 0; i < aclCount; i++) {
+    mesos::ACL::RunTask* acl = acls.add_run_tasks();
+    acl->mutable_principals()->add_values("principal-" + stringify(i));
+    acl->mutable_users()->add_values("user-" + stringify(i));
+  }
+
+  Try<Authorizer*> create = LocalAuthorizer::create();
+  ASSERT_SOME(create);
+  Owned<Authorizer> authorizer(create.get());
+
+  ASSERT_SOME(authorizer.get()->initialize(acls));
+
+  vector<mesos::ACL::RunTask> requests;
+  for (size_t i = 0; i < aclCount + aclCount / 10; i++) {
+    mesos::ACL::RunTask request;
+    request.mutable_principals()->add_values("principal-" + stringify(i));
+    request.mutable_users()->add_values("user-" + stringify(i));
+    requests.push_back(request);
+  }
+
+  for (int round = 0; round < 2; round++) {
+    Stopwatch watch;
+    watch.start();
+
+    size_t allowed = 0;
+    for (size_t i = 0; i < requestCount; i++) {
+      Future<bool> authorized =
+        authorizer.get()->authorize(requests[i % requests.size()]);
+
+      AWAIT_READY(authorized);
+
+      if (authorized.get()) {
+        allowed++;
+      }
+    }
+
+    watch.stop();
+
+    EXPECT_LT(0u, allowed);
+
+    cout << (round == 0 ? "Cold: " : "Warm: ")
+         << "Authorized " << requestCount << " tasks against " << aclCount
+         << " ACLs in " << watch.elapsed() << endl;
+  }
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -14,6 +14,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <iostream>
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -21,8 +22,14 @@
 #include <mesos/mesos.hpp>
 #include <mesos/resources.hpp>
 
+#include <mesos/scheduler/scheduler.hpp>
+
+#include <stout/bytes.hpp>
 #include <stout/gtest.hpp>
 #include <stout/json.hpp>
+#include <stout/json/reader.hpp>
+#include <stout/protobuf.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
 
 #include "common/http.hpp"
@@ -33,8 +40,12 @@
 using namespace mesos;
 using namespace mesos::internal;
 
+using std::cout;
+using std::endl;
 using std::vector;
 
+using testing::WithParamInterface;
+
 using mesos::internal::protobuf::createTask;
 
 // TODO(bmahler): Add tests for other JSON models.
@@ -222,3 +233,72 @@ TEST(HTTP, SerializeNetworkInfo)
   ASSERT_SOME(expected);
   EXPECT_EQ(expected.get(), object);
 }
+
+
+class HTTP_BENCHMARK_Test : public ::testing::Test,
+                            public WithParamInterface<size_t>
+{};
+
+
+// The HTTP benchmark tests are parameterized by the number of tasks
+// launched by a single ACCEPT call.
+INSTANTIATE_TEST_CASE_P(
+    TasksPerAccept,
+    HTTP_BENCHMARK_Test,
+    ::testing::Values(1000U, 10000U, 50000U));
+
+
+// Compares decoding a JSON scheduler call via an intermediate
+// JSON::Value against decoding it directly with JSON::Reader.
+TEST_P(HTTP_BENCHMARK_Test, DeserializeJSON)
+{
+  const size_t taskCount = GetParam();
+
+  Resources resources = Resources::parse(
+      "cpus:0.1;mem:32;disk:32;ports:[31000-31005]").get();
+
+  scheduler::Call call;
+  call.set_type(scheduler::Call::ACCEPT);
+  call.mutable_framework_id()->set_value("framework");
+
+  scheduler::Call::Accept* accept = call.mutable_accept();
+  accept->add_offer_ids()->set_value("offer");
+
+  Offer::Operation* operation = accept->add_operations();
+  operation->set_type(Offer::Operation::LAUNCH);
+
+  for (size_t i = 0; i < taskCount; i++) {
+    TaskInfo* task = operation->mutable_launch()->add_task_infos();
+    task->set_name("task-" + stringify(i));
+    task->mutable_task_id()->set_value("task-" + stringify(i));
+    task->mutable_slave_id()->set_value("slave");
+    task->mutable_resources()->CopyFrom(resources);
+    task->mutable_command()->set_value("sleep 1000");
+  }
+
+  const std::string json = stringify(JSON::protobuf(call));
+
+  cout << "Decoding an ACCEPT with " << taskCount << " tasks"
+       << " (" << Bytes(json.size()) << " of JSON)" << endl;
+
+  Stopwatch watch;
+  watch.start();
+
+  Try<JSON::Value> value = JSON::parse(json);
+  ASSERT_SOME(value);
+
+  Try<scheduler::Call> dom = ::protobuf::parse<scheduler::Call>(value.get());
+  ASSERT_SOME(dom);
+
+  cout << "JSON::Value based decoding took " << watch.elapsed() << endl;
+
+  watch.start();
+
+  JSON::Reader reader(json);
+  Try<scheduler::Call> stream = ::protobuf::parse<scheduler::Call>(&reader);
+  ASSERT_SOME(stream);
+
+  cout << "JSON::Reader based decoding took " << watch.elapsed() << endl;
+
+  EXPECT_EQ(dom.get().SerializeAsString(), stream.get().SerializeAsString());
+}
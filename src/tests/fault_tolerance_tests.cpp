@@ -14,6 +14,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <iostream>
 #include <string>
 #include <vector>
 
@@ -32,12 +33,14 @@
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/http.hpp>
+#include <process/id.hpp>
 #include <process/owned.hpp>
 #include <process/pid.hpp>
 #include <process/process.hpp>
 #include <process/protobuf.hpp>
 
 #include <stout/json.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
 #include <stout/uuid.hpp>
 
@@ -71,6 +74,8 @@ using process::UPID;
 using process::http::OK;
 using process::http::Response;
 
+using std::cout;
+using std::endl;
 using std::string;
 using std::vector;
 
@@ -82,6 +87,7 @@ using testing::Eq;
 using testing::Not;
 using testing::Return;
 using testing::SaveArg;
+using testing::WithParamInterface;
 
 namespace mesos {
 namespace internal {
@@ -1959,6 +1965,161 @@ TEST_F(FaultToleranceTest, UpdateFrameworkInfoOnSchedulerFailover)
   Shutdown();
 }
 
+
+
+// Returns a re-registration message for a simulated agent with the
+// specified number of running tasks of the given framework.
+static ReregisterSlaveMessage createReregisterSlaveMessage(
+    size_t index,
+    size_t tasks,
+    const FrameworkID& frameworkId)
+{
+  ReregisterSlaveMessage message;
+  message.set_version(MESOS_VERSION);
+
+  SlaveInfo* info = message.mutable_slave();
+  info->mutable_id()->set_value("agent-" + stringify(index));
+  info->set_hostname("agent-" + stringify(index));
+  info->set_checkpoint(true);
+  info->mutable_resources()->CopyFrom(
+      Resources::parse("cpus:1000;mem:1000000").get());
+
+  const Resources resources = Resources::parse("cpus:0.1;mem:32").get();
+
+  for (size_t i = 0; i < tasks; i++) {
+    const string id = "task-" + stringify(index) + "-" + stringify(i);
+
+    Task* task = message.add_tasks();
+    task->set_name(id);
+    task->mutable_task_id()->set_value(id);
+    task->mutable_framework_id()->CopyFrom(frameworkId);
+    task->mutable_slave_id()->CopyFrom(info->id());
+    task->mutable_resources()->CopyFrom(resources);
+    task->set_state(TASK_RUNNING);
+  }
+
+  return message;
+}
+
+
+// This test ensures that a slave re-registering with a failed over
+// master with invalid tasks is shut down rather than admitted.
+TEST_F(FaultToleranceTest, ReregisterSlaveWithInvalidTasks)
+{
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.authenticate_slaves = false;
+
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  // The simulated agent only needs a PID that the master can send
+  // messages to.
+  ProcessBase agent(process::ID::generate("agent"));
+  const UPID pid = process::spawn(&agent);
+
+  FrameworkID frameworkId;
+  frameworkId.set_value("framework");
+
+  ReregisterSlaveMessage message =
+    createReregisterSlaveMessage(0, 2, frameworkId);
+
+  // Report the same task twice.
+  message.mutable_tasks(1)->CopyFrom(message.tasks(0));
+
+  Future<ShutdownMessage> shutdown =
+    FUTURE_PROTOBUF(ShutdownMessage(), master.get(), pid);
+
+  string data;
+  message.SerializeToString(&data);
+
+  process::post(pid, master.get(), message.GetTypeName(),
+                data.data(), data.size());
+
+  AWAIT_READY(shutdown);
+
+  Shutdown();
+
+  process::terminate(pid);
+  process::wait(pid);
+}
+
+
+class MasterFailover_BENCHMARK_Test
+  : public MesosTest,
+    public WithParamInterface<size_t> {};
+
+
+// The master failover benchmark is parameterized by the number of
+// agents that re-register with the failed over master.
+INSTANTIATE_TEST_CASE_P(
+    AgentCount,
+    MasterFailover_BENCHMARK_Test,
+    ::testing::Values(1000U, 5000U, 10000U));
+
+
+// Measures the time it takes for all the agents (each with running
+// tasks) to re-register with a failed over master, i.e., a master
+// that has to readmit the agents through the registrar.
+TEST_P(MasterFailover_BENCHMARK_Test, Reregistration)
+{
+  const size_t agentCount = GetParam();
+  const size_t tasksPerAgent = 10;
+
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.authenticate_slaves = false;
+
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  FrameworkID frameworkId;
+  frameworkId.set_value("framework");
+
+  // The simulated agents only need a PID that the master can link
+  // to, the messages sent to them are dropped.
+  vector<Owned<ProcessBase>> agents;
+  vector<ReregisterSlaveMessage> messages;
+  vector<Future<SlaveReregisteredMessage>> reregistered;
+
+  for (size_t i = 0; i < agentCount; i++) {
+    agents.push_back(Owned<ProcessBase>(
+        new ProcessBase(process::ID::generate("agent"))));
+
+    const UPID pid = process::spawn(agents.back().get());
+
+    messages.push_back(
+        createReregisterSlaveMessage(i, tasksPerAgent, frameworkId));
+
+    reregistered.push_back(
+        FUTURE_PROTOBUF(SlaveReregisteredMessage(), master.get(), pid));
+  }
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < agentCount; i++) {
+    string data;
+    messages[i].SerializeToString(&data);
+
+    process::post(agents[i]->self(), master.get(),
+                  messages[i].GetTypeName(), data.data(), data.size());
+  }
+
+  foreach (const Future<SlaveReregisteredMessage>& future, reregistered) {
+    AWAIT_READY_FOR(future, Minutes(10));
+  }
+
+  cout << "Re-registered " << agentCount << " agents with "
+       << agentCount * tasksPerAgent << " tasks in " << watch.elapsed()
+       << endl;
+
+  Shutdown();
+
+  foreach (const Owned<ProcessBase>& agent, agents) {
+    process::terminate(agent.get());
+    process::wait(agent.get());
+  }
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -16,6 +16,7 @@
 
 #include <stdint.h>
 
+#include <iostream>
 #include <list>
 #include <set>
 #include <string>
@@ -23,6 +24,7 @@
 #include <gmock/gmock.h>
 
 #include <process/clock.hpp>
+#include <process/collect.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
@@ -32,6 +34,7 @@
 #include <process/protobuf.hpp>
 #include <process/shared.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
 #include <stout/none.hpp>
 #include <stout/option.hpp>
@@ -62,6 +65,8 @@ using namespace mesos::internal::log;
 
 using namespace process;
 
+using std::cout;
+using std::endl;
 using std::list;
 using std::set;
 using std::string;
@@ -316,6 +321,124 @@ TYPED_TEST(LogStorageTest, TruncateWithManyHoles)
 }
 
 
+TYPED_TEST(LogStorageTest, Sync)
+{
+  const string path = os::getcwd() + "/.log";
+
+  {
+    TypeParam storage;
+
+    Try<Storage::State> state = storage.restore(path);
+    ASSERT_SOME(state);
+
+    Metadata metadata;
+    metadata.set_status(Metadata::VOTING);
+    metadata.set_promised(1);
+
+    ASSERT_SOME(storage.persist(metadata));
+
+    for (uint64_t i = 0; i < 10; i++) {
+      Action action;
+      action.set_position(i);
+      action.set_promised(1);
+      action.set_performed(1);
+      action.set_learned(true);
+      action.set_type(Action::APPEND);
+      action.mutable_append()->set_bytes(stringify(i));
+
+      ASSERT_SOME(storage.persist(action));
+    }
+
+    // Persisted records are readable before they are synced.
+    Try<Action> action = storage.read(5);
+    ASSERT_SOME(action);
+    EXPECT_EQ(stringify(5), action.get().append().bytes());
+
+    ASSERT_SOME(storage.sync());
+
+    // Truncate to position 3 (at position 10) without syncing; the
+    // truncated positions must not be readable from leveldb anymore.
+    Action truncate;
+    truncate.set_position(10);
+    truncate.set_promised(1);
+    truncate.set_performed(1);
+    truncate.set_learned(true);
+    truncate.set_type(Action::TRUNCATE);
+    truncate.mutable_truncate()->set_to(3);
+
+    ASSERT_SOME(storage.persist(truncate));
+
+    EXPECT_ERROR(storage.read(2));
+    EXPECT_SOME(storage.read(3));
+
+    ASSERT_SOME(storage.sync());
+  }
+
+  TypeParam storage;
+
+  Try<Storage::State> state = storage.restore(path);
+  ASSERT_SOME(state);
+
+  EXPECT_EQ(Metadata::VOTING, state.get().metadata.status());
+  EXPECT_EQ(1u, state.get().metadata.promised());
+  EXPECT_EQ(3u, state.get().begin);
+  EXPECT_EQ(10u, state.get().end);
+
+  EXPECT_ERROR(storage.read(2));
+
+  Try<Action> action = storage.read(9);
+  ASSERT_SOME(action);
+  EXPECT_EQ(stringify(9), action.get().append().bytes());
+}
+
+
+// Measures the rate at which actions are persisted when every action
+// is synced on its own versus when they are synced in groups, as the
+// replica does for concurrent requests.
+TYPED_TEST(LogStorageTest, Storage_BENCHMARK_Persist)
+{
+  const uint64_t actions = 1000;
+  const string bytes(1024, 'x');
+
+  TypeParam storage;
+
+  Try<Storage::State> state = storage.restore(os::getcwd() + "/.log");
+  ASSERT_SOME(state);
+
+  const uint64_t groups[] = {1, 16, 128};
+
+  uint64_t position = 0;
+
+  foreach (uint64_t group, groups) {
+    Stopwatch stopwatch;
+    stopwatch.start();
+
+    for (uint64_t i = 0; i < actions; i++) {
+      Action action;
+      action.set_position(position++);
+      action.set_promised(1);
+      action.set_performed(1);
+      action.set_type(Action::APPEND);
+      action.mutable_append()->set_bytes(bytes);
+
+      ASSERT_SOME(storage.persist(action));
+
+      if ((i + 1) % group == 0) {
+        ASSERT_SOME(storage.sync());
+      }
+    }
+
+    ASSERT_SOME(storage.sync());
+
+    Duration elapsed = stopwatch.elapsed();
+
+    cout << "Persisted " << actions << " actions synced in groups of "
+         << group << " in " << elapsed << " ("
+         << actions / elapsed.secs() << " actions/s)" << endl;
+  }
+}
+
+
 class ReplicaTest : public TemporaryDirectoryTest
 {
 protected:
@@ -916,6 +1039,120 @@ TEST_F(CoordinatorTest, Failover)
 }
 
 
+TEST_F(CoordinatorTest, AppendConcurrent)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network(new Network(pids));
+
+  Coordinator coord(2, replica1, network);
+
+  {
+    Future<Option<uint64_t> > electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  list<Future<Option<uint64_t> > > appendings;
+  for (uint64_t position = 1; position <= 100; position++) {
+    appendings.push_back(coord.append(stringify(position)));
+  }
+
+  uint64_t position = 1;
+  foreach (const Future<Option<uint64_t> >& appending, appendings) {
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(position++, appending.get());
+  }
+
+  {
+    Future<list<Action> > actions = replica1->read(1, 100);
+    AWAIT_READY(actions);
+    ASSERT_EQ(100u, actions.get().size());
+
+    uint64_t expected = 1;
+    foreach (const Action& action, actions.get()) {
+      EXPECT_EQ(expected, action.position());
+      ASSERT_TRUE(action.has_type());
+      ASSERT_EQ(Action::APPEND, action.type());
+      EXPECT_EQ(stringify(expected), action.append().bytes());
+      expected++;
+    }
+  }
+}
+
+
+// Ensures that if a write is rejected while later writes are in
+// flight, the later writes are not reported successful even if they
+// were accepted by the replicas.
+TEST_F(CoordinatorTest, AppendConcurrentRejected)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network(new Network(pids));
+
+  Coordinator coord(2, replica1, network);
+
+  {
+    Future<Option<uint64_t> > electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  // Explicitly promise position 1 (but none of the later positions)
+  // to a higher proposal than the one of the coordinator, so that its
+  // write to position 1 is rejected.
+  foreach (const UPID& pid, pids) {
+    PromiseRequest request;
+    request.set_proposal(2);
+    request.set_position(1);
+
+    Future<PromiseResponse> promising = protocol::promise(pid, request);
+    AWAIT_READY(promising);
+    EXPECT_TRUE(promising.get().okay());
+  }
+
+  Future<Option<uint64_t> > appending1 = coord.append("hello world");
+  Future<Option<uint64_t> > appending2 = coord.append("hello moto");
+
+  AWAIT_READY(appending1);
+  EXPECT_NONE(appending1.get());
+
+  AWAIT_READY(appending2);
+  EXPECT_NONE(appending2.get());
+
+  // The coordinator has been demoted.
+  Future<Option<uint64_t> > appending3 = coord.append("hello hello");
+  AWAIT_READY(appending3);
+  EXPECT_NONE(appending3.get());
+}
+
+
 TEST_F(CoordinatorTest, Demoted)
 {
   const string path1 = os::getcwd() + "/.log1";
@@ -2055,6 +2292,76 @@ TEST_F(LogTest, Position)
 }
 
 
+// Measures the rate at which entries are appended to the log, both
+// when each append waits for the previous one and when the appends
+// are issued concurrently (and thus pipelined by the coordinator).
+TEST_F(LogTest, Log_BENCHMARK_Throughput)
+{
+  const size_t entries = 1000;
+
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  Replica replica1(path1);
+
+  set<UPID> pids;
+  pids.insert(replica1.pid());
+
+  Log log(2, path2, pids);
+
+  Log::Writer writer(&log);
+
+  Future<Option<Log::Position> > start = writer.start();
+
+  AWAIT_READY(start);
+  ASSERT_SOME(start.get());
+
+  const string data(1024, 'x');
+
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  for (size_t i = 0; i < entries; i++) {
+    Future<Option<Log::Position> > position = writer.append(data);
+    AWAIT_READY(position);
+    ASSERT_SOME(position.get());
+  }
+
+  Duration elapsed = stopwatch.elapsed();
+
+  cout << "Sequentially appended " << entries << " entries in "
+       << elapsed << " (" << entries / elapsed.secs() << " entries/s)"
+       << endl;
+
+  list<Future<Option<Log::Position> > > positions;
+
+  stopwatch.start();
+
+  for (size_t i = 0; i < entries; i++) {
+    positions.push_back(writer.append(data));
+  }
+
+  Future<list<Option<Log::Position> > > appended = process::collect(positions);
+
+  AWAIT_READY_FOR(appended, Seconds(60));
+
+  elapsed = stopwatch.elapsed();
+
+  foreach (const Option<Log::Position>& position, appended.get()) {
+    ASSERT_SOME(position);
+  }
+
+  cout << "Concurrently appended " << entries << " entries in "
+       << elapsed << " (" << entries / elapsed.secs() << " entries/s)"
+       << endl;
+}
+
+
 #ifdef MESOS_HAS_JAVA
 // TODO(jieyu): We copy the code from TemporaryDirectoryTest here
 // because we cannot inherit from two test fixtures. In this future,
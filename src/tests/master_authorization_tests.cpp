@@ -14,6 +14,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <iostream>
+#include <string>
 #include <vector>
 
 #include <gmock/gmock.h>
@@ -25,10 +27,14 @@
 
 #include <process/clock.hpp>
 #include <process/future.hpp>
+#include <process/id.hpp>
 #include <process/pid.hpp>
+#include <process/process.hpp>
 #include <process/protobuf.hpp>
 
 #include <stout/gtest.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
 #include <stout/try.hpp>
 
 #include "master/master.hpp"
@@ -52,7 +58,11 @@ using process::Clock;
 using process::Future;
 using process::PID;
 using process::Promise;
+using process::UPID;
 
+using std::cout;
+using std::endl;
+using std::string;
 using std::vector;
 
 using testing::_;
@@ -60,6 +70,7 @@ using testing::An;
 using testing::AtMost;
 using testing::DoAll;
 using testing::Return;
+using testing::WithParamInterface;
 
 namespace mesos {
 namespace internal {
@@ -209,6 +220,73 @@ TEST_F(MasterAuthorizationTest, UnauthorizedTask)
 }
 
 
+// An authorizer that answers a batch of task launches with one
+// result too few, as a misbehaving authorizer module might.
+class ShortBatchAuthorizer : public MockAuthorizer
+{
+public:
+  using MockAuthorizer::authorize;
+
+  virtual Future<vector<bool>> authorize(
+      const vector<mesos::ACL::RunTask>& requests)
+  {
+    return vector<bool>(requests.size() - 1, true);
+  }
+};
+
+
+// This test verifies that the tasks are rejected if the authorizer
+// does not return one result per task.
+TEST_F(MasterAuthorizationTest, BatchSizeMismatch)
+{
+  ShortBatchAuthorizer authorizer;
+  Try<PID<Master> > master = StartMaster(&authorizer);
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  Try<PID<Slave> > slave = StartSlave(&exec);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .Times(1);
+
+  Future<vector<Offer> > offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  TaskInfo task = createTask(offers.get()[0], "", DEFAULT_EXECUTOR_ID);
+
+  EXPECT_CALL(exec, registered(_, _, _, _))
+    .Times(0);
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.launchTasks(offers.get()[0].id(), {task});
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_ERROR, status.get().state());
+  EXPECT_EQ(TaskStatus::REASON_TASK_UNAUTHORIZED, status.get().reason());
+
+  driver.stop();
+  driver.join();
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+}
+
+
 // This test verifies that a 'killTask()' that comes before
 // '_launchTasks()' is called results in TASK_KILLED.
 TEST_F(MasterAuthorizationTest, KillTask)
@@ -1009,6 +1087,147 @@ TEST_F(MasterAuthorizationTest, FrameworkRemovedBeforeReregistration)
   Shutdown();
 }
 
+
+// A simulated agent that counts the tasks that the master asks it to
+// run.
+class RunTaskCounter : public ProtobufProcess<RunTaskCounter>
+{
+public:
+  explicit RunTaskCounter(size_t _expected)
+    : ProcessBase(process::ID::generate("agent")),
+      expected(_expected),
+      received(0) {}
+
+  Future<Nothing> launched()
+  {
+    return promise.future();
+  }
+
+protected:
+  virtual void initialize()
+  {
+    install<RunTaskMessage>(&RunTaskCounter::runTask);
+  }
+
+private:
+  void runTask(const UPID& from, const RunTaskMessage& message)
+  {
+    received++;
+
+    if (received >= expected) {
+      promise.set(Nothing());
+    }
+  }
+
+  const size_t expected;
+  size_t received;
+  Promise<Nothing> promise;
+};
+
+
+class MasterAuthorization_BENCHMARK_Test
+  : public MesosTest,
+    public WithParamInterface<size_t> {};
+
+
+// The accept benchmark is parameterized by the number of tasks
+// launched by a single offer acceptance.
+INSTANTIATE_TEST_CASE_P(
+    TasksPerAccept,
+    MasterAuthorization_BENCHMARK_Test,
+    ::testing::Values(1U, 100U, 1000U, 5000U));
+
+
+// Measures the time it takes from a framework accepting an offer
+// until the (simulated) agent is asked to run all the authorized
+// tasks.
+TEST_P(MasterAuthorization_BENCHMARK_Test, Accept)
+{
+  const size_t taskCount = GetParam();
+
+  // Setup ACLs so that the framework can launch tasks as any user.
+  ACLs acls;
+  mesos::ACL::RunTask* acl = acls.add_run_tasks();
+  acl->mutable_principals()->add_values(DEFAULT_FRAMEWORK_INFO.principal());
+  acl->mutable_users()->set_type(mesos::ACL::Entity::ANY);
+
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.acls = acls;
+  masterFlags.authenticate_slaves = false;
+
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  RunTaskCounter agent(taskCount);
+  const UPID pid = process::spawn(&agent);
+
+  RegisterSlaveMessage registerSlaveMessage;
+  registerSlaveMessage.set_version(MESOS_VERSION);
+  registerSlaveMessage.mutable_slave()->set_hostname("agent");
+  registerSlaveMessage.mutable_slave()->mutable_resources()->CopyFrom(
+      Resources::parse("cpus:1000;mem:1000000").get());
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), pid);
+
+  string data;
+  registerSlaveMessage.SerializeToString(&data);
+
+  process::post(pid, master.get(), registerSlaveMessage.GetTypeName(),
+                data.data(), data.size());
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  ASSERT_EQ(1u, offers.get().size());
+
+  const Offer& offer = offers.get()[0];
+  const Resources resources = Resources::parse("cpus:0.1;mem:32").get();
+
+  vector<TaskInfo> tasks;
+  for (size_t i = 0; i < taskCount; i++) {
+    TaskInfo task;
+    task.set_name("task-" + stringify(i));
+    task.mutable_task_id()->set_value("task-" + stringify(i));
+    task.mutable_slave_id()->CopyFrom(offer.slave_id());
+    task.mutable_resources()->CopyFrom(resources);
+    task.mutable_command()->set_value("sleep 1000");
+
+    tasks.push_back(task);
+  }
+
+  Stopwatch watch;
+  watch.start();
+
+  driver.launchTasks(offer.id(), tasks);
+
+  AWAIT_READY_FOR(agent.launched(), Minutes(5));
+
+  cout << "Launched " << taskCount << " tasks in a single accept in "
+       << watch.elapsed() << endl;
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+
+  process::terminate(agent);
+  process::wait(agent);
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
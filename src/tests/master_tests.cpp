@@ -16,6 +16,8 @@
 
 #include <unistd.h>
 
+#include <algorithm>
+#include <iostream>
 #include <memory>
 #include <string>
 #include <vector>
@@ -33,23 +35,37 @@
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/http.hpp>
+#include <process/id.hpp>
+#include <process/owned.hpp>
 #include <process/pid.hpp>
+#include <process/protobuf.hpp>
+#include <process/time.hpp>
+#include <process/timer.hpp>
 
 #include <process/metrics/counter.hpp>
 #include <process/metrics/metrics.hpp>
 
+#include <stout/hashmap.hpp>
 #include <stout/json.hpp>
+#include <stout/lambda.hpp>
 #include <stout/net.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
+#include <stout/recordio.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/strings.hpp>
 #include <stout/try.hpp>
+#include <stout/uuid.hpp>
 
 #include "common/build.hpp"
+#include "common/http.hpp"
 #include "common/protobuf_utils.hpp"
+#include "common/recordio.hpp"
 
 #include "master/flags.hpp"
 #include "master/master.hpp"
+#include "master/offer_expiry.hpp"
+#include "master/state_events.hpp"
 
 #include "master/allocator/mesos/allocator.hpp"
 
@@ -71,6 +87,8 @@ using mesos::internal::master::allocator::MesosAllocatorProcess;
 
 using mesos::internal::protobuf::createLabel;
 
+using mesos::internal::recordio::Reader;
+
 using mesos::internal::slave::GarbageCollectorProcess;
 using mesos::internal::slave::Slave;
 using mesos::internal::slave::Containerizer;
@@ -78,9 +96,17 @@ using mesos::internal::slave::MesosContainerizerProcess;
 
 using process::Clock;
 using process::Future;
+using process::Owned;
 using process::PID;
+using process::ProcessBase;
 using process::Promise;
+using process::Time;
+using process::UPID;
+
+using recordio::Decoder;
 
+using std::cout;
+using std::endl;
 using std::shared_ptr;
 using std::string;
 using std::vector;
@@ -92,6 +118,7 @@ using testing::Eq;
 using testing::Not;
 using testing::Return;
 using testing::SaveArg;
+using testing::WithParamInterface;
 
 namespace mesos {
 namespace internal {
@@ -2911,6 +2938,167 @@ TEST_F(MasterTest, StateEndpoint)
 }
 
 
+// Tests that the subscribers of '/events' are sent a snapshot of the
+// state of the master, followed by the changes of the state.
+TEST_F(MasterTest, EventsEndpoint)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  process::http::Headers headers;
+  headers["Accept"] = APPLICATION_JSON;
+
+  Future<process::http::Response> response =
+    process::http::streaming::get(master.get(), "events", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+  ASSERT_EQ(process::http::Response::PIPE, response.get().type);
+  ASSERT_SOME(response.get().reader);
+
+  auto deserializer =
+    lambda::bind(deserialize<StateEvent>, ContentType::JSON, lambda::_1);
+
+  Reader<StateEvent> decoder(
+      Decoder<StateEvent>(deserializer), response.get().reader.get());
+
+  Future<Result<StateEvent>> event = decoder.read();
+  AWAIT_READY(event);
+  ASSERT_SOME(event.get());
+
+  EXPECT_EQ(StateEvent::SNAPSHOT, event.get().get().type());
+  EXPECT_EQ(0, event.get().get().snapshot().agents_size());
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  event = decoder.read();
+  AWAIT_READY(event);
+  ASSERT_SOME(event.get());
+
+  EXPECT_EQ(StateEvent::AGENT_ADDED, event.get().get().type());
+  EXPECT_EQ(
+      slaveRegisteredMessage.get().slave_id(),
+      event.get().get().agent().id());
+
+  Shutdown();
+}
+
+
+// Tests that a subscriber of '/events' which does not receive the
+// events it is sent is disconnected rather than buffered for.
+TEST(StateEventsTest, SlowSubscriber)
+{
+  auto snapshot = []() {
+    StateEvent event;
+    event.set_type(StateEvent::SNAPSHOT);
+    return event;
+  };
+
+  // Any data that the subscriber has yet to receive exceeds the limit.
+  master::StateEvents events(
+      UPID(),
+      snapshot,
+      master::StateEvents::DEFAULT_CAPACITY,
+      Bytes(0));
+
+  process::http::Pipe pipe;
+  process::http::Pipe::Reader reader = pipe.reader();
+
+  events.subscribe(pipe.writer(), ContentType::JSON);
+  EXPECT_FALSE(events.empty());
+
+  SlaveInfo agent;
+  agent.set_hostname("host");
+  agent.mutable_id()->set_value("agent");
+
+  // The snapshot was not read, so the subscriber is disconnected
+  // instead of being sent the agent.
+  events.agentAdded(agent);
+  events.flush();
+
+  EXPECT_TRUE(events.empty());
+
+  Future<string> read = reader.read();
+  AWAIT_READY(read);
+  EXPECT_FALSE(read.get().empty());
+
+  AWAIT_EQ("", reader.read());
+}
+
+
+// Tests that requests with the 'ETag' of the current state are
+// answered with '304 Not Modified' and that long-polls are answered
+// once the state changes.
+TEST_F(MasterTest, StateEndpointVersion)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<process::http::Response> response =
+    process::http::get(master.get(), "state");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+
+  Option<string> etag = response.get().headers.get("ETag");
+  ASSERT_SOME(etag);
+
+  const string notModified =
+    process::http::Status::string(process::http::Status::NOT_MODIFIED);
+
+  process::http::Headers headers;
+  headers["If-None-Match"] = etag.get();
+
+  response = process::http::get(master.get(), "state", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(notModified, response);
+  EXPECT_SOME_EQ(etag.get(), response.get().headers.get("ETag"));
+
+  const string version = strings::trim(etag.get(), "\"");
+
+  // The long-poll times out since the state does not change.
+  response = process::http::get(
+      master.get(), "state", "version=" + version + "&timeout=10ms");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(notModified, response);
+
+  // The long-poll is answered once the agent is registered.
+  response = process::http::get(master.get(), "state", "version=" + version);
+
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+
+  Option<string> etag_ = response.get().headers.get("ETag");
+  ASSERT_SOME(etag_);
+  EXPECT_NE(etag.get(), etag_.get());
+
+  // A version of another master (e.g., before a failover) is
+  // outdated, even if its number is not lower.
+  const string version_ = strings::trim(etag_.get(), "\"");
+  const string other =
+    UUID::random().toString() +
+    version_.substr(version_.rfind('-'));
+
+  response = process::http::get(master.get(), "state", "version=" + other);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+
+  headers["If-None-Match"] = "\"" + other + "\"";
+
+  response = process::http::get(master.get(), "state", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+
+  Shutdown();
+}
+
+
 TEST_F(MasterTest, StateSummaryEndpoint)
 {
   master::Flags flags = CreateMasterFlags();
@@ -3948,6 +4136,1377 @@ TEST_F(MasterTest, FrameworksEndpointOneFramework)
   Shutdown();
 }
 
+// Tests that an agent with the '--batch_status_updates' flag
+// negotiates the BATCHED_STATUS_UPDATES capability with the master,
+// after which they exchange status updates and acknowledgements in
+// batches.
+TEST_F(MasterTest, BatchedStatusUpdates)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  TestContainerizer containerizer(&exec);
+
+  slave::Flags flags = CreateSlaveFlags();
+  flags.batch_status_updates = true;
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), _);
+
+  Try<PID<Slave>> slave = StartSlave(&containerizer, flags);
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  const MasterSlaveConnection& connection =
+    slaveRegisteredMessage.get().connection();
+
+  ASSERT_EQ(1, connection.capabilities_size());
+  EXPECT_EQ(SlaveCapability::BATCHED_STATUS_UPDATES,
+            connection.capabilities(0).type());
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  TaskInfo task = createTask(offers.get()[0], "", DEFAULT_EXECUTOR_ID);
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<StatusUpdatesMessage> statusUpdatesMessage =
+    FUTURE_PROTOBUF(StatusUpdatesMessage(), slave.get(), master.get());
+
+  Future<StatusUpdateAcknowledgementsMessage> acknowledgementsMessage =
+    FUTURE_PROTOBUF(
+        StatusUpdateAcknowledgementsMessage(), master.get(), slave.get());
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.launchTasks(offers.get()[0].id(), {task});
+
+  AWAIT_READY(statusUpdatesMessage);
+  ASSERT_EQ(1, statusUpdatesMessage.get().updates_size());
+  EXPECT_EQ(TASK_RUNNING,
+            statusUpdatesMessage.get().updates(0).update().status().state());
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+
+  AWAIT_READY(acknowledgementsMessage);
+  ASSERT_EQ(1, acknowledgementsMessage.get().acknowledgements_size());
+  EXPECT_EQ(task.task_id(),
+            acknowledgementsMessage.get().acknowledgements(0).task_id());
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
+// Returns the IDs of the tasks returned by the '/tasks' endpoint.
+static Future<vector<string>> taskIds(
+    const PID<Master>& master,
+    const string& query)
+{
+  return process::http::get(master, "tasks", query)
+    .then([](const process::http::Response& response)
+        -> Future<vector<string>> {
+      Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.body);
+      if (parse.isError()) {
+        return process::Failure(parse.error());
+      }
+
+      Result<JSON::Array> tasks = parse.get().find<JSON::Array>("tasks");
+      if (!tasks.isSome()) {
+        return process::Failure("Expecting 'tasks' to be an array");
+      }
+
+      vector<string> ids;
+      foreach (const JSON::Value& task, tasks.get().values) {
+        ids.push_back(
+            task.as<JSON::Object>().values.at("id").as<JSON::String>().value);
+      }
+
+      return ids;
+    });
+}
+
+
+// Checks that the '/tasks' endpoint returns the tasks in the order of
+// their earliest status and the boundaries of its 'offset' and
+// 'limit' query parameters.
+TEST_F(MasterTest, TasksEndpoint)
+{
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.authenticate_slaves = false;
+
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<FrameworkID> frameworkId;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId));
+
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillRepeatedly(Return()); // Ignore offers.
+
+  driver.start();
+
+  AWAIT_READY(frameworkId);
+
+  // The tasks are added by an agent that is simulated by
+  // re-registering with the master, out of the order of their
+  // timestamps.
+  ProcessBase agent(process::ID::generate("agent"));
+  const UPID pid = process::spawn(&agent);
+
+  ReregisterSlaveMessage message;
+  message.set_version(MESOS_VERSION);
+
+  SlaveInfo* info = message.mutable_slave();
+  info->mutable_id()->set_value("agent");
+  info->set_hostname("agent");
+  info->set_checkpoint(true);
+  info->mutable_resources()->CopyFrom(
+      Resources::parse("cpus:100;mem:10000").get());
+
+  const size_t taskCount = 10;
+
+  // The IDs of the tasks in ascending order.
+  vector<string> ascending(taskCount);
+
+  for (size_t i = 0; i < taskCount; i++) {
+    const size_t timestamp = (i * 3) % taskCount;
+
+    Task* task = message.add_tasks();
+    task->set_name("task-" + stringify(i));
+    task->mutable_task_id()->set_value("task-" + stringify(i));
+    task->mutable_framework_id()->CopyFrom(frameworkId.get());
+    task->mutable_slave_id()->CopyFrom(info->id());
+    task->mutable_resources()->CopyFrom(
+        Resources::parse("cpus:1;mem:32").get());
+    task->set_state(TASK_RUNNING);
+
+    TaskStatus* status = task->add_statuses();
+    status->mutable_task_id()->CopyFrom(task->task_id());
+    status->set_state(TASK_RUNNING);
+    status->set_timestamp(static_cast<double>(timestamp));
+
+    ascending[timestamp] = task->task_id().value();
+  }
+
+  const vector<string> descending(ascending.rbegin(), ascending.rend());
+
+  Future<SlaveReregisteredMessage> reregistered =
+    FUTURE_PROTOBUF(SlaveReregisteredMessage(), master.get(), pid);
+
+  string data;
+  message.SerializeToString(&data);
+
+  process::post(pid, master.get(), message.GetTypeName(),
+                data.data(), data.size());
+
+  AWAIT_READY(reregistered);
+
+  // The tasks are returned in descending order by default.
+  AWAIT_EXPECT_EQ(descending, taskIds(master.get(), ""));
+  AWAIT_EXPECT_EQ(descending, taskIds(master.get(), "order=desc"));
+  AWAIT_EXPECT_EQ(ascending, taskIds(master.get(), "order=asc"));
+
+  AWAIT_EXPECT_EQ(
+      vector<string>(ascending.begin() + 3, ascending.begin() + 7),
+      taskIds(master.get(), "order=asc&offset=3&limit=4"));
+
+  AWAIT_EXPECT_EQ(
+      vector<string>(descending.begin() + 3, descending.begin() + 7),
+      taskIds(master.get(), "offset=3&limit=4"));
+
+  // The range is cut off at the last task.
+  AWAIT_EXPECT_EQ(
+      vector<string>(ascending.begin() + 8, ascending.end()),
+      taskIds(master.get(), "order=asc&offset=8&limit=5"));
+
+  AWAIT_EXPECT_EQ(
+      vector<string>(1, descending.back()),
+      taskIds(master.get(), "offset=9"));
+
+  AWAIT_EXPECT_EQ(vector<string>(), taskIds(master.get(), "offset=10"));
+  AWAIT_EXPECT_EQ(vector<string>(), taskIds(master.get(), "offset=100"));
+  AWAIT_EXPECT_EQ(vector<string>(), taskIds(master.get(), "limit=0"));
+
+  AWAIT_EXPECT_EQ(
+      vector<string>(1, ascending.front()),
+      taskIds(master.get(), "order=asc&limit=1"));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+
+  process::terminate(agent);
+  process::wait(agent);
+}
+
+
+// Returns the IDs of the tasks.
+static vector<string> taskIds(const vector<Task>& tasks)
+{
+  vector<string> ids;
+  foreach (const Task& task, tasks) {
+    ids.push_back(task.task_id().value());
+  }
+  return ids;
+}
+
+
+// Checks that the task index seeks to any offset in either order,
+// that re-added tasks are moved and that removed tasks are no longer
+// returned.
+TEST(TaskIndexTest, Range)
+{
+  const size_t taskCount = 100;
+
+  // NOTE: The index refers to the tasks, so they must not move.
+  vector<Task> tasks(taskCount);
+  master::TaskIndex index;
+
+  // The IDs of the indexed tasks in ascending order.
+  vector<string> ascending(taskCount);
+
+  for (size_t i = 0; i < taskCount; i++) {
+    const size_t timestamp = (i * 37) % taskCount;
+
+    Task& task = tasks[i];
+    task.mutable_task_id()->set_value("task-" + stringify(i));
+    task.set_state(TASK_RUNNING);
+
+    TaskStatus* status = task.add_statuses();
+    status->mutable_task_id()->CopyFrom(task.task_id());
+    status->set_state(TASK_RUNNING);
+    status->set_timestamp(static_cast<double>(timestamp));
+
+    index.add(&task);
+
+    ascending[timestamp] = task.task_id().value();
+  }
+
+  EXPECT_EQ(taskCount, index.size());
+
+  // Removes the tasks from the index (and the expected IDs) as well
+  // as re-adds a task with a later timestamp between the checks.
+  for (int round = 0; round < 3; round++) {
+    const vector<string> descending(ascending.rbegin(), ascending.rend());
+    const size_t size = ascending.size();
+
+    ASSERT_EQ(size, index.size());
+
+    foreach (size_t offset, vector<size_t>({0, 1, size / 2, size - 1, size,
+                                            size + 1})) {
+      foreach (size_t limit, vector<size_t>({0, 1, 10, size, size + 1})) {
+        const size_t begin = std::min(offset, size);
+        const size_t end = std::min(offset + limit, size);
+
+        EXPECT_EQ(
+            vector<string>(ascending.begin() + begin, ascending.begin() + end),
+            taskIds(index.range(offset, limit, true)))
+          << "offset " << offset << ", limit " << limit;
+
+        EXPECT_EQ(
+            vector<string>(
+                descending.begin() + begin, descending.begin() + end),
+            taskIds(index.range(offset, limit, false)))
+          << "offset " << offset << ", limit " << limit;
+      }
+    }
+
+    if (round == 0) {
+      // Remove every third task, and one of them twice.
+      for (size_t i = 0; i < taskCount; i += 3) {
+        index.remove(&tasks[i]);
+
+        ascending.erase(std::find(
+            ascending.begin(), ascending.end(), tasks[i].task_id().value()));
+      }
+
+      index.remove(&tasks[0]);
+
+      EXPECT_FALSE(index.contains(&tasks[0]));
+      EXPECT_TRUE(index.contains(&tasks[1]));
+    } else if (round == 1) {
+      // The task is moved to its new position.
+      tasks[1].mutable_statuses(0)->set_timestamp(
+          static_cast<double>(taskCount));
+
+      index.add(&tasks[1]);
+
+      ascending.erase(std::find(
+          ascending.begin(), ascending.end(), tasks[1].task_id().value()));
+      ascending.push_back(tasks[1].task_id().value());
+    }
+  }
+}
+
+
+class MasterTasksEndpoint_BENCHMARK_Test
+  : public MesosTest,
+    public WithParamInterface<size_t> {};
+
+
+// The tasks endpoint benchmark is parameterized by the number of tasks.
+INSTANTIATE_TEST_CASE_P(
+    TaskCount,
+    MasterTasksEndpoint_BENCHMARK_Test,
+    ::testing::Values(10000U, 50000U, 200000U));
+
+
+// Measures paginated queries of the '/tasks' endpoint on a master
+// with a large number of tasks. The tasks are added by agents that
+// are simulated by re-registering with the master.
+TEST_P(MasterTasksEndpoint_BENCHMARK_Test, Query)
+{
+  const size_t taskCount = GetParam();
+  const size_t tasksPerAgent = 1000;
+
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.authenticate_slaves = false;
+
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<FrameworkID> frameworkId;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId));
+
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillRepeatedly(Return()); // Ignore offers.
+
+  driver.start();
+
+  AWAIT_READY(frameworkId);
+
+  // The simulated agents only need a PID that the master can link
+  // to, the messages sent to them are dropped.
+  vector<Owned<ProcessBase>> agents;
+  vector<Future<SlaveReregisteredMessage>> reregistered;
+
+  Resources resources = Resources::parse("cpus:0.1;mem:32").get();
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i * tasksPerAgent < taskCount; i++) {
+    agents.push_back(Owned<ProcessBase>(
+        new ProcessBase(process::ID::generate("agent"))));
+
+    const UPID pid = process::spawn(agents.back().get());
+
+    ReregisterSlaveMessage message;
+    message.set_version(MESOS_VERSION);
+
+    SlaveInfo* info = message.mutable_slave();
+    info->mutable_id()->set_value("agent-" + stringify(i));
+    info->set_hostname("agent-" + stringify(i));
+    info->set_checkpoint(true);
+    info->mutable_resources()->CopyFrom(
+        Resources::parse("cpus:1000;mem:1000000").get());
+
+    for (size_t j = 0; j < tasksPerAgent; j++) {
+      const size_t index = i * tasksPerAgent + j;
+
+      Task* task = message.add_tasks();
+      task->set_name("task-" + stringify(index));
+      task->mutable_task_id()->set_value("task-" + stringify(index));
+      task->mutable_framework_id()->CopyFrom(frameworkId.get());
+      task->mutable_slave_id()->CopyFrom(info->id());
+      task->mutable_resources()->CopyFrom(resources);
+      task->set_state(TASK_RUNNING);
+
+      TaskStatus* status = task->add_statuses();
+      status->mutable_task_id()->CopyFrom(task->task_id());
+      status->set_state(TASK_RUNNING);
+      status->set_timestamp(static_cast<double>(index));
+    }
+
+    reregistered.push_back(
+        FUTURE_PROTOBUF(SlaveReregisteredMessage(), master.get(), pid));
+
+    string data;
+    message.SerializeToString(&data);
+
+    process::post(pid, master.get(), message.GetTypeName(),
+                  data.data(), data.size());
+  }
+
+  foreach (const Future<SlaveReregisteredMessage>& future, reregistered) {
+    AWAIT_READY_FOR(future, Minutes(5));
+  }
+
+  cout << "Re-registered " << agents.size() << " agents with "
+       << taskCount << " tasks in " << watch.elapsed() << endl;
+
+  const size_t queries = 100;
+
+  foreach (const string& query,
+           vector<string>({"limit=10",
+                           "limit=100&order=asc",
+                           "limit=100&offset=1000"})) {
+    watch.start();
+
+    for (size_t i = 0; i < queries; i++) {
+      Future<process::http::Response> response =
+        process::http::get(master.get(), "tasks", query);
+
+      AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+    }
+
+    cout << "Queried '/tasks?" << query << "' " << queries << " times"
+         << " with " << taskCount << " tasks in " << watch.elapsed() << endl;
+  }
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+
+  foreach (const Owned<ProcessBase>& agent, agents) {
+    process::terminate(agent.get());
+    process::wait(agent.get());
+  }
+}
+
+
+class MasterStateSummaryEndpoint_BENCHMARK_Test
+  : public MesosTest,
+    public WithParamInterface<size_t> {};
+
+
+// The state summary endpoint benchmark is parameterized by the number
+// of agents, each of which runs the same number of tasks.
+INSTANTIATE_TEST_CASE_P(
+    AgentCount,
+    MasterStateSummaryEndpoint_BENCHMARK_Test,
+    ::testing::Values(1000U, 5000U, 20000U));
+
+
+// Measures queries of the '/state-summary' endpoint on a master with
+// a large number of agents and tasks, both when the master's state
+// does not change between queries and when it does.
+TEST_P(MasterStateSummaryEndpoint_BENCHMARK_Test, Query)
+{
+  const size_t agentCount = GetParam();
+  const size_t tasksPerAgent = 10;
+
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.authenticate_slaves = false;
+
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<FrameworkID> frameworkId;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId));
+
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillRepeatedly(Return()); // Ignore offers.
+
+  driver.start();
+
+  AWAIT_READY(frameworkId);
+
+  // The simulated agents only need a PID that the master can link
+  // to, the messages sent to them are dropped.
+  vector<Owned<ProcessBase>> agents;
+  vector<Future<SlaveReregisteredMessage>> reregistered;
+
+  Resources resources = Resources::parse("cpus:0.1;mem:32").get();
+
+  for (size_t i = 0; i < agentCount; i++) {
+    agents.push_back(Owned<ProcessBase>(
+        new ProcessBase(process::ID::generate("agent"))));
+
+    const UPID pid = process::spawn(agents.back().get());
+
+    ReregisterSlaveMessage message;
+    message.set_version(MESOS_VERSION);
+
+    SlaveInfo* info = message.mutable_slave();
+    info->mutable_id()->set_value("agent-" + stringify(i));
+    info->set_hostname("agent-" + stringify(i));
+    info->set_checkpoint(true);
+    info->mutable_resources()->CopyFrom(
+        Resources::parse("cpus:1000;mem:1000000").get());
+
+    for (size_t j = 0; j < tasksPerAgent; j++) {
+      const size_t index = i * tasksPerAgent + j;
+
+      Task* task = message.add_tasks();
+      task->set_name("task-" + stringify(index));
+      task->mutable_task_id()->set_value("task-" + stringify(index));
+      task->mutable_framework_id()->CopyFrom(frameworkId.get());
+      task->mutable_slave_id()->CopyFrom(info->id());
+      task->mutable_resources()->CopyFrom(resources);
+      task->set_state(TASK_RUNNING);
+    }
+
+    reregistered.push_back(
+        FUTURE_PROTOBUF(SlaveReregisteredMessage(), master.get(), pid));
+
+    string data;
+    message.SerializeToString(&data);
+
+    process::post(pid, master.get(), message.GetTypeName(),
+                  data.data(), data.size());
+  }
+
+  foreach (const Future<SlaveReregisteredMessage>& future, reregistered) {
+    AWAIT_READY_FOR(future, Minutes(5));
+  }
+
+  // Check that the summary accounts for all of the tasks.
+  Future<process::http::Response> response =
+    process::http::get(master.get(), "state-summary");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  EXPECT_SOME_EQ(
+      agentCount * tasksPerAgent,
+      parse.get().find<JSON::Number>("frameworks[0].TASK_RUNNING"));
+
+  const size_t queries = 100;
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < queries; i++) {
+    response = process::http::get(master.get(), "state-summary");
+
+    AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+  }
+
+  cout << "Queried unchanged '/state-summary' " << queries << " times"
+       << " with " << agentCount << " agents in " << watch.elapsed() << endl;
+
+  // Invalidate the serialized summary before every query by having
+  // the scheduler send a message to the master.
+  watch.start();
+
+  for (size_t i = 0; i < queries; i++) {
+    Future<Nothing> reviveOffers =
+      FUTURE_DISPATCH(_, &MesosAllocatorProcess::reviveOffers);
+
+    driver.reviveOffers();
+
+    AWAIT_READY(reviveOffers);
+
+    response = process::http::get(master.get(), "state-summary");
+
+    AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+  }
+
+  cout << "Queried changed '/state-summary' " << queries << " times"
+       << " with " << agentCount << " agents in " << watch.elapsed() << endl;
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+
+  foreach (const Owned<ProcessBase>& agent, agents) {
+    process::terminate(agent.get());
+    process::wait(agent.get());
+  }
+}
+
+
+class MasterStateEndpoint_BENCHMARK_Test
+  : public MesosTest,
+    public WithParamInterface<size_t> {};
+
+
+// The state endpoint benchmark is parameterized by the number of
+// agents, each of which runs the same number of tasks.
+INSTANTIATE_TEST_CASE_P(
+    AgentCount,
+    MasterStateEndpoint_BENCHMARK_Test,
+    ::testing::Values(1000U, 5000U, 20000U));
+
+
+// Measures how long scheduling is stalled by the '/state' endpoint:
+// the scheduler repeatedly revives offers, and the latency of every
+// revival through the master is measured both without polling and
+// while a '/state' request is outstanding at all times. Since every
+// revival changes the state, every poll renders a new snapshot.
+TEST_P(MasterStateEndpoint_BENCHMARK_Test, Stall)
+{
+  const size_t agentCount = GetParam();
+  const size_t tasksPerAgent = 10;
+  const size_t completedTaskCount = master::MAX_COMPLETED_TASKS_PER_FRAMEWORK;
+
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.authenticate_slaves = false;
+
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<FrameworkID> frameworkId;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId));
+
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillRepeatedly(Return()); // Ignore offers.
+
+  driver.start();
+
+  AWAIT_READY(frameworkId);
+
+  // The simulated agents only need a PID that the master can link
+  // to, the messages sent to them are dropped.
+  vector<Owned<ProcessBase>> agents;
+  vector<Future<SlaveReregisteredMessage>> reregistered;
+
+  Resources resources = Resources::parse("cpus:0.1;mem:32").get();
+
+  for (size_t i = 0; i < agentCount; i++) {
+    agents.push_back(Owned<ProcessBase>(
+        new ProcessBase(process::ID::generate("agent"))));
+
+    const UPID pid = process::spawn(agents.back().get());
+
+    ReregisterSlaveMessage message;
+    message.set_version(MESOS_VERSION);
+
+    SlaveInfo* info = message.mutable_slave();
+    info->mutable_id()->set_value("agent-" + stringify(i));
+    info->set_hostname("agent-" + stringify(i));
+    info->set_checkpoint(true);
+    info->mutable_resources()->CopyFrom(
+        Resources::parse("cpus:1000;mem:1000000").get());
+
+    for (size_t j = 0; j < tasksPerAgent; j++) {
+      const size_t index = i * tasksPerAgent + j;
+
+      Task* task = message.add_tasks();
+      task->set_name("task-" + stringify(index));
+      task->mutable_task_id()->set_value("task-" + stringify(index));
+      task->mutable_framework_id()->CopyFrom(frameworkId.get());
+      task->mutable_slave_id()->CopyFrom(info->id());
+      task->mutable_resources()->CopyFrom(resources);
+      task->set_state(TASK_RUNNING);
+    }
+
+    // The first agent reports the completed tasks of the framework.
+    if (i == 0) {
+      Archive::Framework* completed = message.add_completed_frameworks();
+      completed->mutable_framework_info()->CopyFrom(DEFAULT_FRAMEWORK_INFO);
+      completed->mutable_framework_info()->mutable_id()->CopyFrom(
+          frameworkId.get());
+
+      for (size_t j = 0; j < completedTaskCount; j++) {
+        Task* task = completed->add_tasks();
+        task->set_name("completed-" + stringify(j));
+        task->mutable_task_id()->set_value("completed-" + stringify(j));
+        task->mutable_framework_id()->CopyFrom(frameworkId.get());
+        task->mutable_slave_id()->CopyFrom(info->id());
+        task->mutable_resources()->CopyFrom(resources);
+        task->set_state(TASK_FINISHED);
+
+        TaskStatus* status = task->add_statuses();
+        status->mutable_task_id()->CopyFrom(task->task_id());
+        status->set_state(TASK_FINISHED);
+        status->set_timestamp(static_cast<double>(j));
+        status->set_message("Task finished");
+      }
+    }
+
+    reregistered.push_back(
+        FUTURE_PROTOBUF(SlaveReregisteredMessage(), master.get(), pid));
+
+    string data;
+    message.SerializeToString(&data);
+
+    process::post(pid, master.get(), message.GetTypeName(),
+                  data.data(), data.size());
+  }
+
+  foreach (const Future<SlaveReregisteredMessage>& future, reregistered) {
+    AWAIT_READY_FOR(future, Minutes(5));
+  }
+
+  const size_t revivals = 1000;
+
+  foreach (bool polling, vector<bool>({false, true})) {
+    Option<Future<process::http::Response>> response;
+    size_t polls = 0;
+
+    Duration total;
+    Duration max;
+
+    Stopwatch watch;
+    watch.start();
+
+    for (size_t i = 0; i < revivals; i++) {
+      if (polling && (response.isNone() || !response.get().isPending())) {
+        if (response.isSome()) {
+          AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+              process::http::OK().status, response.get());
+          polls++;
+        }
+
+        response = process::http::get(master.get(), "state");
+      }
+
+      Future<Nothing> reviveOffers =
+        FUTURE_DISPATCH(_, &MesosAllocatorProcess::reviveOffers);
+
+      Stopwatch latency;
+      latency.start();
+
+      driver.reviveOffers();
+
+      AWAIT_READY(reviveOffers);
+
+      const Duration elapsed = latency.elapsed();
+
+      total += elapsed;
+      max = std::max(max, elapsed);
+    }
+
+    if (response.isSome()) {
+      AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+          process::http::OK().status, response.get());
+      polls++;
+    }
+
+    cout << "Revived offers " << revivals << " times with " << agentCount
+         << " agents"
+         << (polling ? " while polling '/state' " + stringify(polls) +
+                       " times" : "")
+         << " in " << watch.elapsed() << " (mean latency "
+         << total / revivals << ", max latency " << max << ")" << endl;
+  }
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+
+  foreach (const Owned<ProcessBase>& agent, agents) {
+    process::terminate(agent.get());
+    process::wait(agent.get());
+  }
+}
+
+
+// A simulated agent that counts the status update acknowledgements
+// that the master relays to it.
+class StatusUpdateAcknowledgementCounter
+  : public ProtobufProcess<StatusUpdateAcknowledgementCounter>
+{
+public:
+  explicit StatusUpdateAcknowledgementCounter(size_t _expected)
+    : ProcessBase(process::ID::generate("agent")),
+      expected(_expected),
+      received(0) {}
+
+  Future<Nothing> acknowledged()
+  {
+    return promise.future();
+  }
+
+protected:
+  virtual void initialize()
+  {
+    install<StatusUpdateAcknowledgementMessage>(
+        &StatusUpdateAcknowledgementCounter::acknowledgement);
+
+    install<StatusUpdateAcknowledgementsMessage>(
+        &StatusUpdateAcknowledgementCounter::acknowledgements);
+  }
+
+private:
+  void acknowledgement(
+      const UPID& from,
+      const StatusUpdateAcknowledgementMessage& message)
+  {
+    count(1);
+  }
+
+  void acknowledgements(
+      const UPID& from,
+      const StatusUpdateAcknowledgementsMessage& message)
+  {
+    count(message.acknowledgements_size());
+  }
+
+  void count(size_t acknowledgements)
+  {
+    received += acknowledgements;
+
+    if (received >= expected) {
+      promise.set(Nothing());
+    }
+  }
+
+  const size_t expected;
+  size_t received;
+  Promise<Nothing> promise;
+};
+
+
+class MasterStatusUpdate_BENCHMARK_Test
+  : public MesosTest,
+    public WithParamInterface<bool> {};
+
+
+// The status update benchmark is parameterized by whether the agent
+// and the scheduler exchange the status updates and acknowledgements
+// with the master in batches.
+INSTANTIATE_TEST_CASE_P(
+    Batched,
+    MasterStatusUpdate_BENCHMARK_Test,
+    ::testing::Bool());
+
+
+// Measures the time it takes to forward status updates from a
+// (simulated) agent to an HTTP scheduler, and to relay the
+// scheduler's acknowledgements back to the agent.
+TEST_P(MasterStatusUpdate_BENCHMARK_Test, Throughput)
+{
+  const bool batched = GetParam();
+  const size_t updateCount = 100000;
+  const int updatesPerMessage = 1000;
+
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.authenticate_slaves = false;
+
+  // HTTP schedulers cannot yet authenticate.
+  masterFlags.authenticate_frameworks = false;
+
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  v1::FrameworkInfo frameworkInfo = DEFAULT_V1_FRAMEWORK_INFO;
+
+  if (batched) {
+    frameworkInfo.add_capabilities()->set_type(
+        v1::FrameworkInfo::Capability::BATCHED_STATUS_UPDATES);
+  }
+
+  v1::scheduler::Call subscribe;
+  subscribe.set_type(v1::scheduler::Call::SUBSCRIBE);
+  subscribe.mutable_subscribe()->mutable_framework_info()->CopyFrom(
+      frameworkInfo);
+
+  process::http::Headers headers;
+  headers["Accept"] = APPLICATION_PROTOBUF;
+
+  Future<process::http::Response> response = process::http::streaming::post(
+      master.get(),
+      "api/v1/scheduler",
+      headers,
+      serialize(ContentType::PROTOBUF, subscribe),
+      APPLICATION_PROTOBUF);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+  ASSERT_EQ(process::http::Response::PIPE, response.get().type);
+  ASSERT_SOME(response.get().reader);
+
+  auto deserializer = lambda::bind(
+      deserialize<v1::scheduler::Event>, ContentType::PROTOBUF, lambda::_1);
+
+  Reader<v1::scheduler::Event> decoder(
+      Decoder<v1::scheduler::Event>(deserializer),
+      response.get().reader.get());
+
+  Future<Result<v1::scheduler::Event>> event = decoder.read();
+  AWAIT_READY(event);
+  ASSERT_SOME(event.get());
+  ASSERT_EQ(v1::scheduler::Event::SUBSCRIBED, event.get().get().type());
+
+  const v1::FrameworkID frameworkId =
+    event.get().get().subscribed().framework_id();
+
+  StatusUpdateAcknowledgementCounter agent(updateCount);
+  const UPID pid = process::spawn(&agent);
+
+  RegisterSlaveMessage registerSlaveMessage;
+  registerSlaveMessage.set_version(MESOS_VERSION);
+  registerSlaveMessage.mutable_slave()->set_hostname("agent");
+
+  if (batched) {
+    registerSlaveMessage.add_capabilities()->set_type(
+        SlaveCapability::BATCHED_STATUS_UPDATES);
+  }
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), pid);
+
+  string data;
+  registerSlaveMessage.SerializeToString(&data);
+
+  process::post(pid, master.get(), registerSlaveMessage.GetTypeName(),
+                data.data(), data.size());
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  // The master does not know about the tasks of the simulated agent,
+  // but it forwards their status updates nevertheless.
+  FrameworkID frameworkId_;
+  frameworkId_.set_value(frameworkId.value());
+
+  vector<StatusUpdateMessage> updates;
+
+  for (size_t i = 0; i < updateCount; i++) {
+    TaskID taskId;
+    taskId.set_value("task-" + stringify(i));
+
+    StatusUpdateMessage update;
+    update.mutable_update()->CopyFrom(protobuf::createStatusUpdate(
+        frameworkId_,
+        slaveRegisteredMessage.get().slave_id(),
+        taskId,
+        TASK_FINISHED,
+        TaskStatus::SOURCE_EXECUTOR,
+        UUID::random()));
+    update.set_pid(pid);
+
+    updates.push_back(update);
+  }
+
+  // Serialize the messages of the agent up front.
+  string name;
+  vector<string> messages;
+
+  if (batched) {
+    name = StatusUpdatesMessage().GetTypeName();
+
+    StatusUpdatesMessage message;
+
+    foreach (const StatusUpdateMessage& update, updates) {
+      message.add_updates()->CopyFrom(update);
+
+      if (message.updates_size() == updatesPerMessage) {
+        messages.push_back(message.SerializeAsString());
+        message.Clear();
+      }
+    }
+
+    if (message.updates_size() > 0) {
+      messages.push_back(message.SerializeAsString());
+    }
+  } else {
+    name = StatusUpdateMessage().GetTypeName();
+
+    foreach (const StatusUpdateMessage& update, updates) {
+      messages.push_back(update.SerializeAsString());
+    }
+  }
+
+  Stopwatch watch;
+  watch.start();
+
+  foreach (const string& message, messages) {
+    process::post(pid, master.get(), name, message.data(), message.size());
+  }
+
+  // The scheduler acknowledges the updates as it receives them.
+  size_t received = 0;
+  vector<Future<process::http::Response>> acknowledgements;
+
+  while (received < updateCount) {
+    event = decoder.read();
+    AWAIT_READY(event);
+    ASSERT_SOME(event.get());
+
+    vector<v1::scheduler::Event::Update> updates_;
+
+    if (event.get().get().type() == v1::scheduler::Event::UPDATE) {
+      updates_.push_back(event.get().get().update());
+    } else if (event.get().get().type() == v1::scheduler::Event::UPDATES) {
+      updates_ = google::protobuf::convert(
+          event.get().get().updates().updates());
+    } else {
+      // E.g., heartbeats.
+      continue;
+    }
+
+    v1::scheduler::Call call;
+    call.mutable_framework_id()->CopyFrom(frameworkId);
+
+    foreach (const v1::scheduler::Event::Update& update, updates_) {
+      v1::scheduler::Call::Acknowledge* acknowledge = batched
+        ? call.mutable_acknowledge_updates()->add_acknowledgements()
+        : call.mutable_acknowledge();
+
+      acknowledge->mutable_agent_id()->CopyFrom(update.status().agent_id());
+      acknowledge->mutable_task_id()->CopyFrom(update.status().task_id());
+      acknowledge->set_uuid(update.status().uuid());
+    }
+
+    call.set_type(batched
+        ? v1::scheduler::Call::ACKNOWLEDGE_UPDATES
+        : v1::scheduler::Call::ACKNOWLEDGE);
+
+    acknowledgements.push_back(process::http::post(
+        master.get(),
+        "api/v1/scheduler",
+        None(),
+        serialize(ContentType::PROTOBUF, call),
+        APPLICATION_PROTOBUF));
+
+    received += updates_.size();
+  }
+
+  cout << "Forwarded " << updateCount << " status updates"
+       << (batched ? " in batches" : "") << " in " << watch.elapsed() << endl;
+
+  AWAIT_READY_FOR(agent.acknowledged(), Minutes(5));
+
+  cout << "Acknowledged " << updateCount << " status updates"
+       << (batched ? " in batches" : "") << " in " << watch.elapsed() << endl;
+
+  foreach (const Future<process::http::Response>& response, acknowledgements) {
+    AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::Accepted().status, response);
+  }
+
+  Shutdown();
+
+  process::terminate(agent);
+  process::wait(agent);
+}
+
+
+// Checks that the oldest completed tasks are dropped once the memory
+// budget is exceeded, while the most recent task is always kept.
+TEST(CompletedTasksTest, MemoryBudget)
+{
+  Task task;
+  task.set_name("task");
+  task.mutable_task_id()->set_value("task");
+  task.mutable_framework_id()->set_value("framework");
+  task.mutable_slave_id()->set_value("slave");
+  task.set_state(TASK_FINISHED);
+
+  TaskStatus* status = task.add_statuses();
+  status->mutable_task_id()->CopyFrom(task.task_id());
+  status->set_state(TASK_FINISHED);
+  status->set_timestamp(1.0);
+  status->set_message(string(1024, 'x'));
+
+  master::CompletedTasks tasks(1000, Kilobytes(4));
+
+  for (int i = 0; i < 10; i++) {
+    tasks.push_back(task);
+
+    while (tasks.exceeded()) {
+      tasks.pop_front();
+    }
+
+    EXPECT_GE(Kilobytes(4), tasks.memory());
+  }
+
+  EXPECT_LT(0u, tasks.size());
+  EXPECT_GT(10u, tasks.size());
+
+  EXPECT_SOME_EQ(1.0, tasks.back().timestamp());
+  EXPECT_EQ(task.SerializeAsString(), tasks.back().get().SerializeAsString());
+
+  // A single task exceeding the budget is kept.
+  master::CompletedTasks small(1000, Bytes(1));
+
+  small.push_back(task);
+  EXPECT_FALSE(small.exceeded());
+
+  small.push_back(task);
+  EXPECT_TRUE(small.exceeded());
+}
+
+
+class MasterCompletedTasks_BENCHMARK_Test
+  : public MesosTest,
+    public WithParamInterface<size_t> {};
+
+
+// The completed tasks benchmark is parameterized by the number of
+// statuses of each task.
+INSTANTIATE_TEST_CASE_P(
+    StatusCount,
+    MasterCompletedTasks_BENCHMARK_Test,
+    ::testing::Values(1U, 5U, 20U));
+
+
+// Compares the memory used by the completed tasks of a framework when
+// kept as 'Task' protobufs and when kept serialized, and measures the
+// cost of decoding them all (as done by the '/state' endpoint).
+TEST_P(MasterCompletedTasks_BENCHMARK_Test, Memory)
+{
+  const size_t statusCount = GetParam();
+  const size_t taskCount = master::MAX_COMPLETED_TASKS_PER_FRAMEWORK;
+
+  vector<shared_ptr<Task>> tasks;
+  tasks.reserve(taskCount);
+
+  master::CompletedTasks completedTasks(taskCount, Gigabytes(1));
+
+  Bytes uncompacted;
+
+  for (size_t i = 0; i < taskCount; i++) {
+    shared_ptr<Task> task(new Task());
+    task->set_name("task-" + stringify(i));
+    task->mutable_task_id()->set_value(UUID::random().toString());
+    task->mutable_framework_id()->set_value(UUID::random().toString());
+    task->mutable_slave_id()->set_value(UUID::random().toString());
+    task->mutable_executor_id()->set_value("default");
+    task->set_state(TASK_FINISHED);
+    task->mutable_resources()->CopyFrom(
+        Resources::parse("cpus:1;mem:128;disk:1024").get());
+
+    Labels* labels = task->mutable_labels();
+    labels->add_labels()->CopyFrom(createLabel("key1", "value1"));
+    labels->add_labels()->CopyFrom(createLabel("key2", "value2"));
+
+    for (size_t j = 0; j < statusCount; j++) {
+      TaskStatus* status = task->add_statuses();
+      status->mutable_task_id()->CopyFrom(task->task_id());
+      status->mutable_slave_id()->CopyFrom(task->slave_id());
+      status->set_state(j + 1 == statusCount ? TASK_FINISHED : TASK_RUNNING);
+      status->set_source(TaskStatus::SOURCE_EXECUTOR);
+      status->set_timestamp(static_cast<double>(j));
+      status->set_uuid(UUID::random().toBytes());
+      status->set_message("Status update " + stringify(j));
+    }
+
+    uncompacted += Bytes(sizeof(*task) + task->SpaceUsed());
+
+    tasks.push_back(task);
+    completedTasks.push_back(*task);
+  }
+
+  Stopwatch watch;
+  watch.start();
+
+  size_t decoded = 0;
+  foreach (const master::CompletedTask& task, completedTasks) {
+    decoded += task.get().statuses().size();
+  }
+
+  watch.stop();
+
+  EXPECT_EQ(taskCount * statusCount, decoded);
+
+  cout << taskCount << " completed tasks with " << statusCount
+       << " statuses use " << uncompacted << " as protobufs and "
+       << completedTasks.memory() << " serialized (a "
+       << static_cast<double>(uncompacted.bytes()) /
+            completedTasks.memory().bytes()
+       << "x reduction), decoding them all took " << watch.elapsed() << endl;
+}
+
+
+// Checks that offers are expired in the order of their deadlines and
+// that removed offers are never expired.
+TEST(OfferExpiryTest, Expire)
+{
+  const Time start = Clock::now();
+
+  vector<OfferID> offerIds;
+  master::OfferExpiry expiry;
+
+  for (int i = 0; i < 4; i++) {
+    OfferID offerId;
+    offerId.set_value("offer-" + stringify(i));
+
+    offerIds.push_back(offerId);
+    expiry.add(offerId, start + Seconds(i));
+  }
+
+  EXPECT_EQ(4u, expiry.size());
+  EXPECT_SOME_EQ(start, expiry.next());
+
+  // Removing the earliest offer moves the next deadline.
+  expiry.remove(offerIds[0]);
+  EXPECT_SOME_EQ(start + Seconds(1), expiry.next());
+
+  expiry.remove(offerIds[2]);
+
+  vector<OfferID> expired = expiry.expire(start + Seconds(2));
+  ASSERT_EQ(1u, expired.size());
+  EXPECT_EQ(offerIds[1], expired[0]);
+  EXPECT_SOME_EQ(start + Seconds(3), expiry.next());
+
+  expired = expiry.expire(start + Seconds(10));
+  ASSERT_EQ(1u, expired.size());
+  EXPECT_EQ(offerIds[3], expired[0]);
+
+  EXPECT_TRUE(expiry.empty());
+  EXPECT_NONE(expiry.next());
+
+  // Removed offers do not affect the outstanding offers.
+  expiry.add(offerIds[0], start + Seconds(20));
+
+  for (int i = 0; i < 10000; i++) {
+    OfferID offerId;
+    offerId.set_value("removed-" + stringify(i));
+
+    expiry.add(offerId, start + Seconds(30));
+    expiry.remove(offerId);
+  }
+
+  EXPECT_EQ(1u, expiry.size());
+  EXPECT_SOME_EQ(start + Seconds(20), expiry.next());
+
+  expired = expiry.expire(start + Seconds(30));
+  ASSERT_EQ(1u, expired.size());
+  EXPECT_EQ(offerIds[0], expired[0]);
+
+  EXPECT_TRUE(expiry.empty());
+  EXPECT_NONE(expiry.next());
+
+  // Deadlines can be added out of order, e.g., after the clock went
+  // backwards, and are still expired in order.
+  expiry.add(offerIds[1], start + Seconds(50));
+  expiry.add(offerIds[2], start + Seconds(40));
+
+  EXPECT_SOME_EQ(start + Seconds(40), expiry.next());
+
+  expired = expiry.expire(start + Seconds(45));
+  ASSERT_EQ(1u, expired.size());
+  EXPECT_EQ(offerIds[2], expired[0]);
+
+  expired = expiry.expire(start + Seconds(50));
+  ASSERT_EQ(1u, expired.size());
+  EXPECT_EQ(offerIds[1], expired[0]);
+
+  EXPECT_TRUE(expiry.empty());
+}
+
+
+class MasterOfferExpiry_BENCHMARK_Test
+  : public MesosTest,
+    public WithParamInterface<size_t> {};
+
+
+// The offer expiry benchmark is parameterized by the number of
+// outstanding offers.
+INSTANTIATE_TEST_CASE_P(
+    OfferCount,
+    MasterOfferExpiry_BENCHMARK_Test,
+    ::testing::Values(10000U, 100000U));
+
+
+// Compares arming (and cancelling) a timer per offer, as the master
+// did for '--offer_timeout', with keeping the deadlines of the offers
+// in an 'OfferExpiry' that is swept in bulk. Half of the offers are
+// used before they expire, the other half is expired by a sweep.
+TEST_P(MasterOfferExpiry_BENCHMARK_Test, Expire)
+{
+  const size_t offerCount = GetParam();
+  const Duration timeout = Minutes(5);
+
+  vector<OfferID> offerIds;
+  offerIds.reserve(offerCount);
+
+  for (size_t i = 0; i < offerCount; i++) {
+    OfferID offerId;
+    offerId.set_value(UUID::random().toString());
+    offerIds.push_back(offerId);
+  }
+
+  Stopwatch watch;
+  watch.start();
+
+  hashmap<OfferID, process::Timer> timers;
+  foreach (const OfferID& offerId, offerIds) {
+    timers[offerId] = Clock::timer(timeout, []() {});
+  }
+
+  for (size_t i = 0; i < offerCount; i += 2) {
+    Clock::cancel(timers[offerIds[i]]);
+    timers.erase(offerIds[i]);
+  }
+
+  watch.stop();
+
+  cout << "Arming " << offerCount << " offer timers and cancelling half"
+       << " of them took " << watch.elapsed() << endl;
+
+  foreachvalue (const process::Timer& timer, timers) {
+    Clock::cancel(timer);
+  }
+
+  watch.start();
+
+  const Time now = Clock::now();
+
+  master::OfferExpiry expiry;
+  foreach (const OfferID& offerId, offerIds) {
+    expiry.add(offerId, now + timeout);
+  }
+
+  for (size_t i = 0; i < offerCount; i += 2) {
+    expiry.remove(offerIds[i]);
+  }
+
+  watch.stop();
+
+  cout << "Adding " << offerCount << " offers to the expiry and removing"
+       << " half of them took " << watch.elapsed() << endl;
+
+  watch.start();
+
+  vector<OfferID> expired = expiry.expire(now + timeout);
+
+  watch.stop();
+
+  EXPECT_EQ(offerCount / 2, expired.size());
+  EXPECT_TRUE(expiry.empty());
+
+  cout << "Sweeping " << expired.size() << " expired offers took "
+       << watch.elapsed() << endl;
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
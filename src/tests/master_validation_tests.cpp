@@ -16,6 +16,8 @@
 
 #include <google/protobuf/repeated_field.h>
 
+#include <iostream>
+#include <string>
 #include <vector>
 
 #include <gmock/gmock.h>
@@ -28,8 +30,12 @@
 #include <process/clock.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
+#include <process/id.hpp>
+#include <process/process.hpp>
 
 #include <stout/gtest.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 #include <stout/uuid.hpp>
 
@@ -51,12 +57,17 @@ using mesos::internal::slave::Slave;
 using process::Clock;
 using process::Future;
 using process::PID;
+using process::UPID;
 
+using std::cout;
+using std::endl;
+using std::string;
 using std::vector;
 
 using testing::_;
 using testing::AtMost;
 using testing::Return;
+using testing::WithParamInterface;
 
 namespace mesos {
 namespace internal {
@@ -1174,6 +1185,126 @@ TEST_F(TaskValidationTest, TaskAndExecutorUseRevocableResources)
 }
 
 
+class TaskValidation_BENCHMARK_Test
+  : public MesosTest,
+    public WithParamInterface<size_t> {};
+
+
+// The task validation benchmark is parameterized by the number of
+// tasks launched by a single offer acceptance.
+INSTANTIATE_TEST_CASE_P(
+    TasksPerAccept,
+    TaskValidation_BENCHMARK_Test,
+    ::testing::Values(100U, 1000U, 5000U));
+
+
+// Measures the time it takes to validate and launch all the tasks of
+// a single offer acceptance, each task with its own executor and
+// port. The last task reuses the ID of the first task, so that it is
+// rejected only once all the other tasks are validated and launched.
+TEST_P(TaskValidation_BENCHMARK_Test, Accept)
+{
+  const size_t taskCount = GetParam();
+
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.authenticate_slaves = false;
+
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  // The simulated agent only needs a PID that the master can send
+  // messages to.
+  ProcessBase agent(process::ID::generate("agent"));
+  const UPID pid = process::spawn(&agent);
+
+  RegisterSlaveMessage registerSlaveMessage;
+  registerSlaveMessage.set_version(MESOS_VERSION);
+  registerSlaveMessage.mutable_slave()->set_hostname("agent");
+  registerSlaveMessage.mutable_slave()->mutable_resources()->CopyFrom(
+      Resources::parse("cpus:1000;mem:1000000;ports:[10000-20000]").get());
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), pid);
+
+  string data;
+  registerSlaveMessage.SerializeToString(&data);
+
+  process::post(pid, master.get(), registerSlaveMessage.GetTypeName(),
+                data.data(), data.size());
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<FrameworkID> frameworkId;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(frameworkId);
+  AWAIT_READY(offers);
+  ASSERT_EQ(1u, offers.get().size());
+
+  const Offer& offer = offers.get()[0];
+
+  vector<TaskInfo> tasks;
+  for (size_t i = 0; i < taskCount; i++) {
+    const string id = "task-" + stringify(i);
+    const string port = stringify(10000 + i);
+
+    ExecutorInfo executor = CREATE_EXECUTOR_INFO(id, "exit 1");
+    executor.mutable_framework_id()->CopyFrom(frameworkId.get());
+    executor.mutable_resources()->CopyFrom(
+        Resources::parse("cpus:0.01;mem:32").get());
+
+    TaskInfo task;
+    task.set_name(id);
+    task.mutable_task_id()->set_value(id);
+    task.mutable_slave_id()->CopyFrom(offer.slave_id());
+    task.mutable_resources()->CopyFrom(
+        Resources::parse("cpus:0.01;mem:32;ports:[" + port + "-" + port + "]")
+          .get());
+    task.mutable_executor()->CopyFrom(executor);
+
+    tasks.push_back(task);
+  }
+
+  // Reuse the ID of the first task for the last task.
+  tasks.back().mutable_task_id()->CopyFrom(tasks.front().task_id());
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  Stopwatch watch;
+  watch.start();
+
+  driver.launchTasks(offer.id(), tasks);
+
+  AWAIT_READY_FOR(status, Minutes(5));
+  EXPECT_EQ(TASK_ERROR, status.get().state());
+  EXPECT_EQ(TaskStatus::REASON_TASK_INVALID, status.get().reason());
+
+  cout << "Validated " << taskCount << " tasks in a single accept in "
+       << watch.elapsed() << endl;
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+
+  process::terminate(pid);
+  process::wait(pid);
+}
+
 // TODO(jieyu): Add tests for checking duplicated persistence ID
 // against offered resources.
 
@@ -1138,6 +1138,110 @@ TEST_F(RateLimitingTest, CapacityReached)
   Shutdown();
 }
 
+
+// Verify that a burst of messages up to the configured burst is
+// processed right away, while further messages wait for the rate.
+TEST_F(RateLimitingTest, Burst)
+{
+  master::Flags flags = CreateMasterFlags();
+  RateLimits limits;
+  RateLimit* limit = limits.mutable_limits()->Add();
+  limit->set_principal(DEFAULT_CREDENTIAL.principal());
+  limit->set_qps(1);
+  limit->set_burst(3);
+  flags.rate_limits = limits;
+
+  Try<PID<Master> > master = StartMaster(flags);
+  ASSERT_SOME(master);
+
+  Clock::pause();
+
+  // Advance before the test so that the 1st call to Metrics endpoint
+  // is not throttled. MetricsProcess which hosts the endpoint
+  // throttles requests at 2qps and its singleton instance is shared
+  // across tests.
+  Clock::advance(Milliseconds(501));
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .Times(1);
+
+  // Grab the stuff we need to replay the subscribe call.
+  Future<mesos::scheduler::Call> subscribeCall = FUTURE_CALL(
+      mesos::scheduler::Call(), mesos::scheduler::Call::SUBSCRIBE, _, _);
+
+  Future<process::Message> frameworkRegisteredMessage = FUTURE_MESSAGE(
+      Eq(FrameworkRegisteredMessage().GetTypeName()), master.get(), _);
+
+  ASSERT_EQ(DRIVER_RUNNING, driver.start());
+
+  AWAIT_READY(subscribeCall);
+  AWAIT_READY(frameworkRegisteredMessage);
+
+  const process::UPID schedulerPid = frameworkRegisteredMessage.get().to;
+
+  // Send four duplicate subscribe calls. The first three are
+  // processed right away, the fourth has to wait for a second.
+  for (int i = 0; i < 4; i++) {
+    process::post(schedulerPid, master.get(), subscribeCall.get());
+  }
+
+  Clock::settle();
+
+  const string& messages_received =
+    "frameworks/" + DEFAULT_CREDENTIAL.principal() + "/messages_received";
+  const string& messages_processed =
+    "frameworks/" + DEFAULT_CREDENTIAL.principal() + "/messages_processed";
+  const string& message_admission =
+    "frameworks/" + DEFAULT_CREDENTIAL.principal() + "/message_admission_ms";
+
+  {
+    JSON::Object metrics = Metrics();
+
+    EXPECT_EQ(1u, metrics.values.count(messages_received));
+    EXPECT_EQ(
+        4,
+        metrics.values[messages_received].as<JSON::Number>().as<int64_t>());
+
+    EXPECT_EQ(1u, metrics.values.count(messages_processed));
+    EXPECT_EQ(
+        3,
+        metrics.values[messages_processed].as<JSON::Number>().as<int64_t>());
+
+    // The admitted messages did not wait.
+    EXPECT_EQ(1u, metrics.values.count(message_admission));
+    EXPECT_EQ(
+        0,
+        metrics.values[message_admission].as<JSON::Number>().as<int64_t>());
+  }
+
+  Clock::advance(Seconds(1));
+  Clock::settle();
+
+  {
+    JSON::Object metrics = Metrics();
+
+    EXPECT_EQ(1u, metrics.values.count(messages_processed));
+    EXPECT_EQ(
+        4,
+        metrics.values[messages_processed].as<JSON::Number>().as<int64_t>());
+
+    // The last message waited for a second.
+    EXPECT_EQ(1u, metrics.values.count(message_admission));
+    EXPECT_EQ(
+        1000,
+        metrics.values[message_admission].as<JSON::Number>().as<int64_t>());
+  }
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -17,6 +17,8 @@
 #include <stdint.h>
 #include <unistd.h>
 
+#include <iostream>
+#include <string>
 #include <vector>
 
 #include <gmock/gmock.h>
@@ -26,14 +28,23 @@
 
 #include <mesos/scheduler/scheduler.hpp>
 
+#include <mesos/v1/scheduler/scheduler.hpp>
+
 #include <process/clock.hpp>
 #include <process/future.hpp>
+#include <process/http.hpp>
 #include <process/pid.hpp>
 #include <process/process.hpp>
 
+#include <stout/lambda.hpp>
+#include <stout/recordio.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
 #include <stout/uuid.hpp>
 
+#include "common/http.hpp"
 #include "common/protobuf_utils.hpp"
+#include "common/recordio.hpp"
 
 #include "master/flags.hpp"
 #include "master/master.hpp"
@@ -45,6 +56,8 @@
 
 using mesos::internal::master::Master;
 
+using mesos::internal::recordio::Reader;
+
 using mesos::internal::slave::Slave;
 
 using process::Clock;
@@ -52,6 +65,11 @@ using process::Future;
 using process::PID;
 using process::Promise;
 
+using recordio::Decoder;
+
+using std::cout;
+using std::endl;
+using std::string;
 using std::vector;
 
 using testing::_;
@@ -60,6 +78,7 @@ using testing::AtMost;
 using testing::DoAll;
 using testing::Return;
 using testing::SaveArg;
+using testing::WithParamInterface;
 
 namespace mesos {
 namespace internal {
@@ -890,6 +909,225 @@ TEST_F(ReconciliationTest, ReconcileStatusUpdateTaskState)
   Shutdown(); // Must shutdown before the detector gets de-allocated.
 }
 
+
+// This test verifies that a scheduler with the BATCHED_STATUS_UPDATES
+// capability receives the updates of an explicit reconciliation in
+// chunks, rather than one event per task.
+TEST_F(ReconciliationTest, BatchedExplicitReconciliation)
+{
+  master::Flags masterFlags = CreateMasterFlags();
+
+  // HTTP schedulers cannot yet authenticate.
+  masterFlags.authenticate_frameworks = false;
+
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  v1::FrameworkInfo frameworkInfo = DEFAULT_V1_FRAMEWORK_INFO;
+  frameworkInfo.add_capabilities()->set_type(
+      v1::FrameworkInfo::Capability::BATCHED_STATUS_UPDATES);
+
+  v1::scheduler::Call subscribe;
+  subscribe.set_type(v1::scheduler::Call::SUBSCRIBE);
+  subscribe.mutable_subscribe()->mutable_framework_info()->CopyFrom(
+      frameworkInfo);
+
+  process::http::Headers headers;
+  headers["Accept"] = APPLICATION_PROTOBUF;
+
+  Future<process::http::Response> response = process::http::streaming::post(
+      master.get(),
+      "api/v1/scheduler",
+      headers,
+      serialize(ContentType::PROTOBUF, subscribe),
+      APPLICATION_PROTOBUF);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+  ASSERT_EQ(process::http::Response::PIPE, response.get().type);
+  ASSERT_SOME(response.get().reader);
+
+  auto deserializer = lambda::bind(
+      deserialize<v1::scheduler::Event>, ContentType::PROTOBUF, lambda::_1);
+
+  Reader<v1::scheduler::Event> decoder(
+      Decoder<v1::scheduler::Event>(deserializer),
+      response.get().reader.get());
+
+  Future<Result<v1::scheduler::Event>> event = decoder.read();
+  AWAIT_READY(event);
+  ASSERT_SOME(event.get());
+  ASSERT_EQ(v1::scheduler::Event::SUBSCRIBED, event.get().get().type());
+
+  // Reconcile more tasks than fit into a single chunk. The tasks are
+  // unknown and so is their agent, so they are all reported lost.
+  const size_t taskCount = master::MAX_RECONCILIATION_UPDATES_PER_MESSAGE + 1;
+
+  v1::scheduler::Call call;
+  call.mutable_framework_id()->CopyFrom(
+      event.get().get().subscribed().framework_id());
+  call.set_type(v1::scheduler::Call::RECONCILE);
+
+  for (size_t i = 0; i < taskCount; i++) {
+    call.mutable_reconcile()->add_tasks()->mutable_task_id()->set_value(
+        "task-" + stringify(i));
+  }
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      process::http::Accepted().status,
+      process::http::post(
+          master.get(),
+          "api/v1/scheduler",
+          None(),
+          serialize(ContentType::PROTOBUF, call),
+          APPLICATION_PROTOBUF));
+
+  event = decoder.read();
+  AWAIT_READY(event);
+  ASSERT_SOME(event.get());
+  ASSERT_EQ(v1::scheduler::Event::UPDATES, event.get().get().type());
+  ASSERT_EQ(static_cast<int>(master::MAX_RECONCILIATION_UPDATES_PER_MESSAGE),
+            event.get().get().updates().updates().size());
+
+  const v1::TaskStatus& first =
+    event.get().get().updates().updates(0).status();
+
+  EXPECT_EQ("task-0", first.task_id().value());
+  EXPECT_EQ(v1::TASK_LOST, first.state());
+  EXPECT_EQ(v1::TaskStatus::REASON_RECONCILIATION, first.reason());
+  EXPECT_FALSE(first.has_uuid());
+
+  event = decoder.read();
+  AWAIT_READY(event);
+  ASSERT_SOME(event.get());
+  ASSERT_EQ(v1::scheduler::Event::UPDATES, event.get().get().type());
+  ASSERT_EQ(1, event.get().get().updates().updates().size());
+
+  EXPECT_EQ("task-" + stringify(taskCount - 1),
+            event.get().get().updates().updates(0).status().task_id().value());
+
+  Shutdown();
+}
+
+
+class Reconciliation_BENCHMARK_Test
+  : public MesosTest,
+    public WithParamInterface<bool> {};
+
+
+// The reconciliation benchmark is parameterized by whether the
+// scheduler has the BATCHED_STATUS_UPDATES capability.
+INSTANTIATE_TEST_CASE_P(
+    Batched,
+    Reconciliation_BENCHMARK_Test,
+    ::testing::Bool());
+
+
+// Measures the time it takes for an HTTP scheduler to explicitly
+// reconcile 100k tasks, from sending the call to receiving the last
+// reconciliation update.
+TEST_P(Reconciliation_BENCHMARK_Test, Explicit)
+{
+  const bool batched = GetParam();
+  const size_t taskCount = 100000;
+
+  master::Flags masterFlags = CreateMasterFlags();
+
+  // HTTP schedulers cannot yet authenticate.
+  masterFlags.authenticate_frameworks = false;
+
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  v1::FrameworkInfo frameworkInfo = DEFAULT_V1_FRAMEWORK_INFO;
+
+  if (batched) {
+    frameworkInfo.add_capabilities()->set_type(
+        v1::FrameworkInfo::Capability::BATCHED_STATUS_UPDATES);
+  }
+
+  v1::scheduler::Call subscribe;
+  subscribe.set_type(v1::scheduler::Call::SUBSCRIBE);
+  subscribe.mutable_subscribe()->mutable_framework_info()->CopyFrom(
+      frameworkInfo);
+
+  process::http::Headers headers;
+  headers["Accept"] = APPLICATION_PROTOBUF;
+
+  Future<process::http::Response> response = process::http::streaming::post(
+      master.get(),
+      "api/v1/scheduler",
+      headers,
+      serialize(ContentType::PROTOBUF, subscribe),
+      APPLICATION_PROTOBUF);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+  ASSERT_EQ(process::http::Response::PIPE, response.get().type);
+  ASSERT_SOME(response.get().reader);
+
+  auto deserializer = lambda::bind(
+      deserialize<v1::scheduler::Event>, ContentType::PROTOBUF, lambda::_1);
+
+  Reader<v1::scheduler::Event> decoder(
+      Decoder<v1::scheduler::Event>(deserializer),
+      response.get().reader.get());
+
+  Future<Result<v1::scheduler::Event>> event = decoder.read();
+  AWAIT_READY(event);
+  ASSERT_SOME(event.get());
+  ASSERT_EQ(v1::scheduler::Event::SUBSCRIBED, event.get().get().type());
+
+  // The tasks are unknown to the master, which makes it look up each
+  // of them and report them lost.
+  v1::scheduler::Call call;
+  call.mutable_framework_id()->CopyFrom(
+      event.get().get().subscribed().framework_id());
+  call.set_type(v1::scheduler::Call::RECONCILE);
+
+  for (size_t i = 0; i < taskCount; i++) {
+    call.mutable_reconcile()->add_tasks()->mutable_task_id()->set_value(
+        "task-" + stringify(i));
+  }
+
+  const string body = serialize(ContentType::PROTOBUF, call);
+
+  Stopwatch watch;
+  watch.start();
+
+  Future<process::http::Response> reconcile = process::http::post(
+      master.get(),
+      "api/v1/scheduler",
+      None(),
+      body,
+      APPLICATION_PROTOBUF);
+
+  size_t received = 0;
+  size_t events = 0;
+
+  while (received < taskCount) {
+    event = decoder.read();
+    AWAIT_READY_FOR(event, Minutes(5));
+    ASSERT_SOME(event.get());
+
+    if (event.get().get().type() == v1::scheduler::Event::UPDATES) {
+      received += event.get().get().updates().updates().size();
+    } else {
+      ASSERT_EQ(v1::scheduler::Event::UPDATE, event.get().get().type());
+      received++;
+    }
+
+    events++;
+  }
+
+  watch.stop();
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::Accepted().status, reconcile);
+
+  cout << "Reconciled " << taskCount << " tasks in " << events << " events"
+       << (batched ? " (batched)" : "") << " in " << watch.elapsed() << endl;
+
+  Shutdown();
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -15,6 +15,7 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <map>
 #include <set>
@@ -32,6 +33,7 @@
 
 #include <stout/bytes.hpp>
 #include <stout/stopwatch.hpp>
+#include <stout/strings.hpp>
 #include <stout/uuid.hpp>
 
 #include <stout/tests/utils.hpp>
@@ -100,6 +102,7 @@ using state::LogStorage;
 using state::Storage;
 
 using state::protobuf::State;
+using state::protobuf::Variable;
 
 // TODO(xujyan): This class copies code from LogStateTest. It would
 // be nice to find a common location for log related base tests when
@@ -900,6 +903,86 @@ TEST_P(RegistrarTest, Bootstrap)
 }
 
 
+// Ensures that the registry is recovered from the last snapshot and
+// the deltas stored since, for sequences of operations that are
+// stored both as deltas and as snapshots.
+TEST_P(RegistrarTest, RecoverDeltas)
+{
+  flags.registry_deltas = true;
+
+  vector<SlaveInfo> infos;
+  for (int i = 0; i < 20; i++) {
+    SlaveInfo info;
+    info.set_hostname("localhost");
+    info.mutable_id()->set_value(stringify(i));
+    infos.push_back(info);
+  }
+
+  // Run 1 admits the slaves one at a time and removes some of them.
+  {
+    Registrar registrar(flags, state);
+    AWAIT_READY(registrar.recover(master));
+
+    foreach (const SlaveInfo& info, infos) {
+      AWAIT_EQ(true, registrar.apply(Owned<Operation>(new AdmitSlave(info))));
+    }
+
+    for (size_t i = 0; i < infos.size(); i += 3) {
+      AWAIT_EQ(true,
+               registrar.apply(Owned<Operation>(new RemoveSlave(infos[i]))));
+    }
+  }
+
+  // Run 2 should see the remaining slaves.
+  {
+    Registrar registrar(flags, state);
+
+    Future<Registry> registry = registrar.recover(master);
+    AWAIT_READY(registry);
+
+    set<string> expected;
+    for (size_t i = 0; i < infos.size(); i++) {
+      if (i % 3 != 0) {
+        expected.insert(infos[i].id().value());
+      }
+    }
+
+    set<string> recovered;
+    foreach (const Registry::Slave& slave, registry.get().slaves().slaves()) {
+      recovered.insert(slave.info().id().value());
+    }
+
+    EXPECT_EQ(expected, recovered);
+    EXPECT_EQ(master, registry.get().master().info());
+  }
+}
+
+
+// Ensures that without '--registry_deltas' the whole registry is
+// stored on every change, i.e., no deltas are stored.
+TEST_P(RegistrarTest, NoDeltas)
+{
+  Registrar registrar(flags, state);
+  AWAIT_READY(registrar.recover(master));
+
+  AWAIT_EQ(true, registrar.apply(Owned<Operation>(new AdmitSlave(slave))));
+  AWAIT_EQ(true, registrar.apply(Owned<Operation>(new RemoveSlave(slave))));
+
+  Future<std::set<string> > names = state->names();
+  AWAIT_READY(names);
+
+  foreach (const string& name, names.get()) {
+    EXPECT_FALSE(strings::startsWith(name, "registry_delta_")) << name;
+  }
+
+  Future<Variable<Registry> > variable = state->fetch<Registry>("registry");
+  AWAIT_READY(variable);
+
+  EXPECT_EQ(0, variable.get().get().slaves().slaves().size());
+  EXPECT_FALSE(variable.get().get().has_next_delta());
+}
+
+
 class MockStorage : public Storage
 {
 public:
@@ -951,6 +1034,9 @@ TEST_P(RegistrarTest, StoreTimeout)
   EXPECT_CALL(storage, get(_))
     .WillOnce(Return(None()));
 
+  EXPECT_CALL(storage, names())
+    .WillOnce(Return(std::set<string>()));
+
   Future<Nothing> set;
   EXPECT_CALL(storage, set(_, _))
     .WillOnce(DoAll(FutureSatisfy(&set),
@@ -981,6 +1067,9 @@ TEST_P(RegistrarTest, Abort)
   EXPECT_CALL(storage, get(_))
     .WillOnce(Return(None()));
 
+  EXPECT_CALL(storage, names())
+    .WillOnce(Return(std::set<string>()));
+
   EXPECT_CALL(storage, set(_, _))
     .WillOnce(Return(Future<bool>(true)))              // Recovery.
     .WillOnce(Return(Future<bool>::failed("failure"))) // Failure.
@@ -996,11 +1085,152 @@ TEST_P(RegistrarTest, Abort)
 }
 
 
+// A storage that never completes expunges, as if the master failed
+// over before any of them were performed.
+class PendingExpungeStorage : public Storage
+{
+public:
+  explicit PendingExpungeStorage(Storage* _storage)
+    : storage(_storage), expunges(0) {}
+
+  virtual Future<Option<Entry> > get(const string& name)
+  {
+    return storage->get(name);
+  }
+
+  virtual Future<bool> set(const Entry& entry, const UUID& uuid)
+  {
+    return storage->set(entry, uuid);
+  }
+
+  virtual Future<bool> expunge(const Entry& entry)
+  {
+    expunges++;
+    return Future<bool>();
+  }
+
+  virtual Future<std::set<string> > names()
+  {
+    return storage->names();
+  }
+
+  Storage* storage;
+  std::atomic<size_t> expunges;
+};
+
+
+// Ensures that the deltas that were compacted into a snapshot but not
+// yet expunged when the master failed over are not replayed on top of
+// the (newer) snapshot on recovery.
+TEST_P(RegistrarTest, CompactionFailover)
+{
+  flags.registry_deltas = true;
+
+  PendingExpungeStorage pending(storage);
+  State pendingState(&pending);
+
+  vector<SlaveInfo> infos;
+  for (int i = 0; i < 10; i++) {
+    SlaveInfo info;
+    info.set_hostname("localhost");
+    info.mutable_id()->set_value(stringify(i));
+    infos.push_back(info);
+  }
+
+  // Run 1 admits the slaves one at a time, each stored as a delta,
+  // and then removes the first slave. The removal shrinks the
+  // registry below the size of the deltas, so it is stored as a new
+  // snapshot, after which the master "fails over" before any of the
+  // deltas are expunged.
+  {
+    Registrar registrar(flags, &pendingState);
+    AWAIT_READY(registrar.recover(master));
+
+    foreach (const SlaveInfo& info, infos) {
+      AWAIT_EQ(true, registrar.apply(Owned<Operation>(new AdmitSlave(info))));
+    }
+
+    AWAIT_EQ(true,
+             registrar.apply(Owned<Operation>(new RemoveSlave(infos[0]))));
+
+    // The deltas, including the one that admitted the first slave,
+    // are left behind.
+    EXPECT_LT(0u, pending.expunges.load());
+  }
+
+  // Run 2 should not see the removed slave, and admits it again.
+  {
+    Registrar registrar(flags, state);
+
+    Future<Registry> registry = registrar.recover(master);
+    AWAIT_READY(registry);
+
+    set<string> recovered;
+    foreach (const Registry::Slave& slave, registry.get().slaves().slaves()) {
+      recovered.insert(slave.info().id().value());
+    }
+
+    EXPECT_EQ(infos.size() - 1, recovered.size());
+    EXPECT_EQ(0u, recovered.count(infos[0].id().value()));
+
+    AWAIT_EQ(true,
+             registrar.apply(Owned<Operation>(new AdmitSlave(infos[0]))));
+  }
+
+  // Run 3 should see the slave that was admitted again, i.e., the
+  // deltas stored after the snapshot are replayed.
+  {
+    Registrar registrar(flags, state);
+
+    Future<Registry> registry = registrar.recover(master);
+    AWAIT_READY(registry);
+
+    EXPECT_EQ(static_cast<int>(infos.size()),
+              registry.get().slaves().slaves().size());
+    EXPECT_FALSE(registry.get().has_next_delta());
+  }
+}
+
+
 class Registrar_BENCHMARK_Test : public RegistrarTestBase,
                                  public WithParamInterface<size_t>
 {};
 
 
+// A storage that keeps track of the number of bytes written to the
+// underlying storage.
+class CountingStorage : public Storage
+{
+public:
+  explicit CountingStorage(Storage* _storage)
+    : storage(_storage), bytes(0) {}
+
+  virtual Future<Option<Entry> > get(const string& name)
+  {
+    return storage->get(name);
+  }
+
+  virtual Future<bool> set(const Entry& entry, const UUID& uuid)
+  {
+    bytes += entry.ByteSize();
+    return storage->set(entry, uuid);
+  }
+
+  virtual Future<bool> expunge(const Entry& entry)
+  {
+    return storage->expunge(entry);
+  }
+
+  virtual Future<std::set<string> > names()
+  {
+    return storage->names();
+  }
+
+  Storage* storage;
+  std::atomic<size_t> bytes;
+};
+
+
 // The Registrar benchmark tests are parameterized by the number of slaves.
 INSTANTIATE_TEST_CASE_P(
     SlaveCount,
@@ -1010,7 +1240,12 @@ INSTANTIATE_TEST_CASE_P(
 
 TEST_P(Registrar_BENCHMARK_Test, Performance)
 {
-  Registrar registrar(flags, state);
+  flags.registry_deltas = true;
+
+  CountingStorage counting(storage);
+  State countingState(&counting);
+
+  Registrar registrar(flags, &countingState);
   AWAIT_READY(registrar.recover(master));
 
   vector<SlaveInfo> infos;
@@ -1056,7 +1291,7 @@ TEST_P(Registrar_BENCHMARK_Test, Performance)
   LOG(INFO) << "Readmitted " << slaveCount << " slaves in " << watch.elapsed();
 
   // Recover slaves.
-  Registrar registrar2(flags, state);
+  Registrar registrar2(flags, &countingState);
   watch.start();
   MasterInfo info;
   info.set_id("master");
@@ -1067,6 +1302,38 @@ TEST_P(Registrar_BENCHMARK_Test, Performance)
   LOG(INFO) << "Recovered " << slaveCount << " slaves ("
             << Bytes(registry.get().ByteSize()) << ") in " << watch.elapsed();
 
+  // Admit and then remove additional slaves one at a time, i.e., one
+  // operation per store, to measure the latency of an operation and
+  // the amount of data written for it.
+  const size_t operations = 100;
+
+  vector<SlaveInfo> additional;
+  for (size_t i = 0; i < operations; i++) {
+    SlaveInfo info = infos[i];
+    info.mutable_id()->set_value(info.id().value() + "-additional");
+    additional.push_back(info);
+  }
+
+  const size_t bytes = counting.bytes;
+
+  watch.start();
+  foreach (const SlaveInfo& info, additional) {
+    AWAIT_READY(registrar2.apply(Owned<Operation>(new AdmitSlave(info))));
+  }
+  foreach (const SlaveInfo& info, additional) {
+    AWAIT_READY(registrar2.apply(Owned<Operation>(new RemoveSlave(info))));
+  }
+  Duration elapsed = watch.elapsed();
+
+  const size_t written = counting.bytes - bytes;
+
+  cout << "Admitted and removed " << operations << " slaves one at a time"
+       << " with " << slaveCount << " slaves in " << elapsed
+       << " (" << elapsed / (2 * operations) << " per operation); wrote "
+       << Bytes(written) << " (" << Bytes(written / (2 * operations))
+       << " per operation, " << additional[0].ByteSize()
+       << " bytes per slave)" << endl;
+
   // Shuffle the slaves so we are removing them in random order (same
   // as in production).
   std::random_shuffle(infos.begin(), infos.end());
@@ -14,8 +14,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <iostream>
 #include <string>
 
+#include <mesos/attributes.hpp>
+#include <mesos/resources.hpp>
+
 #include <mesos/v1/mesos.hpp>
 #include <mesos/v1/scheduler.hpp>
 
@@ -29,10 +33,14 @@
 #include <stout/json.hpp>
 #include <stout/lambda.hpp>
 #include <stout/recordio.hpp>
+#include <stout/stopwatch.hpp>
 
 #include "common/http.hpp"
 #include "common/recordio.hpp"
 
+#include "internal/devolve.hpp"
+#include "internal/evolve.hpp"
+
 #include "master/constants.hpp"
 #include "master/master.hpp"
 
@@ -62,6 +70,8 @@ using process::http::UnsupportedMediaType;
 
 using recordio::Decoder;
 
+using std::cout;
+using std::endl;
 using std::string;
 
 using testing::WithParamInterface;
@@ -798,6 +808,120 @@ TEST_F(SchedulerHttpApiTest, GetRequest)
   AWAIT_EXPECT_RESPONSE_STATUS_EQ(MethodNotAllowed().status, response);
 }
 
+
+// Returns a message with offers carrying the resources and
+// attributes typical of a cluster with reservations and volumes.
+static ResourceOffersMessage createResourceOffersMessage(size_t offers)
+{
+  ResourceOffersMessage message;
+
+  for (size_t i = 0; i < offers; i++) {
+    Offer* offer = message.add_offers();
+    offer->mutable_id()->set_value("offer-" + stringify(i));
+    offer->mutable_framework_id()->set_value("framework");
+    offer->mutable_slave_id()->set_value("agent-" + stringify(i));
+    offer->set_hostname("agent-" + stringify(i) + ".example.com");
+
+    Resources resources = Resources::parse(
+        "cpus:8;mem:16384;disk:102400;ports:[31000-32000]").get();
+
+    Resource volume = Resources::parse("disk", "1024", "role").get();
+    volume.mutable_reservation()->set_principal("principal");
+    volume.mutable_disk()->mutable_persistence()->set_id("volume");
+    volume.mutable_disk()->mutable_volume()->set_container_path("path");
+    volume.mutable_disk()->mutable_volume()->set_mode(Volume::RW);
+    resources += volume;
+
+    offer->mutable_resources()->CopyFrom(resources);
+    offer->mutable_attributes()->CopyFrom(
+        Attributes::parse("rack:r1;zone:z1"));
+
+    message.add_pids("scheduler@127.0.0.1:5050");
+  }
+
+  return message;
+}
+
+
+// Evolving the offers must produce the same 'v1' offers as
+// serializing and parsing them.
+TEST(EvolveTest, Offers)
+{
+  const ResourceOffersMessage message = createResourceOffersMessage(10);
+
+  const Event event = evolve(message);
+
+  ASSERT_EQ(Event::OFFERS, event.type());
+  ASSERT_EQ(message.offers_size(), event.offers().offers_size());
+
+  for (int i = 0; i < message.offers_size(); i++) {
+    v1::Offer offer;
+    ASSERT_TRUE(offer.ParseFromString(message.offers(i).SerializeAsString()));
+
+    EXPECT_EQ(offer.SerializeAsString(),
+              event.offers().offers(i).SerializeAsString());
+
+    EXPECT_EQ(message.offers(i).SerializeAsString(),
+              devolve(event.offers().offers(i)).SerializeAsString());
+  }
+}
+
+
+class EvolveOffers_BENCHMARK_Test
+  : public ::testing::Test,
+    public WithParamInterface<size_t> {};
+
+
+// The offer conversion benchmark is parameterized by the number of
+// offers per event.
+INSTANTIATE_TEST_CASE_P(
+    OffersPerEvent,
+    EvolveOffers_BENCHMARK_Test,
+    ::testing::Values(1U, 100U, 1000U));
+
+
+// Measures the throughput of evolving 'ResourceOffersMessage's into
+// 'v1' OFFERS events, as done for every offer sent to an HTTP
+// scheduler, compared to serializing and parsing the offers.
+TEST_P(EvolveOffers_BENCHMARK_Test, Throughput)
+{
+  const size_t offersPerEvent = GetParam();
+  const size_t events = 100000 / offersPerEvent;
+
+  const ResourceOffersMessage message =
+    createResourceOffersMessage(offersPerEvent);
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < events; i++) {
+    Event event = evolve(message);
+  }
+
+  watch.stop();
+
+  const Duration evolved = watch.elapsed();
+
+  watch.start();
+
+  for (size_t i = 0; i < events; i++) {
+    Event event;
+    event.set_type(Event::OFFERS);
+
+    foreach (const Offer& offer, message.offers()) {
+      CHECK(event.mutable_offers()->add_offers()->ParsePartialFromString(
+          offer.SerializePartialAsString()));
+    }
+  }
+
+  watch.stop();
+
+  cout << "Evolved " << events << " events of " << offersPerEvent
+       << " offers in " << evolved << " ("
+       << (events * offersPerEvent) / evolved.secs() << " offers/s),"
+       << " serializing and parsing took " << watch.elapsed() << endl;
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
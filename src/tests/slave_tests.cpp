@@ -1317,6 +1317,44 @@ TEST_F(SlaveTest, StateEndpoint)
 }
 
 
+// Tests that a request with the 'ETag' of the current state is
+// answered with '304 Not Modified'.
+TEST_F(SlaveTest, StateEndpointNotModified)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  Future<process::http::Response> response =
+    process::http::get(slave.get(), "state");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+
+  Option<string> etag = response.get().headers.get("ETag");
+  ASSERT_SOME(etag);
+
+  process::http::Headers headers;
+  headers["If-None-Match"] = etag.get();
+
+  response = process::http::get(slave.get(), "state", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      process::http::Status::string(process::http::Status::NOT_MODIFIED),
+      response);
+
+  EXPECT_SOME_EQ(etag.get(), response.get().headers.get("ETag"));
+
+  Shutdown();
+}
+
+
 // This test ensures that when a slave is shutting down, it will not
 // try to re-register with the master.
 TEST_F(SlaveTest, TerminatingSlaveDoesNotReregister)
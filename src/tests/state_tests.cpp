@@ -563,6 +563,53 @@ TEST_F(LogStateTest, Names)
 }
 
 
+// Ensures that stores issued without waiting for the earlier ones to
+// finish are all written, and that their versions are checked against
+// the stores still in flight.
+TEST_F(LogStateTest, ConcurrentStores)
+{
+  list<Future<Option<Variable<Slaves> > > > stores;
+
+  for (int i = 0; i < 10; i++) {
+    Future<Variable<Slaves> > fetch = state->fetch<Slaves>(stringify(i));
+    AWAIT_READY(fetch);
+
+    Slaves slaves;
+    slaves.add_slaves()->mutable_info()->set_hostname(stringify(i));
+
+    stores.push_back(state->store(fetch.get().mutate(slaves)));
+  }
+
+  // A store of a variable whose version was changed by a store that
+  // is still in flight fails.
+  Future<Variable<Slaves> > fetch = state->fetch<Slaves>("slaves");
+  AWAIT_READY(fetch);
+
+  Future<Option<Variable<Slaves> > > store1 = state->store(fetch.get());
+  Future<Option<Variable<Slaves> > > store2 = state->store(fetch.get());
+
+  foreach (const Future<Option<Variable<Slaves> > >& store, stores) {
+    AWAIT_READY(store);
+    EXPECT_SOME(store.get());
+  }
+
+  AWAIT_READY(store1);
+  EXPECT_SOME(store1.get());
+
+  AWAIT_READY(store2);
+  EXPECT_NONE(store2.get());
+
+  for (int i = 0; i < 10; i++) {
+    Future<Variable<Slaves> > fetch = state->fetch<Slaves>(stringify(i));
+    AWAIT_READY(fetch);
+
+    Slaves slaves = fetch.get().get();
+    ASSERT_EQ(1, slaves.slaves().size());
+    EXPECT_EQ(stringify(i), slaves.slaves(0).info().hostname());
+  }
+}
+
+
 Future<Option<Variable<Slaves> > > timeout(
     Future<Option<Variable<Slaves> > > future)
 {